@@ -33,12 +33,14 @@ SOURCES += \
         main.cpp \
         widget.cpp \
     style.cpp \
-    volumebutton.cpp
+    volumebutton.cpp \
+    timeformat.cpp
 
 HEADERS += \
         widget.h \
     style.h \
-    volumebutton.h
+    volumebutton.h \
+    timeformat.h
 
 FORMS += \
         widget.ui
@@ -0,0 +1,96 @@
+#include "timeformat.h"
+
+TimeFormat::TimeFormat()
+{
+    m_buffer[0] = '\0';
+}
+
+static char *writeNumber(char *out, qint64 value, int minDigits)
+{
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (count < minDigits)
+        digits[count++] = '0';
+    while (count)
+        *out++ = digits[--count];
+    return out;
+}
+
+///Запись одного значения времени. Часы (или минуты в коротком формате)
+///не ограничены сверху, поэтому длинные записи не "заворачиваются"
+int TimeFormat::writeTime(char *out, qint64 seconds, bool withHours)
+{
+    if (seconds < 0)
+        seconds = 0;
+
+    char *p = out;
+    qint64 minutes = seconds / 60;
+    seconds -= minutes * 60;
+
+    if (withHours) {
+        qint64 hours = minutes / 60;
+        minutes -= hours * 60;
+        p = writeNumber(p, hours, 2);
+        *p++ = ':';
+    }
+    p = writeNumber(p, minutes, 2);
+    *p++ = ':';
+    p = writeNumber(p, seconds, 2);
+
+    return int(p - out);
+}
+
+///Одиночное значение: "mm:ss", а начиная с часа — "hh:mm:ss".
+///Возвращает true, если текст изменился
+bool TimeFormat::setTime(qint64 currentSeconds)
+{
+    if (currentSeconds == m_current && m_total == -1)
+        return false;
+
+    m_current = currentSeconds;
+    m_total = -1;
+    m_size = writeTime(m_buffer, currentSeconds, currentSeconds >= 3600);
+    m_buffer[m_size] = '\0';
+    return true;
+}
+
+///Пара значений "текущее / общее". Формат выбирается по общей длительности,
+///чтобы ширина надписи не менялась во время воспроизведения
+bool TimeFormat::setTime(qint64 currentSeconds, qint64 totalSeconds)
+{
+    if (totalSeconds < 0)
+        totalSeconds = 0;
+    if (currentSeconds == m_current && totalSeconds == m_total)
+        return false;
+
+    m_current = currentSeconds;
+    m_total = totalSeconds;
+
+    bool withHours = totalSeconds >= 3600 || currentSeconds >= 3600;
+    char *p = m_buffer;
+    p += writeTime(p, currentSeconds, withHours);
+    *p++ = ' ';
+    *p++ = '/';
+    *p++ = ' ';
+    p += writeTime(p, totalSeconds, withHours);
+
+    m_size = int(p - m_buffer);
+    m_buffer[m_size] = '\0';
+    return true;
+}
+
+bool TimeFormat::clear()
+{
+    if (m_size == 0 && m_current == -1)
+        return false;
+
+    m_current = -1;
+    m_total = -1;
+    m_size = 0;
+    m_buffer[0] = '\0';
+    return true;
+}
@@ -442,18 +442,11 @@ void Widget::seekBackward()
     ui->positionSlider->triggerAction(QSlider::SliderPageStepSub);
 }
 
-static QString formatTime(qint64 timeMilliSeconds)
-{
-    qint64 seconds = timeMilliSeconds / 1000;
-    const qint64 minutes = seconds / 60;
-    seconds -= minutes * 60;
-    return QStringLiteral("%1:%2").arg(minutes, 2, 10, QLatin1Char('0')).arg(seconds, 2, 10, QLatin1Char('0'));
-}
-
 void Widget::updatePosition(qint64 position)
 {
     ui->positionSlider->setValue(position);
-    ui->positionLabel->setText(formatTime(position));
+    if (m_positionFormat.setTime(position / 1000))
+        ui->positionLabel->setText(m_positionFormat.text());
 }
 
 void Widget::updateDuration(qint64 duration)
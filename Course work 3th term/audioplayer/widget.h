@@ -13,6 +13,7 @@
 
 #include "volumebutton.h"
 #include "style.h"
+#include "timeformat.h"
 
 QT_FORWARD_DECLARE_CLASS(QSlider)
 QT_FORWARD_DECLARE_CLASS(QWinTaskbarButton)
@@ -52,6 +53,7 @@ private:
     QMediaPlaylist *m_playlist = nullptr;
 
     VolumeButton *m_volumeButton = nullptr;
+    TimeFormat m_positionFormat;
 
     QWinTaskbarProgress *m_taskbarProgress = nullptr;
     QWinTaskbarButton *m_taskbarButton = nullptr;
@@ -0,0 +1,16 @@
+# Подключение статической библиотеки analysis к приложению или бенчмаркам.
+# Библиотека собирается отдельным подпроектом, см. mediaplayer.pro
+
+ANALYSIS_OUT = $$shadowed($$PWD)
+
+win32:CONFIG(release, debug|release): ANALYSIS_LIBDIR = $$ANALYSIS_OUT/release
+else:win32:CONFIG(debug, debug|release): ANALYSIS_LIBDIR = $$ANALYSIS_OUT/debug
+else: ANALYSIS_LIBDIR = $$ANALYSIS_OUT
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+LIBS += -L$$ANALYSIS_LIBDIR -lanalysis
+
+win32-g++: PRE_TARGETDEPS += $$ANALYSIS_LIBDIR/libanalysis.a
+else:win32:!win32-g++: PRE_TARGETDEPS += $$ANALYSIS_LIBDIR/analysis.lib
+else: PRE_TARGETDEPS += $$ANALYSIS_LIBDIR/libanalysis.a
@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Ядра анализа кадров и звука без зависимости от окна и мультимедиа.
+# Собирается статической библиотекой для плеера и бенчмарков
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+CONFIG   += staticlib c++11
+
+TARGET = analysis
+TEMPLATE = lib
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    lumahistogram.cpp \
+    audiolevels.cpp
+
+HEADERS += \
+    lumahistogram.h \
+    audiolevels.h
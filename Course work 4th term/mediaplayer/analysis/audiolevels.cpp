@@ -0,0 +1,99 @@
+#include "audiolevels.h"
+
+#include <QVarLengthArray>
+#include <climits>
+
+///Максимум и минимум каждого канала в родном типе отсчёта:
+///сравнение целых дешевле перевода каждого отсчёта в qreal
+template <class T>
+static void channelPeaks(const T *buffer, int frames, int channels, qreal *out)
+{
+    QVarLengthArray<T, 8> high(channels);
+    QVarLengthArray<T, 8> low(channels);
+    for (int j = 0; j < channels; ++j)
+        high[j] = low[j] = T(0);
+
+    for (int i = 0; i < frames; ++i, buffer += channels) {
+        for (int j = 0; j < channels; ++j) {
+            const T value = buffer[j];
+            if (value > high[j])
+                high[j] = value;
+            if (value < low[j])
+                low[j] = value;
+        }
+    }
+
+    for (int j = 0; j < channels; ++j)
+        out[j] = qMax(qAbs(qreal(high[j])), qAbs(qreal(low[j])));
+}
+
+qreal AudioLevels::peakValue(SampleType type, int sampleSize)
+{
+    switch (type) {
+    case Float:
+        if (sampleSize != 32)
+            return qreal(0);
+        return qreal(1.00003);
+    case SignedInt:
+        if (sampleSize == 32)
+            return qreal(INT_MAX);
+        if (sampleSize == 16)
+            return qreal(SHRT_MAX);
+        if (sampleSize == 8)
+            return qreal(CHAR_MAX);
+        break;
+    case UnSignedInt:
+        if (sampleSize == 32)
+            return qreal(UINT_MAX);
+        if (sampleSize == 16)
+            return qreal(USHRT_MAX);
+        if (sampleSize == 8)
+            return qreal(UCHAR_MAX);
+        break;
+    }
+
+    return qreal(0);
+}
+
+QVector<qreal> AudioLevels::levels(const void *data, int frames, int channels, SampleType type, int sampleSize)
+{
+    QVector<qreal> values;
+    if (channels <= 0)
+        return values;
+
+    values.fill(0, channels);
+    const qreal peak = peakValue(type, sampleSize);
+    if (qFuzzyCompare(peak, qreal(0)) || !data || frames <= 0)
+        return values;
+
+    qreal *out = values.data();
+    switch (type) {
+    case UnSignedInt:
+        if (sampleSize == 32)
+            channelPeaks(static_cast<const quint32 *>(data), frames, channels, out);
+        if (sampleSize == 16)
+            channelPeaks(static_cast<const quint16 *>(data), frames, channels, out);
+        if (sampleSize == 8)
+            channelPeaks(static_cast<const quint8 *>(data), frames, channels, out);
+        for (int i = 0; i < values.size(); ++i)
+            values[i] = qAbs(values.at(i) - peak / 2) / (peak / 2);
+        break;
+    case Float:
+        channelPeaks(static_cast<const float *>(data), frames, channels, out);
+        for (int i = 0; i < values.size(); ++i)
+            values[i] /= peak;
+        break;
+    case SignedInt:
+        if (sampleSize == 32)
+            channelPeaks(static_cast<const qint32 *>(data), frames, channels, out);
+        if (sampleSize == 16)
+            channelPeaks(static_cast<const qint16 *>(data), frames, channels, out);
+        if (sampleSize == 8)
+            channelPeaks(static_cast<const qint8 *>(data), frames, channels, out);
+        for (int i = 0; i < values.size(); ++i)
+            values[i] /= peak;
+        break;
+    }
+
+    return values;
+}
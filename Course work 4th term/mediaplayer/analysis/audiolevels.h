@@ -0,0 +1,22 @@
+#ifndef AUDIOLEVELS_H
+#define AUDIOLEVELS_H
+
+#include <QVector>
+#include <QtGlobal>
+
+///Пиковые уровни каналов PCM-буфера, нормированные к 0..1.
+///Формат описывается типом и разрядностью отсчёта, без QAudioFormat,
+///чтобы ядро можно было гонять вне мультимедиа
+class AudioLevels
+{
+public:
+    enum SampleType { SignedInt, UnSignedInt, Float };
+
+    ///Максимально возможное значение отсчёта, 0 для неподдерживаемого формата
+    static qreal peakValue(SampleType type, int sampleSize);
+
+    ///Отсчёты чередуются по каналам, порядок байт — как у процессора
+    static QVector<qreal> levels(const void *data, int frames, int channels, SampleType type, int sampleSize);
+};
+
+#endif // AUDIOLEVELS_H
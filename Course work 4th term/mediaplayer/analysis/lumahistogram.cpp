@@ -0,0 +1,79 @@
+#include "lumahistogram.h"
+
+#include <cstring>
+
+LumaHistogram::LumaHistogram()
+{
+    reset();
+}
+
+void LumaHistogram::reset()
+{
+    std::memset(m_bins, 0, sizeof(m_bins));
+}
+
+void LumaHistogram::addPlane(const uchar *plane, int width, int height, int bytesPerLine)
+{
+    quint32 *b0 = m_bins[0];
+    quint32 *b1 = m_bins[1];
+    quint32 *b2 = m_bins[2];
+    quint32 *b3 = m_bins[3];
+
+    for (int y = 0; y < height; ++y, plane += bytesPerLine) {
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            ++b0[plane[x]];
+            ++b1[plane[x + 1]];
+            ++b2[plane[x + 2]];
+            ++b3[plane[x + 3]];
+        }
+        for (; x < width; ++x)
+            ++b0[plane[x]];
+    }
+}
+
+static inline int grayOf(quint32 rgb)
+{
+    return (((rgb >> 16) & 0xff) * 11 + ((rgb >> 8) & 0xff) * 16 + (rgb & 0xff) * 5) >> 5;
+}
+
+void LumaHistogram::addRgb32(const uchar *bits, int width, int height, int bytesPerLine)
+{
+    quint32 *b0 = m_bins[0];
+    quint32 *b1 = m_bins[1];
+
+    for (int y = 0; y < height; ++y, bits += bytesPerLine) {
+        const quint32 *line = reinterpret_cast<const quint32 *>(bits);
+        int x = 0;
+        for (; x + 2 <= width; x += 2) {
+            ++b0[grayOf(line[x])];
+            ++b1[grayOf(line[x + 1])];
+        }
+        for (; x < width; ++x)
+            ++b0[grayOf(line[x])];
+    }
+}
+
+QVector<qreal> LumaHistogram::levels(int levels) const
+{
+    QVector<qreal> histogram(levels);
+    if (levels <= 0)
+        return histogram;
+
+    for (int value = 0; value < 256; ++value) {
+        quint32 count = m_bins[0][value] + m_bins[1][value] + m_bins[2][value] + m_bins[3][value];
+        histogram[(value * levels) >> 8] += count;
+    }
+
+    qreal maxValue = 0.0;
+    for (int i = 0; i < histogram.size(); ++i) {
+        if (histogram.at(i) > maxValue)
+            maxValue = histogram.at(i);
+    }
+
+    if (maxValue > 0.0) {
+        for (int i = 0; i < histogram.size(); ++i)
+            histogram[i] /= maxValue;
+    }
+    return histogram;
+}
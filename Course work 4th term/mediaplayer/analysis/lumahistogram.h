@@ -0,0 +1,31 @@
+#ifndef LUMAHISTOGRAM_H
+#define LUMAHISTOGRAM_H
+
+#include <QVector>
+#include <QtGlobal>
+
+///Гистограмма яркости кадра. В цикле по пикселям считаются 256 точных корзин,
+///в нужное число уровней они сворачиваются уже в конце, так что на пиксель
+///приходится одно сложение без умножения и деления.
+///Корзин четыре копии: соседние пиксели почти всегда одной яркости,
+///и с одной копией каждое сложение ждало бы предыдущее
+class LumaHistogram
+{
+private:
+    quint32 m_bins[4][256];
+
+public:
+    LumaHistogram();
+
+    void reset();
+
+    ///Плоскость яркости YUV420P и NV12
+    void addPlane(const uchar *plane, int width, int height, int bytesPerLine);
+    ///Пиксели Format_RGB32, яркость считается как в qGray
+    void addRgb32(const uchar *bits, int width, int height, int bytesPerLine);
+
+    ///Гистограмма из levels уровней, нормированная по самому высокому
+    QVector<qreal> levels(int levels) const;
+};
+
+#endif // LUMAHISTOGRAM_H
@@ -0,0 +1,350 @@
+#include "audiomixer.h"
+
+#include <QtMath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIOMIXER_SSE2
+#endif
+
+static inline quint32 floatBits(float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bitsFloat(quint32 bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+///Коэффициент однополюсного сглаживания для постоянной времени в миллисекундах
+static inline float smoothing(float milliseconds, int sampleRate)
+{
+    if (milliseconds <= 0)
+        return 0.0f;
+    return float(qExp(-1.0 / (milliseconds * 0.001 * sampleRate)));
+}
+
+static inline float dbToGain(float db)
+{
+    return float(qPow(10.0, db / 20.0));
+}
+
+AudioMixer::AudioMixer()
+    : m_duckKey(-1),
+      m_duckTarget(-1)
+{
+    configure(48000, 480, 2, 48000);
+}
+
+///Перестраивает буферы. Вызывать только при остановленном выводе
+void AudioMixer::configure(int sampleRate, int blockFrames, int streamCount, int ringFrames)
+{
+    m_sampleRate = qMax(1, sampleRate);
+    m_blockFrames = qMax(1, blockFrames);
+    m_ringFrames = qMax(m_blockFrames, ringFrames);
+
+    m_streams.clear();
+    for (int i = 0; i < streamCount; ++i) {
+        QSharedPointer<Stream> stream(new Stream);
+        stream->ring.fill(0.0f, m_ringFrames * Channels);
+        stream->gain.storeRelease(floatBits(1.0f));
+        m_streams.append(stream);
+    }
+
+    m_scratch.fill(0.0f, m_blockFrames * Channels);
+    m_curve.fill(0.0f, m_blockFrames * Channels);
+
+    ///Детектор огибающей быстрый, плавность даёт сглаживание самого усиления
+    m_detectorAttack = smoothing(1.0f, m_sampleRate);
+    m_detectorRelease = smoothing(50.0f, m_sampleRate);
+    m_envelope = 0.0f;
+    m_duckGain = 1.0f;
+    m_duckGainOut.storeRelease(floatBits(1.0f));
+
+    m_equalizer.configure(m_sampleRate, Channels);
+    m_convolver.configure(m_sampleRate);
+    m_dynamics.configure(m_sampleRate);
+}
+
+int AudioMixer::writable(int stream) const
+{
+    const Stream &s = *m_streams.at(stream);
+    return m_ringFrames - int(s.writePos.loadAcquire() - s.readPos.loadAcquire());
+}
+
+int AudioMixer::queued(int stream) const
+{
+    const Stream &s = *m_streams.at(stream);
+    return int(s.writePos.loadAcquire() - s.readPos.loadAcquire());
+}
+
+///Возвращает число записанных кадров. При переполнении лишнее отбрасывается:
+///читатель не должен ждать писателя
+int AudioMixer::write(int stream, const float *interleaved, int frames)
+{
+    Stream &s = *m_streams[stream];
+    const quint32 write = s.writePos.loadAcquire();
+    const quint32 read = s.readPos.loadAcquire();
+    const int count = qMin(frames, m_ringFrames - int(write - read));
+    if (count <= 0)
+        return 0;
+
+    const int start = int(write % quint32(m_ringFrames));
+    const int first = qMin(count, m_ringFrames - start);
+    float *ring = s.ring.data();
+    std::memcpy(ring + start * Channels, interleaved, size_t(first) * Channels * sizeof(float));
+    std::memcpy(ring, interleaved + first * Channels, size_t(count - first) * Channels * sizeof(float));
+
+    s.writePos.storeRelease(write + quint32(count));
+    return count;
+}
+
+int AudioMixer::readStream(Stream &s, float *out, int frames)
+{
+    quint32 read = s.readPos.loadAcquire();
+    const quint32 write = s.writePos.loadAcquire();
+
+    if (s.flushRequest.fetchAndStoreAcquire(0)) {
+        read = write;
+        s.readPos.storeRelease(read);
+    }
+
+    const int count = qMin(frames, int(write - read));
+    const int start = int(read % quint32(m_ringFrames));
+    const int first = qMin(count, m_ringFrames - start);
+    const float *ring = s.ring.constData();
+    std::memcpy(out, ring + start * Channels, size_t(first) * Channels * sizeof(float));
+    std::memcpy(out + first * Channels, ring, size_t(count - first) * Channels * sizeof(float));
+
+    if (count < frames) {
+        std::memset(out + count * Channels, 0, size_t(frames - count) * Channels * sizeof(float));
+        if (count > 0)
+            s.underruns.fetchAndAddRelaxed(1);
+    }
+
+    s.readPos.storeRelease(read + quint32(count));
+    return count;
+}
+
+void AudioMixer::setGain(int stream, float gain)
+{
+    m_streams[stream]->gain.storeRelease(floatBits(qMax(0.0f, gain)));
+}
+
+float AudioMixer::gain(int stream) const
+{
+    return bitsFloat(m_streams.at(stream)->gain.loadAcquire());
+}
+
+///Сбрасывает накопленное в кольце, например при перемотке источника
+void AudioMixer::flush(int stream)
+{
+    m_streams[stream]->flushRequest.storeRelease(1);
+}
+
+quint32 AudioMixer::underruns(int stream) const
+{
+    return m_streams.at(stream)->underruns.loadAcquire();
+}
+
+void AudioMixer::setDucking(int key, int target, float thresholdDb, float depthDb, float attackMs, float releaseMs)
+{
+    m_duckThreshold.storeRelease(floatBits(dbToGain(thresholdDb)));
+    m_duckDepth.storeRelease(floatBits(dbToGain(-qAbs(depthDb))));
+    m_duckAttack.storeRelease(floatBits(smoothing(attackMs, m_sampleRate)));
+    m_duckRelease.storeRelease(floatBits(smoothing(releaseMs, m_sampleRate)));
+    m_duckTarget.storeRelease(target);
+    m_duckKey.storeRelease(key);
+}
+
+void AudioMixer::clearDucking()
+{
+    m_duckKey.storeRelease(-1);
+    m_duckTarget.storeRelease(-1);
+}
+
+///Текущее приглушение, 1 — без приглушения. Для индикации в интерфейсе
+float AudioMixer::duckGain() const
+{
+    return bitsFloat(m_duckGainOut.loadAcquire());
+}
+
+void AudioMixer::process(float *out, int frames)
+{
+    while (frames > 0) {
+        const int block = qMin(frames, m_blockFrames);
+        processBlock(out, block);
+        out += block * Channels;
+        frames -= block;
+    }
+}
+
+///Кривая усиления приглушаемого потока: огибающая ключа по кадрам,
+///сглаженное приглушение и плавный переход усиления самого потока
+void AudioMixer::buildDuckCurve(const float *key, float gainFrom, float gainTo, int frames)
+{
+    const float threshold = bitsFloat(m_duckThreshold.loadAcquire());
+    const float depth = bitsFloat(m_duckDepth.loadAcquire());
+    const float attack = bitsFloat(m_duckAttack.loadAcquire());
+    const float release = bitsFloat(m_duckRelease.loadAcquire());
+    const float step = (gainTo - gainFrom) / frames;
+
+    float envelope = m_envelope;
+    float duck = m_duckGain;
+    float *curve = m_curve.data();
+    for (int i = 0; i < frames; ++i) {
+        const float level = qMax(qAbs(key[2 * i]), qAbs(key[2 * i + 1]));
+        const float detector = level > envelope ? m_detectorAttack : m_detectorRelease;
+        envelope = level + detector * (envelope - level);
+
+        const float target = envelope > threshold ? depth : 1.0f;
+        const float coefficient = target < duck ? attack : release;
+        duck = target + coefficient * (duck - target);
+
+        const float g = duck * (gainFrom + step * (i + 1));
+        curve[2 * i] = g;
+        curve[2 * i + 1] = g;
+    }
+
+    ///Денормализованные числа на затухающем хвосте заметно замедляют FPU
+    m_envelope = envelope < 1e-9f ? 0.0f : envelope;
+    m_duckGain = duck;
+    m_duckGainOut.storeRelease(floatBits(duck));
+}
+
+void AudioMixer::processBlock(float *out, int frames)
+{
+    const int samples = frames * Channels;
+    std::memset(out, 0, size_t(samples) * sizeof(float));
+
+    const int key = m_duckKey.loadAcquire();
+    const int target = m_duckTarget.loadAcquire();
+    const bool ducking = key >= 0 && target >= 0 && key < m_streams.size() && target < m_streams.size();
+
+    ///Ключ читается первым, чтобы его огибающая была готова к приглушаемому потоку.
+    ///Свободную часть буфера кривой занимают сэмплы ключа до смешивания
+    if (ducking) {
+        Stream &keyStream = *m_streams[key];
+        float *scratch = m_scratch.data();
+        readStream(keyStream, scratch, frames);
+
+        const float gainTo = bitsFloat(keyStream.gain.loadAcquire());
+        mix(out, scratch, keyStream.currentGain, gainTo, frames);
+        keyStream.currentGain = gainTo;
+
+        Stream &targetStream = *m_streams[target];
+        const float targetGain = bitsFloat(targetStream.gain.loadAcquire());
+        buildDuckCurve(scratch, targetStream.currentGain, targetGain, frames);
+        targetStream.currentGain = targetGain;
+
+        readStream(targetStream, scratch, frames);
+        mixCurve(out, scratch, m_curve.constData(), samples);
+    } else if (m_duckGain != 1.0f) {
+        m_envelope = 0.0f;
+        m_duckGain = 1.0f;
+        m_duckGainOut.storeRelease(floatBits(1.0f));
+    }
+
+    for (int i = 0; i < m_streams.size(); ++i) {
+        if (ducking && (i == key || i == target))
+            continue;
+
+        Stream &stream = *m_streams[i];
+        float *scratch = m_scratch.data();
+        if (readStream(stream, scratch, frames) == 0 && stream.currentGain == bitsFloat(stream.gain.loadAcquire()))
+            continue;
+
+        const float gainTo = bitsFloat(stream.gain.loadAcquire());
+        mix(out, scratch, stream.currentGain, gainTo, frames);
+        stream.currentGain = gainTo;
+    }
+
+    m_equalizer.process(out, frames);
+    m_convolver.process(out, frames);
+    m_dynamics.process(out, frames);
+    clip(out, samples);
+}
+
+///out += in * gain, усиление линейно идёт от gainFrom к gainTo по кадрам блока
+void AudioMixer::mix(float *out, const float *in, float gainFrom, float gainTo, int frames)
+{
+    const int samples = frames * Channels;
+    const float step = (gainTo - gainFrom) / frames;
+    int i = 0;
+
+#ifdef AUDIOMIXER_SSE2
+    if (step == 0.0f) {
+        const __m128 g = _mm_set1_ps(gainTo);
+        for (; i + 8 <= samples; i += 8) {
+            __m128 a = _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), g));
+            __m128 b = _mm_add_ps(_mm_loadu_ps(out + i + 4), _mm_mul_ps(_mm_loadu_ps(in + i + 4), g));
+            _mm_storeu_ps(out + i, a);
+            _mm_storeu_ps(out + i + 4, b);
+        }
+    } else {
+        ///Четыре сэмпла — два стереокадра с усилениями g и g + step
+        __m128 g = _mm_set_ps(gainFrom + 2 * step, gainFrom + 2 * step, gainFrom + step, gainFrom + step);
+        const __m128 increment = _mm_set1_ps(2 * step);
+        for (; i + 4 <= samples; i += 4) {
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), g)));
+            g = _mm_add_ps(g, increment);
+        }
+    }
+#endif
+
+    for (; i < samples; ++i)
+        out[i] += in[i] * (gainFrom + step * (i / Channels + 1));
+}
+
+///out += in * curve, кривая задана на каждый сэмпл
+void AudioMixer::mixCurve(float *out, const float *in, const float *curve, int samples)
+{
+    int i = 0;
+#ifdef AUDIOMIXER_SSE2
+    for (; i + 4 <= samples; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i),
+                                          _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(curve + i))));
+#endif
+    for (; i < samples; ++i)
+        out[i] += in[i] * curve[i];
+}
+
+void AudioMixer::clip(float *buffer, int samples)
+{
+    int i = 0;
+#ifdef AUDIOMIXER_SSE2
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+    for (; i + 4 <= samples; i += 4)
+        _mm_storeu_ps(buffer + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buffer + i), low), high));
+#endif
+    for (; i < samples; ++i)
+        buffer[i] = qBound(-1.0f, buffer[i], 1.0f);
+}
+
+void AudioMixer::toInt16(const float *in, qint16 *out, int samples)
+{
+    int i = 0;
+#ifdef AUDIOMIXER_SSE2
+    ///Ограничение до умножения, как в скалярной ветке: насыщение упаковки
+    ///дало бы -32768 там, где скалярная даёт -32767
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+    for (; i + 8 <= samples; i += 8) {
+        const __m128 x = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high);
+        const __m128 y = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), low), high);
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(x, scale));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(y, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(a, b));
+    }
+#endif
+    for (; i < samples; ++i)
+        out[i] = qint16(qRound(qBound(-1.0f, in[i], 1.0f) * 32767.0f));
+}
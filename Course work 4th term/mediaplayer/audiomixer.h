@@ -0,0 +1,105 @@
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QAtomicInteger>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "convolver.h"
+#include "dynamics.h"
+#include "equalizer.h"
+
+///Блочный микшер: складывает несколько потоков float-стерео в один выход.
+///У каждого потока своё кольцо без блокировок (один писатель, один читатель)
+///и своё усиление, которое меняется плавно в пределах блока.
+///Приглушение: огибающая потока-ключа (звук видео) опускает уровень другого
+///потока (музыки), пока ключ звучит громче порога.
+///Сумма проходит через эквалайзер, свёртку с импульсной характеристикой
+///и обработку динамики (компрессор и лимитер) перед ограничением.
+///Все буферы выделяются в configure(), process() не выделяет памяти и не блокируется
+class AudioMixer
+{
+public:
+    static const int Channels = 2;
+
+private:
+    struct Stream
+    {
+        QVector<float> ring;
+        QAtomicInteger<quint32> writePos;
+        QAtomicInteger<quint32> readPos;
+        QAtomicInteger<quint32> flushRequest;
+        QAtomicInteger<quint32> gain;       // биты float
+        QAtomicInteger<quint32> underruns;
+        float currentGain = 1.0f;
+    };
+
+    QVector<QSharedPointer<Stream>> m_streams;
+    int m_sampleRate = 48000;
+    int m_blockFrames = 480;
+    int m_ringFrames = 48000;
+
+    QVector<float> m_scratch;
+    QVector<float> m_curve;
+
+    QAtomicInteger<int> m_duckKey;
+    QAtomicInteger<int> m_duckTarget;
+    QAtomicInteger<quint32> m_duckThreshold;
+    QAtomicInteger<quint32> m_duckDepth;
+    QAtomicInteger<quint32> m_duckAttack;
+    QAtomicInteger<quint32> m_duckRelease;
+    QAtomicInteger<quint32> m_duckGainOut;
+
+    float m_envelope = 0.0f;
+    float m_duckGain = 1.0f;
+    float m_detectorAttack = 0.0f;
+    float m_detectorRelease = 0.0f;
+
+    Equalizer m_equalizer;
+    Convolver m_convolver;
+    Dynamics m_dynamics;
+
+    int readStream(Stream &stream, float *out, int frames);
+    void buildDuckCurve(const float *key, float gainFrom, float gainTo, int frames);
+    void processBlock(float *out, int frames);
+
+public:
+    AudioMixer();
+
+    void configure(int sampleRate, int blockFrames, int streamCount, int ringFrames);
+
+    int sampleRate() const { return m_sampleRate; }
+    int blockFrames() const { return m_blockFrames; }
+    int streamCount() const { return m_streams.size(); }
+
+    ///Вызывается из потока-источника
+    int write(int stream, const float *interleaved, int frames);
+    int writable(int stream) const;
+    int queued(int stream) const;
+
+    ///Вызываются из любого потока
+    void setGain(int stream, float gain);
+    float gain(int stream) const;
+    void flush(int stream);
+    quint32 underruns(int stream) const;
+
+    void setDucking(int key, int target, float thresholdDb, float depthDb, float attackMs, float releaseMs);
+    void clearDucking();
+    float duckGain() const;
+
+    ///Полосы и включение настраиваются из любого потока, configure() — только микшер
+    Equalizer *equalizer() { return &m_equalizer; }
+    ///Характеристика загружается из потока интерфейса, поток вывода подхватит её сам
+    Convolver *convolver() { return &m_convolver; }
+    Dynamics *dynamics() { return &m_dynamics; }
+
+    ///Вызывается из потока вывода
+    void process(float *out, int frames);
+
+    static void mix(float *out, const float *in, float gainFrom, float gainTo, int frames);
+    static void mixCurve(float *out, const float *in, const float *curve, int samples);
+    static void clip(float *buffer, int samples);
+    static void toInt16(const float *in, qint16 *out, int samples);
+};
+
+#endif // AUDIOMIXER_H
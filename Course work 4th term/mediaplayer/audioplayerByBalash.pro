@@ -43,7 +43,38 @@ SOURCES += \
     playercontrols.cpp \
     playlistmodel.cpp \
     videowidget.cpp \
-    player.cpp
+    player.cpp \
+    uirefreshclock.cpp \
+    timeformat.cpp \
+    coverartloader.cpp \
+    thumbnailstrip.cpp \
+    seekpreview.cpp \
+    framequeuesurface.cpp \
+    coloradjustment.cpp \
+    startuptimeline.cpp \
+    windowshadow.cpp \
+    mediasession.cpp \
+    audiomixer.cpp \
+    mixeroutput.cpp \
+    performancehud.cpp \
+    trace.cpp \
+    playlistview.cpp \
+    playbackorder.cpp \
+    playlistsequence.cpp \
+    tracklistmodel.cpp \
+    audiosniffer.cpp \
+    trackimporter.cpp \
+    wavfile.cpp \
+    wavstream.cpp \
+    tagreader.cpp \
+    trackinfoloader.cpp \
+    durationestimator.cpp \
+    resampler.cpp \
+    timestretcher.cpp \
+    equalizer.cpp \
+    fft.cpp \
+    convolver.cpp \
+    dynamics.cpp
 
 HEADERS += \
         widget.h \
@@ -53,7 +84,42 @@ HEADERS += \
     playercontrols.h \
     playlistmodel.h \
     videowidget.h \
-    player.h
+    player.h \
+    uirefreshclock.h \
+    timeformat.h \
+    coverartloader.h \
+    thumbnailstrip.h \
+    seekpreview.h \
+    framequeuesurface.h \
+    coloradjustment.h \
+    startuptimeline.h \
+    windowshadow.h \
+    mediasession.h \
+    audiomixer.h \
+    mixeroutput.h \
+    performancehud.h \
+    trace.h \
+    playlistview.h \
+    playbackorder.h \
+    playlistsequence.h \
+    tracklistmodel.h \
+    audiosniffer.h \
+    trackimporter.h \
+    wavfile.h \
+    wavstream.h \
+    tagreader.h \
+    trackinfoloader.h \
+    durationestimator.h \
+    resampler.h \
+    timestretcher.h \
+    equalizer.h \
+    fft.h \
+    convolver.h \
+    dynamics.h
+
+win32: LIBS += -lpsapi
+
+include(analysis/analysis.pri)
 
 FORMS += \
         widget.ui
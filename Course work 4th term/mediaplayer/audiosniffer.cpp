@@ -0,0 +1,253 @@
+#include "audiosniffer.h"
+
+#include <cstring>
+
+static inline quint32 readLe16(const uchar *p)
+{
+    return quint32(p[0]) | quint32(p[1]) << 8;
+}
+
+static inline quint32 readLe32(const uchar *p)
+{
+    return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+}
+
+static inline quint32 readBe32(const uchar *p)
+{
+    return quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | quint32(p[3]);
+}
+
+static inline bool hasTag(const uchar *p, const char *tag)
+{
+    return std::memcmp(p, tag, 4) == 0;
+}
+
+static void setError(QString *error, const QString &text)
+{
+    if (error)
+        *error = text;
+}
+
+bool AudioSniffer::parseMpegFrame(const uchar *header, MpegFrame *frame)
+{
+    static const short bitrates[2][3][15] = {
+        {   // MPEG-1, Layer I, II, III
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+            { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 }
+        },
+        {   // MPEG-2 и 2.5
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }
+        }
+    };
+    static const int sampleRates[3] = { 44100, 48000, 32000 };
+
+    const quint32 h = readBe32(header);
+    if ((h & 0xFFE00000u) != 0xFFE00000u)
+        return false;
+
+    const int versionBits = (h >> 19) & 3;
+    const int layerBits = (h >> 17) & 3;
+    const int bitrateIndex = (h >> 12) & 15;
+    const int sampleRateIndex = (h >> 10) & 3;
+    if (versionBits == 1 || layerBits == 0 || bitrateIndex == 15 || sampleRateIndex == 3 || (h & 3) == 2)
+        return false;
+
+    MpegFrame result;
+    result.version = versionBits == 3 ? 10 : versionBits == 2 ? 20 : 25;
+    result.layer = 4 - layerBits;
+    result.bitrate = bitrates[result.version == 10 ? 0 : 1][result.layer - 1][bitrateIndex];
+    result.sampleRate = sampleRates[sampleRateIndex] >> (result.version == 10 ? 0 : result.version == 20 ? 1 : 2);
+    result.channels = ((h >> 6) & 3) == 3 ? 1 : 2;
+
+    const int padding = (h >> 9) & 1;
+    if (result.layer == 1) {
+        result.samplesPerFrame = 384;
+        if (result.bitrate)
+            result.length = (12 * result.bitrate * 1000 / result.sampleRate + padding) * 4;
+    } else {
+        result.samplesPerFrame = result.layer == 3 && result.version != 10 ? 576 : 1152;
+        if (result.bitrate)
+            result.length = result.samplesPerFrame / 8 * result.bitrate * 1000 / result.sampleRate + padding;
+    }
+
+    *frame = result;
+    return true;
+}
+
+int AudioSniffer::id3Size(const uchar *data, int size)
+{
+    if (size < 10 || std::memcmp(data, "ID3", 3) != 0)
+        return 0;
+
+    const int version = data[3];
+    const int flags = data[5];
+    static const int reservedFlags[5] = { 0, 0, 0x3F, 0x1F, 0x0F };
+    if (version < 2 || version > 4 || data[4] == 0xFF || (flags & reservedFlags[version]))
+        return 0;
+    if ((data[6] | data[7] | data[8] | data[9]) & 0x80)
+        return 0;
+
+    const int tagSize = int(data[6]) << 21 | int(data[7]) << 14 | int(data[8]) << 7 | int(data[9]);
+    return 10 + tagSize + (version == 4 && (flags & 0x10) ? 10 : 0);
+}
+
+///Кадр считается найденным, если за ним в прочитанном куске стоит ещё один кадр
+///того же потока, или следующий кадр уже за пределами куска.
+///Одна случайная пара байт 0xFFE в произвольных данных так проверку не пройдёт
+static int findMpegFrame(const uchar *data, int from, int size, bool strict)
+{
+    for (int offset = from; offset + 4 <= size; ++offset) {
+        AudioSniffer::MpegFrame frame;
+        if (data[offset] != 0xFF || !AudioSniffer::parseMpegFrame(data + offset, &frame))
+            continue;
+
+        const int next = offset + frame.length;
+        if (frame.length == 0 || next + 4 > size) {
+            if (!strict || offset == from)
+                return offset;
+            continue;
+        }
+
+        AudioSniffer::MpegFrame nextFrame;
+        if (AudioSniffer::parseMpegFrame(data + next, &nextFrame)
+                && nextFrame.version == frame.version
+                && nextFrame.layer == frame.layer
+                && nextFrame.sampleRate == frame.sampleRate)
+            return offset;
+    }
+    return -1;
+}
+
+static AudioSniffer::Format sniffWave(const uchar *data, int size, AudioSniffer::Format format, QString *error)
+{
+    for (int offset = 12; offset + 8 <= size;) {
+        const quint32 chunkSize = readLe32(data + offset + 4);
+
+        if (hasTag(data + offset, "data")) {
+            setError(error, AudioSniffer::tr("WAV data chunk comes before the fmt chunk"));
+            return AudioSniffer::Unknown;
+        }
+
+        if (hasTag(data + offset, "fmt ")) {
+            if (chunkSize < 16) {
+                setError(error, AudioSniffer::tr("WAV fmt chunk is too short"));
+                return AudioSniffer::Unknown;
+            }
+            if (offset + 24 > size)
+                return format;
+
+            const uchar *fmt = data + offset + 8;
+            const quint32 tag = readLe16(fmt);
+            const quint32 channels = readLe16(fmt + 2);
+            const quint32 sampleRate = readLe32(fmt + 4);
+            const quint32 blockAlign = readLe16(fmt + 12);
+            const quint32 bits = readLe16(fmt + 14);
+            if (tag == 0 || channels == 0 || sampleRate == 0 || sampleRate > 1536000 || blockAlign == 0
+                    || ((tag == 1 || tag == 3) && (bits == 0 || bits > 64))) {
+                setError(error, AudioSniffer::tr("WAV fmt chunk is invalid"));
+                return AudioSniffer::Unknown;
+            }
+            return format;
+        }
+
+        offset += 8 + int(qMin<quint32>(chunkSize + (chunkSize & 1), quint32(size)));
+    }
+
+    ///fmt дальше прочитанного (большие bext или JUNK) — сигнатуры достаточно
+    return format;
+}
+
+AudioSniffer::Format AudioSniffer::sniff(const char *bytes, int size, QString *error)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(bytes);
+    if (size < 4) {
+        setError(error, AudioSniffer::tr("File is too short"));
+        return Unknown;
+    }
+
+    if (size >= 12 && (hasTag(data, "RIFF") || hasTag(data, "RF64") || hasTag(data, "BW64"))) {
+        if (!hasTag(data + 8, "WAVE")) {
+            setError(error, AudioSniffer::tr("RIFF file without WAVE audio"));
+            return Unknown;
+        }
+        return sniffWave(data, size, hasTag(data, "RIFF") ? Wave : Rf64, error);
+    }
+
+    if (hasTag(data, "fLaC"))
+        return Flac;
+    if (hasTag(data, "OggS"))
+        return Ogg;
+    if (size >= 12 && hasTag(data + 4, "ftyp"))
+        return Mp4;
+    if (size >= 12 && hasTag(data, "FORM") && (hasTag(data + 8, "AIFF") || hasTag(data + 8, "AIFC")))
+        return Aiff;
+
+    if (size >= 3 && std::memcmp(data, "ID3", 3) == 0) {
+        const int tagSize = id3Size(data, size);
+        if (tagSize == 0) {
+            setError(error, AudioSniffer::tr("ID3 tag header is invalid"));
+            return Unknown;
+        }
+        if (tagSize + 4 > size)
+            return Mpeg;
+        if (hasTag(data + tagSize, "fLaC"))
+            return Flac;
+        if (findMpegFrame(data, tagSize, size, false) < 0) {
+            setError(error, AudioSniffer::tr("No MPEG audio after the ID3 tag"));
+            return Unknown;
+        }
+        return Mpeg;
+    }
+
+    if (findMpegFrame(data, 0, size, true) >= 0)
+        return Mpeg;
+
+    setError(error, AudioSniffer::tr("Unknown file format"));
+    return Unknown;
+}
+
+QString AudioSniffer::name(Format format)
+{
+    switch (format) {
+    case Wave: return QStringLiteral("WAV");
+    case Rf64: return QStringLiteral("RF64");
+    case Mpeg: return QStringLiteral("MP3");
+    case Flac: return QStringLiteral("FLAC");
+    case Ogg: return QStringLiteral("Ogg");
+    case Mp4: return QStringLiteral("MP4");
+    case Aiff: return QStringLiteral("AIFF");
+    default: return QString();
+    }
+}
+
+QString AudioSniffer::mimeType(Format format)
+{
+    switch (format) {
+    case Wave:
+    case Rf64: return QStringLiteral("audio/wav");
+    case Mpeg: return QStringLiteral("audio/mpeg");
+    case Flac: return QStringLiteral("audio/flac");
+    case Ogg: return QStringLiteral("audio/ogg");
+    case Mp4: return QStringLiteral("audio/mp4");
+    case Aiff: return QStringLiteral("audio/aiff");
+    default: return QString();
+    }
+}
+
+bool AudioSniffer::matchesSuffix(Format format, const QString &suffix)
+{
+    const QString lower = suffix.toLower();
+    switch (format) {
+    case Wave:
+    case Rf64: return lower == "wav" || lower == "wave" || lower == "bwf" || lower == "rf64";
+    case Mpeg: return lower == "mp3" || lower == "mp2" || lower == "mpga";
+    case Flac: return lower == "flac";
+    case Ogg: return lower == "ogg" || lower == "oga" || lower == "opus";
+    case Mp4: return lower == "m4a" || lower == "mp4" || lower == "aac";
+    case Aiff: return lower == "aif" || lower == "aiff" || lower == "aifc";
+    default: return false;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef AUDIOSNIFFER_H
+#define AUDIOSNIFFER_H
+
+#include <QCoreApplication>
+#include <QString>
+
+///Распознавание аудиофайла по первым байтам, без обращения к декодерам.
+///Хватает одного чтения HeaderSize байт: проверяются сигнатура контейнера
+///и поля заголовка (fmt у WAV, тег ID3 и заголовки кадров MPEG),
+///поэтому переименованный или испорченный файл отсекается до плейлиста
+class AudioSniffer
+{
+    Q_DECLARE_TR_FUNCTIONS(AudioSniffer)
+
+public:
+    enum Format {
+        Unknown = 0,
+        Wave,
+        Rf64,
+        Mpeg,
+        Flac,
+        Ogg,
+        Mp4,
+        Aiff
+    };
+
+    ///Заголовок кадра MPEG-1/2/2.5 Layer I–III
+    struct MpegFrame
+    {
+        int version = 0;        // 10 — MPEG-1, 20 — MPEG-2, 25 — MPEG-2.5
+        int layer = 0;
+        int bitrate = 0;        // кбит/с, 0 — свободный битрейт
+        int sampleRate = 0;
+        int channels = 0;
+        int samplesPerFrame = 0;
+        int length = 0;         // байт вместе с заголовком, 0 — неизвестна
+    };
+
+    static const int HeaderSize = 4096;
+
+    ///size — сколько байт удалось прочитать. error получает причину отказа
+    static Format sniff(const char *data, int size, QString *error = nullptr);
+
+    static bool parseMpegFrame(const uchar *header, MpegFrame *frame);
+
+    ///Размер тега ID3v2 вместе с заголовком; 0, если тега нет или он испорчен
+    static int id3Size(const uchar *data, int size);
+
+    static bool isSupported(Format format) { return format == Wave || format == Rf64 || format == Mpeg; }
+    static QString name(Format format);
+    static QString mimeType(Format format);
+
+    ///Соответствует ли расширение файла его содержимому
+    static bool matchesSuffix(Format format, const QString &suffix);
+};
+
+#endif // AUDIOSNIFFER_H
@@ -0,0 +1,118 @@
+#include <QByteArray>
+#include <QVector>
+
+#include "benchmark.h"
+#include "audiolevels.h"
+#include "lumahistogram.h"
+
+///Синтетическое содержимое: градиент с шумом, чтобы заполнялись все корзины
+static QByteArray syntheticBytes(int size)
+{
+    QByteArray bytes(size, Qt::Uninitialized);
+    quint32 state = 2463534242u;
+    for (int i = 0; i < size; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        bytes[i] = char(((i >> 4) + (state & 0x3f)) & 0xff);
+    }
+    return bytes;
+}
+
+struct FrameSize
+{
+    const char *name;
+    int width;
+    int height;
+    int iterations;
+};
+
+static const FrameSize frameSizes[] = {
+    { "720p",  1280,  720, 400 },
+    { "1080p", 1920, 1080, 200 },
+    { "4k",    3840, 2160,  50 }
+};
+
+///Как в FrameProcessor::processFrame: сброс, проход по кадру и свёртка в 128 уровней
+static void benchFrames()
+{
+    const int levels = 128;
+    LumaHistogram histogram;
+
+    for (const FrameSize &size : frameSizes) {
+        const int lumaBytes = size.width * size.height;
+
+        ///YUV420P: плоскость яркости, за ней U и V в четверть размера
+        const QByteArray yuv420p = syntheticBytes(lumaBytes * 3 / 2);
+        runThroughputBenchmark(QString("analysis/histogram/yuv420p/%1").arg(size.name), size.iterations, lumaBytes,
+                               [&](qint64) {
+            histogram.reset();
+            histogram.addPlane(reinterpret_cast<const uchar *>(yuv420p.constData()), size.width, size.height, size.width);
+            benchmarkSink += qint64(histogram.levels(levels).at(levels / 2) * 1000);
+        });
+
+        ///NV12: строки выровнены по 64 байта, как у аппаратных декодеров
+        const int nv12Stride = (size.width + 63) & ~63;
+        const QByteArray nv12 = syntheticBytes(nv12Stride * size.height * 3 / 2);
+        runThroughputBenchmark(QString("analysis/histogram/nv12/%1").arg(size.name), size.iterations, lumaBytes,
+                               [&](qint64) {
+            histogram.reset();
+            histogram.addPlane(reinterpret_cast<const uchar *>(nv12.constData()), size.width, size.height, nv12Stride);
+            benchmarkSink += qint64(histogram.levels(levels).at(levels / 2) * 1000);
+        });
+
+        const QByteArray rgb32 = syntheticBytes(lumaBytes * 4);
+        runThroughputBenchmark(QString("analysis/histogram/rgb32/%1").arg(size.name), size.iterations, lumaBytes * 4,
+                               [&](qint64) {
+            histogram.reset();
+            histogram.addRgb32(reinterpret_cast<const uchar *>(rgb32.constData()), size.width, size.height, size.width * 4);
+            benchmarkSink += qint64(histogram.levels(levels).at(levels / 2) * 1000);
+        });
+    }
+}
+
+struct SampleFormat
+{
+    const char *name;
+    AudioLevels::SampleType type;
+    int sampleSize;
+};
+
+static const SampleFormat sampleFormats[] = {
+    { "s8",  AudioLevels::SignedInt,    8 },
+    { "u8",  AudioLevels::UnSignedInt,  8 },
+    { "s16", AudioLevels::SignedInt,   16 },
+    { "u16", AudioLevels::UnSignedInt, 16 },
+    { "s32", AudioLevels::SignedInt,   32 },
+    { "u32", AudioLevels::UnSignedInt, 32 },
+    { "f32", AudioLevels::Float,       32 }
+};
+
+///Буфер пробника: 4096 кадров стерео, около 85 мс при 48 кГц
+static void benchLevels()
+{
+    const int frames = 4096;
+    const int channels = 2;
+
+    for (const SampleFormat &format : sampleFormats) {
+        const int bytes = frames * channels * format.sampleSize / 8;
+        QByteArray data = syntheticBytes(bytes);
+        if (format.type == AudioLevels::Float) {
+            float *samples = reinterpret_cast<float *>(data.data());
+            for (int i = 0; i < frames * channels; ++i)
+                samples[i] = (i % 200 - 100) / 100.0f;
+        }
+
+        runThroughputBenchmark(QString("analysis/levels/%1/stereo_4096").arg(format.name), 20000, bytes, [&](qint64) {
+            QVector<qreal> levels = AudioLevels::levels(data.constData(), frames, channels,
+                                                        format.type, format.sampleSize);
+            benchmarkSink += qint64(levels.at(0) * 1000);
+        });
+    }
+}
+
+void benchAnalysis()
+{
+    benchFrames();
+    benchLevels();
+}
@@ -0,0 +1,67 @@
+#include <QVector>
+
+#include "benchmark.h"
+#include "convolver.h"
+#include "fft.h"
+
+///Затухающий шум вместо настоящей характеристики: цена свёртки зависит только от длины
+static QVector<float> syntheticImpulse(int frames)
+{
+    QVector<float> impulse(frames * Convolver::Channels);
+    quint32 state = 2463534242u;
+    float envelope = 0.5f;
+    for (int i = 0; i < impulse.size(); ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        impulse[i] = envelope * (float(state & 0xffff) / 32768.0f - 1.0f);
+        envelope *= 0.99998f;
+    }
+    return impulse;
+}
+
+static void benchFft(int size)
+{
+    Fft fft;
+    fft.configure(size);
+    QVector<float> time(size, 0.25f), re(size / 2), im(size / 2);
+    runThroughputBenchmark(QString("convolver/fft_roundtrip/%1").arg(size), 20000, size * qint64(sizeof(float)), [&](qint64) {
+        fft.forward(time.constData(), re.data(), im.data());
+        fft.inverse(re.data(), im.data(), time.data());
+        time[0] = 0.25f;
+        benchmarkSink += qint64(time[1]);
+    });
+}
+
+///Итерация — один блок, то есть одно прямое и одно обратное БПФ на канал
+///и полная сумма по кольцу. Доля ядра в реальном времени — ns/итерацию,
+///делённое на длительность блока (blockFrames / 48000 с)
+static void benchPartitioned(int taps, int blockFrames)
+{
+    const QVector<float> impulse = syntheticImpulse(taps);
+    Convolver convolver;
+    convolver.configure(48000);
+    convolver.setBlockFrames(blockFrames);
+    convolver.setImpulseResponse(impulse.constData(), taps, Convolver::Channels, 48000);
+
+    QVector<float> buffer(blockFrames * Convolver::Channels, 0.1f);
+    const qint64 iterations = qMax(50, 20000 * 512 / taps);
+    runThroughputBenchmark(QString("convolver/2x%1_taps/block_%2").arg(taps).arg(blockFrames), iterations,
+                           buffer.size() * qint64(sizeof(float)), [&](qint64) {
+        convolver.process(buffer.data(), blockFrames);
+        buffer[0] = 0.1f;
+        benchmarkSink += qint64(buffer[1] * 1000);
+    });
+}
+
+void benchConvolver()
+{
+    benchFft(256);
+    benchFft(1024);
+    benchFft(4096);
+
+    static const int blocks[] = { 128, 256, 512, 1024, 2048 };
+    for (int block : blocks)
+        benchPartitioned(131072, block);
+    benchPartitioned(65536, 512);
+}
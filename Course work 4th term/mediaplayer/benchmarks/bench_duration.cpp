@@ -0,0 +1,45 @@
+#include "benchmark.h"
+#include "durationestimator.h"
+
+#include <QByteArray>
+
+///Кадр MPEG-1 Layer III, 44,1 кГц, стерео, без дополнения
+static void appendFrame(QByteArray *stream, int bitrateIndex)
+{
+    static const int bitrates[15] = { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 };
+    QByteArray frame(144000 * bitrates[bitrateIndex] / 44100, '\0');
+    frame[0] = char(0xFF);
+    frame[1] = char(0xFB);
+    frame[2] = char(bitrateIndex << 4);
+    stream->append(frame);
+}
+
+///Четырёхминутный трек (~9200 кадров) в памяти: с заголовком Xing читается один кадр,
+///при постоянном битрейте — CbrProbeFrames кадров, при переменном без заголовка — все
+void benchDuration()
+{
+    const int frames = 240 * 44100 / 1152;
+
+    QByteArray cbr;
+    for (int i = 0; i < frames; ++i)
+        appendFrame(&cbr, 9);
+
+    QByteArray vbr;
+    for (int i = 0; i < frames; ++i)
+        appendFrame(&vbr, 9 + (i * 7 % 5));
+
+    QByteArray xing = vbr;
+    xing.replace(4 + 32, 12, QByteArray("Xing\0\0\0\x01\0\0\0\0", 12));
+    xing[4 + 32 + 10] = char(frames >> 8);
+    xing[4 + 32 + 11] = char(frames);
+
+    runBenchmark("duration/mpeg_xing", 1000000, [&](qint64) {
+        benchmarkSink += DurationEstimator::mpegDuration(reinterpret_cast<const uchar *>(xing.constData()), xing.size());
+    });
+    runBenchmark("duration/mpeg_cbr", 100000, [&](qint64) {
+        benchmarkSink += DurationEstimator::mpegDuration(reinterpret_cast<const uchar *>(cbr.constData()), cbr.size());
+    });
+    runThroughputBenchmark("duration/mpeg_vbr_walk", 2000, vbr.size(), [&](qint64) {
+        benchmarkSink += DurationEstimator::mpegDuration(reinterpret_cast<const uchar *>(vbr.constData()), vbr.size());
+    });
+}
@@ -0,0 +1,42 @@
+#include <QtMath>
+#include <QVector>
+#include <cstring>
+
+#include "benchmark.h"
+#include "dynamics.h"
+
+///Итерация — блок микшера в 10 мс при 48 кГц. Громкий сигнал держит
+///лимитер в работе, так что монотонная очередь всё время меняется
+static void benchStage(const QString &name, bool compressor, bool limiter, float amplitude)
+{
+    const int frames = 480;
+    QVector<float> source(frames * Dynamics::Channels);
+    quint32 state = 2463534242u;
+    for (int i = 0; i < frames; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const float noise = float(state & 0xffff) / 65536.0f - 0.5f;
+        source[i * 2] = amplitude * (float(qSin(2 * M_PI * 220 * i / 48000)) + 0.3f * noise);
+        source[i * 2 + 1] = amplitude * float(qSin(2 * M_PI * 330 * i / 48000));
+    }
+
+    Dynamics dynamics;
+    dynamics.configure(48000);
+    dynamics.setCompressorEnabled(compressor);
+    dynamics.setLimiterEnabled(limiter);
+    QVector<float> buffer = source;
+
+    runThroughputBenchmark(name, 20000, buffer.size() * qint64(sizeof(float)), [&](qint64) {
+        std::memcpy(buffer.data(), source.constData(), size_t(buffer.size()) * sizeof(float));
+        dynamics.process(buffer.data(), frames);
+        benchmarkSink += qint64(buffer[1] * 1000);
+    });
+}
+
+void benchDynamics()
+{
+    benchStage("dynamics/limiter/quiet", false, true, 0.2f);
+    benchStage("dynamics/limiter/loud", false, true, 2.0f);
+    benchStage("dynamics/compressor_limiter/loud", true, true, 2.0f);
+}
@@ -0,0 +1,42 @@
+#include <QtMath>
+#include <QVector>
+
+#include "benchmark.h"
+#include "equalizer.h"
+
+///Итерация — блок микшера в 10 мс при 48 кГц (480 кадров).
+///ns на отсчёт — ns/итерацию, делённое на кадры × каналы
+static void benchBands(const QString &name, int rate, int channels, bool flat, bool moving)
+{
+    const int frames = 480;
+    QVector<float> buffer(frames * channels);
+    for (int i = 0; i < frames; ++i) {
+        for (int c = 0; c < channels; ++c)
+            buffer[i * channels + c] = 0.3f * float(qSin(2 * M_PI * (110 + 55 * c) * i / rate));
+    }
+
+    Equalizer equalizer;
+    equalizer.configure(rate, channels);
+    for (int i = 0; i < Equalizer::Bands; ++i)
+        equalizer.setGain(i, flat ? 0.0f : (i % 2 ? 4.0f : -4.0f));
+    equalizer.reset();
+
+    runThroughputBenchmark(name, 20000, frames * channels * qint64(sizeof(float)), [&](qint64 i) {
+        ///Двигающийся ползунок: коэффициенты пересчитываются и ведутся каждый отрезок
+        if (moving)
+            equalizer.setGain(5, (i & 1) ? 6.0f : -6.0f);
+        equalizer.process(buffer.data(), frames);
+        benchmarkSink += qint64(buffer[0] * 1000);
+    });
+}
+
+void benchEqualizer()
+{
+    benchBands("equalizer/flat/48000_2ch", 48000, 2, true, false);
+    for (int rate : { 44100, 48000, 96000 }) {
+        for (int channels : { 2, 8 }) {
+            benchBands(QString("equalizer/10_bands/%1_%2ch").arg(rate).arg(channels), rate, channels, false, false);
+        }
+    }
+    benchBands("equalizer/10_bands_moving/48000_2ch", 48000, 2, false, true);
+}
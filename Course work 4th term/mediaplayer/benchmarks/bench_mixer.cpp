@@ -0,0 +1,40 @@
+#include <QtMath>
+#include <QVector>
+
+#include "benchmark.h"
+#include "audiomixer.h"
+
+///Блок 10 мс при 48 кГц: запись каждого потока в кольцо и сведение.
+///Звук ключа — синус выше порога, чтобы приглушение реально работало
+static void benchMixerBlock(const QString &name, int streams, bool ducking)
+{
+    const int rate = 48000;
+    const int block = rate / 100;
+
+    AudioMixer mixer;
+    mixer.configure(rate, block, streams, rate);
+    if (ducking)
+        mixer.setDucking(0, 1, -40, 12, 20, 500);
+    for (int s = 0; s < streams; ++s)
+        mixer.setGain(s, 0.8f);
+
+    QVector<float> input(block * AudioMixer::Channels);
+    for (int i = 0; i < block; ++i)
+        input[i * 2] = input[i * 2 + 1] = 0.5f * float(qSin(2 * M_PI * 440 * i / rate));
+    QVector<float> output(block * AudioMixer::Channels);
+
+    runBenchmark(name, 20000, [&](qint64 i) {
+        for (int s = 0; s < streams; ++s)
+            mixer.write(s, input.constData(), block);
+        mixer.process(output.data(), block);
+        benchmarkSink += qint64(output[int(i % block) * 2] * 1000);
+    });
+}
+
+void benchMixer()
+{
+    benchMixerBlock("mixer/10ms_block/2_streams", 2, false);
+    benchMixerBlock("mixer/10ms_block/2_streams_ducking", 2, true);
+    benchMixerBlock("mixer/10ms_block/4_streams", 4, false);
+    benchMixerBlock("mixer/10ms_block/8_streams_ducking", 8, true);
+}
@@ -0,0 +1,48 @@
+#include "benchmark.h"
+#include "playbackorder.h"
+
+///Очередь на миллион треков: шаг, правка при вставке, дописывании и удалении, перестройка круга
+void benchPlaybackOrder()
+{
+    const int tracks = 1000000;
+
+    PlaybackOrder order(1);
+    order.reset(tracks);
+    order.setMode(PlaybackOrder::Shuffle);
+
+    runBenchmark("playback_order/1M/next", 10000000, [&](qint64) {
+        benchmarkSink += order.next();
+    });
+
+    runBenchmark("playback_order/1M/previous", 10000000, [&](qint64) {
+        benchmarkSink += order.previous();
+    });
+
+    runBenchmark("playback_order/1M/set_current", 1000000, [&](qint64 i) {
+        order.setCurrent(int((i * 7919) % tracks));
+        benchmarkSink += order.position();
+    });
+
+    runBenchmark("playback_order/1M/insert_remove", 20, [&](qint64 i) {
+        const int index = int((i * 104729) % tracks);
+        order.insert(index, 1);
+        order.remove(index, 1);
+        benchmarkSink += order.current();
+    });
+
+    ///Импорт папки: треки приходят в конец по одному, очередь растёт с миллиона
+    runBenchmark("playback_order/1M/append_one", 100000, [&](qint64) {
+        order.insert(order.count(), 1);
+        benchmarkSink += order.count();
+    });
+
+    runBenchmark("playback_order/1M/shuffle", 10, [&](qint64 i) {
+        order.setMode(i % 2 ? PlaybackOrder::Shuffle : PlaybackOrder::Sequential);
+        benchmarkSink += order.trackAt(0);
+    });
+
+    runBenchmark("playback_order/1M/weighted", 5, [&](qint64 i) {
+        order.setMode(i % 2 ? PlaybackOrder::Weighted : PlaybackOrder::Sequential);
+        benchmarkSink += order.trackAt(0);
+    });
+}
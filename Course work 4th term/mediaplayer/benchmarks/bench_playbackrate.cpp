@@ -0,0 +1,55 @@
+#include <QtMath>
+#include <QVector>
+
+#include "benchmark.h"
+#include "resampler.h"
+#include "timestretcher.h"
+
+///Буфер пробника — 4096 кадров стерео. Итерация — один буфер, поэтому доля ядра
+///при воспроизведении в реальном времени равна ns/итерацию, делённому на длительность буфера
+static QVector<float> probeBuffer(int rate, int frames)
+{
+    QVector<float> buffer(frames * 2);
+    for (int i = 0; i < frames; ++i) {
+        buffer[i * 2] = 0.4f * float(qSin(2 * M_PI * 220 * i / rate)) + 0.1f * float(qSin(2 * M_PI * 3100 * i / rate));
+        buffer[i * 2 + 1] = 0.4f * float(qSin(2 * M_PI * 330 * i / rate));
+    }
+    return buffer;
+}
+
+static void benchResample(const QString &name, int inputRate, int outputRate)
+{
+    const int frames = 4096;
+    const QVector<float> input = probeBuffer(inputRate, frames);
+    Resampler resampler;
+    resampler.configure(inputRate, outputRate);
+    QVector<float> output(resampler.maxOutputFrames(frames) * 2);
+
+    runThroughputBenchmark(name, 5000, frames * 2 * qint64(sizeof(float)), [&](qint64) {
+        benchmarkSink += resampler.process(input.constData(), frames, output.data());
+    });
+}
+
+static void benchStretch(const QString &name, int rate, double tempo)
+{
+    const int frames = 4096;
+    const QVector<float> input = probeBuffer(rate, frames);
+    TimeStretcher stretcher;
+    stretcher.configure(rate);
+    stretcher.setRate(tempo);
+    QVector<float> output(stretcher.maxOutputFrames(frames) * 2);
+
+    runThroughputBenchmark(name, 5000, frames * 2 * qint64(sizeof(float)), [&](qint64) {
+        benchmarkSink += stretcher.process(input.constData(), frames, output.data());
+    });
+}
+
+void benchPlaybackRate()
+{
+    benchResample("playback_rate/resample/44100_48000", 44100, 48000);
+    benchResample("playback_rate/resample/48000_44100", 48000, 44100);
+    benchResample("playback_rate/resample/96000_48000", 96000, 48000);
+    benchStretch("playback_rate/stretch/48000_0.5x", 48000, 0.5);
+    benchStretch("playback_rate/stretch/48000_1.5x", 48000, 1.5);
+    benchStretch("playback_rate/stretch/48000_2.0x", 48000, 2.0);
+}
@@ -0,0 +1,43 @@
+#include "benchmark.h"
+#include "playlistsequence.h"
+
+///Плейлист на миллион строк: доступ к строке, позиция трека,
+///вставка и удаление в середине, перенос выделения из тысяч строк
+void benchPlaylistSequence()
+{
+    const int tracks = 1000000;
+
+    QVector<int> ids;
+    runBenchmark("playlist_sequence/build_1M", 5, [&](qint64) {
+        PlaylistSequence sequence;
+        ids.resize(0);
+        sequence.insert(0, tracks, &ids);
+        benchmarkSink += sequence.count();
+    });
+
+    PlaylistSequence sequence;
+    ids.resize(0);
+    sequence.insert(0, tracks, &ids);
+
+    runBenchmark("playlist_sequence/1M/at", 1000000, [&](qint64 i) {
+        benchmarkSink += sequence.at(int((i * 7919) % tracks));
+    });
+
+    runBenchmark("playlist_sequence/1M/index_of", 1000000, [&](qint64 i) {
+        benchmarkSink += sequence.indexOf(ids.at(int((i * 7919) % tracks)));
+    });
+
+    runBenchmark("playlist_sequence/1M/insert_remove_middle", 100000, [&](qint64 i) {
+        const int position = int((i * 104729) % tracks);
+        sequence.insert(position, 1, nullptr);
+        sequence.remove(position, 1);
+        benchmarkSink += sequence.count();
+    });
+
+    QVector<int> rows;
+    for (int i = 0; i < 5000; ++i)
+        rows.append(i * 150);
+    runBenchmark("playlist_sequence/1M/move_5000_rows", 100, [&](qint64 i) {
+        benchmarkSink += sequence.move(rows, int((i * 104729) % tracks));
+    });
+}
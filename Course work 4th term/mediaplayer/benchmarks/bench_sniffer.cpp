@@ -0,0 +1,53 @@
+#include "benchmark.h"
+#include "audiosniffer.h"
+
+#include <QByteArray>
+
+#include <cstring>
+
+///Распознавание по первым HeaderSize байт: WAV, MP3 с тегом ID3 и без него, мусор.
+///Мусор — худший случай, перебирается каждый байт куска
+void benchSniffer()
+{
+    QByteArray wave(AudioSniffer::HeaderSize, '\0');
+    const uchar waveHeader[44] = {
+        'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 2, 0, 0x44, 0xAC, 0, 0, 0x10, 0xB1, 2, 0, 4, 0, 16, 0,
+        'd', 'a', 't', 'a', 0, 0, 0, 0
+    };
+    std::memcpy(wave.data(), waveHeader, sizeof(waveHeader));
+
+    ///MPEG-1 Layer III, 128 кбит/с, 44100 Гц: кадр 417 байт
+    QByteArray mpeg(AudioSniffer::HeaderSize, '\0');
+    for (int offset = 0; offset + 4 <= mpeg.size(); offset += 417) {
+        mpeg[offset] = char(0xFF);
+        mpeg[offset + 1] = char(0xFB);
+        mpeg[offset + 2] = char(0x90);
+        mpeg[offset + 3] = char(0x00);
+    }
+
+    QByteArray id3 = mpeg;
+    const char tag[10] = { 'I', 'D', '3', 3, 0, 0, 0, 0, 3, 106 };     // 490 байт тега
+    id3.prepend(QByteArray(500, '\0'));
+    std::memcpy(id3.data(), tag, sizeof(tag));
+    id3.truncate(AudioSniffer::HeaderSize);
+
+    QByteArray junk(AudioSniffer::HeaderSize, '\0');
+    quint32 seed = 12345;
+    for (int i = 0; i < junk.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        junk[i] = char(seed >> 24);
+    }
+
+    const struct { const char *name; const QByteArray *data; } cases[] = {
+        { "sniffer/wav", &wave },
+        { "sniffer/mp3", &mpeg },
+        { "sniffer/mp3_id3", &id3 },
+        { "sniffer/junk", &junk }
+    };
+    for (const auto &item: cases) {
+        runThroughputBenchmark(item.name, 100000, item.data->size(), [&](qint64) {
+            benchmarkSink += AudioSniffer::sniff(item.data->constData(), item.data->size());
+        });
+    }
+}
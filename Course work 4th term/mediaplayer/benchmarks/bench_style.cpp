@@ -0,0 +1,214 @@
+#include <QApplication>
+#include <QBoxLayout>
+#include <QComboBox>
+#include <QScrollBar>
+#include <QSlider>
+#include <QToolButton>
+
+#include "benchmark.h"
+#include "playlistview.h"
+#include "style.h"
+#include "ui_widget.h"
+
+///Окна с теми же именами классов, что и в плеере: общая таблица выбирает
+///правила окна по типу Widget и Player
+class Widget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Widget(QWidget *parent = nullptr) : QWidget(parent) {}
+};
+
+class Player : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Player(QWidget *parent = nullptr) : QWidget(parent) {}
+};
+
+///Окно считается готовым, когда все его виджеты отполированы: до первого показа
+///Qt откладывает разбор общей таблицы, а таблицу отдельного виджета разбирает сразу
+static void polishAll(QWidget *window)
+{
+    window->ensurePolished();
+    for (QWidget *child : window->findChildren<QWidget *>())
+        child->ensurePolished();
+}
+
+///Главное окно: форма widget.ui и кнопка громкости. В режиме perWidget
+///повторяются вызовы setStyleSheet из конструктора Widget до общей таблицы,
+///включая таблицы трёх надписей, которые тогда лежали в самой форме
+static void buildWidget(bool perWidget)
+{
+    Widget window;
+    Ui::Widget ui;
+    ui.setupUi(&window);
+
+    QToolButton *volumeButton = new QToolButton(&window);
+    volumeButton->setObjectName("btn_volume");
+    ui.gridLayout_3->addWidget(volumeButton, 0, 0);
+
+    if (perWidget) {
+        const QString labelFont = "QLabel{\n\tfont: 8pt \"Century Gothic\";}";
+        ui.currentTrack->setStyleSheet(labelFont);
+        ui.label->setStyleSheet("QLabel{\ncolor:rgb(143, 143, 143);\n\tfont: 8pt \"Century Gothic\";}");
+        ui.positionLabel->setStyleSheet(labelFont);
+
+        window.setStyleSheet(Style::getWindowStyleSheet());
+        ui.currentTrack->setStyleSheet("color:#c1c1c1;");
+        ui.btn_close->setStyleSheet(Style::getCloseStyleSheet());
+        ui.btn_maximize->setStyleSheet(Style::getMaximizeStyleSheet());
+        ui.btn_minimize->setStyleSheet(Style::getMinimizeStyleSheet());
+        ui.btn_next->setStyleSheet(Style::getNextStyleSheet());
+        ui.btn_previous->setStyleSheet(Style::getPreviousStyleSheet());
+        ui.btn_stop->setStyleSheet(Style::getStopStyleSheet());
+        ui.btn_play->setStyleSheet(Style::getPlayStyleSheet());
+        ui.btn_pause->setStyleSheet(Style::getPauseStyleSheet());
+        ui.btn_add->setStyleSheet(Style::getMenuStyleSheet());
+        ui.btn_del->setStyleSheet(Style::getRemoveStyleSheet());
+        ui.btn_add->setStyleSheet(Style::getAddStyleSheet());
+        ui.btn_random->setStyleSheet(Style::getRandomStyleSheet());
+        ui.btn_music->setStyleSheet(Style::getBtnToolStyleSheet());
+        ui.btn_video->setStyleSheet(Style::getBtnToolStyleSheet());
+
+        ui.playlistView->setStyleSheet(Style::getTableViewStyleSheet());
+        ui.positionSlider->setStyleSheet(Style::getSliderStyleSheet());
+        ui.playlistView->verticalScrollBar()->setStyleSheet(Style::getVerticalScrollBarStyleSheet());
+        ui.playlistView->horizontalScrollBar()->setStyleSheet(Style::getHorizontalScrollBarStyleSheet());
+
+        volumeButton->setStyleSheet("padding-left: 0px;"
+                                    "padding-right: 0px;"
+                                    "padding-top: 0px;"
+                                    "padding-bottom: 0px;");
+        volumeButton->setStyleSheet("QToolButton::menu-indicator{image:none;}");
+    }
+
+    polishAll(&window);
+    benchmarkSink += window.findChildren<QWidget *>().size();
+}
+
+///Панель PlayerControls без мультимедиа: те же виджеты и те же имена
+static QWidget *buildControls(QWidget *parent, bool perWidget)
+{
+    QWidget *controls = new QWidget(parent);
+    QToolButton *play = new QToolButton(controls);
+    play->setObjectName("btn_play");
+    QToolButton *stop = new QToolButton(controls);
+    stop->setObjectName("btn_stop");
+    QToolButton *next = new QToolButton(controls);
+    next->setObjectName("btn_next");
+    QToolButton *previous = new QToolButton(controls);
+    previous->setObjectName("btn_previous");
+    QToolButton *mute = new QToolButton(controls);
+    mute->setObjectName("btn_volume");
+    QSlider *volume = new QSlider(Qt::Horizontal, controls);
+    volume->setObjectName("volumeSlider");
+    QComboBox *rate = new QComboBox(controls);
+    rate->setObjectName("rateBox");
+    for (const char *item : { "0.5x", "0.75x", "1.0x", "1.25x", "1.5x", "2.0x" })
+        rate->addItem(item);
+
+    if (perWidget) {
+        play->setStyleSheet(Style::getPlayStyleSheet());
+        stop->setStyleSheet(Style::getStopStyleSheet());
+        next->setStyleSheet(Style::getNextStyleSheet());
+        previous->setStyleSheet(Style::getPreviousStyleSheet());
+        mute->setStyleSheet("padding-left: 0px;"
+                            "padding-right: 0px;"
+                            "padding-top: 0px;"
+                            "padding-bottom: 0px;");
+        controls->setStyleSheet(Style::getSliderStyleSheet2());
+        rate->setStyleSheet(Style::getComboBoxStyleSheet());
+    }
+
+    QBoxLayout *layout = new QHBoxLayout(controls);
+    layout->setMargin(0);
+    for (QWidget *widget : { static_cast<QWidget *>(stop), static_cast<QWidget *>(previous),
+                             static_cast<QWidget *>(play), static_cast<QWidget *>(next),
+                             static_cast<QWidget *>(mute), static_cast<QWidget *>(volume),
+                             static_cast<QWidget *>(rate) })
+        layout->addWidget(widget);
+    return controls;
+}
+
+///Окно видео и музыки: стилизуемые виджеты конструктора Player
+///(виды плейлистов, ползунки, кнопки, две панели управления) без мультимедиа
+static void buildPlayer(bool perWidget)
+{
+    Player window;
+    QVBoxLayout *layout = new QVBoxLayout(&window);
+
+    for (int page = 0; page < 2; ++page) {
+        PlaylistView *view = new PlaylistView(&window);
+        view->setObjectName("playlistView");
+        QSlider *slider = new QSlider(Qt::Horizontal, &window);
+        slider->setObjectName("positionSlider");
+        QToolButton *add = new QToolButton(&window);
+        add->setObjectName("btn_add");
+        QToolButton *remove = new QToolButton(&window);
+        remove->setObjectName("btn_del");
+        QWidget *controls = buildControls(&window, perWidget);
+
+        if (perWidget) {
+            view->verticalScrollBar()->setStyleSheet(Style::getVerticalScrollBarStyleSheet());
+            view->horizontalScrollBar()->setStyleSheet(Style::getHorizontalScrollBarStyleSheet());
+            slider->setStyleSheet(Style::getSliderStyleSheet());
+            add->setStyleSheet(Style::getAddStyleSheet());
+            remove->setStyleSheet(Style::getRemoveStyleSheet());
+        }
+
+        QHBoxLayout *row = new QHBoxLayout;
+        row->addWidget(add);
+        row->addWidget(remove);
+        row->addWidget(controls);
+        layout->addWidget(view);
+        layout->addWidget(slider);
+        layout->addLayout(row);
+    }
+
+    QToolButton *fullScreen = new QToolButton(&window);
+    fullScreen->setObjectName("btn_fullScreen");
+    QToolButton *color = new QToolButton(&window);
+    color->setObjectName("btn_color");
+    layout->addWidget(fullScreen);
+    layout->addWidget(color);
+
+    if (perWidget) {
+        window.setStyleSheet(Style::getWindowStyleSheet());
+        fullScreen->setStyleSheet(Style::getFullStyleSheet());
+        color->setStyleSheet(Style::getSettingsStyleSheet());
+    }
+
+    polishAll(&window);
+    benchmarkSink += window.findChildren<QWidget *>().size();
+}
+
+///Построение окна и полировка всех его виджетов: по таблице на каждый виджет,
+///как до общей таблицы, и с одной таблицей приложения. Установка самой общей
+///таблицы в main() делается один раз и замеряется отдельно
+void benchStyle()
+{
+    qApp->setStyleSheet(QString());
+    runBenchmark("style/widget/per_widget_sheets", 200, [&](qint64) {
+        buildWidget(true);
+    });
+    runBenchmark("style/player/per_widget_sheets", 200, [&](qint64) {
+        buildPlayer(true);
+    });
+
+    runBenchmark("style/application_sheet/install", 20, [&](qint64) {
+        qApp->setStyleSheet(QString());
+        qApp->setStyleSheet(Style::applicationStyleSheet());
+    });
+    runBenchmark("style/widget/application_sheet", 200, [&](qint64) {
+        buildWidget(false);
+    });
+    runBenchmark("style/player/application_sheet", 200, [&](qint64) {
+        buildPlayer(false);
+    });
+    qApp->setStyleSheet(QString());
+}
+
+#include "bench_style.moc"
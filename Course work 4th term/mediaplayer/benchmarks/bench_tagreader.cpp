@@ -0,0 +1,54 @@
+#include "benchmark.h"
+#include "tagreader.h"
+
+#include <QByteArray>
+
+static void appendFrame(QByteArray *tag, const char *id, const QByteArray &content)
+{
+    const int size = content.size();
+    tag->append(id, 4);
+    tag->append(char(size >> 24)).append(char(size >> 16)).append(char(size >> 8)).append(char(size));
+    tag->append(2, '\0');
+    tag->append(content);
+}
+
+///Начало и хвост файла уже в памяти: ID3v2.3 с текстом в UTF-16 и обложкой
+///впереди текстовых кадров, ID3v1 в хвосте. Один замер — один файл
+void benchTagReader()
+{
+    QByteArray frames;
+    appendFrame(&frames, "APIC", QByteArray(8000, '\x55'));
+    appendFrame(&frames, "TIT2", QByteArray("\x01\xFF\xFE" "T\0i\0t\0l\0e\0", 13));
+    appendFrame(&frames, "TPE1", QByteArray("\x01\xFF\xFE" "A\0r\0t\0i\0s\0t\0", 15));
+    appendFrame(&frames, "TALB", QByteArray("\x00" "Album", 6));
+    appendFrame(&frames, "TRCK", QByteArray("\x00" "4/12", 5));
+    appendFrame(&frames, "TYER", QByteArray("\x00" "1999", 5));
+    appendFrame(&frames, "TCON", QByteArray("\x00" "(17)", 5));
+    frames.append(1024, '\0');
+
+    const int size = frames.size();
+    QByteArray head("ID3\x03\x00\x00", 6);
+    head.append(char((size >> 21) & 0x7F)).append(char((size >> 14) & 0x7F))
+        .append(char((size >> 7) & 0x7F)).append(char(size & 0x7F));
+    head.append(frames);
+    head.append(TagReader::HeadSize - head.size() % TagReader::HeadSize, '\xFB');
+
+    QByteArray tail(TagReader::TailSize, '\0');
+    tail.replace(tail.size() - 128, 3, "TAG");
+
+    const uchar *headData = reinterpret_cast<const uchar *>(head.constData());
+    const uchar *tailData = reinterpret_cast<const uchar *>(tail.constData());
+    runBenchmark("tag_reader/id3v2_utf16_apic", 200000, [&](qint64) {
+        TagReader::Tags tags;
+        TagReader::parse(headData, head.size(), tailData, tail.size(), 4 * 1024 * 1024, &tags);
+        benchmarkSink += tags.track + tags.title.size();
+    });
+
+    const QByteArray noTag(TagReader::HeadSize, '\xFB');
+    runBenchmark("tag_reader/no_tags", 200000, [&](qint64) {
+        TagReader::Tags tags;
+        benchmarkSink += TagReader::parse(reinterpret_cast<const uchar *>(noTag.constData()), noTag.size(),
+                                          reinterpret_cast<const uchar *>(noTag.constData()), TagReader::TailSize,
+                                          4 * 1024 * 1024, &tags);
+    });
+}
@@ -0,0 +1,63 @@
+#include <QTime>
+
+#include "benchmark.h"
+#include "timeformat.h"
+
+///Прежний вариант из Player::updateDurationInfo
+static QString formatWithQTime(qint64 currentInfo, qint64 duration)
+{
+    QString tStr;
+    if (currentInfo || duration) {
+        QTime currentTime((currentInfo / 3600) % 60, (currentInfo / 60) % 60,
+            currentInfo % 60, (currentInfo * 1000) % 1000);
+        QTime totalTime((duration / 3600) % 60, (duration / 60) % 60,
+            duration % 60, (duration * 1000) % 1000);
+        QString format = "mm:ss";
+        if (duration > 3600)
+            format = "hh:mm:ss";
+        tStr = currentTime.toString(format) + " / " + totalTime.toString(format);
+    }
+    return tStr;
+}
+
+///Прежний formatTime из Widget
+static QString formatWithArg(qint64 timeMilliSeconds)
+{
+    qint64 seconds = timeMilliSeconds / 1000;
+    const qint64 minutes = seconds / 60;
+    seconds -= minutes * 60;
+    return QStringLiteral("%1:%2").arg(minutes, 2, 10, QLatin1Char('0')).arg(seconds, 2, 10, QLatin1Char('0'));
+}
+
+void benchTimeFormat()
+{
+    const qint64 iterations = 1000000;
+    const qint64 duration = 2 * 3600 + 17;
+
+    runBenchmark("timeformat/duration/qtime", iterations, [&](qint64 i) {
+        benchmarkSink += formatWithQTime(i % duration, duration).size();
+    });
+
+    TimeFormat durationFormat;
+    runBenchmark("timeformat/duration/timeformat", iterations, [&](qint64 i) {
+        durationFormat.setTime(i % duration, duration);
+        benchmarkSink += durationFormat.size();
+    });
+
+    ///Тики позиции идут чаще смены секунды, поэтому часть вызовов попадает в быстрый путь
+    TimeFormat tickFormat;
+    runBenchmark("timeformat/duration/timeformat_ticks", iterations, [&](qint64 i) {
+        if (tickFormat.setTime((i / 4) % duration, duration))
+            benchmarkSink += tickFormat.size();
+    });
+
+    runBenchmark("timeformat/position/arg", iterations, [&](qint64 i) {
+        benchmarkSink += formatWithArg(i * 1000).size();
+    });
+
+    TimeFormat positionFormat;
+    runBenchmark("timeformat/position/timeformat", iterations, [&](qint64 i) {
+        positionFormat.setTime(i);
+        benchmarkSink += positionFormat.size();
+    });
+}
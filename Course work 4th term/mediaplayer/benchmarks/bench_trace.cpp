@@ -0,0 +1,26 @@
+#include "benchmark.h"
+#include "trace.h"
+
+///Стоимость одного TRACE_SCOPE вокруг пустого тела
+void benchTrace()
+{
+    const qint64 iterations = 10000000;
+
+    Trace::setEnabled(false);
+    runBenchmark("trace/scope/disabled", iterations, [&](qint64 i) {
+        TRACE_SCOPE("bench", "disabled");
+        benchmarkSink += i;
+    });
+
+    Trace::setEnabled(true);
+    runBenchmark("trace/scope/enabled", iterations, [&](qint64 i) {
+        TRACE_SCOPE("bench", "enabled");
+        benchmarkSink += i;
+    });
+    Trace::setEnabled(false);
+
+    runBenchmark("trace/flush/8192_events", 20, [&](qint64) {
+        benchmarkSink += Trace::chromeEvents().size();
+    });
+    Trace::clear();
+}
@@ -0,0 +1,31 @@
+#include "benchmark.h"
+
+#include <QTextStream>
+
+volatile qint64 benchmarkSink = 0;
+
+static QString benchmarkFilter;
+
+void setBenchmarkFilter(const QString &filter)
+{
+    benchmarkFilter = filter;
+}
+
+bool benchmarkEnabled(const QString &name)
+{
+    return benchmarkFilter.isEmpty() || name.contains(benchmarkFilter);
+}
+
+void reportBenchmark(const QString &name, qint64 iterations, qint64 elapsedNs, qint64 bytesPerIteration)
+{
+    static QTextStream out(stdout);
+    QString line = QString("{\"name\":\"%1\",\"iterations\":%2,\"ns_per_iteration\":%3")
+            .arg(name)
+            .arg(iterations)
+            .arg(iterations ? double(elapsedNs) / iterations : 0.0, 0, 'f', 2);
+    if (bytesPerIteration > 0 && elapsedNs > 0)
+        line += QString(",\"bytes_per_iteration\":%1,\"mb_per_s\":%2")
+                .arg(bytesPerIteration)
+                .arg(double(bytesPerIteration) * iterations * 1000.0 / elapsedNs, 0, 'f', 1);
+    out << line << "}" << endl;
+}
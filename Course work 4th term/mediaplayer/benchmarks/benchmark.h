@@ -0,0 +1,56 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+///Защищает результат замера от удаления оптимизатором
+extern volatile qint64 benchmarkSink;
+
+///Печатает результат замера одной JSON-строкой.
+///Если известен объём данных за итерацию, добавляется пропускная способность в МБ/с
+void reportBenchmark(const QString &name, qint64 iterations, qint64 elapsedNs, qint64 bytesPerIteration = 0);
+
+///Запускаются только замеры, в имени которых есть подстрока фильтра
+void setBenchmarkFilter(const QString &filter);
+bool benchmarkEnabled(const QString &name);
+
+template <class Body>
+void runThroughputBenchmark(const QString &name, qint64 iterations, qint64 bytesPerIteration, Body body)
+{
+    if (!benchmarkEnabled(name))
+        return;
+
+    ///Прогрев кэшей и предсказателя переходов
+    for (qint64 i = 0; i < iterations / 10; ++i)
+        body(i);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 i = 0; i < iterations; ++i)
+        body(i);
+    reportBenchmark(name, iterations, timer.nsecsElapsed(), bytesPerIteration);
+}
+
+template <class Body>
+void runBenchmark(const QString &name, qint64 iterations, Body body)
+{
+    runThroughputBenchmark(name, iterations, 0, body);
+}
+
+void benchTimeFormat();
+void benchMixer();
+void benchAnalysis();
+void benchTrace();
+void benchPlaybackOrder();
+void benchPlaylistSequence();
+void benchSniffer();
+void benchTagReader();
+void benchDuration();
+void benchPlaybackRate();
+void benchEqualizer();
+void benchConvolver();
+void benchDynamics();
+void benchStyle();
+
+#endif // BENCHMARK_H
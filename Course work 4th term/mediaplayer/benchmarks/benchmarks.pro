@@ -0,0 +1,81 @@
+#-------------------------------------------------
+#
+# Микробенчмарки горячих участков медиаплеера.
+# Запуск: benchmarks [фильтр], результаты выводятся по одной JSON-строке на замер
+#
+#-------------------------------------------------
+
+QT       += core gui widgets
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = benchmarks
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+include(../analysis/analysis.pri)
+
+SOURCES += \
+        main.cpp \
+    benchmark.cpp \
+    bench_timeformat.cpp \
+    bench_mixer.cpp \
+    bench_analysis.cpp \
+    bench_trace.cpp \
+    bench_playbackorder.cpp \
+    bench_playlistsequence.cpp \
+    bench_sniffer.cpp \
+    bench_tagreader.cpp \
+    bench_duration.cpp \
+    bench_playbackrate.cpp \
+    bench_equalizer.cpp \
+    bench_convolver.cpp \
+    bench_dynamics.cpp \
+    bench_style.cpp \
+    ../timeformat.cpp \
+    ../audiomixer.cpp \
+    ../trace.cpp \
+    ../playbackorder.cpp \
+    ../playlistsequence.cpp \
+    ../audiosniffer.cpp \
+    ../tagreader.cpp \
+    ../wavfile.cpp \
+    ../durationestimator.cpp \
+    ../resampler.cpp \
+    ../timestretcher.cpp \
+    ../equalizer.cpp \
+    ../fft.cpp \
+    ../convolver.cpp \
+    ../dynamics.cpp \
+    ../style.cpp \
+    ../playlistview.cpp
+
+HEADERS += \
+        benchmark.h \
+    ../timeformat.h \
+    ../audiomixer.h \
+    ../trace.h \
+    ../playbackorder.h \
+    ../playlistsequence.h \
+    ../audiosniffer.h \
+    ../tagreader.h \
+    ../wavfile.h \
+    ../durationestimator.h \
+    ../resampler.h \
+    ../timestretcher.h \
+    ../equalizer.h \
+    ../fft.h \
+    ../convolver.h \
+    ../dynamics.h \
+    ../style.h \
+    ../playlistview.h
+
+FORMS += \
+    ../widget.ui
+
+RESOURCES += \
+    ../buttons.qrc
@@ -0,0 +1,31 @@
+#include <QApplication>
+
+#include "benchmark.h"
+
+int main(int argc, char *argv[])
+{
+    ///Замерам окон не нужен экран
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+
+    if (a.arguments().size() > 1)
+        setBenchmarkFilter(a.arguments().at(1));
+
+    benchTimeFormat();
+    benchMixer();
+    benchAnalysis();
+    benchTrace();
+    benchPlaybackOrder();
+    benchPlaylistSequence();
+    benchSniffer();
+    benchTagReader();
+    benchDuration();
+    benchPlaybackRate();
+    benchEqualizer();
+    benchConvolver();
+    benchDynamics();
+    benchStyle();
+
+    return 0;
+}
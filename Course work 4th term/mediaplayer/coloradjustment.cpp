@@ -0,0 +1,237 @@
+#include "coloradjustment.h"
+
+#include <QtMath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLORADJUSTMENT_SSE2
+#endif
+
+static inline uchar clampByte(int value)
+{
+    return uchar(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+ColorAdjustment::ColorAdjustment()
+{
+    rebuild();
+}
+
+void ColorAdjustment::setBrightness(int brightness)
+{
+    m_brightness = qBound(-100, brightness, 100);
+    rebuild();
+}
+
+void ColorAdjustment::setContrast(int contrast)
+{
+    m_contrast = qBound(-100, contrast, 100);
+    rebuild();
+}
+
+void ColorAdjustment::setHue(int hue)
+{
+    m_hue = qBound(-100, hue, 100);
+    rebuild();
+}
+
+void ColorAdjustment::setSaturation(int saturation)
+{
+    m_saturation = qBound(-100, saturation, 100);
+    rebuild();
+}
+
+///Читатель сначала отмечается в копии, потом проверяет, что она всё ещё текущая.
+///Если между чтением номера и отметкой её успели сменить, отметка снимается
+///и берётся новая текущая: в нетекущую копию, которую он не успел закрепить, он не смотрит.
+///Отметка и переключение — полные барьеры, поэтому писатель, выбирающий копию
+///после переключения, увидит отметку любого читателя, прошедшего проверку
+ColorAdjustment::Snapshot::Snapshot(const ColorAdjustment *owner)
+    : m_owner(owner)
+{
+    if (!m_owner)
+        return;
+
+    for (;;) {
+        m_index = m_owner->m_current.loadAcquire();
+        m_owner->m_readers[m_index].fetchAndAddOrdered(1);
+        if (m_owner->m_current.loadAcquire() == m_index)
+            break;
+        m_owner->m_readers[m_index].fetchAndAddRelease(-1);
+    }
+}
+
+ColorAdjustment::Snapshot::~Snapshot()
+{
+    if (m_owner)
+        m_owner->m_readers[m_index].fetchAndAddRelease(-1);
+}
+
+///Пересчёт в копию, которая не текущая и никем не закреплена, затем атомарное
+///переключение. Закреплённые копии не переписываются, поэтому кадр, уже взявший
+///снимок, дообрабатывается старыми значениями целиком, а следующий берёт новые
+void ColorAdjustment::rebuild()
+{
+    const int current = m_current.loadAcquire();
+    int next = -1;
+    while (next < 0) {
+        for (int i = 0; i < TableCount; ++i) {
+            if (i != current && m_readers[i].loadAcquire() == 0) {
+                next = i;
+                break;
+            }
+        }
+    }
+    Tables &t = m_tables[next];
+
+    const double c = (m_contrast + 100) / 100.0;
+    const double b = m_brightness * 1.275;
+    const double s = (m_saturation + 100) / 100.0;
+    const double angle = m_hue / 100.0 * M_PI;
+    const double hueCos = s * qCos(angle);
+    const double hueSin = s * qSin(angle);
+
+    t.identity = !m_brightness && !m_contrast && !m_hue && !m_saturation;
+
+    for (int y = 0; y < 256; ++y)
+        t.luma[y] = clampByte(qRound((y - 128) * c + 128 + b));
+
+    for (int u = 0; u < 256; ++u) {
+        for (int v = 0; v < 256; ++v) {
+            double cu = u - 128;
+            double cv = v - 128;
+            int outU = clampByte(qRound(128 + cu * hueCos - cv * hueSin));
+            int outV = clampByte(qRound(128 + cu * hueSin + cv * hueCos));
+            t.chroma[(u << 8) | v] = quint16((outU << 8) | outV);
+        }
+    }
+
+    ///Для RGB все четыре настройки складываются в одну аффинную матрицу:
+    ///RGB -> YUV (BT.601), коррекция, YUV -> RGB
+    const double toYuv[3][3] = {
+        {  0.299,     0.587,     0.114    },
+        { -0.168736, -0.331264,  0.5      },
+        {  0.5,      -0.418688, -0.081312 }
+    };
+    const double adjust[3][3] = {
+        { c, 0,       0        },
+        { 0, hueCos, -hueSin   },
+        { 0, hueSin,  hueCos   }
+    };
+    const double toRgb[3][3] = {
+        { 1,  0,         1.402    },
+        { 1, -0.344136, -0.714136 },
+        { 1,  1.772,     0        }
+    };
+
+    double tmp[3][3];
+    double linear[3][3];
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j) {
+            tmp[i][j] = 0;
+            for (int k = 0; k < 3; ++k)
+                tmp[i][j] += adjust[i][k] * toYuv[k][j];
+        }
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j) {
+            linear[i][j] = 0;
+            for (int k = 0; k < 3; ++k)
+                linear[i][j] += toRgb[i][k] * tmp[k][j];
+        }
+
+    ///Строки матрицы — выходные каналы B, G, R; столбцы — входные B, G, R и смещение.
+    ///Коэффициенты в формате Q8, смещение делится на 64, так как умножается на 64
+    const double offset = 128 * (1 - c) + b;
+    for (int out = 0; out < 3; ++out) {
+        int row = 2 - out;  // linear хранит строки в порядке R, G, B
+        t.matrix[out][0] = qint16(qRound(linear[row][2] * 256));
+        t.matrix[out][1] = qint16(qRound(linear[row][1] * 256));
+        t.matrix[out][2] = qint16(qRound(linear[row][0] * 256));
+        t.matrix[out][3] = qint16(qRound(offset * 4) + 2);
+    }
+
+    m_current.fetchAndStoreOrdered(next);
+}
+
+void ColorAdjustment::Snapshot::processLuma(const uchar *in, uchar *out, int count) const
+{
+    const uchar *lut = tables().luma;
+    for (int i = 0; i < count; ++i)
+        out[i] = lut[in[i]];
+}
+
+void ColorAdjustment::Snapshot::processChroma(const uchar *inU, const uchar *inV, uchar *outU, uchar *outV, int count) const
+{
+    const quint16 *lut = tables().chroma;
+    for (int i = 0; i < count; ++i) {
+        quint16 uv = lut[(inU[i] << 8) | inV[i]];
+        outU[i] = uchar(uv >> 8);
+        outV[i] = uchar(uv);
+    }
+}
+
+///Чередующиеся пары: UV для NV12, VU для NV21
+void ColorAdjustment::Snapshot::processChromaInterleaved(const uchar *in, uchar *out, int count, bool swapped) const
+{
+    const quint16 *lut = tables().chroma;
+    const int u = swapped ? 1 : 0;
+    const int v = 1 - u;
+    for (int i = 0; i < count; ++i, in += 2, out += 2) {
+        quint16 uv = lut[(in[u] << 8) | in[v]];
+        out[u] = uchar(uv >> 8);
+        out[v] = uchar(uv);
+    }
+}
+
+///Пиксели Format_RGB32 и Format_ARGB32 (байты B, G, R, A). Альфа ARGB32 переносится
+///как есть (keepAlpha), у RGB32 она всегда 255. По четыре пикселя за итерацию SSE2
+void ColorAdjustment::Snapshot::processRgb32(const uchar *in, uchar *out, int count, bool keepAlpha) const
+{
+    const qint16 (*m)[4] = tables().matrix;
+    int i = 0;
+
+#ifdef COLORADJUSTMENT_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colorMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i offsetLane = _mm_set_epi16(64, 0, 0, 0, 64, 0, 0, 0);
+    const __m128i opaque = _mm_set1_epi32(255);
+    __m128i coef[3];
+    for (int c = 0; c < 3; ++c)
+        coef[c] = _mm_set_epi16(m[c][3], m[c][2], m[c][1], m[c][0],
+                                m[c][3], m[c][2], m[c][1], m[c][0]);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 4));
+        __m128i lo = _mm_or_si128(_mm_and_si128(_mm_unpacklo_epi8(pixels, zero), colorMask), offsetLane);
+        __m128i hi = _mm_or_si128(_mm_and_si128(_mm_unpackhi_epi8(pixels, zero), colorMask), offsetLane);
+
+        __m128i channel[3];
+        for (int c = 0; c < 3; ++c) {
+            __m128i sumLo = _mm_madd_epi16(lo, coef[c]);
+            __m128i sumHi = _mm_madd_epi16(hi, coef[c]);
+            sumLo = _mm_add_epi32(sumLo, _mm_srli_epi64(sumLo, 32));
+            sumHi = _mm_add_epi32(sumHi, _mm_srli_epi64(sumHi, 32));
+            sumLo = _mm_shuffle_epi32(sumLo, _MM_SHUFFLE(3, 3, 2, 0));
+            sumHi = _mm_shuffle_epi32(sumHi, _MM_SHUFFLE(3, 3, 2, 0));
+            channel[c] = _mm_srai_epi32(_mm_unpacklo_epi64(sumLo, sumHi), 8);
+        }
+
+        __m128i bg = _mm_packs_epi32(channel[0], channel[1]);
+        __m128i alpha = keepAlpha ? _mm_srli_epi32(pixels, 24) : opaque;
+        __m128i ra = _mm_packs_epi32(channel[2], alpha);
+        __m128i bgPairs = _mm_unpacklo_epi16(bg, _mm_srli_si128(bg, 8));
+        __m128i raPairs = _mm_unpacklo_epi16(ra, _mm_srli_si128(ra, 8));
+        __m128i first = _mm_unpacklo_epi32(bgPairs, raPairs);
+        __m128i second = _mm_unpackhi_epi32(bgPairs, raPairs);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 4), _mm_packus_epi16(first, second));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const uchar *p = in + i * 4;
+        uchar *q = out + i * 4;
+        for (int c = 0; c < 3; ++c)
+            q[c] = clampByte((p[0] * m[c][0] + p[1] * m[c][1] + p[2] * m[c][2] + 64 * m[c][3]) >> 8);
+        q[3] = keepAlpha ? p[3] : 255;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef COLORADJUSTMENT_H
+#define COLORADJUSTMENT_H
+
+#include <QAtomicInt>
+#include <QtGlobal>
+
+///Программная цветокоррекция кадра: яркость, контраст, оттенок и насыщенность
+///сворачиваются в заранее посчитанные таблицы. Для YUV это таблица яркостной
+///плоскости и общая таблица пары (U, V), для RGB — единая аффинная матрица.
+///Движение ползунков только пересчитывает таблицы, кадр обрабатывается за один проход
+class ColorAdjustment
+{
+private:
+    struct Tables
+    {
+        uchar luma[256];
+        quint16 chroma[256 * 256];
+        qint16 matrix[3][4];
+        bool identity = true;
+    };
+
+    ///Копий три: текущая, та, что ещё держит обработчик кадра, и свободная под пересчёт.
+    ///Кадры копирует один поток, поэтому свободная копия есть всегда
+    static const int TableCount = 3;
+
+    Tables m_tables[TableCount];
+    mutable QAtomicInt m_readers[TableCount];
+    QAtomicInt m_current;
+
+    int m_brightness = 0;
+    int m_contrast = 0;
+    int m_hue = 0;
+    int m_saturation = 0;
+
+    void rebuild();
+
+public:
+    ///Таблицы, закреплённые на время обработки одного кадра.
+    ///Пока снимок жив, rebuild() не пишет в его копию, и все строки кадра
+    ///обрабатываются одними и теми же значениями. Без источника — тождественный
+    class Snapshot
+    {
+    private:
+        const ColorAdjustment *m_owner = nullptr;
+        int m_index = 0;
+
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        const Tables &tables() const { return m_owner->m_tables[m_index]; }
+
+    public:
+        explicit Snapshot(const ColorAdjustment *owner);
+        ~Snapshot();
+
+        bool isIdentity() const { return !m_owner || tables().identity; }
+
+        void processLuma(const uchar *in, uchar *out, int count) const;
+        void processChroma(const uchar *inU, const uchar *inV, uchar *outU, uchar *outV, int count) const;
+        void processChromaInterleaved(const uchar *in, uchar *out, int count, bool swapped) const;
+        void processRgb32(const uchar *in, uchar *out, int count, bool keepAlpha) const;
+    };
+
+    ColorAdjustment();
+
+    int brightness() const { return m_brightness; }
+    int contrast() const { return m_contrast; }
+    int hue() const { return m_hue; }
+    int saturation() const { return m_saturation; }
+
+    void setBrightness(int brightness);
+    void setContrast(int contrast);
+    void setHue(int hue);
+    void setSaturation(int saturation);
+};
+
+#endif // COLORADJUSTMENT_H
@@ -0,0 +1,384 @@
+#include "convolver.h"
+
+#include <QCoreApplication>
+#include <cstring>
+
+#include "resampler.h"
+#include "wavfile.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONVOLVER_SSE2
+#endif
+
+static inline quint32 floatBits(float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bitsFloat(quint32 bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+///Хвост тише -120 дБ при загрузке отрезается, чтобы не считать пустые куски
+static const float silence = 1e-6f;
+
+///Предел предвзвода в кадрах исходной частоты: 44.1 ↔ 48 кГц дают шаг 147 и 160
+static const int maxPreRoll = 1024;
+
+static int greatestCommonDivisor(int a, int b)
+{
+    while (b) {
+        const int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+///Сколько кадров исходной частоты хватит на MaxTaps после приведения частоты
+static qint64 sourceLimit(int sourceRate, int sampleRate)
+{
+    return qint64(Convolver::MaxTaps) * sourceRate / sampleRate + 1;
+}
+
+Convolver::Convolver()
+    : m_mix(floatBits(1.0f))
+{
+}
+
+Convolver::~Convolver()
+{
+    delete m_engine;
+    delete m_stale;
+    delete m_pending.fetchAndStoreAcquire(nullptr);
+    delete m_retired.fetchAndStoreAcquire(nullptr);
+}
+
+///Новая частота — характеристика пересобирается. Хвост прошлого
+///воспроизведения в любом случае сбрасывается, чтобы не прозвучать при старте
+void Convolver::configure(int sampleRate)
+{
+    sampleRate = qMax(1, sampleRate);
+    if (sampleRate != m_sampleRate) {
+        m_sampleRate = sampleRate;
+        if (isLoaded())
+            post(build());
+    }
+    if (m_engine)
+        resetEngine(m_engine);
+    m_currentMix = mix();
+}
+
+bool Convolver::load(const QString &fileName)
+{
+    WavFile file;
+    if (!file.open(fileName)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+
+    const WavFile::Format &format = file.format();
+    const qint64 frames = qMin(file.frameCount(), sourceLimit(format.sampleRate, m_sampleRate));
+
+    QVector<float> samples(int(frames * format.channels));
+    qint64 frame = 0;
+    while (frame < frames) {
+        qint64 count = 0;
+        const uchar *data = file.map(frame, frames - frame, &count);
+        if (!data || !WavFile::convertToFloat(data, format, count, samples.data() + frame * format.channels)) {
+            m_errorString = QCoreApplication::translate("Convolver", "Cannot read impulse response samples");
+            return false;
+        }
+        frame += count;
+    }
+
+    setImpulseResponse(samples.constData(), int(frames), format.channels, format.sampleRate);
+    m_fileName = fileName;
+    m_errorString.clear();
+    return true;
+}
+
+///Моно идёт в оба канала, из многоканальной берутся первые два
+void Convolver::setImpulseResponse(const float *interleaved, int frames, int channels, int sampleRate)
+{
+    m_fileName.clear();
+    if (frames <= 0 || channels <= 0 || sampleRate <= 0) {
+        clear();
+        return;
+    }
+
+    frames = int(qMin<qint64>(frames, sourceLimit(sampleRate, m_sampleRate)));
+    m_sourceRate = sampleRate;
+    m_source.resize(frames * Channels);
+    for (int i = 0; i < frames; ++i) {
+        const float *in = interleaved + qint64(i) * channels;
+        m_source[i * Channels] = in[0];
+        m_source[i * Channels + 1] = in[channels > 1 ? 1 : 0];
+    }
+    post(build());
+}
+
+void Convolver::clear()
+{
+    m_source.clear();
+    m_sourceRate = 0;
+    m_taps = 0;
+    m_delay = 0;
+    m_fileName.clear();
+    post(new Engine);
+}
+
+void Convolver::setBlockFrames(int frames)
+{
+    int block = MinBlockFrames;
+    while (block < frames && block < MaxBlockFrames)
+        block *= 2;
+    if (block == m_blockFrames)
+        return;
+    m_blockFrames = block;
+    if (isLoaded())
+        post(build());
+}
+
+void Convolver::setMix(float wet)
+{
+    m_mix.storeRelease(floatBits(qBound(0.0f, wet, 1.0f)));
+}
+
+float Convolver::mix() const
+{
+    return bitsFloat(m_mix.loadAcquire());
+}
+
+///Характеристика приводится к частоте вывода и нормируется на отношение
+///частот (отсчётов станет больше или меньше, а площадь должна остаться той же).
+///Фильтр ресемплера симметричен, и его левая половина для первых отсчётов
+///легла бы на кадры до начала характеристики: без предвзвода она обрезается,
+///и короткая характеристика теряет часть усиления (дельта 44.1 → 48 кГц — около 8 %
+///на постоянном сигнале). Поэтому перед характеристикой ставится не меньше
+///Resampler::MaxTaps / 2 нулевых кадров, а за ней — MaxTaps, чтобы досчитался
+///правый хвост. Предвзвод остаётся в характеристике задержкой: его отсчёты
+///и есть отрезанная иначе половина фильтра. Сухой сигнал задерживается на столько же
+///(Engine::delay), иначе при частичном смешивании они дали бы гребенчатый фильтр.
+///Предвзвод берётся кратным шагу ресемплера по входу — тогда после приведения
+///он равен целому числу кадров и сухой сигнал совпадает с мокрым точно.
+///Для нестандартных пар частот, где такой шаг больше maxPreRoll, берётся
+///MaxTaps / 2 и задержка округляется — расхождение не больше полукадра
+Convolver::Engine *Convolver::build()
+{
+    const float *impulse = m_source.constData();
+    int frames = m_source.size() / Channels;
+    float scale = 1.0f;
+
+    int delay = 0;
+    QVector<float> resampled;
+    if (m_sourceRate != m_sampleRate) {
+        const int step = m_sourceRate / greatestCommonDivisor(m_sourceRate, m_sampleRate);
+        const int minimum = Resampler::MaxTaps / 2;
+        const int preRoll = step <= maxPreRoll ? (minimum + step - 1) / step * step : minimum;
+        delay = int((qint64(preRoll) * m_sampleRate + m_sourceRate / 2) / m_sourceRate);
+        const int padded = preRoll + frames + Resampler::MaxTaps;
+        QVector<float> source(padded * Channels, 0.0f);
+        std::memcpy(source.data() + preRoll * Channels, m_source.constData(), size_t(m_source.size()) * sizeof(float));
+        Resampler resampler;
+        resampler.configure(m_sourceRate, m_sampleRate, padded);
+        resampled.resize(resampler.maxOutputFrames(padded) * Channels);
+        frames = resampler.process(source.constData(), padded, resampled.data());
+        impulse = resampled.constData();
+        scale = float(m_sourceRate) / m_sampleRate;
+    }
+
+    while (frames > 0 && qAbs(impulse[frames * Channels - 1]) < silence && qAbs(impulse[frames * Channels - 2]) < silence)
+        --frames;
+    frames = qMin(frames, int(MaxTaps));
+    m_taps = frames;
+    m_delay = delay;
+
+    Engine *engine = new Engine;
+    const int block = m_blockFrames;
+    const int size = 2 * block;
+    engine->fft.configure(size);
+    engine->blockFrames = block;
+    engine->partitions = qMax(1, (frames + block - 1) / block);
+    engine->kernel.fill(0.0f, engine->partitions * Channels * size);
+    engine->spectra.fill(0.0f, engine->partitions * Channels * size);
+    engine->input.fill(0.0f, Channels * size);
+    engine->output.fill(0.0f, block * Channels);
+    engine->accumulator.fill(0.0f, size);
+    engine->time.fill(0.0f, size);
+    engine->delay = delay;
+    engine->delayLine.fill(0.0f, delay * Channels);
+
+    ///Обратное БПФ не нормировано и даёт x · N / 2 — множитель 2 / N уходит в куски.
+    ///Кусок дополнен нулями до 2 · blockFrames: последние blockFrames отсчётов
+    ///круговой свёртки с окном входа [прошлый, текущий] совпадают с линейной
+    scale *= 2.0f / size;
+    float *time = engine->time.data();
+    for (int p = 0; p < engine->partitions; ++p) {
+        for (int c = 0; c < Channels; ++c) {
+            for (int n = 0; n < size; ++n) {
+                const int i = p * block + n;
+                time[n] = n < block && i < frames ? impulse[i * Channels + c] * scale : 0.0f;
+            }
+            float *spectrum = engine->kernel.data() + (p * Channels + c) * size;
+            engine->fft.forward(time, spectrum, spectrum + block);
+        }
+    }
+    return engine;
+}
+
+///Старая сборка, которую поток вывода уже вернул, удаляется здесь.
+///Вывод кладёт в m_retired только в пустой слот, поэтому вернуть сборку
+///между двумя строками ниже он может, а затереть неудалённую — нет
+void Convolver::post(Engine *engine)
+{
+    delete m_retired.fetchAndStoreAcquire(nullptr);
+    delete m_pending.fetchAndStoreOrdered(engine);
+}
+
+void Convolver::resetEngine(Engine *engine)
+{
+    engine->spectra.fill(0.0f);
+    engine->input.fill(0.0f);
+    engine->output.fill(0.0f);
+    engine->delayLine.fill(0.0f);
+    engine->head = 0;
+    engine->fill = 0;
+    engine->delayHead = 0;
+}
+
+///Сухой сигнал берётся из прошлого блока входа, поэтому он выровнен
+///с мокрым, который считается по тому же блоку; предвзвод характеристики
+///добавляется к нему кольцом delayLine
+void Convolver::process(float *interleaved, int frames)
+{
+    ///Пока старая сборка не возвращена, новая не забирается: её, если придёт
+    ///следующая, удалит сам post(), и у вывода не копится больше одной старой
+    if (m_stale && m_retired.testAndSetRelease(nullptr, m_stale))
+        m_stale = nullptr;
+    if (!m_stale) {
+        if (Engine *next = m_pending.fetchAndStoreAcquire(nullptr)) {
+            if (m_engine && !m_retired.testAndSetRelease(nullptr, m_engine))
+                m_stale = m_engine;
+            m_engine = next;
+        }
+    }
+
+    Engine *engine = m_engine;
+    if (!engine || engine->partitions == 0 || frames <= 0)
+        return;
+
+    const int block = engine->blockFrames;
+    const int delay = engine->delay;
+    const float mixFrom = m_currentMix;
+    const float mixTo = mix();
+    const float mixStep = (mixTo - mixFrom) / frames;
+
+    int done = 0;
+    while (done < frames) {
+        const int count = qMin(frames - done, block - engine->fill);
+        for (int c = 0; c < Channels; ++c) {
+            float *input = engine->input.data() + c * 2 * block + engine->fill;
+            const float *wet = engine->output.constData() + engine->fill * Channels + c;
+            float *sample = interleaved + done * Channels + c;
+            float *line = engine->delayLine.data() + c;
+            int tap = engine->delayHead;
+            for (int n = 0; n < count; ++n, sample += Channels, wet += Channels) {
+                float dry = input[n];
+                if (delay) {
+                    const float delayed = line[tap * Channels];
+                    line[tap * Channels] = dry;
+                    dry = delayed;
+                    if (++tap == delay)
+                        tap = 0;
+                }
+                const float amount = mixFrom + mixStep * (done + n + 1);
+                input[block + n] = *sample;
+                *sample = dry + (*wet - dry) * amount;
+            }
+        }
+        if (delay)
+            engine->delayHead = (engine->delayHead + count) % delay;
+        engine->fill += count;
+        done += count;
+
+        if (engine->fill == block) {
+            runBlock(engine);
+            engine->fill = 0;
+        }
+    }
+    m_currentMix = mixTo;
+}
+
+///Новый блок кладётся в кольцо на место самого старого; кусок p характеристики
+///умножается на спектр, пришедший p блоков назад
+void Convolver::runBlock(Engine *engine)
+{
+    const int block = engine->blockFrames;
+    const int size = 2 * block;
+    const int partitions = engine->partitions;
+    float *accumulator = engine->accumulator.data();
+    float *time = engine->time.data();
+
+    for (int c = 0; c < Channels; ++c) {
+        float *input = engine->input.data() + c * size;
+        float *newest = engine->spectra.data() + (engine->head * Channels + c) * size;
+        engine->fft.forward(input, newest, newest + block);
+
+        std::memset(accumulator, 0, size_t(size) * sizeof(float));
+        const float *kernel = engine->kernel.constData() + c * size;
+        for (int p = 0; p < partitions; ++p) {
+            int slot = engine->head - p;
+            if (slot < 0)
+                slot += partitions;
+            multiplyAccumulate(engine->spectra.constData() + (slot * Channels + c) * size,
+                               kernel + p * Channels * size, accumulator, block);
+        }
+
+        engine->fft.inverse(accumulator, accumulator + block, time);
+        float *out = engine->output.data() + c;
+        for (int n = 0; n < block; ++n)
+            out[n * Channels] = time[block + n];
+
+        std::memcpy(input, input + block, size_t(block) * sizeof(float));
+    }
+
+    engine->head = engine->head + 1 < partitions ? engine->head + 1 : 0;
+}
+
+void Convolver::multiplyAccumulate(const float *x, const float *h, float *acc, int bins)
+{
+    const float *xr = x, *xi = x + bins;
+    const float *hr = h, *hi = h + bins;
+    float *ar = acc, *ai = acc + bins;
+
+    const float dc = ar[0] + xr[0] * hr[0];
+    const float nyquist = ai[0] + xi[0] * hi[0];
+
+    int k = 0;
+#ifdef CONVOLVER_SSE2
+    for (; k + 4 <= bins; k += 4) {
+        const __m128 a = _mm_loadu_ps(xr + k), b = _mm_loadu_ps(xi + k);
+        const __m128 c = _mm_loadu_ps(hr + k), d = _mm_loadu_ps(hi + k);
+        const __m128 re = _mm_sub_ps(_mm_mul_ps(a, c), _mm_mul_ps(b, d));
+        const __m128 im = _mm_add_ps(_mm_mul_ps(a, d), _mm_mul_ps(b, c));
+        _mm_storeu_ps(ar + k, _mm_add_ps(_mm_loadu_ps(ar + k), re));
+        _mm_storeu_ps(ai + k, _mm_add_ps(_mm_loadu_ps(ai + k), im));
+    }
+#endif
+    for (; k < bins; ++k) {
+        const float re = xr[k] * hr[k] - xi[k] * hi[k];
+        const float im = xr[k] * hi[k] + xi[k] * hr[k];
+        ar[k] += re;
+        ai[k] += im;
+    }
+
+    ar[0] = dc;
+    ai[0] = nyquist;
+}
@@ -0,0 +1,112 @@
+#ifndef CONVOLVER_H
+#define CONVOLVER_H
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QString>
+#include <QVector>
+
+#include "fft.h"
+
+///Свёртка float-стерео с длинной импульсной характеристикой (коррекция
+///комнаты, реверберация) — равномерно разбитое перекрытие с сохранением.
+///Характеристика режется на куски по blockFrames() отсчётов, спектры кусков
+///(БПФ размера 2 · blockFrames) считаются заранее. Спектры входных блоков
+///лежат в кольце той же длины — частотной линии задержки, и каждый выходной
+///блок — одно прямое и одно обратное БПФ плюс сумма произведений кольца
+///на куски характеристики. Задержка — blockFrames кадров, от длины
+///характеристики не зависит; если частота характеристики другая, к ней
+///добавляется предвзвод ресемплера (см. build()).
+///Всё для новой характеристики (таблицы, спектры, кольцо) собирается в потоке
+///интерфейса и передаётся потоку вывода указателем; тот подхватывает его
+///на границе своего вызова. Поток вывода памяти не выделяет и не освобождает
+class Convolver
+{
+public:
+    static const int Channels = 2;
+    static const int MinBlockFrames = 64;
+    static const int MaxBlockFrames = 8192;
+    static const int DefaultBlockFrames = 512;
+    ///Длиннее характеристика обрезается: 2^18 — около 5,5 с при 48 кГц
+    static const int MaxTaps = 1 << 18;
+
+private:
+    ///Характеристика, готовая к свёртке. Без кусков — свёртка выключена
+    struct Engine
+    {
+        Fft fft;
+        int blockFrames = 0;
+        int partitions = 0;
+        QVector<float> kernel;      // куски × каналы × (re, im по blockFrames)
+        QVector<float> spectra;     // кольцо спектров входа в той же раскладке
+        QVector<float> input;       // по каналам: прошлый и текущий блок входа
+        QVector<float> output;      // мокрый сигнал прошлого блока, каналы чередуются
+        QVector<float> accumulator; // re, im
+        QVector<float> time;
+        QVector<float> delayLine;   // сухой сигнал на время предвзвода, каналы чередуются
+        int delay = 0;              // предвзвод в кадрах вывода
+        int head = 0;               // кусок кольца с самым новым блоком
+        int fill = 0;               // кадров текущего блока уже собрано
+        int delayHead = 0;
+    };
+
+    ///Только поток вывода
+    Engine *m_engine = nullptr;
+    Engine *m_stale = nullptr;          // старая сборка, которую ещё некуда вернуть
+    float m_currentMix = 1.0f;
+
+    ///Передача между потоками: интерфейс кладёт, вывод забирает и возвращает старую
+    QAtomicPointer<Engine> m_pending;
+    QAtomicPointer<Engine> m_retired;
+    QAtomicInteger<quint32> m_mix;      // биты float
+
+    ///Только поток интерфейса: характеристика как загружена, для пересборки
+    QVector<float> m_source;
+    int m_sourceRate = 0;
+    int m_sampleRate = 48000;
+    int m_blockFrames = DefaultBlockFrames;
+    int m_taps = 0;
+    int m_delay = 0;
+    QString m_fileName;
+    QString m_errorString;
+
+    Engine *build();
+    void post(Engine *engine);
+    static void resetEngine(Engine *engine);
+    static void runBlock(Engine *engine);
+
+public:
+    Convolver();
+    ~Convolver();
+
+    ///Вызывать только при остановленном выводе
+    void configure(int sampleRate);
+
+    ///Вызываются из потока интерфейса
+    bool load(const QString &fileName);
+    void setImpulseResponse(const float *interleaved, int frames, int channels, int sampleRate);
+    void clear();
+    ///Округляется до степени двойки в пределах MinBlockFrames…MaxBlockFrames
+    void setBlockFrames(int frames);
+    ///Доля обработанного сигнала; сухой сигнал задерживается вместе с ним
+    void setMix(float wet);
+
+    bool isLoaded() const { return !m_source.isEmpty(); }
+    QString fileName() const { return m_fileName; }
+    QString errorString() const { return m_errorString; }
+    int sampleRate() const { return m_sampleRate; }
+    int blockFrames() const { return m_blockFrames; }
+    int latencyFrames() const { return isLoaded() ? m_blockFrames + m_delay : 0; }
+    ///Отсчётов характеристики на канал после приведения к частоте вывода
+    int taps() const { return m_taps; }
+    float mix() const;
+
+    ///Вызывается из потока вывода
+    void process(float *interleaved, int frames);
+
+    ///acc += x · h по bins бинам; x, h и acc — re, затем im.
+    ///В бине 0 лежат два вещественных значения (0 и N/2), они умножаются порознь
+    static void multiplyAccumulate(const float *x, const float *h, float *acc, int bins);
+};
+
+#endif // CONVOLVER_H
@@ -0,0 +1,169 @@
+#include "coverartloader.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+///Удаление самых давно прочитанных файлов, пока кэш на диске больше лимита.
+///Время изменения файла обновляется при каждом чтении, поэтому вытеснение LRU
+static void trimDiskCache(const QString &path, qint64 limit)
+{
+    QFileInfoList files = QDir(path).entryInfoList(QStringList() << "*.png", QDir::Files);
+    qint64 total = 0;
+    for (const QFileInfo &info : files)
+        total += info.size();
+    if (total <= limit)
+        return;
+
+    std::sort(files.begin(), files.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return a.lastModified() < b.lastModified();
+    });
+    for (const QFileInfo &info : files) {
+        if (total <= limit)
+            break;
+        if (QFile::remove(info.filePath()))
+            total -= info.size();
+    }
+}
+
+///Задача рабочего потока: найти миниатюру на диске или декодировать
+///исходное изображение сразу в нужном размере
+class CoverArtTask : public QRunnable
+{
+private:
+    CoverArtLoader *m_loader;
+    QString m_key;
+    QUrl m_url;
+    QSize m_size;
+    QString m_diskCachePath;
+    qint64 m_diskCacheLimit;
+
+public:
+    CoverArtTask(CoverArtLoader *loader, const QString &key, const QUrl &url,
+                 const QSize &size, const QString &diskCachePath, qint64 diskCacheLimit)
+        : m_loader(loader), m_key(key), m_url(url), m_size(size),
+          m_diskCachePath(diskCachePath), m_diskCacheLimit(diskCacheLimit)
+    {
+    }
+
+    void run() override
+    {
+        QString source = m_url.isLocalFile() ? m_url.toLocalFile() : m_url.toString();
+        QFileInfo sourceInfo(source);
+
+        ///Имя файла на диске учитывает время изменения исходника
+        QByteArray diskKey = m_key.toUtf8() + '|'
+                + QByteArray::number(sourceInfo.lastModified().toMSecsSinceEpoch());
+        QString diskFile = m_diskCachePath.isEmpty()
+                ? QString()
+                : m_diskCachePath + '/' + QCryptographicHash::hash(diskKey, QCryptographicHash::Sha1).toHex() + ".png";
+
+        QImage image;
+        if (!diskFile.isEmpty() && QFileInfo::exists(diskFile) && image.load(diskFile, "PNG")) {
+            QFile file(diskFile);
+            if (file.open(QIODevice::Append))
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+
+        if (image.isNull()) {
+            QImageReader reader(source);
+            reader.setAutoTransform(true);
+            ///Масштабирование при декодировании: для JPEG это в разы дешевле полного декодирования
+            if (reader.size().isValid() && m_size.isValid())
+                reader.setScaledSize(reader.size().scaled(m_size, Qt::KeepAspectRatio));
+            image = reader.read();
+
+            if (!image.isNull() && !diskFile.isEmpty()) {
+                QSaveFile file(diskFile);
+                if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG") && file.commit())
+                    trimDiskCache(m_diskCachePath, m_diskCacheLimit);
+            }
+        }
+
+        QMetaObject::invokeMethod(m_loader, "imageDecoded", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_key), Q_ARG(QUrl, m_url), Q_ARG(QImage, image));
+    }
+};
+
+CoverArtLoader::CoverArtLoader(QObject *parent)
+    : QObject(parent), m_diskCacheLimit(64 * 1024 * 1024)
+{
+    m_cache.setMaxCost(8 * 1024 * 1024);
+    m_pool.setMaxThreadCount(2);
+
+    QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheLocation.isEmpty() && QDir().mkpath(cacheLocation + "/covers"))
+        m_diskCachePath = cacheLocation + "/covers";
+}
+
+CoverArtLoader::~CoverArtLoader()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+int CoverArtLoader::cacheLimit() const
+{
+    return m_cache.maxCost();
+}
+
+///Ограничение кэша в памяти в байтах декодированных миниатюр
+void CoverArtLoader::setCacheLimit(int bytes)
+{
+    m_cache.setMaxCost(bytes);
+}
+
+qint64 CoverArtLoader::diskCacheLimit() const
+{
+    return m_diskCacheLimit;
+}
+
+///Ограничение кэша на диске в байтах файлов миниатюр.
+///Проверяется после записи каждой новой миниатюры
+void CoverArtLoader::setDiskCacheLimit(qint64 bytes)
+{
+    m_diskCacheLimit = bytes;
+}
+
+QString CoverArtLoader::cacheKey(const QUrl &url, const QSize &size)
+{
+    return QString("%1|%2x%3").arg(url.toString()).arg(size.width()).arg(size.height());
+}
+
+///Запрос обложки в размере отображения. Ответ приходит сигналом coverReady:
+///сразу, если миниатюра уже в кэше, иначе после декодирования в рабочем потоке
+void CoverArtLoader::request(const QUrl &url, const QSize &size)
+{
+    if (url.isEmpty())
+        return;
+
+    QString key = cacheKey(url, size);
+    if (QImage *image = m_cache.object(key)) {
+        emit coverReady(url, *image);
+        return;
+    }
+
+    if (m_pending.contains(key))
+        return;
+
+    m_pending.insert(key);
+    m_pool.start(new CoverArtTask(this, key, url, size, m_diskCachePath, m_diskCacheLimit));
+}
+
+void CoverArtLoader::imageDecoded(const QString &key, const QUrl &url, const QImage &image)
+{
+    m_pending.remove(key);
+
+    if (!image.isNull())
+        m_cache.insert(key, new QImage(image), int(image.sizeInBytes()));
+
+    emit coverReady(url, image);
+}
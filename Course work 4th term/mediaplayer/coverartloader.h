@@ -0,0 +1,48 @@
+#ifndef COVERARTLOADER_H
+#define COVERARTLOADER_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+#include <QUrl>
+
+///Сервис обложек: декодирование и масштабирование выполняются в рабочем потоке,
+///готовые миниатюры хранятся в LRU-кэше, ограниченном по объёму в байтах,
+///и в кэше на диске с вытеснением давно не читанных файлов,
+///поэтому одна и та же обложка не декодируется дважды
+class CoverArtLoader : public QObject
+{
+    Q_OBJECT
+
+private:
+    QCache<QString, QImage> m_cache;
+    QSet<QString> m_pending;
+    QThreadPool m_pool;
+    QString m_diskCachePath;
+    qint64 m_diskCacheLimit;
+
+    static QString cacheKey(const QUrl &url, const QSize &size);
+
+private slots:
+    void imageDecoded(const QString &key, const QUrl &url, const QImage &image);
+
+public:
+    explicit CoverArtLoader(QObject *parent = nullptr);
+    ~CoverArtLoader();
+
+    int cacheLimit() const;
+    void setCacheLimit(int bytes);
+
+    qint64 diskCacheLimit() const;
+    void setDiskCacheLimit(qint64 bytes);
+
+    void request(const QUrl &url, const QSize &size);
+
+signals:
+    void coverReady(const QUrl &url, const QImage &image);
+};
+
+#endif // COVERARTLOADER_H
@@ -0,0 +1,134 @@
+#include "durationestimator.h"
+
+#include <QFile>
+#include <cstring>
+
+#include "wavfile.h"
+
+static inline quint32 readBe32(const uchar *p)
+{
+    return quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | quint32(p[3]);
+}
+
+static inline quint32 readLe32(const uchar *p)
+{
+    return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+}
+
+static inline bool sameStream(const AudioSniffer::MpegFrame &a, const AudioSniffer::MpegFrame &b)
+{
+    return a.version == b.version && a.layer == b.layer && a.sampleRate == b.sampleRate;
+}
+
+///Первый кадр, за которым сразу идёт ещё один кадр того же потока
+static qint64 findFirstFrame(const uchar *data, qint64 from, qint64 end, AudioSniffer::MpegFrame *frame)
+{
+    const qint64 limit = qMin(end, from + 64 * 1024);
+    for (qint64 offset = from; offset + 4 <= limit; ++offset) {
+        if (data[offset] != 0xFF || !AudioSniffer::parseMpegFrame(data + offset, frame) || frame->length == 0)
+            continue;
+
+        const qint64 next = offset + frame->length;
+        AudioSniffer::MpegFrame nextFrame;
+        if (next + 4 > end || (AudioSniffer::parseMpegFrame(data + next, &nextFrame) && sameStream(*frame, nextFrame)))
+            return offset;
+    }
+    return -1;
+}
+
+///Xing/Info лежит сразу за побочной информацией первого кадра, VBRI — всегда через 32 байта
+qint64 DurationEstimator::vbrFrameCount(const uchar *frame, qint64 available, const AudioSniffer::MpegFrame &header)
+{
+    const int sideInfo = header.version == 10 ? (header.channels == 1 ? 17 : 32)
+                                              : (header.channels == 1 ? 9 : 17);
+    const qint64 xing = 4 + sideInfo;
+    if (xing + 12 <= available && (!std::memcmp(frame + xing, "Xing", 4) || !std::memcmp(frame + xing, "Info", 4))) {
+        if (readBe32(frame + xing + 4) & 1)
+            return readBe32(frame + xing + 8);
+    }
+
+    const qint64 vbri = 4 + 32;
+    if (vbri + 18 <= available && !std::memcmp(frame + vbri, "VBRI", 4))
+        return readBe32(frame + vbri + 14);
+
+    return -1;
+}
+
+qint64 DurationEstimator::mpegDuration(const uchar *data, qint64 size)
+{
+    qint64 begin = AudioSniffer::id3Size(data, int(qMin<qint64>(size, 10)));
+    qint64 end = size;
+
+    ///Теги в хвосте: ID3v1 и перед ним APEv2
+    if (end >= 128 && !std::memcmp(data + end - 128, "TAG", 3))
+        end -= 128;
+    if (end >= 32 && !std::memcmp(data + end - 32, "APETAGEX", 8)) {
+        const qint64 apeSize = readLe32(data + end - 32 + 12) + ((readLe32(data + end - 32 + 20) & 0x80000000u) ? 32 : 0);
+        end = qMax(begin, end - apeSize);
+    }
+
+    AudioSniffer::MpegFrame first;
+    const qint64 start = findFirstFrame(data, begin, end, &first);
+    if (start < 0)
+        return -1;
+
+    const qint64 vbrFrames = vbrFrameCount(data + start, end - start, first);
+    if (vbrFrames > 0)
+        return vbrFrames * first.samplesPerFrame * 1000 / first.sampleRate;
+
+    ///Обход кадров. Если первые CbrProbeFrames кадров с одним битрейтом — дальше
+    ///не читаем: длительность следует из объёма данных
+    qint64 frames = 0;
+    qint64 offset = start;
+    bool constant = true;
+    while (offset + 4 <= end) {
+        AudioSniffer::MpegFrame frame;
+        if (!AudioSniffer::parseMpegFrame(data + offset, &frame) || frame.length == 0 || !sameStream(frame, first)) {
+            ///Мусор внутри потока: ищем следующий кадр
+            const qint64 next = findFirstFrame(data, offset + 1, end, &frame);
+            if (next < 0)
+                break;
+            offset = next;
+            continue;
+        }
+
+        constant = constant && frame.bitrate == first.bitrate;
+        if (constant && frames + 1 == CbrProbeFrames)
+            return (end - start) * 8 / first.bitrate;
+
+        ++frames;
+        offset += frame.length;
+    }
+
+    return frames > 0 ? frames * first.samplesPerFrame * 1000 / first.sampleRate : -1;
+}
+
+qint64 DurationEstimator::estimate(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    const QByteArray header = file.read(AudioSniffer::HeaderSize);
+    const AudioSniffer::Format format = AudioSniffer::sniff(header.constData(), header.size());
+
+    if (format == AudioSniffer::Wave || format == AudioSniffer::Rf64) {
+        file.close();
+        WavFile wave;
+        if (!wave.open(fileName))
+            return -1;
+        return wave.frameCount() * 1000 / wave.format().sampleRate;
+    }
+
+    if (format != AudioSniffer::Mpeg)
+        return -1;
+
+    ///Отображается весь файл, но с диска читаются только страницы с заголовками
+    const qint64 size = file.size();
+    uchar *data = file.map(0, size);
+    if (!data)
+        return -1;
+    const qint64 duration = mpegDuration(data, size);
+    file.unmap(data);
+    return duration;
+}
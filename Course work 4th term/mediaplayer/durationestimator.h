@@ -0,0 +1,29 @@
+#ifndef DURATIONESTIMATOR_H
+#define DURATIONESTIMATOR_H
+
+#include <QString>
+
+#include "audiosniffer.h"
+
+///Длительность трека по заголовкам контейнера, без декодирования.
+///WAV/RF64 — размер data, делённый на размер кадра из fmt.
+///MP3 — число кадров из заголовка Xing/Info или VBRI в первом кадре;
+///без них — постоянный битрейт, если первые кадры одинаковы, иначе обход
+///заголовков всех кадров (4 байта на кадр, файл отображён в память).
+///Результат в миллисекундах, -1 — длительность не определить
+class DurationEstimator
+{
+public:
+    ///Столько первых кадров с одним битрейтом считается признаком CBR
+    static const int CbrProbeFrames = 64;
+
+    static qint64 estimate(const QString &fileName);
+
+    ///data — весь файл MP3 (с тегами)
+    static qint64 mpegDuration(const uchar *data, qint64 size);
+
+    ///Число кадров из заголовка Xing/Info или VBRI первого кадра; -1, если его нет
+    static qint64 vbrFrameCount(const uchar *frame, qint64 available, const AudioSniffer::MpegFrame &header);
+};
+
+#endif // DURATIONESTIMATOR_H
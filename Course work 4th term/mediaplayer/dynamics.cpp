@@ -0,0 +1,231 @@
+#include "dynamics.h"
+
+#include <QtMath>
+#include <cstring>
+
+static inline quint32 floatBits(float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bitsFloat(quint32 bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+///Шаг однополюсного сглаживания за кадр для постоянной времени в миллисекундах
+static inline float coefficient(float milliseconds, int sampleRate)
+{
+    if (milliseconds <= 0)
+        return 1.0f;
+    return float(1.0 - qExp(-1.0 / (milliseconds * 0.001 * sampleRate)));
+}
+
+static inline float dbToGain(float db)
+{
+    return float(qPow(10.0, db / 20.0));
+}
+
+Dynamics::Dynamics()
+    : m_compressorEnabled(0),
+      m_limiterEnabled(1),
+      m_peakReduction(floatBits(0.0f))
+{
+    setCompressor(-18.0f, 3.0f, 6.0f, 5.0f, 150.0f, 0.0f);
+    setLimiter(-1.0f, 60.0f);
+    configure(48000);
+}
+
+///Перестраивает буферы. Вызывать только при остановленном выводе
+void Dynamics::configure(int sampleRate)
+{
+    m_sampleRate = qMax(1, sampleRate);
+    m_lookahead = qMax(1, qRound(m_sampleRate * LookaheadMs / 1000.0));
+
+    m_delay.fill(0.0f, m_lookahead * Channels);
+    m_window.fill(1.0f, m_lookahead + 1);
+    m_dequeValue.fill(1.0f, m_lookahead + 1);
+    m_dequeFrame.fill(0, m_lookahead + 1);
+    reset();
+}
+
+void Dynamics::reset()
+{
+    m_delay.fill(0.0f);
+    m_window.fill(1.0f);
+    m_windowSum = m_window.size();
+    m_dequeFirst = 0;
+    m_dequeSize = 0;
+    m_frame = 0;
+    m_delayPos = 0;
+    m_windowPos = 0;
+    m_limiterGain = 1.0f;
+    m_envelope = 0.0f;
+    m_compressorGain = 1.0f;
+}
+
+void Dynamics::setCompressorEnabled(bool enabled)
+{
+    m_compressorEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+void Dynamics::setCompressor(float thresholdDb, float ratio, float kneeDb, float attackMs, float releaseMs, float makeupDb)
+{
+    m_threshold.storeRelease(floatBits(qBound(-60.0f, thresholdDb, 0.0f)));
+    m_ratio.storeRelease(floatBits(qBound(1.0f, ratio, 50.0f)));
+    m_knee.storeRelease(floatBits(qBound(0.0f, kneeDb, 24.0f)));
+    m_attack.storeRelease(floatBits(qMax(0.0f, attackMs)));
+    m_release.storeRelease(floatBits(qMax(0.0f, releaseMs)));
+    m_makeup.storeRelease(floatBits(qBound(0.0f, makeupDb, 24.0f)));
+}
+
+void Dynamics::setLimiterEnabled(bool enabled)
+{
+    m_limiterEnabled.storeRelease(enabled ? 1 : 0);
+}
+
+void Dynamics::setLimiter(float ceilingDb, float releaseMs)
+{
+    m_ceiling.storeRelease(floatBits(qBound(-24.0f, ceilingDb, 0.0f)));
+    m_limiterRelease.storeRelease(floatBits(qMax(0.0f, releaseMs)));
+}
+
+bool Dynamics::isCompressorEnabled() const
+{
+    return m_compressorEnabled.loadAcquire() != 0;
+}
+
+bool Dynamics::isLimiterEnabled() const
+{
+    return m_limiterEnabled.loadAcquire() != 0;
+}
+
+float Dynamics::ceiling() const
+{
+    return bitsFloat(m_ceiling.loadAcquire());
+}
+
+float Dynamics::takeGainReduction()
+{
+    return bitsFloat(m_peakReduction.fetchAndStoreAcquire(floatBits(0.0f)));
+}
+
+///Колено шириной knee вокруг порога: ослабление растёт квадратично,
+///выше колена — прямая с наклоном 1/ratio
+float Dynamics::gainComputer(float levelDb, float thresholdDb, float ratio, float kneeDb)
+{
+    const float over = levelDb - thresholdDb;
+    const float slope = 1.0f / ratio - 1.0f;
+    if (2 * over <= -kneeDb)
+        return 0.0f;
+    if (2 * qAbs(over) < kneeDb)
+        return slope * (over + kneeDb / 2) * (over + kneeDb / 2) / (2 * kneeDb);
+    return slope * over;
+}
+
+float Dynamics::compressorGain(float envelope) const
+{
+    if (!isCompressorEnabled())
+        return 1.0f;
+    const float levelDb = 20.0f * float(qLn(qMax(envelope, 1e-6f)) / M_LN10);
+    return dbToGain(gainComputer(levelDb, bitsFloat(m_threshold.loadAcquire()), bitsFloat(m_ratio.loadAcquire()),
+                                 bitsFloat(m_knee.loadAcquire())) + bitsFloat(m_makeup.loadAcquire()));
+}
+
+void Dynamics::publishReduction(float minimumGain)
+{
+    const float reduction = minimumGain < 1.0f ? -20.0f * float(qLn(qMax(minimumGain, 1e-6f)) / M_LN10) : 0.0f;
+    const quint32 bits = floatBits(reduction);
+    for (;;) {
+        const quint32 current = m_peakReduction.loadAcquire();
+        if (bits <= current || m_peakReduction.testAndSetRelease(current, bits))
+            return;
+    }
+}
+
+void Dynamics::process(float *interleaved, int frames)
+{
+    const float attack = coefficient(bitsFloat(m_attack.loadAcquire()), m_sampleRate);
+    const float release = coefficient(bitsFloat(m_release.loadAcquire()), m_sampleRate);
+    const float ceiling = isLimiterEnabled() ? dbToGain(this->ceiling()) : 1e30f;
+    const float limiterRelease = coefficient(bitsFloat(m_limiterRelease.loadAcquire()), m_sampleRate);
+
+    const int capacity = m_lookahead + 1;
+    const float windowScale = 1.0f / capacity;
+    float *delay = m_delay.data();
+    float *window = m_window.data();
+    float *dequeValue = m_dequeValue.data();
+    quint32 *dequeFrame = m_dequeFrame.data();
+    float minimumGain = 1.0f;
+
+    for (int start = 0; start < frames; start += ControlFrames) {
+        const int count = qMin(int(ControlFrames), frames - start);
+        const float gainFrom = m_compressorGain;
+        const float gainTo = compressorGain(m_envelope);
+        const float gainStep = (gainTo - gainFrom) / count;
+
+        float *sample = interleaved + start * Channels;
+        for (int n = 0; n < count; ++n, sample += Channels) {
+            ///Компрессор: детектор по входу, усиление — по кривой от прошлого отрезка
+            const float left = sample[0];
+            const float right = sample[1];
+            const float peak = qMax(qAbs(left), qAbs(right));
+            m_envelope += (peak - m_envelope) * (peak > m_envelope ? attack : release);
+            const float compressor = gainFrom + gainStep * (n + 1);
+            const float l = left * compressor;
+            const float r = right * compressor;
+
+            ///Лимитер: минимум нужного усиления по окну в capacity кадров
+            const float level = qMax(qAbs(l), qAbs(r));
+            const float required = level > ceiling ? ceiling / level : 1.0f;
+            if (m_dequeSize > 0 && m_frame - dequeFrame[m_dequeFirst] >= quint32(capacity)) {
+                m_dequeFirst = m_dequeFirst + 1 < capacity ? m_dequeFirst + 1 : 0;
+                --m_dequeSize;
+            }
+            while (m_dequeSize > 0) {
+                int back = m_dequeFirst + m_dequeSize - 1;
+                if (back >= capacity)
+                    back -= capacity;
+                if (dequeValue[back] < required)
+                    break;
+                --m_dequeSize;
+            }
+            int slot = m_dequeFirst + m_dequeSize;
+            if (slot >= capacity)
+                slot -= capacity;
+            dequeValue[slot] = required;
+            dequeFrame[slot] = m_frame;
+            ++m_dequeSize;
+            ++m_frame;
+
+            const float minimum = dequeValue[m_dequeFirst];
+            m_windowSum += minimum - window[m_windowPos];
+            window[m_windowPos] = minimum;
+            m_windowPos = m_windowPos + 1 < capacity ? m_windowPos + 1 : 0;
+
+            ///Вниз — сразу за средним, вверх — не быстрее спада: так усиление
+            ///остаётся не больше среднего, а значит, и нужного
+            const float smoothed = float(m_windowSum) * windowScale;
+            if (smoothed < m_limiterGain)
+                m_limiterGain = smoothed;
+            else
+                m_limiterGain += (smoothed - m_limiterGain) * limiterRelease;
+
+            float *delayed = delay + m_delayPos * Channels;
+            sample[0] = delayed[0] * m_limiterGain;
+            sample[1] = delayed[1] * m_limiterGain;
+            delayed[0] = l;
+            delayed[1] = r;
+            m_delayPos = m_delayPos + 1 < m_lookahead ? m_delayPos + 1 : 0;
+
+            minimumGain = qMin(minimumGain, compressor * m_limiterGain);
+        }
+        m_compressorGain = gainTo;
+    }
+
+    publishReduction(minimumGain);
+}
@@ -0,0 +1,92 @@
+#ifndef DYNAMICS_H
+#define DYNAMICS_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+///Обработка динамики float-стерео на выходе: компрессор с прямой связью
+///и за ним брикволл-лимитер с заглядыванием вперёд.
+///Компрессор: пиковый детектор по обоим каналам сразу (стерео не плывёт),
+///атака и спад — однополюсные, кривая с мягким коленом; усиление пересчитывается
+///каждые ControlFrames кадров и ведётся линейно внутри отрезка.
+///Лимитер задерживает звук на LookaheadMs. Нужное усиление (ceiling / пик)
+///сворачивается минимумом по окну задержки — монотонной очередью, O(1)
+///на отсчёт — и усредняется по тому же окну. Среднее из минимумов окна
+///не больше нужного усиления отсчёта, выходящего из задержки, поэтому
+///выход не превышает ceiling, а огибающая гладкая и без щелчков.
+///Параметры задаются из любого потока. Буферы выделяются в configure(),
+///process() памяти не выделяет
+class Dynamics
+{
+public:
+    static const int Channels = 2;
+    static const int LookaheadMs = 5;
+    static const int ControlFrames = 16;
+
+private:
+    ///Параметры — биты float, пишутся из потока интерфейса
+    QAtomicInteger<int> m_compressorEnabled;
+    QAtomicInteger<int> m_limiterEnabled;
+    QAtomicInteger<quint32> m_threshold;
+    QAtomicInteger<quint32> m_ratio;
+    QAtomicInteger<quint32> m_knee;
+    QAtomicInteger<quint32> m_attack;
+    QAtomicInteger<quint32> m_release;
+    QAtomicInteger<quint32> m_makeup;
+    QAtomicInteger<quint32> m_ceiling;
+    QAtomicInteger<quint32> m_limiterRelease;
+    ///Наибольшее ослабление в дБ с прошлого takeGainReduction(); для неотрицательных
+    ///float порядок битов совпадает с порядком чисел
+    QAtomicInteger<quint32> m_peakReduction;
+
+    int m_sampleRate = 48000;
+    int m_lookahead = 1;
+
+    float m_envelope = 0.0f;
+    float m_compressorGain = 1.0f;
+
+    QVector<float> m_delay;         // m_lookahead кадров стерео
+    QVector<float> m_window;        // минимумы последних m_lookahead + 1 кадров
+    QVector<float> m_dequeValue;    // монотонная очередь: нужные усиления по возрастанию
+    QVector<quint32> m_dequeFrame;  // и номера их кадров
+    int m_dequeFirst = 0;
+    int m_dequeSize = 0;
+    double m_windowSum = 0;
+    quint32 m_frame = 0;
+    int m_delayPos = 0;
+    int m_windowPos = 0;
+    float m_limiterGain = 1.0f;
+
+    float compressorGain(float envelope) const;
+    void publishReduction(float minimumGain);
+
+public:
+    Dynamics();
+
+    void configure(int sampleRate);
+    void reset();
+
+    int sampleRate() const { return m_sampleRate; }
+    int latencyFrames() const { return m_lookahead; }
+
+    ///Вызываются из любого потока
+    void setCompressorEnabled(bool enabled);
+    void setCompressor(float thresholdDb, float ratio, float kneeDb, float attackMs, float releaseMs, float makeupDb);
+    void setLimiterEnabled(bool enabled);
+    void setLimiter(float ceilingDb, float releaseMs);
+
+    bool isCompressorEnabled() const;
+    bool isLimiterEnabled() const;
+    float ceiling() const;
+
+    ///Наибольшее ослабление в дБ с прошлого вызова; сбрасывает его
+    float takeGainReduction();
+
+    ///Вызывается из потока вывода
+    void process(float *interleaved, int frames);
+
+    ///Ослабление кривой компрессора в дБ (не больше нуля) для уровня levelDb
+    static float gainComputer(float levelDb, float thresholdDb, float ratio, float kneeDb);
+};
+
+#endif // DYNAMICS_H
@@ -0,0 +1,409 @@
+#include "equalizer.h"
+
+#include <QtMath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EQUALIZER_SSE2
+#endif
+
+static inline quint32 floatBits(float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bitsFloat(quint32 bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+///Добротность полосы шириной в октаву
+static const float octaveQ = 1.41f;
+
+Equalizer::Equalizer()
+    : m_preampTarget(floatBits(0.0f)),
+      m_preampLinear(floatBits(1.0f)),
+      m_enabled(1)
+{
+    for (int i = 0; i < Bands; ++i)
+        setBand(i, Peaking, defaultFrequency(i), 0.0f, octaveQ);
+    configure(48000, 2);
+}
+
+float Equalizer::defaultFrequency(int band)
+{
+    return 31.25f * float(1 << qBound(0, band, Bands - 1));
+}
+
+///Перестраивает буферы. Вызывать только при остановленном выводе
+void Equalizer::configure(int sampleRate, int channels)
+{
+    m_sampleRate = qMax(1, sampleRate);
+    m_channels = qMax(1, channels);
+    m_groups = (m_channels + Lanes - 1) / Lanes;
+    m_smoothing = float(1.0 - qExp(-double(ControlFrames) / (SmoothingMs * 0.001 * m_sampleRate)));
+
+    m_state.fill(0.0f, Bands * m_groups * 2 * Lanes);
+    m_scratch.fill(0.0f, ControlFrames * m_groups * Lanes);
+    reset();
+}
+
+///Сглаживание начинается сразу с заданных значений, без перехода
+void Equalizer::reset()
+{
+    std::memset(m_state.data(), 0, size_t(m_state.size()) * sizeof(float));
+
+    const bool enabled = isEnabled();
+    for (int i = 0; i < Bands; ++i) {
+        Band &band = m_bands[i];
+        band.type = m_targets[i].type.loadAcquire();
+        band.logFrequency = bitsFloat(m_targets[i].logFrequency.loadAcquire());
+        band.gain = enabled ? bitsFloat(m_targets[i].gain.loadAcquire()) : 0.0f;
+        band.q = bitsFloat(m_targets[i].q.loadAcquire());
+        coefficients(FilterType(band.type), qExp(band.logFrequency), band.gain, band.q, m_sampleRate, band.coefficients);
+        band.active = band.gain != 0.0f;
+    }
+    m_preamp = enabled ? bitsFloat(m_preampLinear.loadAcquire()) : 1.0f;
+}
+
+void Equalizer::setBand(int band, FilterType type, float frequency, float gainDb, float q)
+{
+    if (band < 0 || band >= Bands)
+        return;
+    Target &target = m_targets[band];
+    target.type.storeRelease(type);
+    frequency = qMax(10.0f, frequency);
+    target.logFrequency.storeRelease(floatBits(float(qLn(frequency))));
+    target.frequency.storeRelease(floatBits(frequency));
+    target.q.storeRelease(floatBits(qBound(0.1f, q, 10.0f)));
+    setGain(band, gainDb);
+}
+
+void Equalizer::setGain(int band, float gainDb)
+{
+    if (band >= 0 && band < Bands)
+        m_targets[band].gain.storeRelease(floatBits(qBound(-2.0f * MaxGainDb, gainDb, 2.0f * MaxGainDb)));
+}
+
+void Equalizer::setPreamp(float gainDb)
+{
+    gainDb = qBound(-2.0f * MaxGainDb, gainDb, 2.0f * MaxGainDb);
+    m_preampLinear.storeRelease(floatBits(float(qPow(10.0, gainDb / 20.0))));
+    m_preampTarget.storeRelease(floatBits(gainDb));
+}
+
+///Выключенный эквалайзер плавно уводит все усиления в ноль и перестаёт считать
+void Equalizer::setEnabled(bool enabled)
+{
+    m_enabled.storeRelease(enabled ? 1 : 0);
+}
+
+float Equalizer::gain(int band) const
+{
+    return band >= 0 && band < Bands ? bitsFloat(m_targets[band].gain.loadAcquire()) : 0.0f;
+}
+
+float Equalizer::frequency(int band) const
+{
+    return band >= 0 && band < Bands ? bitsFloat(m_targets[band].frequency.loadAcquire()) : 0.0f;
+}
+
+float Equalizer::preamp() const
+{
+    return bitsFloat(m_preampTarget.loadAcquire());
+}
+
+bool Equalizer::isEnabled() const
+{
+    return m_enabled.loadAcquire() != 0;
+}
+
+bool Equalizer::isActive() const
+{
+    if (!isEnabled())
+        return false;
+    if (preamp() != 0.0f)
+        return true;
+    for (int i = 0; i < Bands; ++i) {
+        if (gain(i) != 0.0f)
+            return true;
+    }
+    return false;
+}
+
+void Equalizer::coefficients(FilterType type, float frequency, float gainDb, float q, int sampleRate, float *out)
+{
+    const double a = qPow(10.0, gainDb / 40.0);
+    const double w0 = 2 * M_PI * qBound(10.0, double(frequency), 0.45 * sampleRate) / sampleRate;
+    const double cosw = qCos(w0);
+    const double alpha = qSin(w0) / (2 * q);
+    const double shelf = 2 * qSqrt(a) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+    switch (type) {
+    case LowShelf:
+        b0 = a * ((a + 1) - (a - 1) * cosw + shelf);
+        b1 = 2 * a * ((a - 1) - (a + 1) * cosw);
+        b2 = a * ((a + 1) - (a - 1) * cosw - shelf);
+        a0 = (a + 1) + (a - 1) * cosw + shelf;
+        a1 = -2 * ((a - 1) + (a + 1) * cosw);
+        a2 = (a + 1) + (a - 1) * cosw - shelf;
+        break;
+    case HighShelf:
+        b0 = a * ((a + 1) + (a - 1) * cosw + shelf);
+        b1 = -2 * a * ((a - 1) + (a + 1) * cosw);
+        b2 = a * ((a + 1) + (a - 1) * cosw - shelf);
+        a0 = (a + 1) - (a - 1) * cosw + shelf;
+        a1 = 2 * ((a - 1) - (a + 1) * cosw);
+        a2 = (a + 1) - (a - 1) * cosw - shelf;
+        break;
+    default:
+        b0 = 1 + alpha * a;
+        b1 = -2 * cosw;
+        b2 = 1 - alpha * a;
+        a0 = 1 + alpha / a;
+        a1 = -2 * cosw;
+        a2 = 1 - alpha / a;
+        break;
+    }
+
+    out[0] = float(b0 / a0);
+    out[1] = float(b1 / a0);
+    out[2] = float(b2 / a0);
+    out[3] = float(a1 / a0);
+    out[4] = float(a2 / a0);
+}
+
+///Сглаживает параметры полосы на один управляющий отрезок и пишет в to
+///коэффициенты его конца. false — параметры уже на месте
+bool Equalizer::updateBand(int index, float *to)
+{
+    const Target &target = m_targets[index];
+    Band &band = m_bands[index];
+
+    const int type = target.type.loadAcquire();
+    const float logFrequency = bitsFloat(target.logFrequency.loadAcquire());
+    const float gain = isEnabled() ? bitsFloat(target.gain.loadAcquire()) : 0.0f;
+    const float q = bitsFloat(target.q.loadAcquire());
+
+    bool changed = type != band.type;
+    band.type = type;
+
+    auto approach = [this, &changed](float &value, float goal, float epsilon) {
+        if (value == goal)
+            return;
+        value += (goal - value) * m_smoothing;
+        if (qAbs(goal - value) < epsilon)
+            value = goal;
+        changed = true;
+    };
+    approach(band.logFrequency, logFrequency, 1e-4f);
+    approach(band.gain, gain, 1e-3f);
+    approach(band.q, q, 1e-4f);
+
+    if (changed)
+        coefficients(FilterType(band.type), qExp(band.logFrequency), band.gain, band.q, m_sampleRate, to);
+    else
+        std::memcpy(to, band.coefficients, sizeof(band.coefficients));
+    return changed;
+}
+
+///y = b0·x + s1; s1 = b1·x − a1·y + s2; s2 = b2·x − a2·y.
+///Коэффициенты растут на шаг до обработки кадра, так что последний кадр идёт ровно с to.
+///Sections биквадов идут подряд в одном цикле по кадрам: цепочки зависимостей у них
+///разные, и процессор считает следующую секцию, не дожидаясь предыдущей
+template <int Sections, bool Ramp>
+static void filterSections(float *data, int frames, int groups, float *const *state,
+                           const float *const *from, const float *const *to)
+{
+    const int stride = groups * Equalizer::Lanes;
+    float step[Sections][5];
+    for (int i = 0; i < Sections; ++i) {
+        for (int k = 0; k < 5; ++k)
+            step[i][k] = (to[i][k] - from[i][k]) / frames;
+    }
+
+    for (int g = 0; g < groups; ++g) {
+#ifdef EQUALIZER_SSE2
+        __m128 c[Sections][5], d[Sections][5], s1[Sections], s2[Sections];
+        for (int i = 0; i < Sections; ++i) {
+            for (int k = 0; k < 5; ++k) {
+                c[i][k] = _mm_set1_ps(from[i][k]);
+                d[i][k] = _mm_set1_ps(step[i][k]);
+            }
+            s1[i] = _mm_loadu_ps(state[i] + g * 2 * Equalizer::Lanes);
+            s2[i] = _mm_loadu_ps(state[i] + g * 2 * Equalizer::Lanes + Equalizer::Lanes);
+        }
+
+        float *x = data + g * Equalizer::Lanes;
+        for (int n = 0; n < frames; ++n, x += stride) {
+            __m128 in = _mm_loadu_ps(x);
+            for (int i = 0; i < Sections; ++i) {
+                if (Ramp) {
+                    for (int k = 0; k < 5; ++k)
+                        c[i][k] = _mm_add_ps(c[i][k], d[i][k]);
+                }
+                const __m128 y = _mm_add_ps(_mm_mul_ps(c[i][0], in), s1[i]);
+                s1[i] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c[i][1], in), _mm_mul_ps(c[i][3], y)), s2[i]);
+                s2[i] = _mm_sub_ps(_mm_mul_ps(c[i][2], in), _mm_mul_ps(c[i][4], y));
+                in = y;
+            }
+            _mm_storeu_ps(x, in);
+        }
+
+        ///Денормализованные числа в затухающем хвосте заметно замедляют FPU
+        const __m128 tiny = _mm_set1_ps(1e-20f);
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        for (int i = 0; i < Sections; ++i) {
+            s1[i] = _mm_and_ps(s1[i], _mm_cmpgt_ps(_mm_andnot_ps(sign, s1[i]), tiny));
+            s2[i] = _mm_and_ps(s2[i], _mm_cmpgt_ps(_mm_andnot_ps(sign, s2[i]), tiny));
+            _mm_storeu_ps(state[i] + g * 2 * Equalizer::Lanes, s1[i]);
+            _mm_storeu_ps(state[i] + g * 2 * Equalizer::Lanes + Equalizer::Lanes, s2[i]);
+        }
+#else
+        for (int lane = 0; lane < Equalizer::Lanes; ++lane) {
+            float c[Sections][5], s1[Sections], s2[Sections];
+            for (int i = 0; i < Sections; ++i) {
+                std::memcpy(c[i], from[i], sizeof(c[i]));
+                s1[i] = state[i][g * 2 * Equalizer::Lanes + lane];
+                s2[i] = state[i][g * 2 * Equalizer::Lanes + Equalizer::Lanes + lane];
+            }
+
+            float *sample = data + g * Equalizer::Lanes + lane;
+            for (int n = 0; n < frames; ++n, sample += stride) {
+                float in = *sample;
+                for (int i = 0; i < Sections; ++i) {
+                    if (Ramp) {
+                        for (int k = 0; k < 5; ++k)
+                            c[i][k] += step[i][k];
+                    }
+                    const float y = c[i][0] * in + s1[i];
+                    s1[i] = c[i][1] * in - c[i][3] * y + s2[i];
+                    s2[i] = c[i][2] * in - c[i][4] * y;
+                    in = y;
+                }
+                *sample = in;
+            }
+
+            for (int i = 0; i < Sections; ++i) {
+                state[i][g * 2 * Equalizer::Lanes + lane] = qAbs(s1[i]) > 1e-20f ? s1[i] : 0.0f;
+                state[i][g * 2 * Equalizer::Lanes + Equalizer::Lanes + lane] = qAbs(s2[i]) > 1e-20f ? s2[i] : 0.0f;
+            }
+        }
+#endif
+    }
+}
+
+static void filterSections(int sections, bool ramp, float *data, int frames, int groups, float *const *state,
+                           const float *const *from, const float *const *to)
+{
+    if (sections == 2) {
+        if (ramp)
+            filterSections<2, true>(data, frames, groups, state, from, to);
+        else
+            filterSections<2, false>(data, frames, groups, state, from, to);
+    } else {
+        if (ramp)
+            filterSections<1, true>(data, frames, groups, state, from, to);
+        else
+            filterSections<1, false>(data, frames, groups, state, from, to);
+    }
+}
+
+void Equalizer::process(float *interleaved, int frames)
+{
+    while (frames > 0) {
+        const int block = qMin(frames, int(ControlFrames));
+        processBlock(interleaved, block);
+        interleaved += block * m_channels;
+        frames -= block;
+    }
+}
+
+void Equalizer::processBlock(float *interleaved, int frames)
+{
+    const int stride = m_groups * Lanes;
+    const int stateSize = m_groups * 2 * Lanes;
+
+    ///Полоса считается, пока её усиление не ноль или пока не затух её хвост
+    float to[Bands][5];
+    bool changed[Bands];
+    bool any = false;
+    for (int i = 0; i < Bands; ++i) {
+        Band &band = m_bands[i];
+        changed[i] = updateBand(i, to[i]);
+        if (band.gain != 0.0f || changed[i]) {
+            band.active = true;
+        } else if (band.active) {
+            float *state = m_state.data() + i * stateSize;
+            bool silent = true;
+            for (int k = 0; k < stateSize && silent; ++k)
+                silent = qAbs(state[k]) < 1e-9f;
+            if (silent) {
+                band.active = false;
+                std::memset(state, 0, size_t(stateSize) * sizeof(float));
+            }
+        }
+        any = any || band.active;
+    }
+
+    const float preampTo = isEnabled() ? bitsFloat(m_preampLinear.loadAcquire()) : 1.0f;
+    const float preampFrom = m_preamp;
+    m_preamp = preampFrom + (preampTo - preampFrom) * m_smoothing;
+    if (qAbs(m_preamp - preampTo) < 1e-5f)
+        m_preamp = preampTo;
+
+    if (!any && preampFrom == 1.0f && m_preamp == 1.0f)
+        return;
+
+    ///Раскладка по блокам каналов; лишние дорожки последнего блока остаются нулями
+    float *scratch = m_scratch.data();
+    const float preampStep = (m_preamp - preampFrom) / frames;
+    for (int n = 0; n < frames; ++n) {
+        const float gain = preampFrom + preampStep * (n + 1);
+        const float *in = interleaved + n * m_channels;
+        float *out = scratch + n * stride;
+        for (int c = 0; c < m_channels; ++c)
+            out[c] = in[c] * gain;
+    }
+
+    ///Активные полосы идут парами, нечётная последняя — одна. Ведутся коэффициенты
+    ///только у пары, где что-то менялось: без ведения всё умещается в регистрах
+    float *states[2];
+    const float *froms[2];
+    const float *tos[2];
+    int pending = 0;
+    bool ramp = false;
+    for (int i = 0; i < Bands; ++i) {
+        if (!m_bands[i].active)
+            continue;
+        states[pending] = m_state.data() + i * stateSize;
+        froms[pending] = m_bands[i].coefficients;
+        tos[pending] = to[i];
+        ramp = ramp || changed[i];
+        if (++pending == 2) {
+            filterSections(pending, ramp, scratch, frames, m_groups, states, froms, tos);
+            pending = 0;
+            ramp = false;
+        }
+    }
+    if (pending)
+        filterSections(pending, ramp, scratch, frames, m_groups, states, froms, tos);
+    for (int i = 0; i < Bands; ++i) {
+        if (changed[i])
+            std::memcpy(m_bands[i].coefficients, to[i], sizeof(m_bands[i].coefficients));
+    }
+
+    for (int n = 0; n < frames; ++n)
+        std::memcpy(interleaved + n * m_channels, scratch + n * stride, size_t(m_channels) * sizeof(float));
+}
+
+void Equalizer::filter(float *data, int frames, int groups, float *state, const float *from, const float *to)
+{
+    filterSections(1, std::memcmp(from, to, 5 * sizeof(float)) != 0, data, frames, groups, &state, &from, &to);
+}
@@ -0,0 +1,109 @@
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+///Десятиполосный параметрический эквалайзер: каскад биквадов
+///в транспонированной второй прямой форме (коэффициенты по RBJ Audio EQ Cookbook).
+///Векторизован по каналам: кадр раскладывается в блоки по Lanes каналов,
+///и каждый биквад считает все каналы блока одной инструкцией SSE.
+///Параметры полос задаются из любого потока. Поток вывода каждые ControlFrames
+///кадров сглаживает их к заданным (постоянная SmoothingMs), пересчитывает
+///коэффициенты и ведёт их линейно внутри отрезка — ступенек и треска нет.
+///Полоса с нулевым усилением и затухшим состоянием пропускается целиком.
+///Буферы выделяются в configure(), process() памяти не выделяет.
+///Стоит только в микшере окна Player: у окна Widget нет настроек эквалайзера,
+///и его звук (QMediaPlayer и WavStream) через эквалайзер не идёт
+class Equalizer
+{
+public:
+    enum FilterType
+    {
+        Peaking = 0,
+        LowShelf,
+        HighShelf
+    };
+
+    static const int Bands = 10;
+    static const int Lanes = 4;
+    static const int ControlFrames = 32;
+    static const int SmoothingMs = 20;
+    static const int MaxGainDb = 12;
+
+private:
+    ///Заданные параметры полосы — биты float, пишутся из потока интерфейса.
+    ///Логарифм частоты считается при записи, чтобы поток вывода его не пересчитывал
+    struct Target
+    {
+        QAtomicInteger<int> type;
+        QAtomicInteger<quint32> frequency;
+        QAtomicInteger<quint32> logFrequency;
+        QAtomicInteger<quint32> gain;
+        QAtomicInteger<quint32> q;
+    };
+
+    ///Сглаженные параметры и текущие коэффициенты b0, b1, b2, a1, a2 — только поток вывода
+    struct Band
+    {
+        int type = Peaking;
+        float logFrequency = 0;
+        float gain = 0;
+        float q = 1;
+        float coefficients[5] = { 1, 0, 0, 0, 0 };
+        bool active = false;
+    };
+
+    Target m_targets[Bands];
+    QAtomicInteger<quint32> m_preampTarget;
+    QAtomicInteger<quint32> m_preampLinear;
+    QAtomicInteger<int> m_enabled;
+
+    Band m_bands[Bands];
+    float m_preamp = 1.0f;
+    int m_sampleRate = 48000;
+    int m_channels = 2;
+    int m_groups = 1;
+    float m_smoothing = 0;
+
+    QVector<float> m_state;     // по полосам: группы × (s1, s2) × Lanes
+    QVector<float> m_scratch;   // ControlFrames × группы × Lanes
+
+    bool updateBand(int index, float *to);
+    void processBlock(float *interleaved, int frames);
+
+public:
+    Equalizer();
+
+    void configure(int sampleRate, int channels);
+    void reset();
+
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+
+    ///Вызываются из любого потока
+    void setBand(int band, FilterType type, float frequency, float gainDb, float q);
+    void setGain(int band, float gainDb);
+    void setPreamp(float gainDb);
+    void setEnabled(bool enabled);
+
+    float gain(int band) const;
+    float frequency(int band) const;
+    float preamp() const;
+    bool isEnabled() const;
+    ///Включён и хоть что-то меняет в звуке
+    bool isActive() const;
+
+    ///Вызывается из потока вывода, кадры чередуются по channels() каналам
+    void process(float *interleaved, int frames);
+
+    ///Частоты графического эквалайзера: 31 Гц … 16 кГц через октаву
+    static float defaultFrequency(int band);
+    static void coefficients(FilterType type, float frequency, float gainDb, float q, int sampleRate, float *out);
+
+    ///Один биквад над frames кадрами по groups блокам Lanes каналов. Коэффициенты идут
+    ///от from к to по кадрам; state — (s1, s2) каждого блока
+    static void filter(float *data, int frames, int groups, float *state, const float *from, const float *to);
+};
+
+#endif // EQUALIZER_H
@@ -0,0 +1,168 @@
+#include "fft.h"
+
+#include <QtMath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FFT_SSE2
+#endif
+
+Fft::Fft()
+{
+    configure(16);
+}
+
+void Fft::configure(int size)
+{
+    int bits = 4;
+    while ((1 << bits) < size)
+        ++bits;
+    m_size = 1 << bits;
+    m_half = m_size / 2;
+
+    m_reverse.resize(m_half);
+    for (int i = 0; i < m_half; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits - 1; ++b)
+            reversed |= ((i >> b) & 1) << (bits - 2 - b);
+        m_reverse[i] = reversed;
+    }
+
+    m_twiddleRe.resize(m_half - 1);
+    m_twiddleIm.resize(m_half - 1);
+    for (int h = 1; h < m_half; h *= 2) {
+        for (int k = 0; k < h; ++k) {
+            m_twiddleRe[h - 1 + k] = float(qCos(M_PI * k / h));
+            m_twiddleIm[h - 1 + k] = float(-qSin(M_PI * k / h));
+        }
+    }
+
+    m_splitRe.resize(m_half / 2 + 1);
+    m_splitIm.resize(m_half / 2 + 1);
+    for (int k = 0; k <= m_half / 2; ++k) {
+        m_splitRe[k] = float(qCos(2 * M_PI * k / m_size));
+        m_splitIm[k] = float(-qSin(2 * M_PI * k / m_size));
+    }
+}
+
+///Комплексное прямое БПФ размера N/2 на месте: перестановка, затем
+///этапы бабочек по основанию 2. Обратное получается перестановкой re и im
+void Fft::transform(float *re, float *im) const
+{
+    const int n = m_half;
+    const int *reverse = m_reverse.constData();
+    for (int i = 0; i < n; ++i) {
+        const int j = reverse[i];
+        if (i < j) {
+            qSwap(re[i], re[j]);
+            qSwap(im[i], im[j]);
+        }
+    }
+
+    ///Первые два этапа — без умножений: множители там 1 и -i
+    for (int i = 0; i < n; i += 4) {
+        const float r0 = re[i] + re[i + 1], i0 = im[i] + im[i + 1];
+        const float r1 = re[i] - re[i + 1], i1 = im[i] - im[i + 1];
+        const float r2 = re[i + 2] + re[i + 3], i2 = im[i + 2] + im[i + 3];
+        const float r3 = re[i + 2] - re[i + 3], i3 = im[i + 2] - im[i + 3];
+        re[i] = r0 + r2;
+        im[i] = i0 + i2;
+        re[i + 2] = r0 - r2;
+        im[i + 2] = i0 - i2;
+        re[i + 1] = r1 + i3;
+        im[i + 1] = i1 - r3;
+        re[i + 3] = r1 - i3;
+        im[i + 3] = i1 + r3;
+    }
+
+    for (int h = 4; h < n; h *= 2) {
+        const float *wr = m_twiddleRe.constData() + h - 1;
+        const float *wi = m_twiddleIm.constData() + h - 1;
+        for (int start = 0; start < n; start += 2 * h) {
+            float *ar = re + start, *ai = im + start;
+            float *br = ar + h, *bi = ai + h;
+#ifdef FFT_SSE2
+            for (int k = 0; k < h; k += 4) {
+                const __m128 w0 = _mm_loadu_ps(wr + k), w1 = _mm_loadu_ps(wi + k);
+                const __m128 xr = _mm_loadu_ps(br + k), xi = _mm_loadu_ps(bi + k);
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(w0, xr), _mm_mul_ps(w1, xi));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(w0, xi), _mm_mul_ps(w1, xr));
+                const __m128 yr = _mm_loadu_ps(ar + k), yi = _mm_loadu_ps(ai + k);
+                _mm_storeu_ps(ar + k, _mm_add_ps(yr, tr));
+                _mm_storeu_ps(ai + k, _mm_add_ps(yi, ti));
+                _mm_storeu_ps(br + k, _mm_sub_ps(yr, tr));
+                _mm_storeu_ps(bi + k, _mm_sub_ps(yi, ti));
+            }
+#else
+            for (int k = 0; k < h; ++k) {
+                const float tr = wr[k] * br[k] - wi[k] * bi[k];
+                const float ti = wr[k] * bi[k] + wi[k] * br[k];
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+#endif
+        }
+    }
+}
+
+///Z — спектр z[k] = x[2k] + i·x[2k+1]. Чётная и нечётная части:
+///E = (Z[k] + Z*[M-k]) / 2, O = (Z[k] - Z*[M-k]) / 2i, X[k] = E + W^k·O,
+///X[M-k] = (E - W^k·O)*, где M = N/2 и W = exp(-2πi/N)
+void Fft::forward(const float *in, float *re, float *im) const
+{
+    for (int k = 0; k < m_half; ++k) {
+        re[k] = in[2 * k];
+        im[k] = in[2 * k + 1];
+    }
+    transform(re, im);
+
+    const float dc = re[0] + im[0];
+    const float nyquist = re[0] - im[0];
+    re[0] = dc;
+    im[0] = nyquist;
+
+    for (int k = 1; k <= m_half / 2; ++k) {
+        const int m = m_half - k;
+        const float er = 0.5f * (re[k] + re[m]);
+        const float ei = 0.5f * (im[k] - im[m]);
+        const float or_ = 0.5f * (im[k] + im[m]);
+        const float oi = -0.5f * (re[k] - re[m]);
+        const float tr = m_splitRe[k] * or_ - m_splitIm[k] * oi;
+        const float ti = m_splitRe[k] * oi + m_splitIm[k] * or_;
+        re[k] = er + tr;
+        im[k] = ei + ti;
+        re[m] = er - tr;
+        im[m] = ti - ei;
+    }
+}
+
+///Обратно к Z: E = (X[k] + X*[M-k]) / 2, O = (X[k] - X*[M-k]) · W^-k / 2, Z = E + i·O
+void Fft::inverse(float *re, float *im, float *out) const
+{
+    const float dc = re[0];
+    const float nyquist = im[0];
+    re[0] = 0.5f * (dc + nyquist);
+    im[0] = 0.5f * (dc - nyquist);
+
+    for (int k = 1; k <= m_half / 2; ++k) {
+        const int m = m_half - k;
+        const float er = 0.5f * (re[k] + re[m]);
+        const float ei = 0.5f * (im[k] - im[m]);
+        const float dr = 0.5f * (re[k] - re[m]);
+        const float di = 0.5f * (im[k] + im[m]);
+        const float or_ = m_splitRe[k] * dr + m_splitIm[k] * di;
+        const float oi = m_splitRe[k] * di - m_splitIm[k] * dr;
+        re[k] = er - oi;
+        im[k] = ei + or_;
+        re[m] = er + oi;
+        im[m] = or_ - ei;
+    }
+
+    transform(im, re);
+    for (int k = 0; k < m_half; ++k) {
+        out[2 * k] = re[k];
+        out[2 * k + 1] = im[k];
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+
+///Вещественное БПФ размера N (степень двойки) через комплексное
+///размера N/2: чётные отсчёты идут в действительную часть, нечётные —
+///в мнимую, после преобразования спектры разделяются одним проходом.
+///Спектр хранится раздельно (re и im — отдельные массивы по N/2 значений),
+///чтобы покомпонентные операции над ним векторизовались без перестановок.
+///Бины 0 и N/2 вещественные, поэтому значение на N/2 лежит в im[0].
+///Таблицы считаются в configure(), преобразования памяти не выделяют
+///и не меняют объект — один Fft можно звать из разных потоков
+class Fft
+{
+private:
+    int m_size = 0;
+    int m_half = 0;
+    QVector<int> m_reverse;         // перестановка индексов комплексного БПФ
+    QVector<float> m_twiddleRe;     // множители этапов подряд: этап h с индекса h - 1
+    QVector<float> m_twiddleIm;
+    QVector<float> m_splitRe;       // exp(-2πik/N) для разделения спектров
+    QVector<float> m_splitIm;
+
+    void transform(float *re, float *im) const;
+
+public:
+    Fft();
+
+    void configure(int size);
+    int size() const { return m_size; }
+    ///Комплексных значений в спектре, N/2
+    int bins() const { return m_half; }
+
+    ///in — N отсчётов; re, im — по N/2 значений
+    void forward(const float *in, float *re, float *im) const;
+    ///Обратное без нормировки: inverse(forward(x)) = x · N / 2.
+    ///re и im портятся
+    void inverse(float *re, float *im, float *out) const;
+};
+
+#endif // FFT_H
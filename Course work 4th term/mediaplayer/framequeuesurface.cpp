@@ -0,0 +1,422 @@
+#include "framequeuesurface.h"
+
+#include <QAbstractVideoBuffer>
+
+///Буфер кадра поверх слота пула. Когда кадр отпускают все получатели,
+///слот возвращается в пул
+class PooledVideoBuffer : public QAbstractVideoBuffer
+{
+private:
+    QSharedPointer<FrameSlot> m_slot;
+    MapMode m_mapMode = NotMapped;
+
+public:
+    explicit PooledVideoBuffer(const QSharedPointer<FrameSlot> &slot)
+        : QAbstractVideoBuffer(NoHandle),
+          m_slot(slot)
+    {
+    }
+
+    ~PooledVideoBuffer() override
+    {
+        m_slot->busy.storeRelease(0);
+    }
+
+    MapMode mapMode() const override
+    {
+        return m_mapMode;
+    }
+
+    uchar *map(MapMode mode, int *numBytes, int *bytesPerLine) override
+    {
+        if (mode == NotMapped || m_mapMode != NotMapped)
+            return nullptr;
+
+        m_mapMode = mode;
+        if (numBytes)
+            *numBytes = m_slot->bytes;
+        if (bytesPerLine)
+            *bytesPerLine = m_slot->bytesPerLine;
+        return reinterpret_cast<uchar *>(m_slot->data.data());
+    }
+
+    void unmap() override
+    {
+        m_mapMode = NotMapped;
+    }
+};
+
+///Размер кадра в стандартной раскладке плоскостей, которую ожидает QVideoFrame::map
+static int standardFrameBytes(QVideoFrame::PixelFormat format, int bytesPerLine, int height)
+{
+    switch (format) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+        return bytesPerLine * height + 2 * (bytesPerLine / 2) * (height / 2);
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+        return bytesPerLine * height + bytesPerLine * (height / 2);
+    default:
+        return bytesPerLine * height;
+    }
+}
+
+FrameQueueSurface::FrameQueueSurface(QObject *parent)
+    : QAbstractVideoSurface(parent)
+{
+    m_queue.resize(m_depth);
+    m_scheduler.setTimerType(Qt::PreciseTimer);
+    m_scheduler.setInterval(2);
+    connect(&m_scheduler, &QTimer::timeout, this, &FrameQueueSurface::schedule);
+}
+
+FrameQueueSurface::~FrameQueueSurface()
+{
+    dropQueued(m_queueCount);
+}
+
+void FrameQueueSurface::setTarget(QAbstractVideoSurface *target)
+{
+    m_target = target;
+}
+
+///Источник звуковых часов: по его позиции выбирается момент показа кадра
+void FrameQueueSurface::setClock(QMediaPlayer *player)
+{
+    if (m_clock)
+        disconnect(m_clock, &QMediaPlayer::stateChanged, this, &FrameQueueSurface::clockStateChanged);
+
+    m_clock = player;
+    m_lastClock = -1;
+
+    if (m_clock)
+        connect(m_clock, &QMediaPlayer::stateChanged, this, &FrameQueueSurface::clockStateChanged);
+}
+
+///Программная цветокоррекция, применяемая при копировании кадра в пул
+void FrameQueueSurface::setColorAdjustment(ColorAdjustment *adjustment)
+{
+    m_colorAdjustment = adjustment;
+}
+
+void FrameQueueSurface::setDepth(int depth)
+{
+    dropQueued(m_queueCount);
+    m_depth = qMax(1, depth);
+    m_queue.fill(QSharedPointer<FrameSlot>(), m_depth);
+    m_queueHead = 0;
+    m_pool.clear();
+}
+
+FrameQueueStats FrameQueueSurface::stats() const
+{
+    FrameQueueStats stats = m_stats;
+    stats.queued = m_queueCount;
+    return stats;
+}
+
+void FrameQueueSurface::resetStats()
+{
+    m_stats = FrameQueueStats();
+}
+
+QList<QVideoFrame::PixelFormat> FrameQueueSurface::supportedPixelFormats(QAbstractVideoBuffer::HandleType type) const
+{
+    ///Кадры копируются в память пула, поэтому принимаются только кадры в памяти
+    if (!m_target || type != QAbstractVideoBuffer::NoHandle)
+        return QList<QVideoFrame::PixelFormat>();
+
+    return m_target->supportedPixelFormats(QAbstractVideoBuffer::NoHandle);
+}
+
+bool FrameQueueSurface::isFormatSupported(const QVideoSurfaceFormat &format) const
+{
+    return m_target
+            && format.handleType() == QAbstractVideoBuffer::NoHandle
+            && m_target->isFormatSupported(format);
+}
+
+bool FrameQueueSurface::start(const QVideoSurfaceFormat &format)
+{
+    if (!m_target || !m_target->start(format))
+        return false;
+
+    m_lastClock = -1;
+    return QAbstractVideoSurface::start(format);
+}
+
+void FrameQueueSurface::stop()
+{
+    m_scheduler.stop();
+    dropQueued(m_queueCount);
+
+    if (m_target)
+        m_target->stop();
+
+    QAbstractVideoSurface::stop();
+}
+
+///Пул выделяется при первом кадре и заново только при смене размера кадра.
+///Слоты, которые ещё держит получатель, живут до его освобождения
+void FrameQueueSurface::allocatePool(int bytes)
+{
+    m_pool.clear();
+    for (int i = 0; i < m_depth + 3; ++i) {
+        QSharedPointer<FrameSlot> slot(new FrameSlot);
+        slot->data.resize(bytes);
+        m_pool.append(slot);
+    }
+}
+
+QSharedPointer<FrameSlot> FrameQueueSurface::acquireSlot()
+{
+    for (const QSharedPointer<FrameSlot> &slot : m_pool) {
+        if (slot->busy.testAndSetAcquire(0, 1))
+            return slot;
+    }
+    return QSharedPointer<FrameSlot>();
+}
+
+bool FrameQueueSurface::present(const QVideoFrame &frame)
+{
+    if (!m_target || !isActive())
+        return false;
+
+    ++m_stats.received;
+
+    QVideoFrame source(frame);
+    if (!source.map(QAbstractVideoBuffer::ReadOnly)) {
+        ++m_stats.dropped;
+        return true;
+    }
+
+    int bytes = standardFrameBytes(source.pixelFormat(), source.bytesPerLine(0), source.height());
+    if (m_pool.isEmpty() || m_pool.first()->data.size() < bytes)
+        allocatePool(bytes);
+
+    ///Очередь переполнена: самый старый кадр уже не успеет к показу
+    if (m_queueCount == m_depth)
+        dropQueued(1);
+
+    QSharedPointer<FrameSlot> slot = acquireSlot();
+    if (!slot || !copyFrame(source, slot.data())) {
+        if (slot)
+            slot->busy.storeRelease(0);
+        source.unmap();
+        ++m_stats.dropped;
+        return true;
+    }
+    source.unmap();
+
+    m_queue[(m_queueHead + m_queueCount) % m_depth] = slot;
+    ++m_queueCount;
+
+    schedule();
+    if (m_queueCount && clockRunning() && !m_scheduler.isActive())
+        m_scheduler.start();
+
+    return true;
+}
+
+///Копирование кадра в слот в стандартной раскладке плоскостей.
+///Если задана цветокоррекция, она применяется в том же проходе, что и копирование
+bool FrameQueueSurface::copyFrame(const QVideoFrame &frame, FrameSlot *slot)
+{
+    int width = frame.width();
+    int height = frame.height();
+    int bytesPerLine = frame.bytesPerLine(0);
+    QVideoFrame::PixelFormat format = frame.pixelFormat();
+
+    slot->pixelFormat = format;
+    slot->size = frame.size();
+    slot->bytesPerLine = bytesPerLine;
+    slot->bytes = standardFrameBytes(format, bytesPerLine, height);
+    slot->startTime = frame.startTime();
+    slot->endTime = frame.endTime();
+
+    uchar *out = reinterpret_cast<uchar *>(slot->data.data());
+    ///Один снимок таблиц на весь кадр: смена настроек посреди кадра его не разорвёт
+    const ColorAdjustment::Snapshot tables(m_colorAdjustment);
+    const ColorAdjustment::Snapshot *adjust = tables.isIdentity() ? nullptr : &tables;
+
+    if (frame.planeCount() <= 1) {
+        bool argb = format == QVideoFrame::Format_ARGB32;
+        if (adjust && (format == QVideoFrame::Format_RGB32 || argb)) {
+            for (int y = 0; y < height; ++y)
+                adjust->processRgb32(frame.bits() + y * bytesPerLine, out + y * bytesPerLine, width, argb);
+        } else {
+            memcpy(out, frame.bits(), size_t(qMin(slot->bytes, frame.mappedBytes())));
+        }
+        return true;
+    }
+
+    bool semiPlanar = format == QVideoFrame::Format_NV12 || format == QVideoFrame::Format_NV21;
+    bool planar = format == QVideoFrame::Format_YUV420P || format == QVideoFrame::Format_YV12;
+    if (!semiPlanar && !planar)
+        return false;
+
+    ///Яркостная плоскость
+    const uchar *in = frame.bits(0);
+    int inStride = frame.bytesPerLine(0);
+    for (int y = 0; y < height; ++y) {
+        if (adjust)
+            adjust->processLuma(in + y * inStride, out + y * bytesPerLine, width);
+        else
+            memcpy(out + y * bytesPerLine, in + y * inStride, size_t(qMin(inStride, bytesPerLine)));
+    }
+    out += height * bytesPerLine;
+
+    int chromaRows = height / 2;
+    int chromaWidth = width / 2;
+
+    if (semiPlanar) {
+        in = frame.bits(1);
+        inStride = frame.bytesPerLine(1);
+        for (int y = 0; y < chromaRows; ++y) {
+            if (adjust)
+                adjust->processChromaInterleaved(in + y * inStride, out + y * bytesPerLine, chromaWidth,
+                                                 format == QVideoFrame::Format_NV21);
+            else
+                memcpy(out + y * bytesPerLine, in + y * inStride, size_t(qMin(inStride, bytesPerLine)));
+        }
+        return true;
+    }
+
+    ///Плоскости U и V обрабатываются вместе: оттенок и насыщенность смешивают оба канала
+    int outStride = bytesPerLine / 2;
+    int uPlane = format == QVideoFrame::Format_YV12 ? 2 : 1;
+    int vPlane = 3 - uPlane;
+    uchar *outU = out + (uPlane - 1) * chromaRows * outStride;
+    uchar *outV = out + (vPlane - 1) * chromaRows * outStride;
+    const uchar *inU = frame.bits(uPlane);
+    const uchar *inV = frame.bits(vPlane);
+    int inStrideU = frame.bytesPerLine(uPlane);
+    int inStrideV = frame.bytesPerLine(vPlane);
+
+    for (int y = 0; y < chromaRows; ++y) {
+        if (adjust) {
+            adjust->processChroma(inU + y * inStrideU, inV + y * inStrideV,
+                                  outU + y * outStride, outV + y * outStride, chromaWidth);
+        } else {
+            memcpy(outU + y * outStride, inU + y * inStrideU, size_t(qMin(inStrideU, outStride)));
+            memcpy(outV + y * outStride, inV + y * inStrideV, size_t(qMin(inStrideV, outStride)));
+        }
+    }
+    return true;
+}
+
+void FrameQueueSurface::dropQueued(int count)
+{
+    while (count-- > 0 && m_queueCount) {
+        QSharedPointer<FrameSlot> slot = m_queue[m_queueHead];
+        m_queue[m_queueHead].clear();
+        m_queueHead = (m_queueHead + 1) % m_depth;
+        --m_queueCount;
+
+        slot->busy.storeRelease(0);
+        ++m_stats.dropped;
+    }
+}
+
+///Позиция звуковых часов в микросекундах. Между обновлениями позиции плеера
+///время экстраполируется, чтобы кадры 60 fps не выводились пачками
+qint64 FrameQueueSurface::clockTime()
+{
+    if (!m_clock)
+        return -1;
+
+    qint64 position = m_clock->position() * 1000;
+    if (position != m_lastClock || m_clock->state() != QMediaPlayer::PlayingState) {
+        m_lastClock = position;
+        m_clockTimer.start();
+        return position;
+    }
+
+    qreal rate = qFuzzyIsNull(m_clock->playbackRate()) ? 1.0 : m_clock->playbackRate();
+    return position + qint64(m_clockTimer.nsecsElapsed() / 1000 * rate);
+}
+
+///Без часов кадры выводятся сразу, поэтому планировщику есть чего ждать
+///только пока часы идут
+bool FrameQueueSurface::clockRunning() const
+{
+    return !m_clock || m_clock->state() == QMediaPlayer::PlayingState;
+}
+
+///На паузе часы стоят и кадры в очереди не станут своевременными,
+///поэтому таймер останавливается и запускается снова со стартом воспроизведения
+void FrameQueueSurface::clockStateChanged(QMediaPlayer::State state)
+{
+    if (state == QMediaPlayer::PlayingState) {
+        if (m_queueCount && !m_scheduler.isActive())
+            m_scheduler.start();
+    } else {
+        m_scheduler.stop();
+        schedule();
+    }
+}
+
+void FrameQueueSurface::schedule()
+{
+    if (!m_queueCount || !clockRunning())
+        m_scheduler.stop();
+    if (!m_queueCount)
+        return;
+
+    qint64 now = clockTime();
+
+    ///Среди кадров, чьё время уже наступило, показывается самый свежий
+    int due = 0;
+    for (int i = 0; i < m_queueCount; ++i) {
+        const QSharedPointer<FrameSlot> &slot = m_queue[(m_queueHead + i) % m_depth];
+        ///Кадр без метки времени или после разрыва часов (перемотка) выводится сразу
+        if (now < 0 || slot->startTime < 0 || slot->startTime <= now
+                || slot->startTime - now > 1000000)
+            due = i + 1;
+        else
+            break;
+    }
+
+    ///На паузе часы не дойдут до кадров впереди, поэтому показывается кадр,
+    ///ближайший к ним с любой стороны: иначе кадр чуть впереди часов
+    ///(например, после перемотки на паузе) так и не появится
+    if (!clockRunning() && now >= 0 && due < m_queueCount) {
+        qint64 ahead = m_queue[(m_queueHead + due) % m_depth]->startTime - now;
+        qint64 behind = due ? now - m_queue[(m_queueHead + due - 1) % m_depth]->startTime : -1;
+        if (!due || ahead < behind)
+            ++due;
+    }
+
+    if (!due)
+        return;
+
+    dropQueued(due - 1);
+
+    QSharedPointer<FrameSlot> slot = m_queue[m_queueHead];
+    m_queue[m_queueHead].clear();
+    m_queueHead = (m_queueHead + 1) % m_depth;
+    --m_queueCount;
+
+    if (now >= 0 && slot->startTime >= 0 && now - slot->startTime > m_lateThreshold)
+        ++m_stats.late;
+
+    presentSlot(slot);
+}
+
+void FrameQueueSurface::presentSlot(const QSharedPointer<FrameSlot> &slot)
+{
+    QVideoFrame frame(new PooledVideoBuffer(slot), slot->size, slot->pixelFormat);
+    frame.setStartTime(slot->startTime);
+    frame.setEndTime(slot->endTime);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (m_target)
+        m_target->present(frame);
+    qint64 renderTime = timer.nsecsElapsed() / 1000;
+
+    ++m_stats.presented;
+    m_stats.lastRenderTime = renderTime;
+    m_stats.totalRenderTime += renderTime;
+    m_stats.maxRenderTime = qMax(m_stats.maxRenderTime, renderTime);
+}
@@ -0,0 +1,105 @@
+#ifndef FRAMEQUEUESURFACE_H
+#define FRAMEQUEUESURFACE_H
+
+#include <QAbstractVideoSurface>
+#include <QElapsedTimer>
+#include <QMediaPlayer>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+#include <QVideoSurfaceFormat>
+
+#include "coloradjustment.h"
+
+///Счётчики очереди кадров. Время отрисовки в микросекундах
+struct FrameQueueStats
+{
+    quint64 received = 0;
+    quint64 presented = 0;
+    quint64 late = 0;
+    quint64 dropped = 0;
+    qint64 lastRenderTime = 0;
+    qint64 maxRenderTime = 0;
+    qint64 totalRenderTime = 0;
+    int queued = 0;
+
+    qint64 averageRenderTime() const { return presented ? totalRenderTime / qint64(presented) : 0; }
+};
+
+///Слот пула: буфер кадра, выделенный один раз при старте поверхности
+struct FrameSlot
+{
+    QByteArray data;
+    QAtomicInt busy;
+    QVideoFrame::PixelFormat pixelFormat = QVideoFrame::Format_Invalid;
+    QSize size;
+    int bytesPerLine = 0;
+    int bytes = 0;
+    qint64 startTime = -1;
+    qint64 endTime = -1;
+};
+
+///Промежуточная поверхность между плеером и виджетом видео.
+///Кадры копируются в заранее выделенный пул и ставятся в очередь опережающего
+///декодирования, а планировщик выводит их по звуковым часам плеера:
+///из опоздавших кадров показывается только самый свежий, остальные отбрасываются
+class FrameQueueSurface : public QAbstractVideoSurface
+{
+    Q_OBJECT
+
+private:
+    QPointer<QAbstractVideoSurface> m_target;
+    QPointer<QMediaPlayer> m_clock;
+    ColorAdjustment *m_colorAdjustment = nullptr;
+
+    QVector<QSharedPointer<FrameSlot>> m_pool;
+    QVector<QSharedPointer<FrameSlot>> m_queue;
+    int m_queueHead = 0;
+    int m_queueCount = 0;
+    int m_depth = 4;
+    qint64 m_lateThreshold = 8000;
+
+    QTimer m_scheduler;
+    QElapsedTimer m_clockTimer;
+    qint64 m_lastClock = -1;
+
+    FrameQueueStats m_stats;
+
+    void allocatePool(int bytes);
+    QSharedPointer<FrameSlot> acquireSlot();
+    bool copyFrame(const QVideoFrame &frame, FrameSlot *slot);
+    void presentSlot(const QSharedPointer<FrameSlot> &slot);
+    void dropQueued(int count);
+    qint64 clockTime();
+    bool clockRunning() const;
+
+private slots:
+    void schedule();
+    void clockStateChanged(QMediaPlayer::State state);
+
+public:
+    explicit FrameQueueSurface(QObject *parent = nullptr);
+    ~FrameQueueSurface();
+
+    void setTarget(QAbstractVideoSurface *target);
+    void setClock(QMediaPlayer *player);
+    void setColorAdjustment(ColorAdjustment *adjustment);
+
+    int depth() const { return m_depth; }
+    void setDepth(int depth);
+    qint64 lateThreshold() const { return m_lateThreshold; }
+    void setLateThreshold(qint64 microseconds) { m_lateThreshold = microseconds; }
+
+    FrameQueueStats stats() const;
+    void resetStats();
+
+    QList<QVideoFrame::PixelFormat> supportedPixelFormats(
+            QAbstractVideoBuffer::HandleType type = QAbstractVideoBuffer::NoHandle) const override;
+    bool isFormatSupported(const QVideoSurfaceFormat &format) const override;
+    bool start(const QVideoSurfaceFormat &format) override;
+    void stop() override;
+    bool present(const QVideoFrame &frame) override;
+};
+
+#endif // FRAMEQUEUESURFACE_H
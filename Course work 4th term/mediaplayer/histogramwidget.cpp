@@ -2,14 +2,17 @@
 #include <QPainter>
 #include <QHBoxLayout>
 
-template <class T>
-static QVector<qreal> getBufferLevels(const T *buffer, int frames, int channels);
+#include "audiolevels.h"
+#include "lumahistogram.h"
+#include "trace.h"
+
+constexpr qreal HistogramWidget::ReductionRangeDb;
 
 class QAudioLevel : public QWidget
 {
     Q_OBJECT
 public:
-    explicit QAudioLevel(QWidget *parent = nullptr);
+    explicit QAudioLevel(QWidget *parent = nullptr, const QColor &color = QColor("#3575ff"), bool fromRight = false);
 
     void setLevel(qreal level);
 
@@ -18,10 +21,14 @@ protected:
 
 private:
     qreal m_level = 0;
+    QColor m_color;
+    bool m_fromRight;
 };
 
-QAudioLevel::QAudioLevel(QWidget *parent)
-    : QWidget(parent)
+QAudioLevel::QAudioLevel(QWidget *parent, const QColor &color, bool fromRight)
+    : QWidget(parent),
+      m_color(color),
+      m_fromRight(fromRight)
 {
     setMinimumHeight(15);
     setMaximumHeight(50);
@@ -40,20 +47,21 @@ void QAudioLevel::paintEvent(QPaintEvent *event)
     Q_UNUSED(event);
 
     QPainter painter(this);
-    ///Отрисовка уровня громкости
+    ///Отрисовка уровня громкости; ослабление растёт справа налево
     qreal widthLevel = m_level * width();
-    painter.fillRect(0, 0, widthLevel, height(), "#3575ff");
+    qreal start = m_fromRight ? width() - widthLevel : 0;
+    painter.fillRect(QRectF(start, 0, widthLevel, height()), m_color);
     ///Отрисовка черного фона
-    painter.fillRect(widthLevel, 0, width(), height(), "#292929");
+    painter.fillRect(QRectF(m_fromRight ? 0 : widthLevel, 0, width() - widthLevel, height()), QColor("#292929"));
 }
 
 HistogramWidget::HistogramWidget(QWidget *parent)
     : QWidget(parent)
 {
+    m_processorThread.setObjectName("histogram");
     m_processor.moveToThread(&m_processorThread);
     qRegisterMetaType<QVector<qreal>>("QVector<qreal>");
     connect(&m_processor, &FrameProcessor::histogramReady, this, &HistogramWidget::setHistogram);
-    m_processorThread.start(QThread::LowestPriority);
     setLayout(new QHBoxLayout);
 }
 
@@ -68,46 +76,37 @@ void HistogramWidget::processFrame(const QVideoFrame &frame)
     if (m_isBusy && frame.isValid())
         return;
 
+    ///Поток обработки запускается только с первым кадром:
+    ///звуковой гистограмме и пустому окну он не нужен
+    if (!m_processorThread.isRunning()) {
+        if (!frame.isValid()) {
+            setHistogram(QVector<qreal>());
+            return;
+        }
+        m_processorThread.start(QThread::LowestPriority);
+    }
+
     m_isBusy = true;
     QMetaObject::invokeMethod(&m_processor, "processFrame",
                               Qt::QueuedConnection, Q_ARG(QVideoFrame, frame), Q_ARG(int, m_levels));
 }
 
-///Функция, которая возвращает максимальное возможное значение для аудиоформата
-qreal getPeakValue(const QAudioFormat& format)
+///Тип отсчёта аудиоформата для ядра уровней. Unknown считается беззнаковым
+static bool sampleTypeOf(const QAudioFormat &format, AudioLevels::SampleType *type)
 {
-    if (!format.isValid())
-        return qreal(0);
-
-    if (format.codec() != "audio/pcm")
-        return qreal(0);
-
     switch (format.sampleType()) {
     case QAudioFormat::Unknown:
-        break;
+    case QAudioFormat::UnSignedInt:
+        *type = AudioLevels::UnSignedInt;
+        return true;
     case QAudioFormat::Float:
-        if (format.sampleSize() != 32)
-            return qreal(0);
-        return qreal(1.00003);
+        *type = AudioLevels::Float;
+        return true;
     case QAudioFormat::SignedInt:
-        if (format.sampleSize() == 32)
-            return qreal(INT_MAX);
-        if (format.sampleSize() == 16)
-            return qreal(SHRT_MAX);
-        if (format.sampleSize() == 8)
-            return qreal(CHAR_MAX);
-        break;
-    case QAudioFormat::UnSignedInt:
-        if (format.sampleSize() == 32)
-            return qreal(UINT_MAX);
-        if (format.sampleSize() == 16)
-            return qreal(USHRT_MAX);
-        if (format.sampleSize() == 8)
-            return qreal(UCHAR_MAX);
-        break;
+        *type = AudioLevels::SignedInt;
+        return true;
     }
-
-    return qreal(0);
+    return false;
 }
 
 ///Функция, которая возвращает уровень громкости для каждого канала
@@ -124,72 +123,28 @@ QVector<qreal> getBufferLevels(const QAudioBuffer& buffer)
     if (buffer.format().codec() != "audio/pcm")
         return values;
 
-    int channelCount = buffer.format().channelCount();
-    values.fill(0, channelCount);
-    qreal peak_value = getPeakValue(buffer.format());
-    if (qFuzzyCompare(peak_value, qreal(0)))
+    AudioLevels::SampleType type;
+    if (!sampleTypeOf(buffer.format(), &type)) {
+        values.fill(0, buffer.format().channelCount());
         return values;
-
-    switch (buffer.format().sampleType()) {
-    case QAudioFormat::Unknown:
-    case QAudioFormat::UnSignedInt:
-        if (buffer.format().sampleSize() == 32)
-            values = getBufferLevels(buffer.constData<quint32>(), buffer.frameCount(), channelCount);
-        if (buffer.format().sampleSize() == 16)
-            values = getBufferLevels(buffer.constData<quint16>(), buffer.frameCount(), channelCount);
-        if (buffer.format().sampleSize() == 8)
-            values = getBufferLevels(buffer.constData<quint8>(), buffer.frameCount(), channelCount);
-        for (int i = 0; i < values.size(); ++i)
-            values[i] = qAbs(values.at(i) - peak_value / 2) / (peak_value / 2);
-        break;
-    case QAudioFormat::Float:
-        if (buffer.format().sampleSize() == 32) {
-            values = getBufferLevels(buffer.constData<float>(), buffer.frameCount(), channelCount);
-            for (int i = 0; i < values.size(); ++i)
-                values[i] /= peak_value;
-        }
-        break;
-    case QAudioFormat::SignedInt:
-        if (buffer.format().sampleSize() == 32)
-            values = getBufferLevels(buffer.constData<qint32>(), buffer.frameCount(), channelCount);
-        if (buffer.format().sampleSize() == 16)
-            values = getBufferLevels(buffer.constData<qint16>(), buffer.frameCount(), channelCount);
-        if (buffer.format().sampleSize() == 8)
-            values = getBufferLevels(buffer.constData<qint8>(), buffer.frameCount(), channelCount);
-        for (int i = 0; i < values.size(); ++i)
-            values[i] /= peak_value;
-        break;
-    }
-
-    return values;
-}
-
-template <class T>
-QVector<qreal> getBufferLevels(const T *buffer, int frames, int channels)
-{
-    QVector<qreal> max_values;
-    max_values.fill(0, channels);
-
-    for (int i = 0; i < frames; ++i) {
-        for (int j = 0; j < channels; ++j) {
-            qreal value = qAbs(qreal(buffer[i * channels + j]));
-            if (value > max_values.at(j))
-                max_values.replace(j, value);
-        }
     }
 
-    return max_values;
+    return AudioLevels::levels(buffer.constData(), buffer.frameCount(), buffer.format().channelCount(),
+                               type, buffer.format().sampleSize());
 }
 
 void HistogramWidget::processBuffer(const QAudioBuffer &buffer)
 {
+    TRACE_SCOPE("analysis", "HistogramWidget::processBuffer");
+
     if (m_audioLevels.count() != buffer.format().channelCount()) {
         qDeleteAll(m_audioLevels);
         m_audioLevels.clear();
+        ///Уровни каналов стоят перед индикатором ослабления
         for (int i = 0; i < buffer.format().channelCount(); ++i) {
             QAudioLevel *level = new QAudioLevel(this);
             m_audioLevels.append(level);
-            layout()->addWidget(level);
+            static_cast<QHBoxLayout *>(layout())->insertWidget(i, level);
         }
     }
 
@@ -198,8 +153,28 @@ void HistogramWidget::processBuffer(const QAudioBuffer &buffer)
         m_audioLevels.at(i)->setLevel(levels.at(i));
 }
 
+///Индикатор ослабления виден, только пока звук идёт через обработку динамики
+void HistogramWidget::setGainReduction(qreal db)
+{
+    if (db < 0) {
+        if (m_reductionLevel)
+            m_reductionLevel->setVisible(false);
+        return;
+    }
+
+    if (!m_reductionLevel) {
+        m_reductionLevel = new QAudioLevel(this, QColor("#ff9f35"), true);
+        m_reductionLevel->setToolTip(tr("Gain reduction"));
+        layout()->addWidget(m_reductionLevel);
+    }
+    m_reductionLevel->setVisible(true);
+    m_reductionLevel->setLevel(qMin(db, ReductionRangeDb) / ReductionRangeDb);
+}
+
 void HistogramWidget::setHistogram(const QVector<qreal> &histogram)
 {
+    TRACE_SCOPE("analysis", "HistogramWidget::setHistogram");
+
     m_isBusy = false;
     m_histogram = histogram;
     update();
@@ -208,6 +183,7 @@ void HistogramWidget::setHistogram(const QVector<qreal> &histogram)
 void HistogramWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
+    TRACE_SCOPE("paint", "HistogramWidget::paintEvent");
 
     if (!m_audioLevels.isEmpty())
         return;
@@ -230,6 +206,8 @@ void HistogramWidget::paintEvent(QPaintEvent *event)
 
 void FrameProcessor::processFrame(QVideoFrame frame, int levels)
 {
+    TRACE_SCOPE("analysis", "FrameProcessor::processFrame");
+
     QVector<qreal> histogram(levels);
 
     do {
@@ -239,41 +217,22 @@ void FrameProcessor::processFrame(QVideoFrame frame, int levels)
         if (!frame.map(QAbstractVideoBuffer::ReadOnly))
             break;
 
+        m_histogram.reset();
         if (frame.pixelFormat() == QVideoFrame::Format_YUV420P ||
             frame.pixelFormat() == QVideoFrame::Format_NV12) {
-            uchar *b = frame.bits();
-            for (int y = 0; y < frame.height(); ++y) {
-                uchar *lastPixel = b + frame.width();
-                for (uchar *curPixel = b; curPixel < lastPixel; curPixel++)
-                    histogram[(*curPixel * levels) >> 8] += 1.0;
-                b += frame.bytesPerLine();
-            }
+            m_histogram.addPlane(frame.bits(), frame.width(), frame.height(), frame.bytesPerLine());
+        } else if (frame.pixelFormat() == QVideoFrame::Format_RGB32 ||
+                   frame.pixelFormat() == QVideoFrame::Format_ARGB32) {
+            m_histogram.addRgb32(frame.bits(), frame.width(), frame.height(), frame.bytesPerLine());
         } else {
             QImage::Format imageFormat = QVideoFrame::imageFormatFromPixelFormat(frame.pixelFormat());
             if (imageFormat != QImage::Format_Invalid) {
-                QImage image(frame.bits(), frame.width(), frame.height(), imageFormat);
+                QImage image(frame.bits(), frame.width(), frame.height(), frame.bytesPerLine(), imageFormat);
                 image = image.convertToFormat(QImage::Format_RGB32);
-
-                const QRgb* b = (const QRgb*)image.bits();
-                for (int y = 0; y < image.height(); ++y) {
-                    const QRgb *lastPixel = b + frame.width();
-                    for (const QRgb *curPixel = b; curPixel < lastPixel; curPixel++)
-                        histogram[(qGray(*curPixel) * levels) >> 8] += 1.0;
-                    b = (const QRgb*)((uchar*)b + image.bytesPerLine());
-                }
+                m_histogram.addRgb32(image.constBits(), image.width(), image.height(), image.bytesPerLine());
             }
         }
-
-        qreal maxValue = 0.0;
-        for (int i = 0; i < histogram.size(); i++) {
-            if (histogram[i] > maxValue)
-                maxValue = histogram[i];
-        }
-
-        if (maxValue > 0.0) {
-            for (int i = 0; i < histogram.size(); i++)
-                histogram[i] /= maxValue;
-        }
+        histogram = m_histogram.levels(levels);
 
         frame.unmap();
     } while (false);
@@ -6,12 +6,17 @@
 #include <QAudioBuffer>
 #include <QWidget>
 
+#include "lumahistogram.h"
+
 class QAudioLevel;
 
 class FrameProcessor: public QObject
 {
     Q_OBJECT
 
+private:
+    LumaHistogram m_histogram;
+
 public slots:
     void processFrame(QVideoFrame frame, int levels);
 
@@ -30,11 +35,15 @@ private:
     QThread m_processorThread;
     bool m_isBusy = false;
     QVector<QAudioLevel *> m_audioLevels;
+    QAudioLevel *m_reductionLevel = nullptr;
 
 protected:
     void paintEvent(QPaintEvent *event) override;
 
 public:
+    ///Полная шкала индикатора ослабления
+    static constexpr qreal ReductionRangeDb = 12.0;
+
     explicit HistogramWidget(QWidget *parent = nullptr);
     ~HistogramWidget();
     void setLevels(int levels) { m_levels = levels; }
@@ -42,6 +51,8 @@ public:
 public slots:
     void processFrame(const QVideoFrame &frame);
     void processBuffer(const QAudioBuffer &buffer);
+    ///Ослабление динамики в дБ; отрицательное прячет индикатор
+    void setGainReduction(qreal db);
     void setHistogram(const QVector<qreal> &histogram);
 
 };
@@ -1,11 +1,23 @@
 #include "widget.h"
+#include "startuptimeline.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    StartupTimeline::start(argc, argv);
+
     QApplication a(argc, argv);
+    StartupTimeline::mark("QApplication");
+
+    a.setStyleSheet(Style::applicationStyleSheet());
+    StartupTimeline::mark("application style sheet");
+
     Widget w;
+    StartupTimeline::mark("Widget constructed");
+
+    StartupTimeline::watchFirstPaint(&w);
     w.show();
+    StartupTimeline::mark("Widget shown");
 
     return a.exec();
 }
@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Сборка плеера вместе с библиотекой анализа, бенчмарками и тестами
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    analysis \
+    app \
+    benchmarks \
+    tests
+
+app.file = audioplayerByBalash.pro
+app.makefile = Makefile.app
+app.depends = analysis
+benchmarks.depends = analysis
@@ -0,0 +1,287 @@
+#include "mediasession.h"
+
+#include <QAbstractVideoSurface>
+#include <QFile>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+MediaSession::MediaSession(const QString &name, QAudio::Role role, QObject *parent)
+    : QObject(parent),
+      m_name(name),
+      m_role(role)
+{
+    m_playlist = new QMediaPlaylist(this);
+
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(10000);
+    connect(&m_idleTimer, &QTimer::timeout, this, &MediaSession::release);
+}
+
+///Без сигналов: получатели могут разрушаться вместе с окном, которому принадлежит сессия
+MediaSession::~MediaSession()
+{
+    if (m_player) {
+        disconnect(m_player, nullptr, this, nullptr);
+        m_player->setPlaylist(nullptr);
+        delete m_player;
+    }
+}
+
+///Создаёт конвейер, если его ещё нет. Сохранённые настройки применяются
+///до подключения плейлиста, чтобы первый буфер уже шёл с нужной громкостью
+QMediaPlayer *MediaSession::acquire()
+{
+    if (m_player)
+        return m_player;
+
+    m_player = new QMediaPlayer(this);
+    m_player->setAudioRole(m_role);
+    applyVolume();
+    m_player->setPlaybackRate(m_playbackRate);
+    if (m_videoOutput)
+        m_player->setVideoOutput(m_videoOutput.data());
+
+    connect(m_player, &QMediaPlayer::stateChanged, this, &MediaSession::playerStateChanged);
+    connect(m_player, &QMediaPlayer::stateChanged, this, &MediaSession::stateChanged);
+    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &MediaSession::mediaStatusChanged);
+    connect(m_player, &QMediaPlayer::durationChanged, this, &MediaSession::durationChanged);
+    connect(m_player, &QMediaPlayer::positionChanged, this, &MediaSession::positionChanged);
+    connect(m_player, &QMediaPlayer::bufferStatusChanged, this, &MediaSession::bufferStatusChanged);
+    connect(m_player, &QMediaPlayer::videoAvailableChanged, this, &MediaSession::videoAvailableChanged);
+    connect(m_player, QOverload<>::of(&QMediaPlayer::metaDataChanged), this, &MediaSession::metaDataChanged);
+    connect(m_player, QOverload<QMediaPlayer::Error>::of(&QMediaPlayer::error), this, &MediaSession::error);
+
+    emit playerCreated(m_player);
+    m_player->setPlaylist(m_playlist);
+    return m_player;
+}
+
+///Плейлист остаётся у сессии, поэтому после освобождения
+///текущий трек и порядок воспроизведения сохраняются
+void MediaSession::release()
+{
+    m_idleTimer.stop();
+    if (!m_player)
+        return;
+
+    QMediaPlayer *player = m_player;
+    bool hadVideo = player->isVideoAvailable();
+    m_player = nullptr;
+
+    disconnect(player, nullptr, this, nullptr);
+    player->stop();
+    player->setVideoOutput(static_cast<QAbstractVideoSurface *>(nullptr));
+    player->setPlaylist(nullptr);
+
+    emit playerReleased(player);
+    if (hadVideo)
+        emit videoAvailableChanged(false);
+
+    player->deleteLater();
+}
+
+void MediaSession::playerStateChanged(QMediaPlayer::State state)
+{
+    if (state == QMediaPlayer::StoppedState)
+        m_idleTimer.start();
+    else
+        m_idleTimer.stop();
+}
+
+void MediaSession::setVideoOutput(QAbstractVideoSurface *surface)
+{
+    m_videoOutput = surface;
+    if (m_player)
+        m_player->setVideoOutput(surface);
+}
+
+QMediaPlayer::State MediaSession::state() const
+{
+    return m_player ? m_player->state() : QMediaPlayer::StoppedState;
+}
+
+QMediaPlayer::MediaStatus MediaSession::mediaStatus() const
+{
+    return m_player ? m_player->mediaStatus() : QMediaPlayer::NoMedia;
+}
+
+qint64 MediaSession::position() const
+{
+    return m_player ? m_player->position() : 0;
+}
+
+qint64 MediaSession::duration() const
+{
+    return m_player ? m_player->duration() : 0;
+}
+
+///Без созданного плеера сессия считается доступной: конвейер появится по требованию
+bool MediaSession::isAvailable() const
+{
+    return m_player ? m_player->isAvailable() : true;
+}
+
+bool MediaSession::isVideoAvailable() const
+{
+    return m_player && m_player->isVideoAvailable();
+}
+
+bool MediaSession::isMetaDataAvailable() const
+{
+    return m_player && m_player->isMetaDataAvailable();
+}
+
+QVariant MediaSession::metaData(const QString &key) const
+{
+    return m_player ? m_player->metaData(key) : QVariant();
+}
+
+QString MediaSession::errorString() const
+{
+    return m_player ? m_player->errorString() : QString();
+}
+
+///Пустой плейлист не стоит конвейера: play() на нём ничего не создаёт
+void MediaSession::play()
+{
+    if (m_playlist->isEmpty())
+        return;
+    acquire()->play();
+}
+
+void MediaSession::pause()
+{
+    if (m_player)
+        m_player->pause();
+}
+
+void MediaSession::stop()
+{
+    if (m_player)
+        m_player->stop();
+}
+
+void MediaSession::setPosition(qint64 position)
+{
+    if (m_player)
+        m_player->setPosition(position);
+}
+
+///Сигналы громкости идут от сессии, а не от плеера: при маршрутизации
+///в микшер громкость плеера всегда нулевая
+void MediaSession::setVolume(int volume)
+{
+    if (m_volume == volume)
+        return;
+    m_volume = volume;
+    applyVolume();
+    emit volumeChanged(volume);
+}
+
+void MediaSession::setMuted(bool muted)
+{
+    if (m_muted == muted)
+        return;
+    m_muted = muted;
+    applyVolume();
+    emit mutedChanged(muted);
+}
+
+void MediaSession::setRouted(bool routed)
+{
+    m_routed = routed;
+    applyVolume();
+}
+
+void MediaSession::applyVolume()
+{
+    if (!m_player)
+        return;
+    m_player->setVolume(m_routed ? 0 : m_volume);
+    m_player->setMuted(m_routed ? false : m_muted);
+}
+
+void MediaSession::setPlaybackRate(qreal rate)
+{
+    m_playbackRate = rate;
+    if (m_player)
+        m_player->setPlaybackRate(rate);
+}
+
+MediaSessionManager::MediaSessionManager(QObject *parent)
+    : QObject(parent)
+{
+}
+
+MediaSession *MediaSessionManager::createSession(const QString &name, QAudio::Role role)
+{
+    MediaSession *session = new MediaSession(name, role, this);
+    m_sessions.append(session);
+    return session;
+}
+
+int MediaSessionManager::activeCount() const
+{
+    int count = 0;
+    for (MediaSession *session : m_sessions)
+        count += session->isActive();
+    return count;
+}
+
+///Освобождает конвейеры всех остановленных сессий, не дожидаясь таймера
+void MediaSessionManager::releaseIdle()
+{
+    for (MediaSession *session : m_sessions)
+        if (session->state() == QMediaPlayer::StoppedState)
+            session->release();
+}
+
+///Резидентный объём процесса в байтах, -1 если платформа не поддерживается
+qint64 MediaSessionManager::residentMemory()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.WorkingSetSize);
+    return -1;
+#elif defined(Q_OS_UNIX)
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+QString MediaSessionManager::memoryReport() const
+{
+    static const char *const states[] = { "stopped", "playing", "paused" };
+
+    const qint64 resident = residentMemory();
+    QString report = QString("Media sessions: %1 of %2 active, resident %3\n")
+            .arg(activeCount())
+            .arg(m_sessions.size())
+            .arg(resident < 0 ? QString("n/a") : QString("%1 MB").arg(resident / 1048576.0, 0, 'f', 1));
+
+    for (MediaSession *session : m_sessions) {
+        report += QString("  %1  ").arg(session->name(), -8);
+        if (session->isActive()) {
+            report += QString("active  %1  %2")
+                    .arg(QString::fromLatin1(states[session->state()]), -8)
+                    .arg(session->playlist()->currentMedia().canonicalUrl().fileName());
+        } else {
+            report += QString("released, %1 items queued").arg(session->playlist()->mediaCount());
+        }
+        report += QLatin1Char('\n');
+    }
+    return report;
+}
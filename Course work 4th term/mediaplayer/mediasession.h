@@ -0,0 +1,125 @@
+#ifndef MEDIASESSION_H
+#define MEDIASESSION_H
+
+#include <QAudio>
+#include <QMediaPlayer>
+#include <QMediaPlaylist>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+QT_FORWARD_DECLARE_CLASS(QAbstractVideoSurface)
+
+///Поток воспроизведения с конвейером декодирования по требованию.
+///Плейлист и настройки (громкость, скорость, видеовыход) живут всё время,
+///а QMediaPlayer создаётся при первом play() и освобождается вместе с декодером
+///и буферами, если сессия простояла остановленной дольше idleTimeout.
+///Сигналы плеера пробрасываются, поэтому подписчикам не важно, есть ли он сейчас
+class MediaSession : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString m_name;
+    QAudio::Role m_role;
+    QMediaPlaylist *m_playlist = nullptr;
+    QMediaPlayer *m_player = nullptr;
+    QPointer<QAbstractVideoSurface> m_videoOutput;
+
+    int m_volume = 100;
+    bool m_muted = false;
+    qreal m_playbackRate = 1.0;
+    bool m_routed = false;
+
+    QTimer m_idleTimer;
+
+    void applyVolume();
+
+private slots:
+    void playerStateChanged(QMediaPlayer::State state);
+
+public:
+    MediaSession(const QString &name, QAudio::Role role, QObject *parent = nullptr);
+    ~MediaSession();
+
+    QString name() const { return m_name; }
+    QMediaPlaylist *playlist() const { return m_playlist; }
+
+    QMediaPlayer *player() const { return m_player; }
+    QMediaPlayer *acquire();
+    bool isActive() const { return m_player != nullptr; }
+
+    int idleTimeout() const { return m_idleTimer.interval(); }
+    void setIdleTimeout(int milliseconds) { m_idleTimer.setInterval(milliseconds); }
+
+    void setVideoOutput(QAbstractVideoSurface *surface);
+
+    ///Звук сессии уходит в микшер: собственный вывод плеера заглушается,
+    ///а громкость и mute сессии применяет микшер
+    bool isRouted() const { return m_routed; }
+    void setRouted(bool routed);
+
+    QMediaPlayer::State state() const;
+    QMediaPlayer::MediaStatus mediaStatus() const;
+    qint64 position() const;
+    qint64 duration() const;
+    int volume() const { return m_volume; }
+    bool isMuted() const { return m_muted; }
+    qreal playbackRate() const { return m_playbackRate; }
+    bool isAvailable() const;
+    bool isVideoAvailable() const;
+    bool isMetaDataAvailable() const;
+    QVariant metaData(const QString &key) const;
+    QString errorString() const;
+
+public slots:
+    void play();
+    void pause();
+    void stop();
+    void setPosition(qint64 position);
+    void setVolume(int volume);
+    void setMuted(bool muted);
+    void setPlaybackRate(qreal rate);
+    void release();
+
+signals:
+    void playerCreated(QMediaPlayer *player);
+    void playerReleased(QMediaPlayer *player);
+
+    void stateChanged(QMediaPlayer::State state);
+    void mediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void durationChanged(qint64 duration);
+    void positionChanged(qint64 position);
+    void bufferStatusChanged(int percentFilled);
+    void videoAvailableChanged(bool videoAvailable);
+    void volumeChanged(int volume);
+    void mutedChanged(bool muted);
+    void metaDataChanged();
+    void error(QMediaPlayer::Error error);
+};
+
+///Владелец всех сессий окна. Отчёт о памяти показывает, какие конвейеры
+///сейчас созданы, и резидентный объём процесса
+class MediaSessionManager : public QObject
+{
+    Q_OBJECT
+
+private:
+    QVector<MediaSession *> m_sessions;
+
+public:
+    explicit MediaSessionManager(QObject *parent = nullptr);
+
+    MediaSession *createSession(const QString &name, QAudio::Role role);
+    QVector<MediaSession *> sessions() const { return m_sessions; }
+    int activeCount() const;
+
+    static qint64 residentMemory();
+    QString memoryReport() const;
+
+public slots:
+    void releaseIdle();
+};
+
+#endif // MEDIASESSION_H
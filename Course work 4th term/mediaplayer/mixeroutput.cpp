@@ -0,0 +1,254 @@
+#include "mixeroutput.h"
+
+#include <QAudioDeviceInfo>
+#include <QAudioProbe>
+#include <QtMath>
+
+MixerDevice::MixerDevice(AudioMixer *mixer, QObject *parent)
+    : QIODevice(parent),
+      m_mixer(mixer)
+{
+    m_block.fill(0.0f, m_mixer->blockFrames() * AudioMixer::Channels);
+}
+
+///Вызывается потоком вывода. Смесь считается блоками микшера прямо в буфер устройства
+qint64 MixerDevice::readData(char *data, qint64 maxSize)
+{
+    const int frameBytes = AudioMixer::Channels * int(sizeof(qint16));
+    const int frames = int(maxSize / frameBytes);
+    qint16 *out = reinterpret_cast<qint16 *>(data);
+
+    for (int done = 0; done < frames; ) {
+        const int block = qMin(frames - done, m_mixer->blockFrames());
+        m_mixer->process(m_block.data(), block);
+        AudioMixer::toInt16(m_block.constData(), out + done * AudioMixer::Channels, block * AudioMixer::Channels);
+        done += block;
+    }
+    return qint64(frames) * frameBytes;
+}
+
+qint64 MixerDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return 0;
+}
+
+///Смесь есть всегда: при пустых кольцах микшер отдаёт тишину
+qint64 MixerDevice::bytesAvailable() const
+{
+    return qint64(m_mixer->blockFrames()) * AudioMixer::Channels * qint64(sizeof(qint16)) * 4
+            + QIODevice::bytesAvailable();
+}
+
+template <class T>
+static void convertFrames(const T *in, int frames, int channels, float scale, float offset, float *out)
+{
+    for (int i = 0; i < frames; ++i, in += channels, out += AudioMixer::Channels) {
+        out[0] = (float(in[0]) - offset) * scale;
+        out[1] = channels > 1 ? (float(in[1]) - offset) * scale : out[0];
+    }
+}
+
+MixerOutput::MixerOutput(QObject *parent)
+    : QObject(parent)
+{
+    m_meterTimer.setInterval(MeterMs);
+    connect(&m_meterTimer, &QTimer::timeout, this, &MixerOutput::publishGainReduction);
+}
+
+MixerOutput::~MixerOutput()
+{
+    stop();
+}
+
+///Номер потока в микшере совпадает с порядком добавления сессий
+int MixerOutput::addSession(MediaSession *session)
+{
+    const int stream = m_sources.size();
+    m_sources.append(Source());
+    m_sources[stream].session = session;
+
+    connect(session, &MediaSession::playerCreated, this, [this, stream]() { attachProbe(stream); });
+    connect(session, &MediaSession::volumeChanged, this, [this, stream]() { updateGain(stream); });
+    connect(session, &MediaSession::mutedChanged, this, [this, stream]() { updateGain(stream); });
+    connect(session, &MediaSession::stateChanged, this, [this, stream](QMediaPlayer::State state) {
+        if (m_running && state == QMediaPlayer::StoppedState) {
+            m_mixer.flush(stream);
+            resetSource(stream);
+        }
+    });
+    return stream;
+}
+
+void MixerOutput::setDucking(int key, int target, float thresholdDb, float depthDb, float attackMs, float releaseMs)
+{
+    m_duckKey = key;
+    m_duckTarget = target;
+    m_duckThreshold = thresholdDb;
+    m_duckDepth = depthDb;
+    m_duckAttack = attackMs;
+    m_duckRelease = releaseMs;
+
+    if (m_running)
+        m_mixer.setDucking(key, target, thresholdDb, depthDb, attackMs, releaseMs);
+}
+
+void MixerOutput::start()
+{
+    if (m_running)
+        return;
+
+    const QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+    QAudioFormat format;
+    format.setSampleRate(device.preferredFormat().sampleRate() > 0 ? device.preferredFormat().sampleRate() : 48000);
+    format.setChannelCount(AudioMixer::Channels);
+    format.setSampleSize(16);
+    format.setCodec("audio/pcm");
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setSampleType(QAudioFormat::SignedInt);
+    if (!device.isFormatSupported(format))
+        format.setSampleRate(48000);
+    m_format = format;
+
+    ///Блок 10 мс, кольцо на секунду: пробник отдаёт буферы неравномерно
+    const int rate = format.sampleRate();
+    m_mixer.configure(rate, rate / 100, m_sources.size(), rate);
+    if (m_duckKey >= 0)
+        m_mixer.setDucking(m_duckKey, m_duckTarget, m_duckThreshold, m_duckDepth, m_duckAttack, m_duckRelease);
+    else
+        m_mixer.clearDucking();
+
+    for (int i = 0; i < m_sources.size(); ++i) {
+        resetSource(i);
+        updateGain(i);
+        if (m_sources[i].session)
+            m_sources[i].session->setRouted(true);
+        attachProbe(i);
+    }
+
+    m_device = new MixerDevice(&m_mixer, this);
+    m_device->open(QIODevice::ReadOnly);
+
+    m_output = new QAudioOutput(device, format, this);
+    m_output->setBufferSize(format.bytesForDuration(40000));
+    m_output->start(m_device);
+    m_running = true;
+    m_meterTimer.start();
+}
+
+void MixerOutput::stop()
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    m_meterTimer.stop();
+    m_output->stop();
+    delete m_output;
+    m_output = nullptr;
+    delete m_device;
+    m_device = nullptr;
+
+    for (Source &source : m_sources)
+        if (source.session)
+            source.session->setRouted(false);
+    emit gainReductionChanged(-1);
+}
+
+void MixerOutput::publishGainReduction()
+{
+    emit gainReductionChanged(m_mixer.dynamics()->takeGainReduction());
+}
+
+void MixerOutput::updateGain(int stream)
+{
+    MediaSession *session = m_sources.at(stream).session;
+    if (!session || stream >= m_mixer.streamCount())
+        return;
+    m_mixer.setGain(stream, session->isMuted() ? 0.0f : session->volume() / 100.0f);
+}
+
+void MixerOutput::attachProbe(int stream)
+{
+    Source &source = m_sources[stream];
+    if (!m_running && !source.probe)
+        return;
+    if (!source.session || !source.session->player())
+        return;
+
+    if (!source.probe) {
+        source.probe = new QAudioProbe(this);
+        connect(source.probe, &QAudioProbe::audioBufferProbed, this, [this, stream](const QAudioBuffer &buffer) {
+            feed(stream, buffer);
+        });
+    }
+    if (!source.probe->isActive())
+        source.probe->setSource(source.session->player());
+}
+
+void MixerOutput::resetSource(int stream)
+{
+    Source &source = m_sources[stream];
+    source.stretcher.reset();
+    source.resampler.reset();
+}
+
+///Приводит буфер к float-стерео, реальному темпу и частоте микшера.
+///Растяжение и ресемплер хранят состояние между буферами, поэтому на стыках нет щелчков.
+///Их буферы выделяются при первой встрече с частотой источника, дальше — только рост до размера пробника
+void MixerOutput::feed(int stream, const QAudioBuffer &buffer)
+{
+    if (!m_running || !buffer.isValid())
+        return;
+
+    const QAudioFormat format = buffer.format();
+    int frames = buffer.frameCount();
+    const int channels = format.channelCount();
+    if (frames <= 0 || channels <= 0)
+        return;
+
+    Source &source = m_sources[stream];
+    source.converted.resize(frames * AudioMixer::Channels);
+    float *converted = source.converted.data();
+
+    if (format.sampleType() == QAudioFormat::Float && format.sampleSize() == 32)
+        convertFrames(buffer.constData<float>(), frames, channels, 1.0f, 0.0f, converted);
+    else if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 16)
+        convertFrames(buffer.constData<qint16>(), frames, channels, 1.0f / 32768, 0.0f, converted);
+    else if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 32)
+        convertFrames(buffer.constData<qint32>(), frames, channels, 1.0f / 2147483648.0f, 0.0f, converted);
+    else if (format.sampleType() == QAudioFormat::UnSignedInt && format.sampleSize() == 8)
+        convertFrames(buffer.constData<quint8>(), frames, channels, 1.0f / 128, 128.0f, converted);
+    else
+        return;
+
+    const float *data = converted;
+
+    ///При переходе на 1x хвост растяжения отбрасывается: бэкенд в этот момент тоже перестраивается
+    const qreal rate = source.session ? source.session->playbackRate() : 1.0;
+    const bool stretching = !qFuzzyCompare(rate, qreal(1.0));
+    if (stretching != source.stretching) {
+        source.stretching = stretching;
+        source.stretcher.reset();
+    }
+    if (stretching) {
+        if (source.stretcher.sampleRate() != format.sampleRate())
+            source.stretcher.configure(format.sampleRate());
+        source.stretcher.setRate(rate);
+        source.stretched.resize(source.stretcher.maxOutputFrames(frames) * AudioMixer::Channels);
+        frames = source.stretcher.process(data, frames, source.stretched.data());
+        data = source.stretched.constData();
+    }
+
+    if (format.sampleRate() != m_mixer.sampleRate()) {
+        if (source.resampler.inputRate() != format.sampleRate() || source.resampler.outputRate() != m_mixer.sampleRate())
+            source.resampler.configure(format.sampleRate(), m_mixer.sampleRate());
+        source.resampled.resize(source.resampler.maxOutputFrames(frames) * AudioMixer::Channels);
+        frames = source.resampler.process(data, frames, source.resampled.data());
+        data = source.resampled.constData();
+    }
+
+    if (frames > 0)
+        m_mixer.write(stream, data, frames);
+}
@@ -0,0 +1,109 @@
+#ifndef MIXEROUTPUT_H
+#define MIXEROUTPUT_H
+
+#include <QAudioBuffer>
+#include <QAudioOutput>
+#include <QIODevice>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+#include "audiomixer.h"
+#include "mediasession.h"
+#include "resampler.h"
+#include "timestretcher.h"
+
+QT_FORWARD_DECLARE_CLASS(QAudioProbe)
+
+///Устройство, из которого QAudioOutput забирает готовую смесь в формате Int16
+class MixerDevice : public QIODevice
+{
+    Q_OBJECT
+
+private:
+    AudioMixer *m_mixer;
+    QVector<float> m_block;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+public:
+    explicit MixerDevice(AudioMixer *mixer, QObject *parent = nullptr);
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+};
+
+///Сводит звук сессий в один выход. Звук каждой сессии снимается пробником,
+///приводится к float-стерео частоты микшера и пишется в его кольцо,
+///а собственный вывод плеера сессии при этом заглушён.
+///При скорости сессии не 1x бэкенд отдаёт звук быстрее или медленнее реального
+///времени; TimeStretcher возвращает ему реальную длительность, сохраняя высоту тона
+///независимо от того, что бэкенд сделал бы со своим выводом сам.
+///Пока вывод идёт, раз в MeterMs сообщает наибольшее ослабление обработки динамики
+class MixerOutput : public QObject
+{
+    Q_OBJECT
+
+private:
+    struct Source
+    {
+        QPointer<MediaSession> session;
+        QAudioProbe *probe = nullptr;
+        QVector<float> converted;
+        QVector<float> stretched;
+        QVector<float> resampled;
+        TimeStretcher stretcher;
+        Resampler resampler;
+        bool stretching = false;
+    };
+
+    AudioMixer m_mixer;
+    MixerDevice *m_device = nullptr;
+    QAudioOutput *m_output = nullptr;
+    QAudioFormat m_format;
+    QVector<Source> m_sources;
+    bool m_running = false;
+    QTimer m_meterTimer;
+
+    int m_duckKey = -1;
+    int m_duckTarget = -1;
+    float m_duckThreshold = -40;
+    float m_duckDepth = 12;
+    float m_duckAttack = 20;
+    float m_duckRelease = 500;
+
+    void updateGain(int stream);
+    void attachProbe(int stream);
+    void feed(int stream, const QAudioBuffer &buffer);
+    void resetSource(int stream);
+
+private slots:
+    void publishGainReduction();
+
+public:
+    static const int MeterMs = 50;
+
+    explicit MixerOutput(QObject *parent = nullptr);
+    ~MixerOutput();
+
+    AudioMixer *mixer() { return &m_mixer; }
+
+    int addSession(MediaSession *session);
+    void setDucking(int key, int target, float thresholdDb = -40, float depthDb = 12,
+                    float attackMs = 20, float releaseMs = 500);
+
+    bool isRunning() const { return m_running; }
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    ///Ослабление в дБ; отрицательное — вывод остановлен, показывать нечего
+    void gainReductionChanged(qreal db);
+};
+
+#endif // MIXEROUTPUT_H
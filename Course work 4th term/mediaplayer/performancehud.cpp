@@ -0,0 +1,378 @@
+#include "performancehud.h"
+
+#include <QAudioProbe>
+#include <QChildEvent>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QPainter>
+#include <QVideoProbe>
+
+#include <algorithm>
+
+RollingSeries::RollingSeries(int capacity)
+{
+    m_values.fill(0, qMax(1, capacity));
+}
+
+void RollingSeries::add(double value)
+{
+    m_values[m_next] = value;
+    m_next = (m_next + 1) % m_values.size();
+    if (m_count < m_values.size())
+        ++m_count;
+}
+
+void RollingSeries::clear()
+{
+    m_next = 0;
+    m_count = 0;
+}
+
+double RollingSeries::last() const
+{
+    if (!m_count)
+        return 0;
+    return m_values.at((m_next + m_values.size() - 1) % m_values.size());
+}
+
+///Копия окна сортируется один раз на все процентили: вызывается только при обновлении HUD
+RollingSeries::Percentiles RollingSeries::percentiles() const
+{
+    Percentiles result;
+    if (!m_count)
+        return result;
+
+    QVector<double> sorted = m_values.mid(0, m_count);
+    std::sort(sorted.begin(), sorted.end());
+    result.p50 = sorted.at((m_count - 1) * 50 / 100);
+    result.p95 = sorted.at((m_count - 1) * 95 / 100);
+    result.p99 = sorted.at((m_count - 1) * 99 / 100);
+    result.max = sorted.last();
+    return result;
+}
+
+///Меряет отрисовку, повторно отправляя событие Paint изнутри фильтра:
+///фильтр видит только начало события, а так известен и его конец.
+///Дочерние виджеты (уровни каналов гистограммы) подхватываются автоматически
+///и учитываются по имени класса
+class PaintWatcher : public QObject
+{
+private:
+    PerformanceMonitor *m_monitor;
+    QObject *m_dispatching = nullptr;
+
+public:
+    explicit PaintWatcher(PerformanceMonitor *monitor)
+        : QObject(monitor),
+          m_monitor(monitor)
+    {
+    }
+
+    void watch(QWidget *widget, const QString &name)
+    {
+        widget->setProperty("performanceName", name);
+        widget->installEventFilter(this);
+    }
+
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::ChildPolished) {
+            QObject *child = static_cast<QChildEvent *>(event)->child();
+            if (child->isWidgetType() && !child->property("performanceName").isValid())
+                watch(static_cast<QWidget *>(child), QString::fromLatin1(child->metaObject()->className()));
+            return false;
+        }
+
+        if (event->type() != QEvent::Paint || watched == m_dispatching || !m_monitor->isActive())
+            return false;
+
+        QObject *previous = m_dispatching;
+        m_dispatching = watched;
+        const qint64 start = m_monitor->now();
+        QCoreApplication::sendEvent(watched, event);
+        m_monitor->recordPaint(watched->property("performanceName").toString(), start, m_monitor->now() - start);
+        m_dispatching = previous;
+        return true;
+    }
+};
+
+PerformanceMonitor::PerformanceMonitor(QObject *parent)
+    : QObject(parent)
+{
+    m_paintWatcher = new PaintWatcher(this);
+
+    m_heartbeat.setInterval(16);
+    m_heartbeat.setTimerType(Qt::PreciseTimer);
+    connect(&m_heartbeat, &QTimer::timeout, this, &PerformanceMonitor::heartbeat);
+}
+
+PerformanceMonitor::~PerformanceMonitor()
+{
+    stopRecording();
+}
+
+PerformanceMonitor *PerformanceMonitor::instance()
+{
+    static PerformanceMonitor *monitor = new PerformanceMonitor(QCoreApplication::instance());
+    return monitor;
+}
+
+void PerformanceMonitor::acquire()
+{
+    ++m_users;
+    updateActive();
+}
+
+void PerformanceMonitor::release()
+{
+    m_users = qMax(0, m_users - 1);
+    updateActive();
+}
+
+///Окна замеров начинаются заново при каждом включении,
+///чтобы в процентили не попадали значения из прошлого сеанса
+void PerformanceMonitor::updateActive()
+{
+    if (isActive() && !m_heartbeat.isActive()) {
+        m_lastBeat = -1;
+        m_rateStart = now();
+        m_latency.clear();
+        for (auto it = m_paints.begin(); it != m_paints.end(); ++it)
+            it.value().clear();
+        for (auto it = m_probeCounts.begin(); it != m_probeCounts.end(); ++it)
+            it.value() = 0;
+        m_heartbeat.start();
+    } else if (!isActive()) {
+        m_heartbeat.stop();
+    }
+}
+
+///Опоздание пульса относительно интервала — столько событие ждало в очереди
+void PerformanceMonitor::heartbeat()
+{
+    const qint64 time = now();
+    if (m_lastBeat >= 0) {
+        const double late = qMax<qint64>(0, time - m_lastBeat - m_heartbeat.interval() * 1000) / 1000.0;
+        m_latency.add(late);
+        writeCounter("event loop latency", "ms", late);
+    }
+    m_lastBeat = time;
+
+    if (time - m_rateStart >= 1000000) {
+        const double seconds = (time - m_rateStart) / 1000000.0;
+        for (auto it = m_probeCounts.begin(); it != m_probeCounts.end(); ++it) {
+            const double rate = it.value() / seconds;
+            m_probeRates[it.key()] = rate;
+            writeCounter("probe rate", it.key(), rate);
+            it.value() = 0;
+        }
+        m_rateStart = time;
+    }
+}
+
+void PerformanceMonitor::watchPaint(QWidget *widget, const QString &name)
+{
+    m_paintWatcher->watch(widget, name);
+}
+
+void PerformanceMonitor::watchProbe(QAudioProbe *probe, const QString &name)
+{
+    m_probeCounts.insert(name, 0);
+    connect(probe, &QAudioProbe::audioBufferProbed, this, [this, name]() { recordProbe(name); });
+}
+
+void PerformanceMonitor::watchProbe(QVideoProbe *probe, const QString &name)
+{
+    m_probeCounts.insert(name, 0);
+    connect(probe, &QVideoProbe::videoFrameProbed, this, [this, name]() { recordProbe(name); });
+}
+
+void PerformanceMonitor::recordPaint(const QString &name, qint64 start, qint64 duration)
+{
+    m_paints[name].add(duration / 1000.0);
+    writeTraceEvent(QString("{\"name\":\"paint %1\",\"cat\":\"paint\",\"ph\":\"X\",\"ts\":%2,\"dur\":%3,\"pid\":%4,\"tid\":%5}")
+                    .arg(name).arg(start).arg(duration).arg(QCoreApplication::applicationPid()).arg(Trace::threadId()));
+}
+
+void PerformanceMonitor::recordProbe(const QString &name)
+{
+    if (isActive())
+        ++m_probeCounts[name];
+}
+
+///Заполнение буфера приходит редко, поэтому запоминается всегда
+void PerformanceMonitor::recordBufferFill(const QString &name, int percent)
+{
+    m_buffers[name].add(percent);
+    writeCounter("buffer fill", name, percent);
+}
+
+static QString formatSeries(const QString &title, const RollingSeries &series, const char *unit)
+{
+    const RollingSeries::Percentiles p = series.percentiles();
+    return QString("%1  p50 %2  p95 %3  p99 %4  max %5 %6")
+            .arg(title, -22)
+            .arg(p.p50, 5, 'f', 1).arg(p.p95, 5, 'f', 1).arg(p.p99, 5, 'f', 1).arg(p.max, 5, 'f', 1)
+            .arg(QString::fromLatin1(unit));
+}
+
+QStringList PerformanceMonitor::summary() const
+{
+    QStringList lines;
+    lines << formatSeries("event loop", m_latency, "ms");
+
+    for (auto it = m_paints.constBegin(); it != m_paints.constEnd(); ++it)
+        lines << formatSeries("paint " + it.key(), it.value(), "ms");
+
+    for (auto it = m_probeCounts.constBegin(); it != m_probeCounts.constEnd(); ++it)
+        lines << QString("%1  %2 /s").arg("probe " + it.key(), -22).arg(m_probeRates.value(it.key()), 5, 'f', 1);
+
+    for (auto it = m_buffers.constBegin(); it != m_buffers.constEnd(); ++it)
+        lines << formatSeries("buffer " + it.key(), it.value(), "%");
+
+    if (isRecording())
+        lines << "trace: " + QDir::toNativeSeparators(tracePath());
+    else
+        lines << "Ctrl+Shift+R: record trace";
+    return lines;
+}
+
+QString PerformanceMonitor::startRecording(const QString &path)
+{
+    if (isRecording())
+        return tracePath();
+
+    QString fileName = path;
+    if (fileName.isEmpty())
+        fileName = QDir::temp().filePath(QString("mediaplayer-trace-%1.json")
+                                         .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+
+    m_trace.setFileName(fileName);
+    if (!m_trace.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot open trace file" << fileName << m_trace.errorString();
+        return QString();
+    }
+
+    m_trace.write("[\n");
+    m_firstTraceEvent = true;
+    Trace::clear();
+    Trace::setEnabled(true);
+    updateActive();
+    return fileName;
+}
+
+void PerformanceMonitor::stopRecording()
+{
+    if (!isRecording())
+        return;
+
+    Trace::setEnabled(false);
+    const QByteArray events = Trace::chromeEvents();
+    if (!events.isEmpty()) {
+        if (!m_firstTraceEvent)
+            m_trace.write(",\n");
+        m_trace.write(events);
+    }
+
+    m_trace.write("\n]\n");
+    m_trace.close();
+    updateActive();
+}
+
+void PerformanceMonitor::toggleRecording()
+{
+    if (isRecording()) {
+        const QString path = tracePath();
+        stopRecording();
+        qDebug().noquote() << "Trace written to" << QDir::toNativeSeparators(path);
+    } else {
+        startRecording();
+    }
+}
+
+void PerformanceMonitor::writeTraceEvent(const QString &event)
+{
+    if (!isRecording())
+        return;
+
+    if (!m_firstTraceEvent)
+        m_trace.write(",\n");
+    m_firstTraceEvent = false;
+    m_trace.write(event.toUtf8());
+}
+
+void PerformanceMonitor::writeCounter(const QString &name, const QString &series, double value)
+{
+    if (!isRecording())
+        return;
+
+    writeTraceEvent(QString("{\"name\":\"%1\",\"ph\":\"C\",\"ts\":%2,\"pid\":%3,\"args\":{\"%4\":%5}}")
+                    .arg(name).arg(now()).arg(QCoreApplication::applicationPid()).arg(series).arg(value, 0, 'f', 3));
+}
+
+PerformanceHud::PerformanceHud(QWidget *host)
+    : QWidget(host)
+{
+    setObjectName("performanceHud");
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFocusPolicy(Qt::NoFocus);
+
+    QFont font("Consolas");
+    font.setStyleHint(QFont::Monospace);
+    font.setPointSize(8);
+    setFont(font);
+    hide();
+
+    m_refresh.setInterval(250);
+    connect(&m_refresh, &QTimer::timeout, this, &PerformanceHud::refresh);
+}
+
+PerformanceHud::~PerformanceHud()
+{
+    if (m_refresh.isActive())
+        PerformanceMonitor::instance()->release();
+}
+
+void PerformanceHud::toggle()
+{
+    if (m_refresh.isActive()) {
+        m_refresh.stop();
+        hide();
+        PerformanceMonitor::instance()->release();
+        return;
+    }
+
+    PerformanceMonitor::instance()->acquire();
+    move(12, 12);
+    refresh();
+    show();
+    m_refresh.start();
+}
+
+void PerformanceHud::refresh()
+{
+    m_lines = PerformanceMonitor::instance()->summary();
+
+    const QFontMetrics metrics(font());
+    int width = 0;
+    for (const QString &line : m_lines)
+        width = qMax(width, metrics.boundingRect(line).width());
+    resize(width + 16, m_lines.size() * metrics.height() + 12);
+    raise();
+    update();
+}
+
+void PerformanceHud::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(0, 0, 0, 190));
+    painter.setPen(QColor("#c1c1c1"));
+
+    const QFontMetrics metrics(font());
+    for (int i = 0; i < m_lines.size(); ++i)
+        painter.drawText(8, 6 + metrics.ascent() + i * metrics.height(), m_lines.at(i));
+}
@@ -0,0 +1,134 @@
+#ifndef PERFORMANCEHUD_H
+#define PERFORMANCEHUD_H
+
+#include <QFile>
+#include <QMap>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+#include "trace.h"
+
+QT_FORWARD_DECLARE_CLASS(QAudioProbe)
+QT_FORWARD_DECLARE_CLASS(QVideoProbe)
+
+class PaintWatcher;
+
+///Последние значения ряда в кольце фиксированного размера
+class RollingSeries
+{
+private:
+    QVector<double> m_values;
+    int m_next = 0;
+    int m_count = 0;
+
+public:
+    struct Percentiles
+    {
+        double p50 = 0;
+        double p95 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+    explicit RollingSeries(int capacity = 512);
+
+    void add(double value);
+    void clear();
+    int count() const { return m_count; }
+    double last() const;
+    Percentiles percentiles() const;
+};
+
+///Сборщик замеров для HUD: задержка цикла событий по опозданию таймера-пульса,
+///время отрисовки виджетов, частота вызовов пробников и заполнение буфера декодера.
+///Пока HUD скрыт и запись не идёт, пульс остановлен, а фильтры отрисовки
+///пропускают события без замеров.
+///Запись ведётся в JSON-формате chrome://tracing, при её остановке в тот же файл
+///сбрасываются кольца Trace со всех потоков
+class PerformanceMonitor : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTimer m_heartbeat;
+    qint64 m_lastBeat = -1;
+    qint64 m_rateStart = 0;
+    int m_users = 0;
+
+    PaintWatcher *m_paintWatcher = nullptr;
+
+    RollingSeries m_latency;
+    QMap<QString, RollingSeries> m_paints;
+    QMap<QString, int> m_probeCounts;
+    QMap<QString, double> m_probeRates;
+    QMap<QString, RollingSeries> m_buffers;
+
+    QFile m_trace;
+    bool m_firstTraceEvent = true;
+
+    explicit PerformanceMonitor(QObject *parent = nullptr);
+    void updateActive();
+    void writeTraceEvent(const QString &event);
+    void writeCounter(const QString &name, const QString &series, double value);
+
+private slots:
+    void heartbeat();
+
+public:
+    ~PerformanceMonitor();
+
+    static PerformanceMonitor *instance();
+
+    bool isActive() const { return m_users > 0 || isRecording(); }
+    void acquire();
+    void release();
+
+    ///Время в микросекундах на той же шкале, что и события Trace
+    qint64 now() const { return Trace::now() / 1000; }
+
+    void watchPaint(QWidget *widget, const QString &name);
+    void watchProbe(QAudioProbe *probe, const QString &name);
+    void watchProbe(QVideoProbe *probe, const QString &name);
+
+    void recordPaint(const QString &name, qint64 start, qint64 duration);
+    void recordProbe(const QString &name);
+    void recordBufferFill(const QString &name, int percent);
+
+    bool isRecording() const { return m_trace.isOpen(); }
+    QString tracePath() const { return m_trace.fileName(); }
+
+    QStringList summary() const;
+
+public slots:
+    QString startRecording(const QString &path = QString());
+    void stopRecording();
+    void toggleRecording();
+};
+
+///Полупрозрачная панель поверх окна со сводкой PerformanceMonitor.
+///Не перехватывает мышь, обновляется четыре раза в секунду, пока видна
+class PerformanceHud : public QWidget
+{
+    Q_OBJECT
+
+private:
+    QTimer m_refresh;
+    QStringList m_lines;
+
+private slots:
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+public:
+    explicit PerformanceHud(QWidget *host);
+    ~PerformanceHud();
+
+public slots:
+    void toggle();
+};
+
+#endif // PERFORMANCEHUD_H
@@ -0,0 +1,390 @@
+#include "playbackorder.h"
+
+#include <QDateTime>
+
+#include "playlistsequence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+///Перемешивает биты зерна (splitmix64), чтобы соседние зёрна давали разные очереди
+static quint64 mixSeed(quint64 seed)
+{
+    seed += 0x9E3779B97F4A7C15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+    seed ^= seed >> 31;
+    return seed ? seed : 1;
+}
+
+PlaybackOrder::PlaybackOrder(quint64 seed)
+    : m_random(mixSeed(seed ? seed : quint64(QDateTime::currentMSecsSinceEpoch())))
+{
+}
+
+///Равномерное число в [0, range) умножением вместо деления (xorshift64*)
+quint32 PlaybackOrder::bounded(quint32 range)
+{
+    m_random ^= m_random >> 12;
+    m_random ^= m_random << 25;
+    m_random ^= m_random >> 27;
+    const quint32 bits = quint32((m_random * 0x2545F4914F6CDD1DULL) >> 32);
+    return quint32((quint64(bits) * range) >> 32);
+}
+
+///Равномерное число в (0, 1]
+float PlaybackOrder::uniform()
+{
+    return float(bounded(1u << 24) + 1) / float(1u << 24);
+}
+
+void PlaybackOrder::reset(int count, int first)
+{
+    count = qMax(0, count);
+    m_order.resize(count);
+    m_position.resize(count);
+    m_weights.clear();
+    m_albums.clear();
+    build(first >= 0 && first < count ? first : -1, -1);
+}
+
+void PlaybackOrder::setMode(Mode mode)
+{
+    if (m_mode == mode)
+        return;
+    const int first = current();
+    m_mode = mode;
+    build(first, -1);
+}
+
+void PlaybackOrder::setWeight(int track, float weight)
+{
+    if (track < 0 || track >= count())
+        return;
+    if (m_weights.isEmpty())
+        m_weights.fill(1.0f, count());
+    m_weights[track] = weight;
+}
+
+void PlaybackOrder::setAlbum(int track, int album)
+{
+    if (track < 0 || track >= count())
+        return;
+    if (m_albums.isEmpty()) {
+        m_albums.resize(count());
+        for (int i = 0; i < count(); ++i)
+            m_albums[i] = -1 - i;
+    }
+    m_albums[track] = album;
+}
+
+int PlaybackOrder::current() const
+{
+    return m_cursor >= 0 && m_cursor < m_order.size() ? m_order.at(m_cursor) : -1;
+}
+
+///Конец очереди в режимах с перемешиванием — новый круг. Только что сыгранный
+///трек (или его альбом) не ставится первым, чтобы не прозвучать дважды подряд
+int PlaybackOrder::next()
+{
+    if (m_order.isEmpty())
+        return -1;
+
+    if (m_cursor + 1 < m_order.size()) {
+        ++m_cursor;
+    } else if (m_loop) {
+        if (m_mode != Sequential)
+            build(-1, current());
+        m_cursor = 0;
+    } else {
+        return -1;
+    }
+    return m_order.at(m_cursor);
+}
+
+///В начале круга истории нет: по порядку переход на последний трек, иначе остаёмся на месте
+int PlaybackOrder::previous()
+{
+    if (m_order.isEmpty())
+        return -1;
+
+    if (m_cursor > 0)
+        --m_cursor;
+    else if (m_mode == Sequential && m_loop)
+        m_cursor = m_order.size() - 1;
+    else if (m_cursor < 0)
+        m_cursor = 0;
+    return m_order.at(m_cursor);
+}
+
+///Ещё не сыгранный трек меняется местами с ближайшим в очереди,
+///уже сыгранный переносится из истории в её конец
+void PlaybackOrder::setCurrent(int track)
+{
+    if (track < 0 || track >= count())
+        return;
+
+    if (m_mode == Sequential) {
+        m_cursor = track;
+        return;
+    }
+
+    const int position = m_position.at(track);
+    if (position == m_cursor)
+        return;
+
+    if (position > m_cursor) {
+        ++m_cursor;
+        std::swap(m_order[position], m_order[m_cursor]);
+        m_position[m_order.at(position)] = position;
+        m_position[track] = m_cursor;
+    } else {
+        std::rotate(m_order.begin() + position, m_order.begin() + position + 1, m_order.begin() + m_cursor + 1);
+        updatePositions(position, m_cursor + 1);
+    }
+}
+
+///Номера треков за местом вставки сдвигаются одним проходом; при дописывании
+///в конец (импорт папки по одному файлу) сдвигать нечего, и вставка стоит O(count).
+///Каждый новый трек дописывается в конец и меняется местами со случайным ещё
+///не сыгранным — это шаг Фишера–Йетса «наизнанку», остаток очереди остаётся
+///равномерно перемешанным. Позиции правятся только у переставленных треков
+void PlaybackOrder::insert(int index, int count)
+{
+    const int size = m_order.size();
+    if (count <= 0 || index < 0 || index > size)
+        return;
+
+    if (!m_weights.isEmpty())
+        m_weights.insert(index, count, 1.0f);
+    if (!m_albums.isEmpty()) {
+        m_albums.insert(index, count, -1);
+        for (int i = index; i < index + count; ++i)
+            m_albums[i] = -1 - i - size;
+    }
+
+    m_order.resize(size + count);
+    m_position.resize(size + count);
+
+    ///По порядку очередь — тождественная перестановка, дописываются только новые номера
+    if (m_mode == Sequential) {
+        if (m_cursor >= index)
+            m_cursor += count;
+        for (int i = size; i < size + count; ++i) {
+            m_order[i] = i;
+            m_position[i] = i;
+        }
+        return;
+    }
+
+    const bool shifted = index < size;
+    if (shifted) {
+        for (int i = 0; i < size; ++i) {
+            if (m_order.at(i) >= index)
+                m_order[i] += count;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const int end = size + i;
+        const int first = m_cursor + 1;
+        const int target = first + int(bounded(quint32(end - first + 1)));
+        m_order[end] = m_order.at(target);
+        m_order[target] = index + i;
+        if (!shifted) {
+            m_position[m_order.at(end)] = end;
+            m_position[index + i] = target;
+        }
+    }
+    if (shifted)
+        updatePositions(0, size + count);
+}
+
+///Очередь сжимается с сохранением порядка остальных треков, начиная с самой ранней
+///позиции удалённых: до неё ничего не сдвигается. Номера остальных треков правятся,
+///только если удалены не последние треки плейлиста.
+///Если удалён текущий, курсор встаёт на предыдущий в истории, и next() продолжит круг
+void PlaybackOrder::remove(int index, int count)
+{
+    const int size = m_order.size();
+    if (count <= 0 || index < 0 || index >= size)
+        return;
+    count = qMin(count, size - index);
+    const int end = index + count;
+
+    if (!m_weights.isEmpty())
+        m_weights.remove(index, count);
+    if (!m_albums.isEmpty())
+        m_albums.remove(index, count);
+
+    if (m_mode == Sequential) {
+        if (m_cursor >= end)
+            m_cursor -= count;
+        else if (m_cursor >= index)
+            m_cursor = index - 1;
+        m_order.resize(size - count);
+        m_position.resize(size - count);
+        if (end < size) {
+            for (int i = index; i < size - count; ++i) {
+                m_order[i] = i;
+                m_position[i] = i;
+            }
+        }
+        return;
+    }
+
+    int from = size;
+    for (int track = index; track < end; ++track)
+        from = qMin(from, m_position.at(track));
+
+    int write = from;
+    int removedBeforeCursor = 0;
+    for (int i = from; i < size; ++i) {
+        const int track = m_order.at(i);
+        if (track >= index && track < end) {
+            if (i <= m_cursor)
+                ++removedBeforeCursor;
+            continue;
+        }
+        m_order[write++] = track >= end ? track - count : track;
+    }
+    m_cursor -= removedBeforeCursor;
+
+    m_order.resize(write);
+    m_position.resize(write);
+    if (end < size) {
+        for (int i = 0; i < from; ++i) {
+            if (m_order.at(i) >= end)
+                m_order[i] -= count;
+        }
+        updatePositions(0, write);
+    } else {
+        updatePositions(from, write);
+    }
+}
+
+void PlaybackOrder::move(const QVector<int> &rows, int destination)
+{
+    const int size = m_order.size();
+    if (rows.isEmpty() || size == 0)
+        return;
+
+    if (!m_weights.isEmpty()) {
+        m_keys = m_weights;
+        for (int i = 0; i < size; ++i)
+            m_weights[PlaylistSequence::rowAfterMove(rows, destination, i)] = m_keys.at(i);
+    }
+    if (!m_albums.isEmpty()) {
+        m_runs = m_albums;
+        for (int i = 0; i < size; ++i)
+            m_albums[PlaylistSequence::rowAfterMove(rows, destination, i)] = m_runs.at(i);
+    }
+
+    if (m_mode == Sequential) {
+        if (m_cursor >= 0)
+            m_cursor = PlaylistSequence::rowAfterMove(rows, destination, m_cursor);
+        return;
+    }
+
+    for (int i = 0; i < size; ++i)
+        m_order[i] = PlaylistSequence::rowAfterMove(rows, destination, m_order.at(i));
+    updatePositions(0, size);
+}
+
+///first встаёт в начало очереди и становится текущим,
+///avoid по возможности не ставится первым
+void PlaybackOrder::build(int first, int avoid)
+{
+    const int size = m_order.size();
+    for (int i = 0; i < size; ++i)
+        m_order[i] = i;
+
+    if (m_mode == Album) {
+        buildAlbums(first, avoid);
+        updatePositions(0, size);
+        return;
+    }
+
+    if (m_mode == Shuffle) {
+        for (int i = size - 1; i > 0; --i)
+            std::swap(m_order[i], m_order[int(bounded(quint32(i + 1)))]);
+    } else if (m_mode == Weighted) {
+        buildWeighted();
+    }
+
+    if (m_mode == Sequential) {
+        m_cursor = first;
+    } else if (first >= 0) {
+        const auto it = std::find(m_order.begin(), m_order.end(), first);
+        std::rotate(m_order.begin(), it, it + 1);
+        m_cursor = 0;
+    } else {
+        m_cursor = -1;
+        if (avoid >= 0 && size > 1 && m_order.at(0) == avoid)
+            std::swap(m_order[0], m_order[1 + int(bounded(quint32(size - 1)))]);
+    }
+    updatePositions(0, size);
+}
+
+///Ключ log(u) / w: сортировка по убыванию даёт выборку без возвращения
+///с вероятностями, пропорциональными весам. Нулевой вес — в самый конец
+void PlaybackOrder::buildWeighted()
+{
+    const int size = m_order.size();
+    m_keys.resize(size);
+    for (int i = 0; i < size; ++i) {
+        const float weight = m_weights.isEmpty() ? 1.0f : m_weights.at(i);
+        m_keys[i] = weight > 0 ? std::log(uniform()) / weight : -std::numeric_limits<float>::infinity();
+    }
+
+    const float *keys = m_keys.constData();
+    std::sort(m_order.begin(), m_order.end(), [keys](int a, int b) { return keys[a] > keys[b]; });
+}
+
+///Альбом — подряд идущие в плейлисте треки с одним номером альбома.
+///Альбом с first ставится первым, курсор — на first внутри него
+void PlaybackOrder::buildAlbums(int first, int avoid)
+{
+    const int size = m_order.size();
+    m_runs.resize(0);
+    for (int i = 0; i < size; ++i) {
+        if (i == 0 || m_albums.isEmpty() || m_albums.at(i) != m_albums.at(i - 1))
+            m_runs.append(i);
+    }
+    const int runCount = m_runs.size();
+    m_runs.append(size);
+
+    m_runOrder.resize(runCount);
+    for (int i = 0; i < runCount; ++i)
+        m_runOrder[i] = i;
+    for (int i = runCount - 1; i > 0; --i)
+        std::swap(m_runOrder[i], m_runOrder[int(bounded(quint32(i + 1)))]);
+
+    const int pinned = first >= 0 ? first : avoid;
+    if (pinned >= 0 && runCount > 0) {
+        const int run = int(std::upper_bound(m_runs.begin(), m_runs.begin() + runCount, pinned) - m_runs.begin()) - 1;
+        const auto it = std::find(m_runOrder.begin(), m_runOrder.end(), run);
+        if (first >= 0)
+            std::swap(*it, m_runOrder[0]);
+        else if (it == m_runOrder.begin() && runCount > 1)
+            std::swap(m_runOrder[0], m_runOrder[1 + int(bounded(quint32(runCount - 1)))]);
+    }
+
+    int write = 0;
+    m_cursor = -1;
+    for (int i = 0; i < runCount; ++i) {
+        const int run = m_runOrder.at(i);
+        for (int track = m_runs.at(run); track < m_runs.at(run + 1); ++track) {
+            if (track == first)
+                m_cursor = write;
+            m_order[write++] = track;
+        }
+    }
+}
+
+void PlaybackOrder::updatePositions(int from, int to)
+{
+    for (int i = from; i < to; ++i)
+        m_position[m_order.at(i)] = i;
+}
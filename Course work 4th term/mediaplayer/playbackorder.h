@@ -0,0 +1,89 @@
+#ifndef PLAYBACKORDER_H
+#define PLAYBACKORDER_H
+
+#include <QVector>
+
+///Порядок воспроизведения плейлиста. Вся очередь круга заранее лежит в массиве
+///индексов треков, курсор указывает на текущий, поэтому next() и previous() — сдвиг
+///курсора за O(1), а previous() честно возвращается по истории круга.
+///Второй массив хранит позицию каждого трека в очереди: по нему за O(1) находится
+///трек, выбранный пользователем, а вставка и удаление треков правят очередь одним
+///проходом без перемешивания заново — новые треки встают на случайные места
+///среди ещё не сыгранных. Дописывание в конец прохода не требует и стоит O(count).
+///Режимы: по порядку, перемешивание Фишера–Йетса, взвешенное (ключи
+///Эфраимидиса–Спиракиса, чем больше вес, тем раньше трек) и по альбомам
+///(перемешиваются альбомы, треки внутри альбома идут по порядку).
+///Массивы перестраиваются только при смене режима и на новом круге,
+///шаг по очереди памяти не выделяет
+class PlaybackOrder
+{
+public:
+    enum Mode {
+        Sequential = 0,
+        Shuffle,
+        Weighted,
+        Album
+    };
+
+private:
+    QVector<int> m_order;       // позиция в очереди -> трек
+    QVector<int> m_position;    // трек -> позиция в очереди
+    QVector<float> m_weights;   // пусто — у всех вес 1
+    QVector<int> m_albums;      // пусто — каждый трек сам себе альбом
+    QVector<float> m_keys;
+    QVector<int> m_runs;
+    QVector<int> m_runOrder;
+
+    Mode m_mode = Sequential;
+    bool m_loop = true;
+    int m_cursor = -1;
+    quint64 m_random;
+
+    quint32 bounded(quint32 range);
+    float uniform();
+
+    void build(int first, int avoid);
+    void buildWeighted();
+    void buildAlbums(int first, int avoid);
+    void updatePositions(int from, int to);
+
+public:
+    explicit PlaybackOrder(quint64 seed = 0);
+
+    ///Новый плейлист из count треков, first — уже играющий трек или -1
+    void reset(int count, int first = -1);
+
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+
+    void setLoop(bool loop) { m_loop = loop; }
+    bool loop() const { return m_loop; }
+
+    ///Вес и альбом учитываются со следующего круга или смены режима
+    void setWeight(int track, float weight);
+    void setAlbum(int track, int album);
+
+    int count() const { return m_order.size(); }
+    int position() const { return m_cursor; }
+    int trackAt(int position) const { return m_order.at(position); }
+
+    ///Текущий трек или -1
+    int current() const;
+
+    ///Следующий и предыдущий трек; -1, если очередь кончилась и повтор выключен
+    int next();
+    int previous();
+
+    ///Пользователь сам выбрал трек: он становится текущим, остаток круга не меняется
+    void setCurrent(int track);
+
+    ///Треки с номерами index..index+count-1 вставлены или удалены из плейлиста
+    void insert(int index, int count);
+    void remove(int index, int count);
+
+    ///Строки rows перенесены одним блоком перед destination (см. PlaylistSequence::move).
+    ///Очередь не перемешивается, меняются только номера треков в ней
+    void move(const QVector<int> &rows, int destination);
+};
+
+#endif // PLAYBACKORDER_H
@@ -11,12 +11,18 @@
 #include "playlistmodel.h"
 #include "histogramwidget.h"
 #include "videowidget.h"
+#include "coverartloader.h"
+#include "seekpreview.h"
+#include "framequeuesurface.h"
+#include "mixeroutput.h"
+#include "performancehud.h"
+#include "trace.h"
+#include "playlistview.h"
 
 
 Player::Player(QWidget *parent)
     : QWidget(parent)
 {
-    this->setStyleSheet(Style::getWindowStyleSheet());
     this->setWindowTitle("Video player");
 
     this->setFixedSize(700, 250);
@@ -29,18 +35,41 @@ Player::Player(QWidget *parent)
         | Qt::WindowFullscreenButtonHint
         | Qt::CustomizeWindowHint);
 
-    m_player = new QMediaPlayer(this);
-    m_player_music = new QMediaPlayer(this);
-    m_player->setAudioRole(QAudio::VideoRole);
-    m_player_music->setAudioRole(QAudio::MusicRole);
+    ///Плееры создаются сессиями при первом воспроизведении
+    ///и освобождаются, когда сессия долго стоит без дела
+    m_sessions = new MediaSessionManager(this);
+    m_session = m_sessions->createSession("video", QAudio::VideoRole);
+    m_session_music = m_sessions->createSession("music", QAudio::MusicRole);
+
+    m_playlist = m_session->playlist();
+    m_playlist_music = m_session_music->playlist();
+
+    ///Позиция обоих плееров опрашивается общими часами интерфейса приложения,
+    ///которые следят за каждым новым плеером сессии, пока тот не освобождён
+    m_refreshClock = UiRefreshClock::instance();
+    for (MediaSession *session : { m_session, m_session_music }) {
+        connect(session, &MediaSession::playerCreated, m_refreshClock, &UiRefreshClock::watch);
+        connect(session, &MediaSession::playerReleased, m_refreshClock, &UiRefreshClock::unwatch);
+    }
+    connect(m_refreshClock, &UiRefreshClock::positionChanged, this, &Player::clockPositionChanged);
 
-    m_playlist = new QMediaPlaylist();
-    m_playlist_music = new QMediaPlaylist();
-    m_player->setPlaylist(m_playlist);
-    m_player_music->setPlaylist(m_playlist_music);
+    m_coverArt = new CoverArtLoader(this);
+    connect(m_coverArt, &CoverArtLoader::coverReady, this, &Player::coverArtReady);
 
     m_videoWidget = new VideoWidget(this);
-    m_player->setVideoOutput(m_videoWidget);
+
+    ///Обложка музыкального трека: размер фиксирован, в нём же декодируется миниатюра
+    m_coverLabel = new QLabel(this);
+    m_coverLabel->setObjectName("coverLabel");
+    m_coverLabel->setFixedSize(200, 200);
+    m_coverLabel->setAlignment(Qt::AlignCenter);
+
+    ///Кадры идут в виджет через очередь с планировщиком по звуковым часам
+    m_frameQueue = new FrameQueueSurface(this);
+    m_frameQueue->setTarget(m_videoWidget->videoSurface());
+    m_frameQueue->setColorAdjustment(&m_colorAdjustment);
+    connect(m_session, &MediaSession::playerCreated, m_frameQueue, &FrameQueueSurface::setClock);
+    m_session->setVideoOutput(m_frameQueue);
 
     m_playlistModel = new PlaylistModel(this);
     m_playlistModel->setPlaylist(m_playlist);
@@ -48,36 +77,42 @@ Player::Player(QWidget *parent)
     m_playlistModel_music = new PlaylistModel(this);
     m_playlistModel_music->setPlaylist(m_playlist_music);
 
-    m_playlistView = new QListView(this);
-    m_playlistView_music = new QListView(this);
+    m_playlistView = new PlaylistView(this);
+    m_playlistView->setObjectName("playlistView");
+    m_playlistView->horizontalHeader()->setVisible(false);
+    m_playlistView->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_playlistView_music = new PlaylistView(this);
+    m_playlistView_music->setObjectName("playlistView");
+    m_playlistView_music->horizontalHeader()->setVisible(false);
+    m_playlistView_music->setSelectionMode(QAbstractItemView::SingleSelection);
 
     m_playlistView->setModel(m_playlistModel);
     m_playlistView_music->setModel(m_playlistModel_music);
+    ///Растягивается название, длительность справа — постоянной ширины
+    for (PlaylistView *view : { m_playlistView, m_playlistView_music }) {
+        view->horizontalHeader()->setStretchLastSection(false);
+        view->horizontalHeader()->setSectionResizeMode(PlaylistModel::Title, QHeaderView::Stretch);
+        view->setDurationColumn(PlaylistModel::Duration);
+    }
+    connect(m_playlistView, &PlaylistView::prefetchRequested, m_playlistModel, &PlaylistModel::prefetch);
+    connect(m_playlistView_music, &PlaylistView::prefetchRequested, m_playlistModel_music, &PlaylistModel::prefetch);
 
     m_playlistView->setCurrentIndex(m_playlistModel->index(m_playlist->currentIndex(), 0));
     m_playlistView_music->setCurrentIndex(m_playlistModel_music->index(m_playlist_music->currentIndex(), 0));
 
-    m_playlistView->verticalScrollBar()->setStyleSheet(Style::getVerticalScrollBarStyleSheet());
-    m_playlistView->horizontalScrollBar()->setStyleSheet(Style::getHorizontalScrollBarStyleSheet());
-
-    m_playlistView_music->verticalScrollBar()->setStyleSheet(Style::getVerticalScrollBarStyleSheet());
-    m_playlistView_music->horizontalScrollBar()->setStyleSheet(Style::getHorizontalScrollBarStyleSheet());
-
 
     m_slider = new QSlider(Qt::Horizontal, this);
-    m_slider->setStyleSheet(Style::getSliderStyleSheet());
-    m_slider->setRange(0, m_player->duration() / 1000);
+    m_slider->setObjectName("positionSlider");
+    m_slider->setRange(0, m_session->duration() / 1000);
+    m_seekPreview = new SeekPreview(m_slider, 1000, this);
 
     m_slider_music = new QSlider(Qt::Horizontal, this);
-    m_slider_music->setStyleSheet(Style::getSliderStyleSheet());
-    m_slider_music->setRange(0, m_player_music->duration() / 1000);
+    m_slider_music->setObjectName("positionSlider");
+    m_slider_music->setRange(0, m_session_music->duration() / 1000);
 
     m_labelDuration = new QLabel(this);
     m_labelDuration_music = new QLabel(this);
 
-    m_videoProbe = new QVideoProbe(this);
-    m_audioProbe = new QAudioProbe(this);
-
     m_videoHistogram = new HistogramWidget(this);
     m_audioHistogram = new HistogramWidget(this);
     QHBoxLayout *histogramLayout = new QHBoxLayout;
@@ -86,34 +121,103 @@ Player::Player(QWidget *parent)
 
     QToolButton *openButton = new QToolButton(this);
     QToolButton *openButton_music = new QToolButton(this);
-    openButton->setStyleSheet(Style::getAddStyleSheet());
-    openButton_music->setStyleSheet(Style::getAddStyleSheet());
+    openButton->setObjectName("btn_add");
+    openButton_music->setObjectName("btn_add");
 
     QToolButton *delButton = new QToolButton(this);
     QToolButton *delButton_music = new QToolButton(this);
-    delButton->setStyleSheet(Style::getRemoveStyleSheet());
-    delButton_music->setStyleSheet(Style::getRemoveStyleSheet());
+    delButton->setObjectName("btn_del");
+    delButton_music->setObjectName("btn_del");
 
     PlayerControls *controls = new PlayerControls(this);
     PlayerControls *controls_music = new PlayerControls(this);
 
-    controls->setState(m_player->state());
-    controls->setVolume(m_player->volume());
+    controls->setState(m_session->state());
+    controls->setVolume(m_session->volume());
     controls->setMuted(controls->isMuted());
 
-    controls_music->setState(m_player_music->state());
-    controls_music->setVolume(m_player_music->volume());
+    controls_music->setState(m_session_music->state());
+    controls_music->setVolume(m_session_music->volume());
     controls_music->setMuted(controls_music->isMuted());
 
     m_fullScreenButton = new QToolButton(this);
-    m_fullScreenButton->setStyleSheet(Style::getFullStyleSheet());
+    m_fullScreenButton->setObjectName("btn_fullScreen");
     m_fullScreenButton->setCheckable(true);
 
     m_colorButton = new QToolButton(this);
     m_colorButton->setEnabled(false);
-    m_colorButton->setStyleSheet(Style::getSettingsStyleSheet());
+    m_colorButton->setObjectName("btn_color");
     connect(m_colorButton, &QPushButton::clicked, this, &Player::showColorDialog);
 
+    ///Музыка под видео: оба потока сводятся в один выход,
+    ///звук видео служит ключом приглушения музыки
+    m_mixerOutput = new MixerOutput(this);
+    m_videoStream = m_mixerOutput->addSession(m_session);
+    m_musicStream = m_mixerOutput->addSession(m_session_music);
+
+    m_mixButton = new QToolButton(this);
+    m_mixButton->setObjectName("btn_mix");
+    m_mixButton->setText(tr("Mix"));
+    m_mixButton->setToolTip(tr("Mix music under video"));
+    m_mixButton->setCheckable(true);
+    connect(m_mixButton, &QToolButton::toggled, this, &Player::setMixing);
+
+    m_equalizerButton = new QToolButton(this);
+    m_equalizerButton->setObjectName("btn_equalizer");
+    m_equalizerButton->setText(tr("EQ"));
+    m_equalizerButton->setToolTip(tr("Equalizer"));
+    connect(m_equalizerButton, &QToolButton::clicked, this, &Player::showEqualizerDialog);
+
+    ///Лимитер в микшере включён всегда; кнопка добавляет компрессор
+    ///и пускает через микшер звук, даже если больше ничего не включено
+    m_dynamicsButton = new QToolButton(this);
+    m_dynamicsButton->setObjectName("btn_dynamics");
+    m_dynamicsButton->setText(tr("DRC"));
+    m_dynamicsButton->setToolTip(tr("Compressor and limiter"));
+    m_dynamicsButton->setCheckable(true);
+    connect(m_dynamicsButton, &QToolButton::toggled, this, &Player::setCompression);
+    connect(m_mixerOutput, &MixerOutput::gainReductionChanged, m_audioHistogram, &HistogramWidget::setGainReduction);
+
+    ///Свёртка с импульсной характеристикой: коррекция комнаты или реверберация.
+    ///Размер блока — это и задержка, и цена: чем он меньше, тем больше работы на отсчёт
+    Convolver *convolver = m_mixerOutput->mixer()->convolver();
+    QMenu *convolverMenu = new QMenu(this);
+    convolverMenu->addAction(tr("Load impulse response..."), this, &Player::loadImpulseResponse);
+    QAction *removeAction = convolverMenu->addAction(tr("Remove"), [this, convolver](){
+        convolver->clear();
+        updateConvolverButton();});
+
+    QMenu *blockMenu = convolverMenu->addMenu(tr("Latency"));
+    QActionGroup *blockGroup = new QActionGroup(blockMenu);
+    for (int frames = Convolver::MinBlockFrames; frames <= Convolver::MaxBlockFrames; frames *= 2) {
+        QAction *action = blockMenu->addAction(tr("%1 frames").arg(frames), [this, convolver, frames](){
+            convolver->setBlockFrames(frames);
+            updateConvolverButton();});
+        action->setCheckable(true);
+        action->setChecked(frames == convolver->blockFrames());
+        blockGroup->addAction(action);
+    }
+
+    QMenu *mixMenu = convolverMenu->addMenu(tr("Wet"));
+    QActionGroup *mixGroup = new QActionGroup(mixMenu);
+    for (int percent : { 100, 50, 25 }) {
+        QAction *action = mixMenu->addAction(tr("%1%").arg(percent), [convolver, percent](){
+            convolver->setMix(percent / 100.0f);});
+        action->setCheckable(true);
+        action->setChecked(percent == 100);
+        mixGroup->addAction(action);
+    }
+    connect(convolverMenu, &QMenu::aboutToShow, [convolver, removeAction](){
+        removeAction->setEnabled(convolver->isLoaded());});
+
+    m_convolverButton = new QToolButton(this);
+    m_convolverButton->setObjectName("btn_convolver");
+    m_convolverButton->setText(tr("IR"));
+    m_convolverButton->setCheckable(true);
+    m_convolverButton->setMenu(convolverMenu);
+    m_convolverButton->setPopupMode(QToolButton::InstantPopup);
+    updateConvolverButton();
+
     connect(m_slider, &QSlider::sliderMoved, this, &Player::seek);
     connect(m_slider_music, &QSlider::sliderMoved, this, &Player::seek_music);
 
@@ -122,69 +226,68 @@ Player::Player(QWidget *parent)
 
     connect(delButton, &QPushButton::clicked, this, &Player::del);
     connect(delButton_music, &QPushButton::clicked, this, &Player::del_music);
-    connect(delButton, &QToolButton::clicked, m_player, &QMediaPlayer::stop);
-    connect(delButton_music, &QToolButton::clicked, m_player_music, &QMediaPlayer::stop);
+    connect(delButton, &QToolButton::clicked, m_session, &MediaSession::stop);
+    connect(delButton_music, &QToolButton::clicked, m_session_music, &MediaSession::stop);
 
-    connect(m_videoProbe, &QVideoProbe::videoFrameProbed, m_videoHistogram, &HistogramWidget::processFrame);
-    m_videoProbe->setSource(m_player);
-
-    connect(m_audioProbe, &QAudioProbe::audioBufferProbed, m_audioHistogram, &HistogramWidget::processBuffer);
-    m_audioProbe->setSource(m_player_music);
+    ///Пробники подключаются при первом воспроизведении соответствующей сессии
+    connect(m_session, &MediaSession::stateChanged, this, &Player::attachProbes);
+    connect(m_session_music, &MediaSession::stateChanged, this, &Player::attachProbes);
 
     connect(m_playlistView, &QAbstractItemView::activated, this, &Player::jump);
     connect(m_playlistView_music, &QAbstractItemView::activated, this, &Player::jump_music);
 
-    connect(controls, &PlayerControls::play, m_player, &QMediaPlayer::play);
-    connect(controls, &PlayerControls::play, m_player_music, &QMediaPlayer::play);
-    connect(controls, &PlayerControls::pause, m_player, &QMediaPlayer::pause);
-    connect(controls, &PlayerControls::pause, m_player_music, &QMediaPlayer::pause);
-    connect(controls, &PlayerControls::stop, m_player, &QMediaPlayer::stop);
-    connect(controls, &PlayerControls::stop, m_player_music, &QMediaPlayer::stop);
+    connect(controls, &PlayerControls::play, m_session, &MediaSession::play);
+    connect(controls, &PlayerControls::play, m_session_music, &MediaSession::play);
+    connect(controls, &PlayerControls::pause, m_session, &MediaSession::pause);
+    connect(controls, &PlayerControls::pause, m_session_music, &MediaSession::pause);
+    connect(controls, &PlayerControls::stop, m_session, &MediaSession::stop);
+    connect(controls, &PlayerControls::stop, m_session_music, &MediaSession::stop);
     connect(controls, &PlayerControls::next, m_playlist, &QMediaPlaylist::next);
     connect(controls, &PlayerControls::previous, this, &Player::previousClicked);
-    connect(controls, &PlayerControls::changeVolume, m_player, &QMediaPlayer::setVolume);
-    connect(controls, &PlayerControls::changeMuting, m_player, &QMediaPlayer::setMuted);
-    connect(controls, &PlayerControls::changeRate, m_player, &QMediaPlayer::setPlaybackRate);
+    connect(controls, &PlayerControls::changeVolume, m_session, &MediaSession::setVolume);
+    connect(controls, &PlayerControls::changeMuting, m_session, &MediaSession::setMuted);
+    connect(controls, &PlayerControls::changeRate, m_session, &MediaSession::setPlaybackRate);
+    connect(controls, &PlayerControls::changeRate, this, &Player::updateAudioRouting);
     connect(controls, &PlayerControls::stop, m_videoWidget, QOverload<>::of(&QVideoWidget::update));
 
-    connect(controls_music, &PlayerControls::play, m_player_music, &QMediaPlayer::play);
-    connect(controls_music, &PlayerControls::pause, m_player_music, &QMediaPlayer::pause);
-    connect(controls_music, &PlayerControls::stop, m_player_music, &QMediaPlayer::stop);
+    connect(controls_music, &PlayerControls::play, m_session_music, &MediaSession::play);
+    connect(controls_music, &PlayerControls::pause, m_session_music, &MediaSession::pause);
+    connect(controls_music, &PlayerControls::stop, m_session_music, &MediaSession::stop);
     connect(controls_music, &PlayerControls::next, m_playlist_music, &QMediaPlaylist::next);
     connect(controls_music, &PlayerControls::previous, m_playlist_music, &QMediaPlaylist::previous);
-    connect(controls_music, &PlayerControls::changeVolume, m_player_music, &QMediaPlayer::setVolume);
-    connect(controls_music, &PlayerControls::changeMuting, m_player_music, &QMediaPlayer::setMuted);
-    connect(controls_music, &PlayerControls::changeRate, m_player_music, &QMediaPlayer::setPlaybackRate);
+    connect(controls_music, &PlayerControls::changeVolume, m_session_music, &MediaSession::setVolume);
+    connect(controls_music, &PlayerControls::changeMuting, m_session_music, &MediaSession::setMuted);
+    connect(controls_music, &PlayerControls::changeRate, m_session_music, &MediaSession::setPlaybackRate);
+    connect(controls_music, &PlayerControls::changeRate, this, &Player::updateAudioRouting);
 
-    connect(m_player, &QMediaPlayer::stateChanged, controls, &PlayerControls::setState);
-    connect(m_player, &QMediaPlayer::volumeChanged, controls, &PlayerControls::setVolume);
-    connect(m_player, &QMediaPlayer::mutedChanged, controls, &PlayerControls::setMuted);
+    connect(m_session, &MediaSession::stateChanged, controls, &PlayerControls::setState);
+    connect(m_session, &MediaSession::volumeChanged, controls, &PlayerControls::setVolume);
+    connect(m_session, &MediaSession::mutedChanged, controls, &PlayerControls::setMuted);
 
-    connect(m_player_music, &QMediaPlayer::stateChanged, controls_music, &PlayerControls::setState);
-    connect(m_player_music, &QMediaPlayer::volumeChanged, controls_music, &PlayerControls::setVolume);
-    connect(m_player_music, &QMediaPlayer::mutedChanged, controls_music, &PlayerControls::setMuted);
+    connect(m_session_music, &MediaSession::stateChanged, controls_music, &PlayerControls::setState);
+    connect(m_session_music, &MediaSession::volumeChanged, controls_music, &PlayerControls::setVolume);
+    connect(m_session_music, &MediaSession::mutedChanged, controls_music, &PlayerControls::setMuted);
 
-    connect(m_player, &QMediaPlayer::durationChanged, this, &Player::durationChanged);
-    connect(m_player, &QMediaPlayer::positionChanged, this, &Player::positionChanged);
-    connect(m_player, QOverload<>::of(&QMediaPlayer::metaDataChanged), this, &Player::metaDataChanged);
+    connect(m_session, &MediaSession::durationChanged, this, &Player::durationChanged);
+    connect(m_session, &MediaSession::metaDataChanged, this, &Player::metaDataChanged);
     connect(m_playlist, &QMediaPlaylist::currentIndexChanged, this, &Player::playlistPositionChanged);
-    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &Player::statusChanged);
-    connect(m_player, &QMediaPlayer::bufferStatusChanged, this, &Player::bufferingProgress);
-    connect(m_player, &QMediaPlayer::videoAvailableChanged, this, &Player::videoAvailableChanged);
-    connect(m_player, QOverload<QMediaPlayer::Error>::of(&QMediaPlayer::error), this, &Player::displayErrorMessage);
-    connect(m_player, &QMediaPlayer::stateChanged, this, &Player::stateChanged);
-
-    connect(m_player_music, &QMediaPlayer::durationChanged, this, &Player::durationChanged_music);
-    connect(m_player_music, &QMediaPlayer::positionChanged, this, &Player::positionChanged_music);
-    connect(m_player_music, QOverload<>::of(&QMediaPlayer::metaDataChanged), this, &Player::metaDataChanged_music);
+    connect(m_session, &MediaSession::mediaStatusChanged, this, &Player::statusChanged);
+    connect(m_session, &MediaSession::bufferStatusChanged, this, &Player::bufferingProgress);
+    connect(m_session, &MediaSession::videoAvailableChanged, this, &Player::videoAvailableChanged);
+    connect(m_session, &MediaSession::error, this, &Player::displayErrorMessage);
+    connect(m_session, &MediaSession::stateChanged, this, &Player::stateChanged);
+
+    connect(m_session_music, &MediaSession::durationChanged, this, &Player::durationChanged_music);
+    connect(m_session_music, &MediaSession::metaDataChanged, this, &Player::metaDataChanged_music);
     connect(m_playlist_music, &QMediaPlaylist::currentIndexChanged, this, &Player::playlistPositionChanged_music);
-    connect(m_player_music, &QMediaPlayer::mediaStatusChanged, this, &Player::statusChanged);
-    connect(m_player_music, &QMediaPlayer::bufferStatusChanged, this, &Player::bufferingProgress);
-    connect(m_player_music, QOverload<QMediaPlayer::Error>::of(&QMediaPlayer::error), this, &Player::displayErrorMessage);
-    connect(m_player_music, &QMediaPlayer::stateChanged, this, &Player::stateChanged);
+    connect(m_session_music, &MediaSession::mediaStatusChanged, this, &Player::statusChanged);
+    connect(m_session_music, &MediaSession::bufferStatusChanged, this, &Player::bufferingProgress);
+    connect(m_session_music, &MediaSession::error, this, &Player::displayErrorMessage);
+    connect(m_session_music, &MediaSession::stateChanged, this, &Player::stateChanged);
 
     QBoxLayout *displayLayout = new QHBoxLayout;
     displayLayout->addWidget(m_videoWidget, 2);
+    displayLayout->addWidget(m_coverLabel, 0, Qt::AlignTop);
     displayLayout->addWidget(m_playlistView);
     displayLayout->addWidget(m_playlistView_music);
 
@@ -195,6 +298,10 @@ Player::Player(QWidget *parent)
     controlLayout->addWidget(controls);
     controlLayout->addWidget(m_fullScreenButton);
     controlLayout->addWidget(m_colorButton);
+    controlLayout->addWidget(m_mixButton);
+    controlLayout->addWidget(m_equalizerButton);
+    controlLayout->addWidget(m_convolverButton);
+    controlLayout->addWidget(m_dynamicsButton);
     controlLayout->addStretch(1);
 
     QBoxLayout *controlLayout_music = new QHBoxLayout;
@@ -225,6 +332,26 @@ Player::Player(QWidget *parent)
 
     setLayout(layout);
 
+    QShortcut *memoryShortcut = new QShortcut(QKeySequence("Ctrl+Shift+M"), this);
+    connect(memoryShortcut, &QShortcut::activated, [this](){
+        qDebug().noquote() << m_sessions->memoryReport();});
+
+    PerformanceMonitor *monitor = PerformanceMonitor::instance();
+    monitor->watchPaint(m_videoHistogram, "video histogram");
+    monitor->watchPaint(m_audioHistogram, "music histogram");
+    monitor->watchPaint(m_playlistView->viewport(), "video playlist");
+    monitor->watchPaint(m_playlistView_music->viewport(), "music playlist");
+    connect(m_session, &MediaSession::bufferStatusChanged, monitor, [monitor](int percent){
+        monitor->recordBufferFill("video", percent);});
+    connect(m_session_music, &MediaSession::bufferStatusChanged, monitor, [monitor](int percent){
+        monitor->recordBufferFill("music", percent);});
+
+    m_hud = new PerformanceHud(this);
+    QShortcut *hudShortcut = new QShortcut(QKeySequence("Ctrl+Shift+H"), this);
+    connect(hudShortcut, &QShortcut::activated, m_hud, &PerformanceHud::toggle);
+    QShortcut *traceShortcut = new QShortcut(QKeySequence("Ctrl+Shift+R"), this);
+    connect(traceShortcut, &QShortcut::activated, monitor, &PerformanceMonitor::toggleRecording);
+
 #ifdef WIN32
     createTaskbar();
     createThumbnailToolBar();
@@ -235,11 +362,44 @@ Player::Player(QWidget *parent)
 
 Player::~Player()
 {
+    m_frameQueue->setColorAdjustment(nullptr);
+}
+
+///Пробник подключается к плееру сессии при первом воспроизведении. Если сессия
+///освободила плеер, пробник становится неактивным и переходит на следующий
+void Player::attachProbes()
+{
+    QMediaPlayer *player = m_session->player();
+    if (player && player->state() == QMediaPlayer::PlayingState) {
+        if (!m_videoProbe) {
+            m_videoProbe = new QVideoProbe(this);
+            connect(m_videoProbe, &QVideoProbe::videoFrameProbed, m_videoHistogram, &HistogramWidget::processFrame);
+            PerformanceMonitor::instance()->watchProbe(m_videoProbe, "video");
+        }
+        if (!m_videoProbe->isActive())
+            m_videoProbe->setSource(player);
+    }
+
+    QMediaPlayer *player_music = m_session_music->player();
+    if (player_music && player_music->state() == QMediaPlayer::PlayingState) {
+        if (!m_audioProbe) {
+            m_audioProbe = new QAudioProbe(this);
+            connect(m_audioProbe, &QAudioProbe::audioBufferProbed, m_audioHistogram, &HistogramWidget::processBuffer);
+            PerformanceMonitor::instance()->watchProbe(m_audioProbe, "music");
+        }
+        if (!m_audioProbe->isActive())
+            m_audioProbe->setSource(player_music);
+    }
 }
 
 bool Player::isPlayerAvailable() const
 {
-    return m_player->isAvailable();
+    return m_session->isAvailable();
+}
+
+FrameQueueSurface *Player::frameQueue() const
+{
+    return m_frameQueue;
 }
 
 void Player::open()
@@ -307,6 +467,8 @@ static bool isPlaylist(const QUrl &url)
 
 void Player::addToPlaylist(const QList<QUrl> &urls)
 {
+    TRACE_SCOPE("playlist", "Player::addToPlaylist");
+
     for (auto &url: urls) {
         if (isPlaylist(url))
             m_playlist->load(url);
@@ -317,6 +479,8 @@ void Player::addToPlaylist(const QList<QUrl> &urls)
 
 void Player::addToPlaylist_music(const QList<QUrl> &urls)
 {
+    TRACE_SCOPE("playlist", "Player::addToPlaylist_music");
+
     for (auto &url: urls) {
         if (isPlaylist(url))
             m_playlist_music->load(url);
@@ -331,8 +495,26 @@ void Player::durationChanged(qint64 duration)
     m_slider->setMaximum(m_duration);
 }
 
+///Часы общие с окном Widget: позиции его плеера сюда тоже приходят и пропускаются
+void Player::clockPositionChanged(QMediaPlayer *player, qint64 position)
+{
+    if (!player)
+        return;
+
+    if (player == m_session->player()) {
+        positionChanged(position);
+#ifdef WIN32
+        updateThumbnailToolBar();
+#endif
+    } else if (player == m_session_music->player()) {
+        positionChanged_music(position);
+    }
+}
+
 void Player::positionChanged(qint64 progress)
 {
+    TRACE_SCOPE("player", "Player::positionChanged");
+
     if (!m_slider->isSliderDown())
         m_slider->setValue(progress / 1000);
 
@@ -355,17 +537,17 @@ void Player::positionChanged_music(qint64 progress)
 
 void Player::metaDataChanged()
 {
-    if (m_player->isMetaDataAvailable()) {
+    if (m_session->isMetaDataAvailable()) {
         setTrackInfo(QString("%1 - %2")
-                .arg(m_player->metaData(QMediaMetaData::AlbumArtist).toString())
-                .arg(m_player->metaData(QMediaMetaData::Title).toString()));
+                .arg(m_session->metaData(QMediaMetaData::AlbumArtist).toString())
+                .arg(m_session->metaData(QMediaMetaData::Title).toString()));
 
         if (m_coverLabel) {
-            QUrl url = m_player->metaData(QMediaMetaData::CoverArtUrlLarge).value<QUrl>();
+            m_coverUrl = m_session->metaData(QMediaMetaData::CoverArtUrlLarge).value<QUrl>();
 
-            m_coverLabel->setPixmap(!url.isEmpty()
-                    ? QPixmap(url.toString())
-                    : QPixmap());
+            ///Обложка декодируется в фоне и приходит в coverArtReady
+            m_coverLabel->setPixmap(QPixmap());
+            m_coverArt->request(m_coverUrl, m_coverLabel->size());
         }
 
     }
@@ -373,36 +555,42 @@ void Player::metaDataChanged()
 
 void Player::metaDataChanged_music()
 {
-    if (m_player->isMetaDataAvailable()) {
+    if (m_session_music->isMetaDataAvailable()) {
         setTrackInfo(QString("%1 - %2")
-                .arg(m_player_music->metaData(QMediaMetaData::AlbumArtist).toString())
-                .arg(m_player_music->metaData(QMediaMetaData::Title).toString()));
+                .arg(m_session_music->metaData(QMediaMetaData::AlbumArtist).toString())
+                .arg(m_session_music->metaData(QMediaMetaData::Title).toString()));
 
         if (m_coverLabel) {
-            QUrl url = m_player_music->metaData(QMediaMetaData::CoverArtUrlLarge).value<QUrl>();
+            m_coverUrl = m_session_music->metaData(QMediaMetaData::CoverArtUrlLarge).value<QUrl>();
 
-            m_coverLabel->setPixmap(!url.isEmpty()
-                    ? QPixmap(url.toString())
-                    : QPixmap());
+            ///Обложка декодируется в фоне и приходит в coverArtReady
+            m_coverLabel->setPixmap(QPixmap());
+            m_coverArt->request(m_coverUrl, m_coverLabel->size());
         }
 
     }
 }
 
+void Player::coverArtReady(const QUrl &url, const QImage &image)
+{
+    if (m_coverLabel && url == m_coverUrl)
+        m_coverLabel->setPixmap(QPixmap::fromImage(image));
+}
+
 void Player::previousClicked()
 {
     ///Переход к предыдущему треку, если менее 5 секунд, иначе в начало
-    if (m_player->position() <= 5000)
+    if (m_session->position() <= 5000)
         m_playlist->previous();
     else
-        m_player->setPosition(0);
+        m_session->setPosition(0);
 }
 
 void Player::jump(const QModelIndex &index)
 {
     if (index.isValid()) {
         m_playlist->setCurrentIndex(index.row());
-        m_player->play();
+        m_session->play();
     }
 }
 
@@ -410,30 +598,40 @@ void Player::jump_music(const QModelIndex &index)
 {
     if (index.isValid()) {
         m_playlist_music->setCurrentIndex(index.row());
-        m_player_music->play();
+        m_session_music->play();
     }
 }
 
 void Player::playlistPositionChanged(int currentItem)
 {
     clearHistogram();
+    m_seekPreview->setSource(m_playlist->media(currentItem).canonicalUrl());
     m_playlistView->setCurrentIndex(m_playlistModel->index(currentItem, 0));
+
+    ///Длительность из заголовков файла известна раньше, чем её сообщит бэкенд
+    const qint64 duration = m_playlistModel->duration(currentItem);
+    if (duration > 0)
+        durationChanged(duration);
 }
 
 void Player::playlistPositionChanged_music(int currentItem)
 {
     clearHistogram();
     m_playlistView_music->setCurrentIndex(m_playlistModel_music->index(currentItem, 0));
+
+    const qint64 duration = m_playlistModel_music->duration(currentItem);
+    if (duration > 0)
+        durationChanged_music(duration);
 }
 
 void Player::seek(int seconds)
 {
-    m_player->setPosition(seconds * 1000);
+    m_session->setPosition(seconds * 1000);
 }
 
 void Player::seek_music(int seconds)
 {
-    m_player_music->setPosition(seconds * 1000);
+    m_session_music->setPosition(seconds * 1000);
 }
 
 void Player::statusChanged(QMediaPlayer::MediaStatus status)
@@ -522,71 +720,56 @@ void Player::setStatusInfo(const QString &info)
 
 void Player::displayErrorMessage()
 {
-    setStatusInfo(m_player->errorString());
+    MediaSession *session = qobject_cast<MediaSession *>(sender());
+    setStatusInfo((session ? session : m_session)->errorString());
 }
 
 void Player::updateDurationInfo_music(qint64 currentInfo)
 {
-    QString tStr;
-    if (currentInfo || m_duration_music) {
-        QTime currentTime((currentInfo / 3600) % 60, (currentInfo / 60) % 60,
-            currentInfo % 60, (currentInfo * 1000) % 1000);
-        QTime totalTime((m_duration_music / 3600) % 60, (m_duration_music / 60) % 60,
-            m_duration_music % 60, (m_duration_music * 1000) % 1000);
-        QString format = "mm:ss";
-        if (m_duration_music > 3600)
-            format = "hh:mm:ss";
-        tStr = currentTime.toString(format) + " / " + totalTime.toString(format);
-    }
-    m_labelDuration_music->setText(tStr);
+    bool changed = currentInfo || m_duration_music
+            ? m_durationFormat_music.setTime(currentInfo, m_duration_music)
+            : m_durationFormat_music.clear();
+    if (changed)
+        m_labelDuration_music->setText(m_durationFormat_music.text());
 }
 
 void Player::updateDurationInfo(qint64 currentInfo)
 {
-    QString tStr;
-    if (currentInfo || m_duration) {
-        QTime currentTime((currentInfo / 3600) % 60, (currentInfo / 60) % 60,
-            currentInfo % 60, (currentInfo * 1000) % 1000);
-        QTime totalTime((m_duration / 3600) % 60, (m_duration / 60) % 60,
-            m_duration % 60, (m_duration * 1000) % 1000);
-        QString format = "mm:ss";
-        if (m_duration > 3600)
-            format = "hh:mm:ss";
-        tStr = currentTime.toString(format) + " / " + totalTime.toString(format);
-    }
-    m_labelDuration->setText(tStr);
+    bool changed = currentInfo || m_duration
+            ? m_durationFormat.setTime(currentInfo, m_duration)
+            : m_durationFormat.clear();
+    if (changed)
+        m_labelDuration->setText(m_durationFormat.text());
 }
 
+///Настройки цвета применяются программно в очереди кадров:
+///ползунки только пересчитывают таблицы, стоимость кадра не зависит от бэкенда
 void Player::showColorDialog()
 {
     if (!m_colorDialog) {
         QSlider *brightnessSlider = new QSlider(Qt::Horizontal);
         brightnessSlider->setRange(-100, 100);
-        brightnessSlider->setValue(m_videoWidget->brightness());
-        brightnessSlider->setStyleSheet(Style::getSliderStyleSheet2());
-        connect(brightnessSlider, &QSlider::sliderMoved, m_videoWidget, &QVideoWidget::setBrightness);
-        connect(m_videoWidget, &QVideoWidget::brightnessChanged, brightnessSlider, &QSlider::setValue);
+        brightnessSlider->setValue(m_colorAdjustment.brightness());
+        connect(brightnessSlider, &QSlider::sliderMoved, [this](int value){
+            m_colorAdjustment.setBrightness(value);});
 
         QSlider *contrastSlider = new QSlider(Qt::Horizontal);
         contrastSlider->setRange(-100, 100);
-        contrastSlider->setValue(m_videoWidget->contrast());
-        contrastSlider->setStyleSheet(Style::getSliderStyleSheet2());
-        connect(contrastSlider, &QSlider::sliderMoved, m_videoWidget, &QVideoWidget::setContrast);
-        connect(m_videoWidget, &QVideoWidget::contrastChanged, contrastSlider, &QSlider::setValue);
+        contrastSlider->setValue(m_colorAdjustment.contrast());
+        connect(contrastSlider, &QSlider::sliderMoved, [this](int value){
+            m_colorAdjustment.setContrast(value);});
 
         QSlider *hueSlider = new QSlider(Qt::Horizontal);
         hueSlider->setRange(-100, 100);
-        hueSlider->setValue(m_videoWidget->hue());
-        hueSlider->setStyleSheet(Style::getSliderStyleSheet2());
-        connect(hueSlider, &QSlider::sliderMoved, m_videoWidget, &QVideoWidget::setHue);
-        connect(m_videoWidget, &QVideoWidget::hueChanged, hueSlider, &QSlider::setValue);
+        hueSlider->setValue(m_colorAdjustment.hue());
+        connect(hueSlider, &QSlider::sliderMoved, [this](int value){
+            m_colorAdjustment.setHue(value);});
 
         QSlider *saturationSlider = new QSlider(Qt::Horizontal);
         saturationSlider->setRange(-100, 100);
-        saturationSlider->setValue(m_videoWidget->saturation());
-        saturationSlider->setStyleSheet(Style::getSliderStyleSheet2());
-        connect(saturationSlider, &QSlider::sliderMoved, m_videoWidget, &QVideoWidget::setSaturation);
-        connect(m_videoWidget, &QVideoWidget::saturationChanged, saturationSlider, &QSlider::setValue);
+        saturationSlider->setValue(m_colorAdjustment.saturation());
+        connect(saturationSlider, &QSlider::sliderMoved, [this](int value){
+            m_colorAdjustment.setSaturation(value);});
 
         QFormLayout *layout = new QFormLayout;
         layout->addRow(tr("Brightness"), brightnessSlider);
@@ -595,10 +778,10 @@ void Player::showColorDialog()
         layout->addRow(tr("Saturation"), saturationSlider);
 
         QPushButton *button = new QPushButton(tr("OK"));
-        button->setStyleSheet(Style::getBtnPushToolStyleSheet());
         layout->addRow(button);
 
         m_colorDialog = new QDialog(this);
+        m_colorDialog->setObjectName("colorDialog");
         m_colorDialog->setWindowTitle(tr("Color Options"));
         m_colorDialog->setLayout(layout);
 
@@ -607,6 +790,133 @@ void Player::showColorDialog()
     m_colorDialog->show();
 }
 
+///Эквалайзер стоит в микшере: пока хоть одна полоса не в нуле, звук идёт через него.
+///Ползунки только меняют целевые усиления, сглаживание делает поток вывода
+void Player::showEqualizerDialog()
+{
+    if (!m_equalizerDialog) {
+        Equalizer *equalizer = m_mixerOutput->mixer()->equalizer();
+
+        QCheckBox *enabledBox = new QCheckBox(tr("Enabled"));
+        enabledBox->setChecked(equalizer->isEnabled());
+        connect(enabledBox, &QCheckBox::toggled, [this, equalizer](bool enabled){
+            equalizer->setEnabled(enabled);
+            updateAudioRouting();});
+
+        QGridLayout *bands = new QGridLayout;
+        auto addSlider = [this, bands](int column, const QString &label, float value, std::function<void(int)> apply) {
+            QSlider *slider = new QSlider(Qt::Vertical);
+            slider->setRange(-Equalizer::MaxGainDb, Equalizer::MaxGainDb);
+            slider->setTickPosition(QSlider::TicksBothSides);
+            slider->setTickInterval(Equalizer::MaxGainDb);
+            slider->setValue(qRound(value));
+            connect(slider, &QSlider::valueChanged, [this, apply](int gain){
+                apply(gain);
+                updateAudioRouting();});
+            bands->addWidget(slider, 0, column, Qt::AlignHCenter);
+            bands->addWidget(new QLabel(label), 1, column, Qt::AlignHCenter);
+        };
+
+        addSlider(0, tr("Pre"), equalizer->preamp(), [equalizer](int gain){ equalizer->setPreamp(gain); });
+        for (int i = 0; i < Equalizer::Bands; ++i) {
+            const float frequency = Equalizer::defaultFrequency(i);
+            const QString label = frequency < 1000 ? QString::number(qRound(frequency))
+                                                   : tr("%1k").arg(qRound(frequency / 1000));
+            addSlider(i + 1, label, equalizer->gain(i), [equalizer, i](int gain){ equalizer->setGain(i, gain); });
+        }
+
+        QPushButton *resetButton = new QPushButton(tr("Reset"));
+        QPushButton *button = new QPushButton(tr("OK"));
+        QHBoxLayout *buttons = new QHBoxLayout;
+        buttons->addWidget(enabledBox);
+        buttons->addStretch(1);
+        buttons->addWidget(resetButton);
+        buttons->addWidget(button);
+
+        QVBoxLayout *layout = new QVBoxLayout;
+        layout->addLayout(bands);
+        layout->addLayout(buttons);
+
+        m_equalizerDialog = new QDialog(this);
+        m_equalizerDialog->setObjectName("equalizerDialog");
+        m_equalizerDialog->setWindowTitle(tr("Equalizer"));
+        m_equalizerDialog->setLayout(layout);
+
+        connect(resetButton, &QPushButton::clicked, [bands](){
+            for (int i = 0; i < bands->count(); ++i) {
+                if (QSlider *slider = qobject_cast<QSlider *>(bands->itemAt(i)->widget()))
+                    slider->setValue(0);
+            }});
+        connect(button, &QPushButton::clicked, m_equalizerDialog, &QDialog::close);
+    }
+    m_equalizerDialog->show();
+}
+
+///WAV любой частоты: она приводится к частоте вывода при загрузке
+void Player::loadImpulseResponse()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Open Impulse Response"),
+                                                          QStandardPaths::standardLocations(QStandardPaths::MusicLocation).value(0, QDir::homePath()),
+                                                          tr("WAV files (*.wav *.wave *.bwf *.rf64)"));
+    if (fileName.isEmpty())
+        return;
+
+    Convolver *convolver = m_mixerOutput->mixer()->convolver();
+    if (!convolver->load(fileName))
+        QMessageBox::warning(this, tr("Impulse Response"), convolver->errorString());
+    updateConvolverButton();
+}
+
+void Player::updateConvolverButton()
+{
+    Convolver *convolver = m_mixerOutput->mixer()->convolver();
+    m_convolverButton->setChecked(convolver->isLoaded());
+    if (convolver->isLoaded()) {
+        m_convolverButton->setToolTip(tr("%1\n%2 taps, latency %3 ms")
+                                      .arg(QFileInfo(convolver->fileName()).fileName())
+                                      .arg(convolver->taps())
+                                      .arg(convolver->latencyFrames() * 1000 / convolver->sampleRate()));
+    } else {
+        m_convolverButton->setToolTip(tr("Impulse response (room correction, reverb)"));
+    }
+    updateAudioRouting();
+}
+
+void Player::setCompression(bool enabled)
+{
+    m_mixerOutput->mixer()->dynamics()->setCompressorEnabled(enabled);
+    updateAudioRouting();
+}
+
+void Player::setMixing(bool enabled)
+{
+    Q_UNUSED(enabled);
+    updateAudioRouting();
+}
+
+///Через микшер звук идёт при сведении, при скорости не 1x — там темп
+///меняется без смены высоты тона — и при включённых эквалайзере, свёртке или компрессоре.
+///Приглушение музыки — только при сведении
+void Player::updateAudioRouting()
+{
+    const bool mixing = m_mixButton->isChecked();
+    const bool stretching = !qFuzzyCompare(m_session->playbackRate(), qreal(1.0))
+            || !qFuzzyCompare(m_session_music->playbackRate(), qreal(1.0));
+    const bool equalizing = m_mixerOutput->mixer()->equalizer()->isActive();
+    const bool convolving = m_mixerOutput->mixer()->convolver()->isLoaded();
+    const bool compressing = m_dynamicsButton->isChecked();
+
+    if (mixing)
+        m_mixerOutput->setDucking(m_videoStream, m_musicStream);
+    else
+        m_mixerOutput->setDucking(-1, -1);
+
+    if (mixing || stretching || equalizing || convolving || compressing)
+        m_mixerOutput->start();
+    else
+        m_mixerOutput->stop();
+}
+
 void Player::clearHistogram()
 {
     QMetaObject::invokeMethod(m_videoHistogram, "processFrame", Qt::QueuedConnection, Q_ARG(QVideoFrame, QVideoFrame()));
@@ -623,12 +933,12 @@ void Player::createTaskbar()
     connect(m_slider, &QAbstractSlider::valueChanged, m_taskbarProgress, &QWinTaskbarProgress::setValue);
     connect(m_slider, &QAbstractSlider::rangeChanged, m_taskbarProgress, &QWinTaskbarProgress::setRange);
 
-    connect(m_player, &QMediaPlayer::stateChanged, this, &Player::updateTaskbar);
+    connect(m_session, &MediaSession::stateChanged, this, &Player::updateTaskbar);
 }
 
 void Player::updateTaskbar()
 {
-    switch (m_player->state()) {
+    switch (m_session->state()) {
     case QMediaPlayer::PlayingState:
         m_taskbarButton->setOverlayIcon(style()->standardIcon(QStyle::SP_MediaPlay));
         m_taskbarProgress->show();
@@ -673,19 +983,18 @@ void Player::createThumbnailToolBar()
     thumbnailToolBar->addButton(playToolButton);
     thumbnailToolBar->addButton(forwardToolButton);
 
-    connect(m_player, &QMediaPlayer::positionChanged, this, &Player::updateThumbnailToolBar);
-    connect(m_player, &QMediaPlayer::durationChanged, this, &Player::updateThumbnailToolBar);
-    connect(m_player, &QMediaPlayer::stateChanged, this, &Player::updateThumbnailToolBar);
+    connect(m_session, &MediaSession::durationChanged, this, &Player::updateThumbnailToolBar);
+    connect(m_session, &MediaSession::stateChanged, this, &Player::updateThumbnailToolBar);
 
 }
 
 void Player::updateThumbnailToolBar()
 {
-    playToolButton->setEnabled(m_player->duration() > 0);
-    backwardToolButton->setEnabled(m_player->position() > 0);
-    forwardToolButton->setEnabled(m_player->position() < m_player->duration());
+    playToolButton->setEnabled(m_session->duration() > 0);
+    backwardToolButton->setEnabled(m_session->position() > 0);
+    forwardToolButton->setEnabled(m_session->position() < m_session->duration());
 
-    if (m_player->state() == QMediaPlayer::PlayingState) {
+    if (m_session->state() == QMediaPlayer::PlayingState) {
         playToolButton->setToolTip(tr("Pause"));
         playToolButton->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
     } else {
@@ -696,10 +1005,10 @@ void Player::updateThumbnailToolBar()
 
 void Player::togglePlayback()
 {
-    if (m_player->state() == QMediaPlayer::PlayingState)
-        m_player->pause();
+    if (m_session->state() == QMediaPlayer::PlayingState)
+        m_session->pause();
     else
-        m_player->play();
+        m_session->play();
 }
 
 void Player::seekForward()
@@ -5,12 +5,18 @@
 #include <QMediaPlayer>
 #include <QMediaPlaylist>
 #include <QToolButton>
+#include <QImage>
+#include <QUrl>
 
 #ifdef WIN32
 #include <QtWinExtras>
 #endif
 
 #include "style.h"
+#include "uirefreshclock.h"
+#include "timeformat.h"
+#include "coloradjustment.h"
+#include "mediasession.h"
 
 QT_FORWARD_DECLARE_CLASS(QAbstractItemView)
 QT_FORWARD_DECLARE_CLASS(QLabel)
@@ -25,6 +31,12 @@ QT_FORWARD_DECLARE_CLASS(QAudioProbe)
 
 class PlaylistModel;
 class HistogramWidget;
+class CoverArtLoader;
+class SeekPreview;
+class FrameQueueSurface;
+class MixerOutput;
+class PerformanceHud;
+class PlaylistView;
 
 class Player : public QWidget
 {
@@ -37,18 +49,34 @@ private:
     void updateDurationInfo(qint64 currentInfo);
     void updateDurationInfo_music(qint64 currentInfo);
 
+    MediaSessionManager *m_sessions = nullptr;
     QMediaPlaylist *m_playlist = nullptr;
     QMediaPlaylist *m_playlist_music = nullptr;
+    UiRefreshClock *m_refreshClock = nullptr;
     QVideoWidget *m_videoWidget = nullptr;
+    FrameQueueSurface *m_frameQueue = nullptr;
+    MixerOutput *m_mixerOutput = nullptr;
+    int m_videoStream = -1;
+    int m_musicStream = -1;
+    PerformanceHud *m_hud = nullptr;
 
     QLabel *m_coverLabel = nullptr;
+    CoverArtLoader *m_coverArt = nullptr;
+    QUrl m_coverUrl;
     QSlider *m_slider = nullptr;
     QSlider *m_slider_music = nullptr;
+    SeekPreview *m_seekPreview = nullptr;
     QLabel *m_labelDuration = nullptr;
     QLabel *m_labelDuration_music = nullptr;
     QToolButton *m_fullScreenButton = nullptr;
     QToolButton *m_colorButton = nullptr;
+    QToolButton *m_mixButton = nullptr;
+    QToolButton *m_equalizerButton = nullptr;
+    QToolButton *m_convolverButton = nullptr;
+    QToolButton *m_dynamicsButton = nullptr;
     QDialog *m_colorDialog = nullptr;
+    QDialog *m_equalizerDialog = nullptr;
+    ColorAdjustment m_colorAdjustment;
 
     HistogramWidget *m_videoHistogram = nullptr;
     HistogramWidget *m_audioHistogram = nullptr;
@@ -56,15 +84,17 @@ private:
     QAudioProbe *m_audioProbe = nullptr;
 
     PlaylistModel *m_playlistModel = nullptr;
-    QAbstractItemView *m_playlistView = nullptr;
+    PlaylistView *m_playlistView = nullptr;
 
     PlaylistModel *m_playlistModel_music = nullptr;
-    QAbstractItemView *m_playlistView_music = nullptr;
+    PlaylistView *m_playlistView_music = nullptr;
 
     QString m_trackInfo;
     QString m_statusInfo;
-    qint64 m_duration;
-    qint64 m_duration_music;
+    qint64 m_duration = 0;
+    qint64 m_duration_music = 0;
+    TimeFormat m_durationFormat;
+    TimeFormat m_durationFormat_music;
 
 #ifdef WIN32
     void createTaskbar();
@@ -88,8 +118,11 @@ private slots:
     void positionChanged(qint64 progress);
     void durationChanged_music(qint64 duration);
     void positionChanged_music(qint64 progress);
+    void clockPositionChanged(QMediaPlayer *player, qint64 position);
     void metaDataChanged();
     void metaDataChanged_music();
+    void coverArtReady(const QUrl &url, const QImage &image);
+    void attachProbes();
 
     void previousClicked();
 
@@ -108,6 +141,12 @@ private slots:
     void displayErrorMessage();
 
     void showColorDialog();
+    void showEqualizerDialog();
+    void loadImpulseResponse();
+    void updateConvolverButton();
+    void setCompression(bool enabled);
+    void setMixing(bool enabled);
+    void updateAudioRouting();
 
 #ifdef WIN32
     void updateTaskbar();
@@ -118,10 +157,11 @@ public:
     explicit Player(QWidget *parent = nullptr);
     ~Player();
 
-    QMediaPlayer *m_player = nullptr;
-    QMediaPlayer *m_player_music = nullptr;
+    MediaSession *m_session = nullptr;
+    MediaSession *m_session_music = nullptr;
 
     bool isPlayerAvailable() const;
+    FrameQueueSurface *frameQueue() const;
 
     void addToPlaylist(const QList<QUrl> &urls);
     void addToPlaylist_music(const QList<QUrl> &urls);
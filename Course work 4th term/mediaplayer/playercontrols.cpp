@@ -11,35 +11,32 @@ PlayerControls::PlayerControls(QWidget *parent)
     : QWidget(parent)
 {
     m_playButton = new QToolButton(this);
-    m_playButton->setStyleSheet(Style::getPlayStyleSheet());
+    m_playButton->setObjectName("btn_play");
 
     connect(m_playButton, &QAbstractButton::clicked, this, &PlayerControls::playClicked);
 
     m_stopButton = new QToolButton(this);
-    m_stopButton->setStyleSheet(Style::getStopStyleSheet());
+    m_stopButton->setObjectName("btn_stop");
     m_stopButton->setEnabled(false);
 
     connect(m_stopButton, &QAbstractButton::clicked, this, &PlayerControls::stop);
 
     m_nextButton = new QToolButton(this);
-    m_nextButton->setStyleSheet(Style::getNextStyleSheet());
+    m_nextButton->setObjectName("btn_next");
 
     connect(m_nextButton, &QAbstractButton::clicked, this, &PlayerControls::next);
 
     m_previousButton = new QToolButton(this);
-    m_previousButton->setStyleSheet(Style::getPreviousStyleSheet());
+    m_previousButton->setObjectName("btn_previous");
 
     connect(m_previousButton, &QAbstractButton::clicked, this, &PlayerControls::previous);
 
     m_muteButton = new QToolButton(this);
-    m_muteButton->setStyleSheet("padding-left: 0px;"
-                                "padding-right: 0px;"
-                                "padding-top: 0px;"
-                                "padding-bottom: 0px;");
+    m_muteButton->setObjectName("btn_volume");
     connect(m_muteButton, &QAbstractButton::clicked, this, &PlayerControls::muteClicked);
 
     m_volumeSlider = new QSlider(Qt::Horizontal, this);
-    setStyleSheet(Style::getSliderStyleSheet2());
+    m_volumeSlider->setObjectName("volumeSlider");
     m_volumeSlider->setRange(0, 100);
 
     connect(m_volumeSlider, &QSlider::valueChanged, this, &PlayerControls::onVolumeSliderValueChanged);
@@ -50,19 +47,18 @@ PlayerControls::PlayerControls(QWidget *parent)
     m_stopButton->setToolTip("Stop");
 
     m_rateBox = new QComboBox(this);
-    m_rateBox->setStyleSheet(Style::getComboBoxStyleSheet());
+    m_rateBox->setObjectName("rateBox");
     m_rateBox->addItem("0.5x", QVariant(0.5));
+    m_rateBox->addItem("0.75x", QVariant(0.75));
     m_rateBox->addItem("1.0x", QVariant(1.0));
+    m_rateBox->addItem("1.25x", QVariant(1.25));
+    m_rateBox->addItem("1.5x", QVariant(1.5));
     m_rateBox->addItem("2.0x", QVariant(2.0));
-    m_rateBox->setCurrentIndex(1);
+    m_rateBox->setCurrentIndex(2);
 
     connect(m_rateBox, QOverload<int>::of(&QComboBox::activated), this, &PlayerControls::updateRate);
 
     m_muteButton->setIcon(QIcon(":/buttons/volume_w.png"));
-    m_muteButton->setStyleSheet("padding-left: 0px;"
-                  "padding-right: 0px;"
-                  "padding-top: 0px;"
-                  "padding-bottom: 0px;");
     m_muteButton->setIconSize(QSize(20,20));
 
     QBoxLayout *layout = new QHBoxLayout;
@@ -90,15 +86,15 @@ void PlayerControls::setState(QMediaPlayer::State state)
         switch (state) {
         case QMediaPlayer::StoppedState:
             m_stopButton->setEnabled(false);
-            m_playButton->setStyleSheet(Style::getPlayStyleSheet());
+            Style::setState(m_playButton, "playing", false);
             break;
         case QMediaPlayer::PlayingState:
             m_stopButton->setEnabled(true);
-            m_playButton->setStyleSheet(Style::getPauseStyleSheet());
+            Style::setState(m_playButton, "playing", true);
             break;
         case QMediaPlayer::PausedState:
             m_stopButton->setEnabled(true);
-            m_playButton->setStyleSheet(Style::getPlayStyleSheet());
+            Style::setState(m_playButton, "playing", false);
             break;
         }
     }
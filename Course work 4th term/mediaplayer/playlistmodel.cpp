@@ -4,9 +4,15 @@
 #include <QUrl>
 #include <QMediaPlaylist>
 
+#include "timeformat.h"
+#include "trace.h"
+
 PlaylistModel::PlaylistModel(QObject *parent)
     : QAbstractItemModel(parent)
 {
+    m_tagTimer.setSingleShot(true);
+    connect(&m_tagTimer, &QTimer::timeout, this, &PlaylistModel::requestTags);
+    connect(&m_infoLoader, &TrackInfoLoader::infoRead, this, &PlaylistModel::infoRead);
 }
 
 PlaylistModel::~PlaylistModel()
@@ -41,11 +47,20 @@ QModelIndex PlaylistModel::parent(const QModelIndex &child) const
 
 QVariant PlaylistModel::data(const QModelIndex &index, int role) const
 {
-    if (index.isValid() && role == Qt::DisplayRole) {
-        QVariant value = m_data[index];
-        if (!value.isValid() && index.column() == Title) {
-            QUrl location = m_playlist->media(index.row()).canonicalUrl();
-            return QFileInfo(location.path()).fileName();
+    TRACE_SCOPE("model", "PlaylistModel::data");
+
+    if (!index.isValid())
+        return QVariant();
+    if (role == Qt::TextAlignmentRole && index.column() == Duration)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+
+    if (role == Qt::DisplayRole) {
+        QVariant value = m_data.value(index);
+        if (!value.isValid() && index.column() == Title)
+            return title(index.row());
+        if (!value.isValid() && index.column() == Duration) {
+            const qint64 ms = duration(index.row());
+            return ms >= 0 ? TimeFormat::toString(ms / 1000) : QString();
         }
 
         return value;
@@ -53,6 +68,126 @@ QVariant PlaylistModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+///Пока теги не прочитаны, название — имя файла, и в кэш строк оно не попадает.
+///Запросы тегов копятся до конца текущей обработки событий и уходят одной пачкой
+QString PlaylistModel::title(int row) const
+{
+    if (row < m_titles.size() && !m_titles.at(row).isNull())
+        return m_titles.at(row);
+
+    const QUrl url = m_playlist->media(row).canonicalUrl();
+    const QString fileName = QFileInfo(url.path()).fileName();
+    if (row >= m_titles.size())
+        return fileName;
+
+    if (!url.isLocalFile()) {
+        m_titles[row] = fileName;
+        return fileName;
+    }
+
+    const QString path = url.toLocalFile();
+    const auto tagged = m_tagTitles.constFind(path);
+    if (tagged != m_tagTitles.constEnd()) {
+        m_titles[row] = tagged.value();
+        return tagged.value();
+    }
+
+    requestInfo(row, path);
+    return fileName;
+}
+
+qint64 PlaylistModel::duration(int row) const
+{
+    if (!m_playlist || row < 0 || row >= m_durations.size())
+        return -1;
+    if (m_durations.at(row) >= 0)
+        return m_durations.at(row);
+
+    const QUrl url = m_playlist->media(row).canonicalUrl();
+    if (!url.isLocalFile())
+        return -1;
+
+    const QString path = url.toLocalFile();
+    const auto known = m_tagDurations.constFind(path);
+    if (known != m_tagDurations.constEnd()) {
+        m_durations[row] = known.value();
+        return known.value();
+    }
+
+    requestInfo(row, path);
+    return -1;
+}
+
+///Название и длительность одного файла приходят одним ответом, поэтому запрос общий
+void PlaylistModel::requestInfo(int row, const QString &path) const
+{
+    if (m_tagPending.contains(path))
+        return;
+    m_tagPending.insert(path);
+    m_tagRows.append(row);
+    m_tagFiles.append(path);
+    if (!m_tagTimer.isActive())
+        m_tagTimer.start(0);
+}
+
+void PlaylistModel::requestTags()
+{
+    m_infoLoader.request(m_tagRows, m_tagFiles);
+    m_tagRows.clear();
+    m_tagFiles.clear();
+}
+
+///Строка могла сдвинуться, пока читались теги: тогда название и длительность
+///найдутся по имени файла при следующей отрисовке
+void PlaylistModel::infoRead(const QVector<int> &rows, const QStringList &fileNames, const QVector<TagReader::Tags> &tags,
+                             const QVector<qint64> &durations)
+{
+    TRACE_SCOPE("model", "PlaylistModel::infoRead");
+
+    if (!m_playlist)
+        return;
+
+    int first = m_titles.size();
+    int last = -1;
+    bool moved = false;
+    for (int i = 0; i < rows.size(); ++i) {
+        const QString &path = fileNames.at(i);
+        const QString title = TagReader::displayTitle(tags.at(i), QFileInfo(path).fileName());
+        m_tagPending.remove(path);
+        m_tagTitles.insert(path, title);
+        m_tagDurations.insert(path, durations.at(i));
+
+        const int row = rows.at(i);
+        if (row >= m_titles.size() || m_playlist->media(row).canonicalUrl().toLocalFile() != path) {
+            moved = true;
+            continue;
+        }
+        m_titles[row] = title;
+        m_durations[row] = durations.at(i);
+        first = qMin(first, row);
+        last = qMax(last, row);
+    }
+
+    if (moved && rowCount() > 0)
+        emit dataChanged(index(0, Title), index(rowCount() - 1, Duration));
+    else if (last >= 0)
+        emit dataChanged(index(first, Title), index(last, Duration));
+}
+
+///Названия строк рядом с видимой областью считаются заранее,
+///чтобы при прокрутке отрисовка брала их из кэша
+void PlaylistModel::prefetch(int first, int last)
+{
+    TRACE_SCOPE("model", "PlaylistModel::prefetch");
+
+    if (!m_playlist)
+        return;
+    first = qMax(0, first);
+    last = qMin(last, m_titles.size() - 1);
+    for (int row = first; row <= last; ++row)
+        title(row);
+}
+
 QMediaPlaylist *PlaylistModel::playlist() const
 {
     return m_playlist.data();
@@ -69,7 +204,16 @@ void PlaylistModel::setPlaylist(QMediaPlaylist *playlist)
     }
 
     beginResetModel();
-    m_playlist.reset(playlist);
+    m_infoLoader.cancel();
+    m_tagTimer.stop();
+    m_tagTitles.clear();
+    m_tagDurations.clear();
+    m_tagPending.clear();
+    m_tagRows.clear();
+    m_tagFiles.clear();
+    m_playlist = playlist;
+    m_titles = QVector<QString>(m_playlist ? m_playlist->mediaCount() : 0);
+    m_durations = QVector<qint64>(m_titles.size(), -1);
 
     if (m_playlist) {
         connect(m_playlist.data(), &QMediaPlaylist::mediaAboutToBeInserted, this, &PlaylistModel::beginInsertItems);
@@ -93,27 +237,41 @@ bool PlaylistModel::setData(const QModelIndex &index, const QVariant &value, int
 void PlaylistModel::beginInsertItems(int start, int end)
 {
     m_data.clear();
+    m_changeStart = start;
+    m_changeCount = end - start + 1;
     beginInsertRows(QModelIndex(), start, end);
 }
 
+///Кэш сдвигается только после изменения плейлиста, чтобы до этого момента
+///строки кэша совпадали с записями плейлиста
 void PlaylistModel::endInsertItems()
 {
+    m_titles.insert(m_changeStart, m_changeCount, QString());
+    m_durations.insert(m_changeStart, m_changeCount, -1);
     endInsertRows();
 }
 
 void PlaylistModel::beginRemoveItems(int start, int end)
 {
     m_data.clear();
+    m_changeStart = start;
+    m_changeCount = end - start + 1;
     beginRemoveRows(QModelIndex(), start, end);
 }
 
 void PlaylistModel::endRemoveItems()
 {
-    endInsertRows();
+    m_titles.remove(m_changeStart, m_changeCount);
+    m_durations.remove(m_changeStart, m_changeCount);
+    endRemoveRows();
 }
 
 void PlaylistModel::changeItems(int start, int end)
 {
     m_data.clear();
-    emit dataChanged(index(start,0), index(end,ColumnCount));
+    for (int row = start; row <= end && row < m_titles.size(); ++row) {
+        m_titles[row] = QString();
+        m_durations[row] = -1;
+    }
+    emit dataChanged(index(start, 0), index(end, ColumnCount - 1));
 }
@@ -2,7 +2,13 @@
 #define PLAYLISTMODEL_H
 
 #include <QAbstractItemModel>
-#include <QScopedPointer>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include "trackinfoloader.h"
 
 QT_BEGIN_NAMESPACE
 class QMediaPlaylist;
@@ -13,9 +19,28 @@ class PlaylistModel : public QAbstractItemModel
     Q_OBJECT
 
 private:
-    QScopedPointer<QMediaPlaylist> m_playlist;
+    ///Плейлист принадлежит сессии, модель его не удаляет
+    QPointer<QMediaPlaylist> m_playlist;
     QMap<QModelIndex, QVariant> m_data;
+    ///Названия строк по мере обращения к ним, пустая строка — ещё не считано
+    mutable QVector<QString> m_titles;
+    int m_changeStart = 0;
+    int m_changeCount = 0;
+
+    ///Длительности строк в мс: -1 — ещё не прочитана или не определяется
+    mutable QVector<qint64> m_durations;
+
+    ///Названия из тегов и длительности по именам файлов; запросы копятся и уходят одной пачкой
+    TrackInfoLoader m_infoLoader;
+    QHash<QString, QString> m_tagTitles;
+    QHash<QString, qint64> m_tagDurations;
+    mutable QSet<QString> m_tagPending;
+    mutable QVector<int> m_tagRows;
+    mutable QStringList m_tagFiles;
+    mutable QTimer m_tagTimer;
 
+    QString title(int row) const;
+    void requestInfo(int row, const QString &path) const;
 
 private slots:
     void beginInsertItems(int start, int end);
@@ -23,11 +48,15 @@ private slots:
     void beginRemoveItems(int start, int end);
     void endRemoveItems();
     void changeItems(int start, int end);
+    void requestTags();
+    void infoRead(const QVector<int> &rows, const QStringList &fileNames, const QVector<TagReader::Tags> &tags,
+                  const QVector<qint64> &durations);
 
 public:
     enum Column
     {
         Title = 0,
+        Duration,
         ColumnCount
     };
 
@@ -42,10 +71,16 @@ public:
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+    ///Длительность по заголовкам файла в мс, -1 — пока неизвестна
+    qint64 duration(int row) const;
+
     QMediaPlaylist *playlist() const;
     void setPlaylist(QMediaPlaylist *playlist);
 
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::DisplayRole) override;
+
+public slots:
+    void prefetch(int first, int last);
 };
 
 #endif // PLAYLISTMODEL_H
@@ -0,0 +1,251 @@
+#include "playlistsequence.h"
+
+#include <algorithm>
+
+quint32 PlaylistSequence::nextPriority()
+{
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return m_random;
+}
+
+int PlaylistSequence::allocate()
+{
+    int node;
+    if (!m_free.isEmpty()) {
+        node = m_free.last();
+        m_free.removeLast();
+    } else {
+        node = m_nodes.size();
+        m_nodes.append(Node());
+    }
+
+    Node &n = m_nodes[node];
+    n.left = -1;
+    n.right = -1;
+    n.parent = -1;
+    n.size = 1;
+    n.priority = nextPriority();
+    return node;
+}
+
+///Пересчитывает размер и заодно привязывает детей к узлу
+void PlaylistSequence::update(int node)
+{
+    Node &n = m_nodes[node];
+    n.size = 1 + size(n.left) + size(n.right);
+    if (n.left >= 0)
+        m_nodes[n.left].parent = node;
+    if (n.right >= 0)
+        m_nodes[n.right].parent = node;
+}
+
+void PlaylistSequence::updateTree(int node)
+{
+    if (node < 0)
+        return;
+    updateTree(m_nodes.at(node).left);
+    updateTree(m_nodes.at(node).right);
+    update(node);
+}
+
+void PlaylistSequence::setRoot(int node)
+{
+    m_root = node;
+    if (node >= 0)
+        m_nodes[node].parent = -1;
+}
+
+int PlaylistSequence::merge(int left, int right)
+{
+    if (left < 0)
+        return right;
+    if (right < 0)
+        return left;
+
+    if (m_nodes.at(left).priority > m_nodes.at(right).priority) {
+        m_nodes[left].right = merge(m_nodes.at(left).right, right);
+        update(left);
+        return left;
+    }
+    m_nodes[right].left = merge(left, m_nodes.at(right).left);
+    update(right);
+    return right;
+}
+
+///Первые count элементов поддерева уходят в left, остальные в right
+void PlaylistSequence::split(int node, int count, int *left, int *right)
+{
+    if (node < 0) {
+        *left = -1;
+        *right = -1;
+        return;
+    }
+
+    const int leftSize = size(m_nodes.at(node).left);
+    if (leftSize < count) {
+        int rest;
+        split(m_nodes.at(node).right, count - leftSize - 1, &rest, right);
+        m_nodes[node].right = rest;
+        update(node);
+        *left = node;
+    } else {
+        int rest;
+        split(m_nodes.at(node).left, count, left, &rest);
+        m_nodes[node].left = rest;
+        update(node);
+        *right = node;
+    }
+}
+
+///Дерево из count новых узлов за линейное время: узлы идут по порядку,
+///в стеке лежит правая ветвь, и каждый новый узел забирает под себя
+///ту её часть, у которой приоритет ниже
+int PlaylistSequence::build(int count, QVector<int> *ids)
+{
+    m_stack.resize(0);
+    for (int i = 0; i < count; ++i) {
+        const int node = allocate();
+        if (ids)
+            ids->append(node);
+
+        int last = -1;
+        while (!m_stack.isEmpty() && m_nodes.at(m_stack.last()).priority < m_nodes.at(node).priority) {
+            last = m_stack.last();
+            m_stack.removeLast();
+        }
+        m_nodes[node].left = last;
+        if (!m_stack.isEmpty())
+            m_nodes[m_stack.last()].right = node;
+        m_stack.append(node);
+    }
+
+    const int root = m_stack.isEmpty() ? -1 : m_stack.first();
+    updateTree(root);
+    return root;
+}
+
+void PlaylistSequence::release(int node, QVector<int> *ids)
+{
+    if (node < 0)
+        return;
+    release(m_nodes.at(node).left, ids);
+    if (ids)
+        ids->append(node);
+    m_nodes[node].parent = -1;
+    m_free.append(node);
+    release(m_nodes.at(node).right, ids);
+}
+
+int PlaylistSequence::at(int position) const
+{
+    int node = m_root;
+    while (node >= 0) {
+        const Node &n = m_nodes.at(node);
+        const int leftSize = size(n.left);
+        if (position < leftSize) {
+            node = n.left;
+        } else if (position == leftSize) {
+            return node;
+        } else {
+            position -= leftSize + 1;
+            node = n.right;
+        }
+    }
+    return -1;
+}
+
+///Позиция — узлы левого поддерева плюс всё, что левее, на пути к корню
+int PlaylistSequence::indexOf(int id) const
+{
+    if (id < 0 || id >= m_nodes.size())
+        return -1;
+
+    int position = size(m_nodes.at(id).left);
+    int node = id;
+    for (int parent = m_nodes.at(node).parent; parent >= 0; parent = m_nodes.at(node).parent) {
+        if (m_nodes.at(parent).right == node)
+            position += size(m_nodes.at(parent).left) + 1;
+        node = parent;
+    }
+    return node == m_root ? position : -1;
+}
+
+void PlaylistSequence::insert(int position, int count, QVector<int> *ids)
+{
+    if (count <= 0)
+        return;
+    position = qBound(0, position, this->count());
+
+    const int block = build(count, ids);
+    int left, right;
+    split(m_root, position, &left, &right);
+    setRoot(merge(merge(left, block), right));
+}
+
+void PlaylistSequence::remove(int position, int count, QVector<int> *ids)
+{
+    if (count <= 0 || position < 0 || position >= this->count())
+        return;
+
+    int left, middle, right;
+    split(m_root, position, &left, &right);
+    split(right, count, &middle, &right);
+    release(middle, ids);
+    setRoot(merge(left, right));
+}
+
+///Отрезки подряд идущих строк вынимаются с конца, чтобы позиции
+///ещё не вынутых не сдвигались, и склеиваются в один блок
+int PlaylistSequence::move(const QVector<int> &rows, int destination)
+{
+    destination = qBound(0, destination, count());
+    const int target = destination - int(std::lower_bound(rows.begin(), rows.end(), destination) - rows.begin());
+
+    int block = -1;
+    for (int end = rows.size(); end > 0;) {
+        int start = end - 1;
+        while (start > 0 && rows.at(start - 1) == rows.at(start) - 1)
+            --start;
+
+        int left, middle, right;
+        split(m_root, rows.at(start), &left, &right);
+        split(right, end - start, &middle, &right);
+        m_root = merge(left, right);
+        block = merge(middle, block);
+        end = start;
+    }
+
+    int left, right;
+    split(m_root, target, &left, &right);
+    setRoot(merge(merge(left, block), right));
+    return target;
+}
+
+void PlaylistSequence::clear()
+{
+    m_nodes.clear();
+    m_free.clear();
+    m_root = -1;
+}
+
+int PlaylistSequence::rowAfterRemove(const QVector<int> &rows, int row)
+{
+    const auto it = std::lower_bound(rows.begin(), rows.end(), row);
+    if (it != rows.end() && *it == row)
+        return -1;
+    return row - int(it - rows.begin());
+}
+
+int PlaylistSequence::rowAfterMove(const QVector<int> &rows, int destination, int row)
+{
+    const int target = destination - int(std::lower_bound(rows.begin(), rows.end(), destination) - rows.begin());
+    const auto it = std::lower_bound(rows.begin(), rows.end(), row);
+    const int before = int(it - rows.begin());
+    if (it != rows.end() && *it == row)
+        return target + before;
+
+    const int rest = row - before;
+    return rest >= target ? rest + rows.size() : rest;
+}
@@ -0,0 +1,66 @@
+#ifndef PLAYLISTSEQUENCE_H
+#define PLAYLISTSEQUENCE_H
+
+#include <QVector>
+
+///Последовательность треков плейлиста — декартово дерево по неявному ключу
+///(позиция в плейлисте = число узлов левее). Вставка, удаление и перенос
+///любого отрезка стоят O(log n), пачка из k треков вставляется за O(k + log n).
+///Номер трека — номер его узла в пуле: он не меняется, пока трек в плейлисте,
+///и по ссылке на родителя за O(log n) даёт текущую позицию.
+///Узлы лежат в одном массиве и переиспользуются после удаления
+class PlaylistSequence
+{
+private:
+    struct Node
+    {
+        int left;
+        int right;
+        int parent;
+        int size;
+        quint32 priority;
+    };
+
+    QVector<Node> m_nodes;
+    QVector<int> m_free;
+    QVector<int> m_stack;
+    int m_root = -1;
+    quint32 m_random = 2463534242u;
+
+    int size(int node) const { return node < 0 ? 0 : m_nodes.at(node).size; }
+    quint32 nextPriority();
+    int allocate();
+    void update(int node);
+    void updateTree(int node);
+    void setRoot(int node);
+    int merge(int left, int right);
+    void split(int node, int count, int *left, int *right);
+    int build(int count, QVector<int> *ids);
+    void release(int node, QVector<int> *ids);
+
+public:
+    int count() const { return size(m_root); }
+    bool isEmpty() const { return m_root < 0; }
+
+    ///Все номера треков меньше capacity()
+    int capacity() const { return m_nodes.size(); }
+
+    int at(int position) const;
+    int indexOf(int id) const;
+
+    ///Новые номера дописываются в ids в порядке позиций
+    void insert(int position, int count, QVector<int> *ids);
+    void remove(int position, int count, QVector<int> *ids = nullptr);
+
+    ///Переносит строки rows (по возрастанию, без повторов) одним блоком
+    ///перед строкой destination. Возвращает новую позицию блока
+    int move(const QVector<int> &rows, int destination);
+
+    void clear();
+
+    ///Куда попадёт строка row после удаления или переноса строк rows; -1 — удалена
+    static int rowAfterRemove(const QVector<int> &rows, int row);
+    static int rowAfterMove(const QVector<int> &rows, int destination, int row);
+};
+
+#endif // PLAYLISTSEQUENCE_H
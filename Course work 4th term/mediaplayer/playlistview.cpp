@@ -0,0 +1,170 @@
+#include "playlistview.h"
+
+#include <QDropEvent>
+#include <QHeaderView>
+#include <QPainter>
+
+#include "trace.h"
+
+PlaylistDelegate::PlaylistDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+///Цвета берутся из палитры вида, которую задаёт общая таблица стилей
+void PlaylistDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const bool selected = option.state & QStyle::State_Selected;
+    if (selected)
+        painter->fillRect(option.rect, option.palette.brush(QPalette::Highlight));
+
+    const QRect textRect = option.rect.adjusted(6, 0, -6, 0);
+    const QString text = option.fontMetrics.elidedText(index.data(Qt::DisplayRole).toString(),
+                                                       Qt::ElideRight, textRect.width());
+    painter->setPen(option.palette.color(selected ? QPalette::HighlightedText : QPalette::Text));
+    const QVariant alignment = index.data(Qt::TextAlignmentRole);
+    painter->drawText(textRect, alignment.isValid() ? Qt::Alignment(alignment.toInt()) : Qt::AlignLeft | Qt::AlignVCenter, text);
+}
+
+QSize PlaylistDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+    return QSize(option.rect.width(), option.fontMetrics.height() + 8);
+}
+
+PlaylistView::PlaylistView(QWidget *parent)
+    : QTableView(parent)
+{
+    setItemDelegate(new PlaylistDelegate(this));
+    setShowGrid(false);
+    setWordWrap(false);
+    setCornerButtonEnabled(false);
+    setSelectionBehavior(QAbstractItemView::SelectRows);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+
+    verticalHeader()->setVisible(false);
+    verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    horizontalHeader()->setStretchLastSection(true);
+    horizontalHeader()->setHighlightSections(false);
+    updateRowHeight();
+
+    ///Подготовка строк откладывается до следующего кадра, чтобы не задерживать прокрутку
+    m_prefetchTimer.setSingleShot(true);
+    m_prefetchTimer.setInterval(16);
+    connect(&m_prefetchTimer, &QTimer::timeout, this, &PlaylistView::requestPrefetch);
+}
+
+void PlaylistView::setModel(QAbstractItemModel *model)
+{
+    QTableView::setModel(model);
+    if (model) {
+        connect(model, &QAbstractItemModel::rowsInserted, &m_prefetchTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+        connect(model, &QAbstractItemModel::modelReset, &m_prefetchTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+        ///После сброса заголовок заново раздаёт столбцам ширину по умолчанию
+        connect(model, &QAbstractItemModel::modelReset, this, &PlaylistView::updateDurationColumn);
+    }
+    m_prefetchTimer.start();
+    updateDurationColumn();
+}
+
+void PlaylistView::updateRowHeight()
+{
+    const int height = fontMetrics().height() + 8;
+    verticalHeader()->setMinimumSectionSize(height);
+    verticalHeader()->setDefaultSectionSize(height);
+}
+
+void PlaylistView::setDurationColumn(int column)
+{
+    m_durationColumn = column;
+    updateDurationColumn();
+}
+
+///Отступы те же, что у делегата, плюс запас на заголовок
+void PlaylistView::updateDurationColumn()
+{
+    if (m_durationColumn < 0)
+        return;
+    horizontalHeader()->setSectionResizeMode(m_durationColumn, QHeaderView::Fixed);
+    horizontalHeader()->resizeSection(m_durationColumn, fontMetrics().boundingRect(QStringLiteral("00:00:00")).width() + 24);
+}
+
+void PlaylistView::visibleRows(int *first, int *last) const
+{
+    *first = -1;
+    *last = -1;
+    if (!model() || model()->rowCount(rootIndex()) == 0)
+        return;
+
+    *first = qMax(0, rowAt(0));
+    *last = rowAt(viewport()->height() - 1);
+    if (*last < 0)
+        *last = model()->rowCount(rootIndex()) - 1;
+}
+
+void PlaylistView::requestPrefetch()
+{
+    TRACE_SCOPE("playlist", "PlaylistView::requestPrefetch");
+
+    int first, last;
+    visibleRows(&first, &last);
+    if (first < 0 || m_prefetchRows <= 0)
+        return;
+
+    const int count = model()->rowCount(rootIndex());
+    if (last + 1 < count)
+        emit prefetchRequested(last + 1, qMin(count - 1, last + m_prefetchRows));
+    if (first > 0)
+        emit prefetchRequested(qMax(0, first - m_prefetchRows), first - 1);
+}
+
+void PlaylistView::scrollContentsBy(int dx, int dy)
+{
+    QTableView::scrollContentsBy(dx, dy);
+    if (dy)
+        m_prefetchTimer.start();
+}
+
+void PlaylistView::resizeEvent(QResizeEvent *event)
+{
+    QTableView::resizeEvent(event);
+    m_prefetchTimer.start();
+}
+
+void PlaylistView::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange || event->type() == QEvent::StyleChange) {
+        updateRowHeight();
+        updateDurationColumn();
+    }
+    QTableView::changeEvent(event);
+}
+
+///Действие подменяется на копирование: на перенос QAbstractItemView
+///после сброса сам удалил бы исходные строки
+void PlaylistView::dropEvent(QDropEvent *event)
+{
+    if (event->source() != this || dragDropMode() != QAbstractItemView::InternalMove) {
+        QTableView::dropEvent(event);
+        return;
+    }
+
+    int destination = model()->rowCount(rootIndex());
+    const QModelIndex index = indexAt(event->pos());
+    if (index.isValid())
+        destination = index.row() + (dropIndicatorPosition() == QAbstractItemView::BelowItem ? 1 : 0);
+
+    QList<int> rows;
+    for (const QModelIndex &selected : selectionModel()->selectedRows())
+        rows.append(selected.row());
+
+    event->setDropAction(Qt::CopyAction);
+    event->accept();
+    stopAutoScroll();
+    setState(QAbstractItemView::NoState);
+    viewport()->update();
+
+    if (!rows.isEmpty())
+        emit rowsDropped(rows, destination);
+}
@@ -0,0 +1,70 @@
+#ifndef PLAYLISTVIEW_H
+#define PLAYLISTVIEW_H
+
+#include <QStyledItemDelegate>
+#include <QTableView>
+#include <QTimer>
+
+///Делегат строки плейлиста: высота строки фиксирована и не зависит от данных,
+///а отрисовка запрашивает у модели только текст и его выравнивание
+class PlaylistDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
+
+///Виртуализированный вид плейлиста. Все строки одной высоты, поэтому положение
+///любой строки считается без обращения к модели, а рисуются только видимые.
+///После прокрутки вид просит модель заранее подготовить строки сразу за краями окна.
+///Перетаскивание строк внутри вида не трогает модель само, а отдаётся сигналом rowsDropped
+class PlaylistView : public QTableView
+{
+    Q_OBJECT
+
+private:
+    int m_prefetchRows = 64;
+    QTimer m_prefetchTimer;
+    int m_durationColumn = -1;
+
+    void updateRowHeight();
+    void updateDurationColumn();
+
+private slots:
+    void requestPrefetch();
+
+protected:
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void dropEvent(QDropEvent *event) override;
+
+public:
+    explicit PlaylistView(QWidget *parent = nullptr);
+
+    void setModel(QAbstractItemModel *model) override;
+
+    int prefetchRows() const { return m_prefetchRows; }
+    void setPrefetchRows(int rows) { m_prefetchRows = rows; }
+
+    ///Столбец длительности получает постоянную ширину под "00:00:00",
+    ///чтобы приходящие в фоне значения не двигали остальные столбцы
+    int durationColumn() const { return m_durationColumn; }
+    void setDurationColumn(int column);
+
+    ///Первая и последняя видимые строки, -1 если строк нет
+    void visibleRows(int *first, int *last) const;
+
+signals:
+    void prefetchRequested(int first, int last);
+
+    ///Выделенные строки перетащены внутри вида (режим InternalMove).
+    ///Переносит их владелец модели, destination — строка, перед которой они встанут
+    void rowsDropped(const QList<int> &rows, int destination);
+};
+
+#endif // PLAYLISTVIEW_H
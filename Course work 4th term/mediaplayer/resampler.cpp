@@ -0,0 +1,178 @@
+#include "resampler.h"
+
+#include <QtMath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RESAMPLER_SSE2
+#endif
+
+///Окно Кайзера с бета 8 — подавление вне полосы около 80 дБ
+static const double kaiserBeta = 8.0;
+///Доля новой частоты Найквиста, которую фильтр пропускает
+static const double passband = 0.92;
+
+///Модифицированная функция Бесселя нулевого порядка
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+static int greatestCommonDivisor(int a, int b)
+{
+    while (b) {
+        const int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+Resampler::Resampler()
+{
+    configure(48000, 48000, 8192);
+}
+
+void Resampler::configure(int inputRate, int outputRate, int maxInputFrames)
+{
+    m_inputRate = qMax(1, inputRate);
+    m_outputRate = qMax(1, outputRate);
+    m_maxInputFrames = qMax(1, maxInputFrames);
+
+    const int divisor = greatestCommonDivisor(m_inputRate, m_outputRate);
+    m_phases = m_outputRate / divisor;
+    m_step = m_inputRate / divisor;
+    m_tablePhases = qMin(m_phases, int(MaxPhases));
+
+    ///Частота среза в долях частоты Найквиста входа
+    const double ratio = qMin(1.0, double(m_outputRate) / m_inputRate);
+    const double cutoff = passband * ratio;
+    m_taps = qMin(int(MaxTaps), (int(qCeil(Taps / ratio)) + 1) & ~1);
+
+    const int half = m_taps / 2;
+    const double norm = besselI0(kaiserBeta);
+    m_coefficients.fill(0.0f, m_tablePhases * m_taps * Channels);
+    QVector<double> values(m_taps);
+    for (int phase = 0; phase < m_tablePhases; ++phase) {
+        ///Отвод j стоит на расстоянии j - (half - 1) - f от отсчёта
+        const double fraction = double(phase) / m_tablePhases;
+        float *row = m_coefficients.data() + phase * m_taps * Channels;
+        double sum = 0;
+        for (int j = 0; j < m_taps; ++j) {
+            const double x = j - (half - 1) - fraction;
+            const double sinc = qFuzzyIsNull(x) ? 1.0 : qSin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            const double t = x / half;
+            const double window = qAbs(t) >= 1.0 ? 0.0 : besselI0(kaiserBeta * qSqrt(1.0 - t * t)) / norm;
+            values[j] = sinc * window;
+            sum += values[j];
+        }
+        ///Единичное усиление на постоянном сигнале в каждой фазе
+        for (int j = 0; j < m_taps; ++j)
+            row[j * Channels] = row[j * Channels + 1] = float(values.at(j) / sum);
+    }
+
+    m_history.fill(0.0f, (m_taps + m_maxInputFrames) * Channels);
+    reset();
+}
+
+///Под фильтром первого отсчёта слева только тишина
+void Resampler::reset()
+{
+    std::memset(m_history.data(), 0, size_t(m_history.size()) * sizeof(float));
+    m_historyFrames = m_taps / 2 - 1;
+    m_start = 0;
+    m_fraction = 0;
+}
+
+int Resampler::maxOutputFrames(int frames) const
+{
+    return int((qint64(frames) * m_phases + m_step - 1) / m_step) + 1;
+}
+
+int Resampler::process(const float *in, int frames, float *out)
+{
+    const int capacity = m_history.size() / Channels;
+    int produced = 0;
+    while (frames > 0) {
+        const int count = qMin(frames, capacity - m_historyFrames);
+        std::memcpy(m_history.data() + m_historyFrames * Channels, in, size_t(count) * Channels * sizeof(float));
+        m_historyFrames += count;
+        in += count * Channels;
+        frames -= count;
+
+        produced += run(out + produced * Channels);
+
+        ///Использованное начало истории сдвигается: остаётся меньше m_taps кадров
+        m_historyFrames -= m_start;
+        std::memmove(m_history.data(), m_history.constData() + m_start * Channels,
+                     size_t(m_historyFrames) * Channels * sizeof(float));
+        m_start = 0;
+    }
+    return produced;
+}
+
+///Отсчёты, для которых под фильтром уже есть все кадры
+int Resampler::run(float *out)
+{
+    const float *history = m_history.constData();
+    const float *coefficients = m_coefficients.constData();
+    const int rowSize = m_taps * Channels;
+    const bool exact = m_tablePhases == m_phases;
+
+    int produced = 0;
+    int start = m_start;
+    int fraction = m_fraction;
+    while (start + m_taps <= m_historyFrames) {
+        const int row = exact ? fraction : int(qint64(fraction) * m_tablePhases / m_phases);
+        convolve(history + start * Channels, coefficients + row * rowSize, m_taps, out + produced * Channels);
+        ++produced;
+
+        fraction += m_step;
+        start += fraction / m_phases;
+        fraction %= m_phases;
+    }
+    m_start = start;
+    m_fraction = fraction;
+    return produced;
+}
+
+void Resampler::convolve(const float *history, const float *coefficients, int taps, float *out)
+{
+    const int samples = taps * Channels;
+    int i = 0;
+
+#ifdef RESAMPLER_SSE2
+    ///Две суммы для независимых цепочек сложений; в дорожках — L, R чётного и нечётного кадра
+    __m128 a = _mm_setzero_ps();
+    __m128 b = _mm_setzero_ps();
+    for (; i + 8 <= samples; i += 8) {
+        a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(history + i), _mm_loadu_ps(coefficients + i)));
+        b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(history + i + 4), _mm_loadu_ps(coefficients + i + 4)));
+    }
+    for (; i + 4 <= samples; i += 4)
+        a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(history + i), _mm_loadu_ps(coefficients + i)));
+    a = _mm_add_ps(a, b);
+    a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    float left = _mm_cvtss_f32(a);
+    float right = _mm_cvtss_f32(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)));
+#else
+    float left = 0.0f;
+    float right = 0.0f;
+#endif
+
+    for (; i < samples; i += Channels) {
+        left += history[i] * coefficients[i];
+        right += history[i + 1] * coefficients[i + 1];
+    }
+    out[0] = left;
+    out[1] = right;
+}
@@ -0,0 +1,63 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+
+///Многофазный ресемплер float-стерео: фильтр sinc с окном Кайзера,
+///разложенный по фазам для отношения частот L/M после сокращения.
+///Если фаз больше MaxPhases (нестандартные частоты), берётся ближайшая
+///из MaxPhases — положение на входе при этом всё равно считается точно,
+///так что выход не уплывает по длительности.
+///При понижении частоты полоса фильтра сужается до новой частоты Найквиста,
+///а число отводов растёт, чтобы переходная полоса осталась той же.
+///Коэффициенты каждой фазы записаны парами (одно значение на оба канала),
+///поэтому внутренний цикл — скалярное произведение по два стереокадра за шаг SSE.
+///Буферы выделяются в configure(), process() памяти не выделяет
+class Resampler
+{
+public:
+    static const int Channels = 2;
+    static const int MaxPhases = 512;
+    ///Отводов на фазу при повышении частоты и предел при понижении
+    static const int Taps = 32;
+    static const int MaxTaps = 96;
+
+private:
+    int m_inputRate = 0;
+    int m_outputRate = 0;
+    int m_phases = 1;           // L: шаг по входу — m_step / m_phases кадра
+    int m_step = 1;             // M
+    int m_tablePhases = 1;
+    int m_taps = Taps;
+    int m_maxInputFrames = 0;
+
+    QVector<float> m_coefficients;  // m_tablePhases строк по m_taps * Channels
+    QVector<float> m_history;
+    int m_historyFrames = 0;
+    int m_start = 0;            // первый кадр истории под фильтром следующего отсчёта
+    int m_fraction = 0;         // дробная часть положения, в долях 1/L
+
+    int run(float *out);
+
+public:
+    Resampler();
+
+    void configure(int inputRate, int outputRate, int maxInputFrames = 8192);
+    ///Сбрасывает историю, например после перемотки источника
+    void reset();
+
+    int inputRate() const { return m_inputRate; }
+    int outputRate() const { return m_outputRate; }
+    int taps() const { return m_taps; }
+
+    ///Сколько кадров самое большее даст process() на frames входных
+    int maxOutputFrames(int frames) const;
+
+    ///Возвращает число записанных в out кадров. Вход любой длины
+    int process(const float *in, int frames, float *out);
+
+    ///Один выходной стереокадр: history — первый кадр под фильтром
+    static void convolve(const float *history, const float *coefficients, int taps, float *out);
+};
+
+#endif // RESAMPLER_H
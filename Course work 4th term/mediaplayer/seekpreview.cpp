@@ -0,0 +1,94 @@
+#include "seekpreview.h"
+
+#include <QEvent>
+#include <QLabel>
+#include <QMouseEvent>
+#include <QSlider>
+#include <QStyle>
+
+SeekPreview::SeekPreview(QSlider *slider, qint64 unit, QObject *parent)
+    : QObject(parent),
+      m_slider(slider),
+      m_unit(unit)
+{
+    m_slider->setMouseTracking(true);
+    m_slider->installEventFilter(this);
+
+    m_popup = new QLabel(m_slider, Qt::ToolTip);
+    m_popup->setObjectName("seekPreview");
+
+    ///Построение атласа не должно конкурировать с воспроизведением.
+    ///Поток запускается с первым источником, а не при создании окна
+    m_builder = new ThumbnailStripBuilder;
+    m_builder->moveToThread(&m_builderThread);
+    connect(&m_builderThread, &QThread::finished, m_builder, &QObject::deleteLater);
+    connect(m_builder, &ThumbnailStripBuilder::stripReady, this, &SeekPreview::stripReady);
+}
+
+SeekPreview::~SeekPreview()
+{
+    if (!m_builderThread.isRunning()) {
+        delete m_builder;
+        return;
+    }
+    m_builderThread.quit();
+    m_builderThread.wait(10000);
+}
+
+void SeekPreview::setSource(const QUrl &source)
+{
+    if (m_source == source)
+        return;
+
+    m_source = source;
+    m_strip.close();
+    m_popup->hide();
+
+    if (m_source.isEmpty())
+        return;
+
+    if (!m_builderThread.isRunning())
+        m_builderThread.start(QThread::LowestPriority);
+    QMetaObject::invokeMethod(m_builder, "build", Qt::QueuedConnection, Q_ARG(QUrl, m_source));
+}
+
+void SeekPreview::stripReady(const QUrl &source, const QString &fileName)
+{
+    if (source == m_source)
+        m_strip.open(fileName);
+}
+
+bool SeekPreview::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_slider) {
+        switch (event->type()) {
+        case QEvent::MouseMove:
+            showPreview(static_cast<QMouseEvent *>(event)->pos().x());
+            break;
+        case QEvent::Leave:
+        case QEvent::Hide:
+            m_popup->hide();
+            break;
+        default:
+            break;
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void SeekPreview::showPreview(int x)
+{
+    if (!m_strip.isValid() || m_slider->maximum() <= m_slider->minimum()) {
+        m_popup->hide();
+        return;
+    }
+
+    int value = QStyle::sliderValueFromPosition(m_slider->minimum(), m_slider->maximum(),
+                                                x, m_slider->width());
+    QImage tile = m_strip.tile(value * m_unit);
+
+    m_popup->setPixmap(QPixmap::fromImage(tile));
+    m_popup->adjustSize();
+    m_popup->move(m_slider->mapToGlobal(QPoint(x - m_popup->width() / 2, -m_popup->height() - 4)));
+    m_popup->show();
+}
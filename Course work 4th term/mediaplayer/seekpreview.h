@@ -0,0 +1,45 @@
+#ifndef SEEKPREVIEW_H
+#define SEEKPREVIEW_H
+
+#include <QObject>
+#include <QThread>
+#include <QUrl>
+
+#include "thumbnailstrip.h"
+
+QT_FORWARD_DECLARE_CLASS(QLabel)
+QT_FORWARD_DECLARE_CLASS(QSlider)
+
+///Превью кадра при наведении на ползунок перемотки.
+///Атлас миниатюр строится в фоне, а при наведении плитка берётся из него без декодирования
+class SeekPreview : public QObject
+{
+    Q_OBJECT
+
+private:
+    QSlider *m_slider = nullptr;
+    QLabel *m_popup = nullptr;
+    qint64 m_unit = 1;
+
+    QUrl m_source;
+    ThumbnailStrip m_strip;
+
+    QThread m_builderThread;
+    ThumbnailStripBuilder *m_builder = nullptr;
+
+    void showPreview(int x);
+
+private slots:
+    void stripReady(const QUrl &source, const QString &fileName);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+public:
+    explicit SeekPreview(QSlider *slider, qint64 unit, QObject *parent = nullptr);
+    ~SeekPreview();
+
+    void setSource(const QUrl &source);
+};
+
+#endif // SEEKPREVIEW_H
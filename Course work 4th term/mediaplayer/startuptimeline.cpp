@@ -0,0 +1,100 @@
+#include "startuptimeline.h"
+
+#include <QDebug>
+#include <QEvent>
+#include <QTimer>
+#include <QWidget>
+
+StartupTimeline::Mark StartupTimeline::m_marks[StartupTimeline::MaxMarks];
+int StartupTimeline::m_count = 0;
+QElapsedTimer StartupTimeline::m_timer;
+bool StartupTimeline::m_dumpOnFirstPaint = false;
+
+///Ловит первое событие отрисовки окна и сразу снимает себя
+class FirstPaintWatcher : public QObject
+{
+private:
+    bool m_dump;
+
+public:
+    FirstPaintWatcher(QWidget *window, bool dump)
+        : QObject(window),
+          m_dump(dump)
+    {
+        window->installEventFilter(this);
+    }
+
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            watched->removeEventFilter(this);
+            StartupTimeline::mark("first paint");
+
+            ///Окно попадает на экран после того, как отрисованы все дочерние виджеты,
+            ///поэтому последняя отметка ставится уже из очереди событий
+            bool dump = m_dump;
+            QTimer::singleShot(0, [dump]() {
+                StartupTimeline::mark("first frame flushed");
+                if (dump)
+                    StartupTimeline::dump();
+            });
+            deleteLater();
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+void StartupTimeline::start(int argc, char *argv[])
+{
+    m_timer.start();
+    m_count = 0;
+
+    m_dumpOnFirstPaint = qEnvironmentVariableIsSet("MEDIAPLAYER_STARTUP_TIMELINE");
+    for (int i = 1; i < argc; ++i)
+        if (qstrcmp(argv[i], "--startup-timeline") == 0)
+            m_dumpOnFirstPaint = true;
+
+    mark("main");
+}
+
+///phase должна быть строковым литералом: указатель хранится без копирования
+void StartupTimeline::mark(const char *phase)
+{
+    if (!m_timer.isValid() || m_count >= MaxMarks)
+        return;
+
+    m_marks[m_count].phase = phase;
+    m_marks[m_count].time = m_timer.nsecsElapsed();
+    ++m_count;
+}
+
+void StartupTimeline::watchFirstPaint(QWidget *window)
+{
+    new FirstPaintWatcher(window, m_dumpOnFirstPaint);
+}
+
+qint64 StartupTimeline::elapsed()
+{
+    return m_timer.isValid() ? m_timer.nsecsElapsed() : 0;
+}
+
+///Строка на этап: время от начала main() и длительность этапа, в миллисекундах
+QString StartupTimeline::report()
+{
+    QString text;
+    qint64 previous = 0;
+    for (int i = 0; i < m_count; ++i) {
+        const Mark &m = m_marks[i];
+        text += QString("%1 ms  +%2 ms  %3\n")
+                .arg(m.time / 1e6, 9, 'f', 3)
+                .arg((m.time - previous) / 1e6, 8, 'f', 3)
+                .arg(QLatin1String(m.phase));
+        previous = m.time;
+    }
+    return text;
+}
+
+void StartupTimeline::dump()
+{
+    qDebug().noquote() << "Startup timeline:\n" + report();
+}
@@ -0,0 +1,38 @@
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+class QWidget;
+
+///Хронология запуска: отметки этапов от начала main() до первой отрисовки окна.
+///Отметки пишутся в заранее выделенный массив, поэтому сама запись почти ничего не стоит.
+///Вывод по запросу: Ctrl+Shift+T в главном окне, либо автоматически после первой
+///отрисовки при запуске с ключом --startup-timeline или переменной MEDIAPLAYER_STARTUP_TIMELINE
+class StartupTimeline
+{
+private:
+    struct Mark
+    {
+        const char *phase;
+        qint64 time;
+    };
+
+    static const int MaxMarks = 64;
+    static Mark m_marks[MaxMarks];
+    static int m_count;
+    static QElapsedTimer m_timer;
+    static bool m_dumpOnFirstPaint;
+
+public:
+    static void start(int argc, char *argv[]);
+    static void mark(const char *phase);
+    static void watchFirstPaint(QWidget *window);
+
+    static qint64 elapsed();
+    static QString report();
+    static void dump();
+};
+
+#endif // STARTUPTIMELINE_H
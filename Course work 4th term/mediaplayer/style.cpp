@@ -1,5 +1,9 @@
 #include "style.h"
 
+#include <QStyle>
+#include <QVariant>
+#include <QWidget>
+
 QString Style::getWindowStyleSheet()
 {
     return "QWidget { "
@@ -280,6 +284,8 @@ QString Style::getTableViewStyleSheet()
     return "QTableView { "
            "background-color: #454545; "
            "color: #adadad; "
+           "selection-background-color: #3575ff; "
+           "selection-color: #adadad; "
            "border: 4px  #454545;"
            "}"
            "QTableView::item:selected {"
@@ -675,3 +681,104 @@ QString Style:: getComboBoxStyleSheet()
     "}";
 
 }
+
+///Переписывает селекторы таблицы стилей под конкретные виджеты.
+///В шаблоне %1 заменяется типом из селектора, псевдосостояния и подэлементы
+///дописываются в конец: "%1#btn_close" даёт "QToolButton#btn_close:hover",
+///"#playlistView %1" даёт "#playlistView QScrollBar::handle:vertical"
+QString Style::scoped(const QString &sheet, const QStringList &patterns)
+{
+    QString result;
+    int pos = 0;
+    while (pos < sheet.size()) {
+        int open = sheet.indexOf(QLatin1Char('{'), pos);
+        int close = sheet.indexOf(QLatin1Char('}'), open);
+        if (open < 0 || close < 0)
+            break;
+
+        QStringList selectors;
+        const QStringList original = sheet.mid(pos, open - pos).split(QLatin1Char(','));
+        for (const QString &part : original) {
+            const QString selector = part.trimmed();
+            int split = 0;
+            while (split < selector.size() && selector.at(split).isLetterOrNumber())
+                ++split;
+            const QString type = selector.left(split);
+            const QString rest = selector.mid(split);
+            for (const QString &pattern : patterns)
+                selectors << QString(pattern).replace(QLatin1String("%1"), type) + rest;
+        }
+
+        result += selectors.join(QLatin1String(", "));
+        result += sheet.midRef(open, close - open + 1);
+        result += QLatin1Char('\n');
+        pos = close + 1;
+    }
+    return result;
+}
+
+///Единая таблица стилей приложения. Собирается один раз при первом обращении
+///и устанавливается через QApplication::setStyleSheet, поэтому разбор CSS
+///не повторяется для каждого виджета. Виджеты выбираются по objectName
+QString Style::applicationStyleSheet()
+{
+    static const QString sheet = [] {
+        const QString maximized = QStringLiteral("[maximized=\"true\"]");
+        const QString random = QStringLiteral("[random=\"true\"]");
+        const QString playing = QStringLiteral("[playing=\"true\"]");
+
+        QString s;
+        s += scoped(getWindowStyleSheet(), { "Widget", "Widget %1", "Player", "Player %1" });
+
+        s += scoped(getCloseStyleSheet(), { "%1#btn_close" });
+        s += scoped(getMaximizeStyleSheet(), { "%1#btn_maximize" });
+        s += scoped(getRestoreStyleSheet(), { "%1#btn_maximize" + maximized });
+        s += scoped(getMinimizeStyleSheet(), { "%1#btn_minimize" });
+
+        s += scoped(getNextStyleSheet(), { "%1#btn_next" });
+        s += scoped(getPreviousStyleSheet(), { "%1#btn_previous" });
+        s += scoped(getStopStyleSheet(), { "%1#btn_stop" });
+        s += scoped(getPlayStyleSheet(), { "%1#btn_play" });
+        s += scoped(getPauseStyleSheet(), { "%1#btn_pause", "%1#btn_play" + playing });
+        s += scoped(getRandomStyleSheet(), { "%1#btn_random" });
+        s += scoped(getSequentialStyleSheet(), { "%1#btn_random" + random });
+
+        s += scoped(getAddStyleSheet(), { "%1#btn_add" });
+        s += scoped(getRemoveStyleSheet(), { "%1#btn_del" });
+        s += scoped(getBtnToolStyleSheet(), { "%1#btn_music", "%1#btn_video", "%1#btn_mix" });
+        s += scoped(getFullStyleSheet(), { "%1#btn_fullScreen" });
+        s += scoped(getSettingsStyleSheet(), { "%1#btn_color" });
+
+        s += scoped(getTableViewStyleSheet(), { "%1#playlistView", "#playlistView %1" });
+        s += scoped(getVerticalScrollBarStyleSheet(), { "#playlistView %1" });
+        s += scoped(getHorizontalScrollBarStyleSheet(), { "#playlistView %1" });
+
+        s += scoped(getSliderStyleSheet(), { "%1#positionSlider" });
+        s += scoped(getSliderStyleSheet2(), { "%1#volumeSlider", "#colorDialog %1" });
+        s += scoped(getBtnPushToolStyleSheet(), { "#colorDialog %1" });
+        s += scoped(getComboBoxStyleSheet(), { "%1#rateBox" });
+
+        s += QLatin1String("QToolButton#btn_volume { padding: 0px; }\n"
+                           "QToolButton#btn_volume::menu-indicator { image: none; }\n"
+                           "QLabel#currentTrack { color: #c1c1c1; }\n"
+                           "QLabel#label { color: rgb(143, 143, 143); font: 8pt \"Century Gothic\"; }\n"
+                           "QLabel#positionLabel { font: 8pt \"Century Gothic\"; }\n"
+                           "QLabel#seekPreview { border: 1px solid #3575ff; background-color: #292929; }\n"
+                           "QToolButton#btn_mix:checked { background-color: #3575ff; }\n");
+        return s;
+    }();
+    return sheet;
+}
+
+///Переключение состояния кнопки через динамическое свойство:
+///селектор вида [maximized="true"] уже есть в общей таблице,
+///виджет только заново применяет к себе готовые правила
+void Style::setState(QWidget *widget, const char *name, bool value)
+{
+    if (widget->property(name).toBool() == value)
+        return;
+
+    widget->setProperty(name, value);
+    widget->style()->unpolish(widget);
+    widget->style()->polish(widget);
+}
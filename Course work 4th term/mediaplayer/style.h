@@ -2,10 +2,19 @@
 #define STYLE_H
 
 #include <QString>
+#include <QStringList>
+
+class QWidget;
 
 class Style
 {
+private:
+    static QString scoped(const QString &sheet, const QStringList &patterns);
+
 public:
+    static QString applicationStyleSheet();
+    static void setState(QWidget *widget, const char *name, bool value);
+
     static QString getWindowStyleSheet();
     static QString getLabelStyleSheet();
     static QString getCloseStyleSheet();
@@ -0,0 +1,431 @@
+#include "tagreader.h"
+
+#include <QFile>
+#include <cstring>
+
+static inline quint32 readBe32(const uchar *p)
+{
+    return quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | quint32(p[3]);
+}
+
+static inline quint32 readBe24(const uchar *p)
+{
+    return quint32(p[0]) << 16 | quint32(p[1]) << 8 | quint32(p[2]);
+}
+
+static inline quint32 readLe32(const uchar *p)
+{
+    return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+}
+
+static inline quint32 readSyncsafe(const uchar *p)
+{
+    return quint32(p[0] & 0x7F) << 21 | quint32(p[1] & 0x7F) << 14 | quint32(p[2] & 0x7F) << 7 | quint32(p[3] & 0x7F);
+}
+
+static inline bool hasTag(const uchar *p, const char *tag)
+{
+    return std::memcmp(p, tag, 4) == 0;
+}
+
+///Убирает вставленные при рассинхронизации нули: FF 00 -> FF
+static int removeUnsync(const uchar *data, int size, uchar *out)
+{
+    int written = 0;
+    for (int i = 0; i < size; ++i) {
+        out[written++] = data[i];
+        if (data[i] == 0xFF && i + 1 < size && data[i + 1] == 0x00)
+            ++i;
+    }
+    return written;
+}
+
+static QString decodeUtf16(const uchar *data, int size, bool bigEndian)
+{
+    int length = 0;
+    while (length + 1 < size && (data[length] || data[length + 1]))
+        length += 2;
+
+    QString text(length / 2, Qt::Uninitialized);
+    QChar *out = text.data();
+    for (int i = 0; i < length; i += 2)
+        *out++ = QChar(bigEndian ? ushort(data[i] << 8 | data[i + 1]) : ushort(data[i] | data[i + 1] << 8));
+    return text;
+}
+
+///Текст до первого нуля. В RIFF INFO кодировка не указана: UTF-8, если он корректен, иначе Latin-1
+static QString decodeNarrow(const uchar *data, int size, bool utf8)
+{
+    const int length = int(qstrnlen(reinterpret_cast<const char *>(data), uint(size)));
+    const char *text = reinterpret_cast<const char *>(data);
+    if (!utf8)
+        return QString::fromLatin1(text, length);
+
+    const QString decoded = QString::fromUtf8(text, length);
+    return decoded.contains(QChar(QChar::ReplacementCharacter)) ? QString::fromLatin1(text, length) : decoded;
+}
+
+///Текстовый кадр ID3v2: байт кодировки и строка; из нескольких значений v2.4 берётся первое
+static QString decodeId3Text(const uchar *data, int size)
+{
+    if (size < 1)
+        return QString();
+
+    const uchar encoding = data[0];
+    ++data;
+    --size;
+    switch (encoding) {
+    case 0:
+        return decodeNarrow(data, size, false).trimmed();
+    case 1:
+        if (size >= 2 && data[0] == 0xFE && data[1] == 0xFF)
+            return decodeUtf16(data + 2, size - 2, true).trimmed();
+        if (size >= 2 && data[0] == 0xFF && data[1] == 0xFE)
+            return decodeUtf16(data + 2, size - 2, false).trimmed();
+        return decodeUtf16(data, size, false).trimmed();
+    case 2:
+        return decodeUtf16(data, size, true).trimmed();
+    case 3:
+        return decodeNarrow(data, size, true).trimmed();
+    default:
+        return QString();
+    }
+}
+
+///Первые цифры строки: «2004-05-01» -> 2004, «3/12» -> 3
+static int leadingNumber(const QString &text)
+{
+    int value = 0;
+    for (int i = 0; i < text.size() && i < 9 && text.at(i).isDigit(); ++i)
+        value = value * 10 + text.at(i).digitValue();
+    return value;
+}
+
+///«(17)», «(17)Rock» и «17» — номера из таблицы ID3v1, остальное — название как есть
+static QString decodeGenre(const QString &text)
+{
+    QString number = text;
+    if (text.startsWith(QLatin1Char('('))) {
+        const int close = text.indexOf(QLatin1Char(')'));
+        const QString rest = close > 0 ? text.mid(close + 1).trimmed() : QString();
+        if (!rest.isEmpty())
+            return rest;
+        number = text.mid(1, close - 1);
+    }
+
+    bool ok = false;
+    const QString name = TagReader::genreName(number.toInt(&ok));
+    return ok && !name.isEmpty() ? name : text;
+}
+
+///После кадра идёт имя следующего кадра, заполнитель или конец тега
+static bool isFrameStart(const uchar *body, int size, qint64 position)
+{
+    if (position == size || (position < size && body[position] == 0))
+        return true;
+    if (position + 4 > size)
+        return false;
+    for (int i = 0; i < 4; ++i) {
+        const uchar c = body[position + i];
+        if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+            return false;
+    }
+    return true;
+}
+
+static void setText(QString *field, const QString &value)
+{
+    if (field->isEmpty())
+        *field = value;
+}
+
+static void setNumber(int *field, int value)
+{
+    if (*field == 0)
+        *field = value;
+}
+
+bool TagReader::Tags::isComplete() const
+{
+    return !title.isEmpty() && !artist.isEmpty() && !album.isEmpty() && !genre.isEmpty() && year && track;
+}
+
+///Заголовок кадра: 3 байта имени и 3 байта размера у v2.2, 4 + 4 + 2 байта флагов у v2.3–2.4.
+///У v2.4 размер синхробезопасный, но некоторые программы пишут обычный — тогда
+///берётся тот, при котором следующий кадр начинается с имени
+bool TagReader::parseId3v2(const uchar *data, qint64 size, Tags *tags)
+{
+    if (size < 10 || std::memcmp(data, "ID3", 3) != 0)
+        return false;
+
+    const int version = data[3];
+    const int flags = data[5];
+    if (version < 2 || version > 4 || ((data[6] | data[7] | data[8] | data[9]) & 0x80))
+        return false;
+    if (version == 2 && (flags & 0x40))
+        return false;   // сжатие v2.2 так и не было определено
+
+    const uchar *body = data + 10;
+    int bodySize = int(qMin<qint64>(qint64(readSyncsafe(data + 6)), size - 10));
+
+    ///До v2.4 рассинхронизирован весь тег, у v2.4 флаг тега означает флаг у каждого кадра
+    QByteArray buffer;
+    if ((flags & 0x80) && version < 4) {
+        buffer.resize(bodySize);
+        bodySize = removeUnsync(body, bodySize, reinterpret_cast<uchar *>(buffer.data()));
+        body = reinterpret_cast<const uchar *>(buffer.constData());
+    }
+
+    int offset = 0;
+    if ((flags & 0x40) && version >= 3 && bodySize >= 4) {
+        const quint32 extended = version == 3 ? readBe32(body) + 4 : readSyncsafe(body);
+        offset = int(qMin<quint32>(extended, quint32(bodySize)));
+    }
+
+    const int headerSize = version == 2 ? 6 : 10;
+    QByteArray frameBuffer;
+    while (offset + headerSize <= bodySize && !tags->isComplete()) {
+        const uchar *frame = body + offset;
+        if (frame[0] == 0)
+            break;  // заполнитель
+
+        quint32 frameSize;
+        int frameFlags = 0;
+        if (version == 2) {
+            frameSize = readBe24(frame + 3);
+        } else if (version == 3) {
+            frameSize = readBe32(frame + 4);
+            frameFlags = frame[9];
+        } else {
+            frameSize = readSyncsafe(frame + 4);
+            const quint32 plain = readBe32(frame + 4);
+            const int content = offset + headerSize;
+            if (plain != frameSize && (((frame[4] | frame[5] | frame[6] | frame[7]) & 0x80)
+                    || (!isFrameStart(body, bodySize, content + qint64(frameSize))
+                        && isFrameStart(body, bodySize, content + qint64(plain)))))
+                frameSize = plain;
+            frameFlags = frame[9];
+        }
+
+        const qint64 next = qint64(offset) + headerSize + frameSize;
+        if (next > bodySize)
+            break;  // кадр обрезан краем отображённого куска
+        offset = int(next);
+
+        const char *id = reinterpret_cast<const char *>(frame);
+        const bool textFrame = id[0] == 'T';
+        if (!textFrame || frameSize == 0)
+            continue;
+
+        ///Сжатые и зашифрованные кадры пропускаются
+        if ((version == 3 && (frameFlags & 0xC0)) || (version == 4 && (frameFlags & 0x0C)))
+            continue;
+
+        const uchar *content = frame + headerSize;
+        int contentSize = int(frameSize);
+        if ((version == 3 && (frameFlags & 0x20)) || (version == 4 && (frameFlags & 0x40))) {
+            ++content;      // номер группы
+            --contentSize;
+        }
+        if (version == 4) {
+            if (frameFlags & 0x01) {
+                content += 4;
+                contentSize -= 4;
+            }
+            if ((frameFlags & 0x02) || (flags & 0x80)) {
+                frameBuffer.resize(qMax(0, contentSize));
+                contentSize = removeUnsync(content, qMax(0, contentSize), reinterpret_cast<uchar *>(frameBuffer.data()));
+                content = reinterpret_cast<const uchar *>(frameBuffer.constData());
+            }
+            if (contentSize <= 0)
+                continue;
+        }
+
+        const bool v22 = version == 2;
+        if (v22 ? !std::memcmp(id, "TT2", 3) : !std::memcmp(id, "TIT2", 4))
+            setText(&tags->title, decodeId3Text(content, contentSize));
+        else if (v22 ? !std::memcmp(id, "TP1", 3) : !std::memcmp(id, "TPE1", 4))
+            setText(&tags->artist, decodeId3Text(content, contentSize));
+        else if (v22 ? !std::memcmp(id, "TAL", 3) : !std::memcmp(id, "TALB", 4))
+            setText(&tags->album, decodeId3Text(content, contentSize));
+        else if (v22 ? !std::memcmp(id, "TCO", 3) : !std::memcmp(id, "TCON", 4))
+            setText(&tags->genre, decodeGenre(decodeId3Text(content, contentSize)));
+        else if (v22 ? !std::memcmp(id, "TRK", 3) : !std::memcmp(id, "TRCK", 4))
+            setNumber(&tags->track, leadingNumber(decodeId3Text(content, contentSize)));
+        else if (v22 ? !std::memcmp(id, "TYE", 3) : (!std::memcmp(id, "TYER", 4) || !std::memcmp(id, "TDRC", 4)))
+            setNumber(&tags->year, leadingNumber(decodeId3Text(content, contentSize)));
+    }
+    return true;
+}
+
+///128 байт «TAG»: название, исполнитель, альбом по 30 байт, год, комментарий,
+///у v1.1 — номер трека в последнем байте комментария
+bool TagReader::parseId3v1(const uchar *tag, Tags *tags)
+{
+    if (std::memcmp(tag, "TAG", 3) != 0)
+        return false;
+
+    setText(&tags->title, decodeNarrow(tag + 3, 30, false).trimmed());
+    setText(&tags->artist, decodeNarrow(tag + 33, 30, false).trimmed());
+    setText(&tags->album, decodeNarrow(tag + 63, 30, false).trimmed());
+    setNumber(&tags->year, leadingNumber(decodeNarrow(tag + 93, 4, false)));
+    if (tag[125] == 0 && tag[126] != 0)
+        setNumber(&tags->track, tag[126]);
+    if (tag[127] != 0xFF)
+        setText(&tags->genre, genreName(tag[127]));
+    return true;
+}
+
+///Тело чанка LIST типа INFO: подчанки с текстом до нуля
+bool TagReader::parseRiffInfo(const uchar *data, qint64 size, Tags *tags)
+{
+    if (size < 4 || !hasTag(data, "INFO"))
+        return false;
+
+    for (qint64 offset = 4; offset + 8 <= size;) {
+        const uchar *chunk = data + offset;
+        const quint32 chunkSize = readLe32(chunk + 4);
+        if (offset + 8 + qint64(chunkSize) > size)
+            break;
+
+        const uchar *text = chunk + 8;
+        const int length = int(chunkSize);
+        if (hasTag(chunk, "INAM"))
+            setText(&tags->title, decodeNarrow(text, length, true).trimmed());
+        else if (hasTag(chunk, "IART"))
+            setText(&tags->artist, decodeNarrow(text, length, true).trimmed());
+        else if (hasTag(chunk, "IPRD"))
+            setText(&tags->album, decodeNarrow(text, length, true).trimmed());
+        else if (hasTag(chunk, "IGNR"))
+            setText(&tags->genre, decodeNarrow(text, length, true).trimmed());
+        else if (hasTag(chunk, "ICRD"))
+            setNumber(&tags->year, leadingNumber(decodeNarrow(text, length, true)));
+        else if (hasTag(chunk, "ITRK") || hasTag(chunk, "IPRT"))
+            setNumber(&tags->track, leadingNumber(decodeNarrow(text, length, true)));
+
+        offset += 8 + qint64(chunkSize) + (chunkSize & 1);
+    }
+    return true;
+}
+
+///Чанки WAV обходятся по заголовкам. LIST после data (так пишут многие редакторы)
+///ищется в хвосте: туда переходим, если следующий после data чанк попал в хвост
+static bool parseRiff(const uchar *head, qint64 headSize, const uchar *tail, qint64 tailSize,
+                      qint64 fileSize, TagReader::Tags *tags)
+{
+    if (headSize < 12 || !hasTag(head, "RIFF") || !hasTag(head + 8, "WAVE"))
+        return false;
+
+    bool found = false;
+    const qint64 tailStart = fileSize - tailSize;
+    qint64 offset = 12;
+    for (int guard = 0; guard < 1024 && offset + 8 <= fileSize; ++guard) {
+        const uchar *chunk;
+        qint64 available;
+        if (offset + 8 <= headSize) {
+            chunk = head + offset;
+            available = headSize - offset;
+        } else if (tail && offset >= tailStart) {
+            chunk = tail + (offset - tailStart);
+            available = fileSize - offset;
+        } else {
+            break;
+        }
+
+        const quint32 size = readLe32(chunk + 4);
+        if (hasTag(chunk, "LIST") && 8 + qint64(size) <= available)
+            found |= TagReader::parseRiffInfo(chunk + 8, size, tags);
+
+        offset += 8 + qint64(size) + (size & 1);
+    }
+    return found;
+}
+
+bool TagReader::parse(const uchar *head, qint64 headSize, const uchar *tail, qint64 tailSize,
+                      qint64 fileSize, Tags *tags)
+{
+    *tags = Tags();
+    bool found = parseId3v2(head, headSize, tags);
+    found |= parseRiff(head, headSize, tail, tailSize, fileSize, tags);
+    if (tail && tailSize >= 128 && fileSize >= 128)
+        found |= parseId3v1(tail + tailSize - 128, tags);
+    return found && !tags->isEmpty();
+}
+
+bool TagReader::read(const QString &fileName, Tags *tags)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = file.size();
+    if (fileSize <= 0)
+        return false;
+
+    ///Файл целиком помещается в начало и хвост — отображается одним куском
+    if (fileSize <= HeadSize + TailSize) {
+        const uchar *data = file.map(0, fileSize);
+        if (!data)
+            return false;
+        const bool found = parse(data, fileSize, data + qMax<qint64>(0, fileSize - TailSize),
+                                 qMin<qint64>(fileSize, TailSize), fileSize, tags);
+        file.unmap(const_cast<uchar *>(data));
+        return found;
+    }
+
+    qint64 headSize = HeadSize;
+    uchar *head = file.map(0, headSize);
+    if (!head)
+        return false;
+
+    ///Тег ID3v2 длиннее начала (обложка впереди текстовых кадров) — отображается весь,
+    ///читаться с диска будут только страницы с заголовками кадров
+    if (!std::memcmp(head, "ID3", 3) && !((head[6] | head[7] | head[8] | head[9]) & 0x80)) {
+        const qint64 tagSize = qMin<qint64>(10 + qint64(readSyncsafe(head + 6)), qMin<qint64>(fileSize, MaxTagSize));
+        if (tagSize > headSize) {
+            file.unmap(head);
+            headSize = tagSize;
+            head = file.map(0, headSize);
+            if (!head)
+                return false;
+        }
+    }
+
+    uchar *tail = file.map(fileSize - TailSize, TailSize);
+    const bool found = parse(head, headSize, tail, tail ? TailSize : 0, fileSize, tags);
+    if (tail)
+        file.unmap(tail);
+    file.unmap(head);
+    return found;
+}
+
+QString TagReader::displayTitle(const Tags &tags, const QString &fallback)
+{
+    if (!tags.artist.isEmpty() && !tags.title.isEmpty())
+        return tags.artist + QLatin1String(" - ") + tags.title;
+    if (!tags.title.isEmpty())
+        return tags.title;
+    return fallback;
+}
+
+///Таблица жанров ID3v1 вместе с расширением Winamp
+QString TagReader::genreName(int index)
+{
+    static const char *const genres[] = {
+        "Blues", "Classic Rock", "Country", "Dance", "Disco", "Funk", "Grunge", "Hip-Hop", "Jazz", "Metal",
+        "New Age", "Oldies", "Other", "Pop", "R&B", "Rap", "Reggae", "Rock", "Techno", "Industrial",
+        "Alternative", "Ska", "Death Metal", "Pranks", "Soundtrack", "Euro-Techno", "Ambient", "Trip-Hop", "Vocal", "Jazz+Funk",
+        "Fusion", "Trance", "Classical", "Instrumental", "Acid", "House", "Game", "Sound Clip", "Gospel", "Noise",
+        "Alternative Rock", "Bass", "Soul", "Punk", "Space", "Meditative", "Instrumental Pop", "Instrumental Rock", "Ethnic", "Gothic",
+        "Darkwave", "Techno-Industrial", "Electronic", "Pop-Folk", "Eurodance", "Dream", "Southern Rock", "Comedy", "Cult", "Gangsta",
+        "Top 40", "Christian Rap", "Pop/Funk", "Jungle", "Native American", "Cabaret", "New Wave", "Psychedelic", "Rave", "Showtunes",
+        "Trailer", "Lo-Fi", "Tribal", "Acid Punk", "Acid Jazz", "Polka", "Retro", "Musical", "Rock & Roll", "Hard Rock",
+        "Folk", "Folk-Rock", "National Folk", "Swing", "Fast Fusion", "Bebop", "Latin", "Revival", "Celtic", "Bluegrass",
+        "Avantgarde", "Gothic Rock", "Progressive Rock", "Psychedelic Rock", "Symphonic Rock", "Slow Rock", "Big Band", "Chorus", "Easy Listening", "Acoustic",
+        "Humour", "Speech", "Chanson", "Opera", "Chamber Music", "Sonata", "Symphony", "Booty Bass", "Primus", "Porn Groove",
+        "Satire", "Slow Jam", "Club", "Tango", "Samba", "Folklore", "Ballad", "Power Ballad", "Rhythmic Soul", "Freestyle",
+        "Duet", "Punk Rock", "Drum Solo", "A Cappella", "Euro-House", "Dance Hall"
+    };
+    const int count = int(sizeof(genres) / sizeof(genres[0]));
+    return index >= 0 && index < count ? QString::fromLatin1(genres[index]) : QString();
+}
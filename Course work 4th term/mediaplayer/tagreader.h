@@ -0,0 +1,53 @@
+#ifndef TAGREADER_H
+#define TAGREADER_H
+
+#include <QMetaType>
+#include <QString>
+
+///Чтение тегов без декодеров: ID3v2.2–2.4 (с рассинхронизацией),
+///ID3v1/1.1 и RIFF INFO из чанка LIST у WAV.
+///Отображается в память только начало файла (или весь тег ID3v2, если он длиннее)
+///и его хвост. Страницы подкачиваются при обращении, поэтому большие кадры
+///вроде обложки APIC, которые перешагиваются по заголовку, с диска не читаются.
+///Поля ID3v2 важнее RIFF INFO, а те — ID3v1: младший тег лишь заполняет пустые поля
+class TagReader
+{
+public:
+    struct Tags
+    {
+        QString title;
+        QString artist;
+        QString album;
+        QString genre;
+        int year = 0;
+        int track = 0;
+
+        bool isEmpty() const { return title.isEmpty() && artist.isEmpty() && album.isEmpty(); }
+        bool isComplete() const;
+    };
+
+    ///Сколько байт начала и конца файла отображается
+    static const int HeadSize = 16 * 1024;
+    static const int TailSize = 4 * 1024;
+    ///Дальше этого тег ID3v2 не просматривается
+    static const int MaxTagSize = 16 * 1024 * 1024;
+
+    ///false, если файл не открылся или тегов в нём нет
+    static bool read(const QString &fileName, Tags *tags);
+
+    ///Разбор уже прочитанных начала и конца файла; tail — последние tailSize байт
+    static bool parse(const uchar *head, qint64 headSize, const uchar *tail, qint64 tailSize,
+                      qint64 fileSize, Tags *tags);
+
+    static bool parseId3v2(const uchar *data, qint64 size, Tags *tags);
+    static bool parseId3v1(const uchar *tag, Tags *tags);
+    static bool parseRiffInfo(const uchar *data, qint64 size, Tags *tags);
+
+    ///«Исполнитель - Название», одно из них или fallback, если обоих нет
+    static QString displayTitle(const Tags &tags, const QString &fallback);
+    static QString genreName(int index);
+};
+
+Q_DECLARE_METATYPE(TagReader::Tags)
+
+#endif // TAGREADER_H
@@ -0,0 +1,22 @@
+include(../tests.pri)
+
+TARGET = tst_audiomixer
+
+SOURCES += \
+        tst_audiomixer.cpp \
+    ../../audiomixer.cpp \
+    ../../convolver.cpp \
+    ../../dynamics.cpp \
+    ../../equalizer.cpp \
+    ../../fft.cpp \
+    ../../resampler.cpp \
+    ../../wavfile.cpp
+
+HEADERS += \
+    ../../audiomixer.h \
+    ../../convolver.h \
+    ../../dynamics.h \
+    ../../equalizer.h \
+    ../../fft.h \
+    ../../resampler.h \
+    ../../wavfile.h
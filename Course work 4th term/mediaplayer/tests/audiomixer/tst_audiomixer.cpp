@@ -0,0 +1,147 @@
+#include <QtTest>
+
+#include "audiomixer.h"
+
+class TestAudioMixer : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QVector<float> noise(int frames, quint32 seed, float amplitude);
+    static double snr(const QVector<double> &reference, const float *actual, int samples);
+
+private slots:
+    void sumMatchesReference();
+    void gainRamp();
+    void duckingDepth();
+    void int16Conversion();
+};
+
+///Равномерный шум с амплитудой amplitude; зерно задаёт поток
+QVector<float> TestAudioMixer::noise(int frames, quint32 seed, float amplitude)
+{
+    QVector<float> samples(frames * AudioMixer::Channels);
+    quint32 state = seed;
+    for (int i = 0; i < samples.size(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        samples[i] = amplitude * float(int(state >> 8) - (1 << 23)) / (1 << 23);
+    }
+    return samples;
+}
+
+///Отношение сигнал/шум в дБ: ошибка — разность с эталоном в double
+double TestAudioMixer::snr(const QVector<double> &reference, const float *actual, int samples)
+{
+    double signal = 0;
+    double error = 0;
+    for (int i = 0; i < samples; ++i) {
+        signal += reference.at(i) * reference.at(i);
+        error += (actual[i] - reference.at(i)) * (actual[i] - reference.at(i));
+    }
+    return error > 0 ? 10.0 * std::log10(signal / error) : 1000.0;
+}
+
+///Два потока, которые и вместе, и на переходе усиления первого блока остаются
+///ниже порога лимитера: выход — их сумма, задержанная на окно лимитера.
+///Ошибка только от округления float — SNR не ниже 120 дБ
+void TestAudioMixer::sumMatchesReference()
+{
+    const int block = 480;
+    const int blocks = 100;
+    const int frames = block * blocks;
+    const QVector<float> first = noise(frames, 1, 0.4f);
+    const QVector<float> second = noise(frames, 2, 0.4f);
+
+    AudioMixer mixer;
+    mixer.configure(48000, block, 2, 4 * block);
+    mixer.setGain(0, 0.6f);
+    mixer.setGain(1, 0.9f);
+    QVector<float> output(frames * AudioMixer::Channels);
+    ///Первый блок ведёт усиление от 1 к заданному — его пропускаем
+    for (int b = 0; b < blocks; ++b) {
+        const int offset = b * block * AudioMixer::Channels;
+        QCOMPARE(mixer.write(0, first.constData() + offset, block), block);
+        QCOMPARE(mixer.write(1, second.constData() + offset, block), block);
+        mixer.process(output.data() + offset, block);
+    }
+
+    const int delay = mixer.dynamics()->latencyFrames();
+    const int skip = block + delay;
+    QVector<double> reference((frames - skip) * AudioMixer::Channels);
+    for (int i = 0; i < reference.size(); ++i) {
+        const int source = (block * AudioMixer::Channels) + i;
+        reference[i] = 0.6 * double(first.at(source)) + 0.9 * double(second.at(source));
+    }
+    const double measured = snr(reference, output.constData() + skip * AudioMixer::Channels, reference.size());
+    QVERIFY2(measured >= 120.0, qPrintable(QString("SNR %1 dB").arg(measured)));
+}
+
+///Усиление идёт линейно по кадрам блока и приходит к заданному; ветка SSE
+///набирает шаг сложением, поэтому от формулы отходит на единицы 1e-6
+void TestAudioMixer::gainRamp()
+{
+    for (int frames : { 1, 3, 480, 487 }) {
+        const QVector<float> input = noise(frames, quint32(frames), 1.0f);
+        QVector<float> output(input.size(), 0.25f);
+        AudioMixer::mix(output.data(), input.constData(), 0.2f, 0.9f, frames);
+
+        const double step = (0.9 - 0.2) / frames;
+        double worst = 0;
+        for (int i = 0; i < input.size(); ++i) {
+            const double expected = 0.25 + input.at(i) * (0.2 + step * (i / AudioMixer::Channels + 1));
+            worst = qMax(worst, std::fabs(output.at(i) - expected));
+        }
+        QVERIFY2(worst <= 1e-5, qPrintable(QString("%1 frames: error %2").arg(frames).arg(worst)));
+    }
+}
+
+///Пока ключ громче порога, музыка опускается на глубину приглушения
+///(-12 дБ — 0.251), после тишины ключа возвращается к исходному уровню
+void TestAudioMixer::duckingDepth()
+{
+    const int block = 480;
+    AudioMixer mixer;
+    mixer.configure(48000, block, 2, 4 * block);
+    mixer.dynamics()->setLimiterEnabled(false);
+    mixer.setDucking(0, 1, -40.0f, -12.0f, 20.0f, 500.0f);
+
+    const QVector<float> voice(block * AudioMixer::Channels, 0.3f);
+    const QVector<float> music(block * AudioMixer::Channels, 0.5f);
+    QVector<float> output(block * AudioMixer::Channels);
+
+    for (int b = 0; b < 50; ++b) {
+        mixer.write(0, voice.constData(), block);
+        mixer.write(1, music.constData(), block);
+        mixer.process(output.data(), block);
+    }
+    const float depth = float(std::pow(10.0, -12.0 / 20.0));
+    QVERIFY2(std::fabs(mixer.duckGain() - depth) < 1e-3f, qPrintable(QString::number(mixer.duckGain())));
+    QVERIFY(std::fabs(output.last() - (0.3f + 0.5f * depth)) < 1e-3f);
+
+    for (int b = 0; b < 500; ++b) {
+        mixer.write(1, music.constData(), block);
+        mixer.process(output.data(), block);
+    }
+    QVERIFY2(mixer.duckGain() > 0.999f, qPrintable(QString::number(mixer.duckGain())));
+    QVERIFY(std::fabs(output.last() - 0.5f) < 1e-3f);
+}
+
+///Перевод в Int16 округляет к ближайшему и насыщается за пределами ±1
+void TestAudioMixer::int16Conversion()
+{
+    QVector<float> input = noise(1001, 5, 1.2f);
+    input[0] = 1.0f;
+    input[1] = -1.0f;
+    QVector<qint16> output(input.size());
+    AudioMixer::toInt16(input.constData(), output.data(), input.size());
+
+    for (int i = 0; i < input.size(); ++i) {
+        const int expected = qRound(qBound(-1.0f, input.at(i), 1.0f) * 32767.0f);
+        QVERIFY2(output.at(i) == expected, qPrintable(QString("sample %1: %2, expected %3")
+                                                      .arg(i).arg(output.at(i)).arg(expected)));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestAudioMixer)
+
+#include "tst_audiomixer.moc"
@@ -0,0 +1,16 @@
+include(../tests.pri)
+
+TARGET = tst_convolver
+
+SOURCES += \
+        tst_convolver.cpp \
+    ../../convolver.cpp \
+    ../../fft.cpp \
+    ../../resampler.cpp \
+    ../../wavfile.cpp
+
+HEADERS += \
+    ../../convolver.h \
+    ../../fft.h \
+    ../../resampler.h \
+    ../../wavfile.h
@@ -0,0 +1,180 @@
+#include <QtTest>
+
+#include "convolver.h"
+
+class TestConvolver : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QVector<float> noise(int samples, quint32 seed, float amplitude);
+
+private slots:
+    void fftMatchesDft();
+    void fftRoundTrip();
+    void matchesDirectConvolution();
+    void resampledImpulseKeepsGain();
+    void dryAlignedWithWet();
+};
+
+QVector<float> TestConvolver::noise(int samples, quint32 seed, float amplitude)
+{
+    QVector<float> values(samples);
+    quint32 state = seed;
+    for (int i = 0; i < samples; ++i) {
+        state = state * 1664525u + 1013904223u;
+        values[i] = amplitude * float(int(state >> 8) - (1 << 23)) / (1 << 23);
+    }
+    return values;
+}
+
+///Спектр сравнивается с ДПФ в double. Бины 0 и N/2 лежат в re[0] и im[0]
+void TestConvolver::fftMatchesDft()
+{
+    for (int size : { 16, 32, 64, 1024 }) {
+        Fft fft;
+        fft.configure(size);
+        QCOMPARE(fft.size(), size);
+        const QVector<float> input = noise(size, quint32(size), 1.0f);
+        QVector<float> re(size / 2), im(size / 2);
+        fft.forward(input.constData(), re.data(), im.data());
+
+        double worst = 0;
+        for (int k = 0; k <= size / 2; ++k) {
+            double sumRe = 0, sumIm = 0;
+            for (int n = 0; n < size; ++n) {
+                const double angle = -2 * M_PI * double(k) * n / size;
+                sumRe += input.at(n) * std::cos(angle);
+                sumIm += input.at(n) * std::sin(angle);
+            }
+            const double actualRe = k == 0 ? re.at(0) : k == size / 2 ? im.at(0) : re.at(k);
+            const double actualIm = k == 0 || k == size / 2 ? 0.0 : im.at(k);
+            worst = qMax(worst, std::hypot(actualRe - sumRe, actualIm - sumIm));
+        }
+        QVERIFY2(worst <= 1e-6 * size, qPrintable(QString("N %1: error %2").arg(size).arg(worst)));
+    }
+}
+
+///inverse(forward(x)) = x · N / 2 на всех размерах, которые берёт свёртка
+void TestConvolver::fftRoundTrip()
+{
+    for (int size = 2 * Convolver::MinBlockFrames; size <= 2 * Convolver::MaxBlockFrames; size *= 2) {
+        Fft fft;
+        fft.configure(size);
+        const QVector<float> input = noise(size, quint32(size) + 1, 1.0f);
+        QVector<float> re(size / 2), im(size / 2), output(size);
+        fft.forward(input.constData(), re.data(), im.data());
+        fft.inverse(re.data(), im.data(), output.data());
+
+        float worst = 0;
+        for (int n = 0; n < size; ++n)
+            worst = qMax(worst, std::fabs(output.at(n) * 2.0f / size - input.at(n)));
+        QVERIFY2(worst <= 2e-6f, qPrintable(QString("N %1: error %2").arg(size).arg(worst)));
+    }
+}
+
+///Выход — прямая свёртка со случайной характеристикой в 3000 отсчётов,
+///задержанная на blockFrames, с точностью 2e-6. Вход идёт порциями другой
+///длины, чем блок, чтобы граница блока попадала внутрь вызова
+void TestConvolver::matchesDirectConvolution()
+{
+    const int taps = 3000;
+    const int frames = 16000;
+    const int channels = Convolver::Channels;
+    const QVector<float> impulse = noise(taps * channels, 1, 0.01f);
+    const QVector<float> input = noise(frames * channels, 2, 1.0f);
+
+    for (int block : { 64, 512, 4096 }) {
+        Convolver convolver;
+        convolver.configure(48000);
+        convolver.setBlockFrames(block);
+        convolver.setImpulseResponse(impulse.constData(), taps, channels, 48000);
+        QCOMPARE(convolver.taps(), taps);
+        QCOMPARE(convolver.latencyFrames(), block);
+
+        QVector<float> output = input;
+        for (int from = 0; from < frames; from += 479)
+            convolver.process(output.data() + from * channels, qMin(479, frames - from));
+
+        double worst = 0;
+        double peak = 0;
+        for (int n = block + taps; n < frames; ++n) {
+            for (int c = 0; c < channels; ++c) {
+                double expected = 0;
+                for (int k = 0; k < taps; ++k)
+                    expected += double(impulse.at(k * channels + c)) * input.at((n - block - k) * channels + c);
+                worst = qMax(worst, std::fabs(output.at(n * channels + c) - expected));
+                peak = qMax(peak, std::fabs(expected));
+            }
+        }
+        QVERIFY(peak > 0.5);
+        QVERIFY2(worst <= 2e-6, qPrintable(QString("block %1: error %2").arg(block).arg(worst)));
+    }
+}
+
+///Дельта на 44.1 кГц после приведения к 48 кГц и нормировки пропускает
+///постоянный сигнал без потерь: левая половина фильтра ресемплера не обрезана
+void TestConvolver::resampledImpulseKeepsGain()
+{
+    for (int at : { 0, 100 }) {
+        QVector<float> impulse(2000 * Convolver::Channels, 0.0f);
+        impulse[at * Convolver::Channels] = impulse[at * Convolver::Channels + 1] = 1.0f;
+        Convolver convolver;
+        convolver.configure(48000);
+        convolver.setImpulseResponse(impulse.constData(), 2000, Convolver::Channels, 44100);
+
+        QVector<float> samples(48000 * Convolver::Channels, 0.5f);
+        convolver.process(samples.data(), 48000);
+        QVERIFY2(std::fabs(samples.last() - 0.5f) < 1e-4f, qPrintable(QString("delta at %1: %2").arg(at).arg(samples.last())));
+    }
+}
+
+///Характеристика другой частоты сдвигает мокрый сигнал на предвзвод ресемплера;
+///сухой задерживается на столько же. Смесь пополам с дельтой даёт тот же синус
+///без гребенчатого провала на высоких частотах, а при нулевой доле выход — вход,
+///задержанный ровно на latencyFrames(). Доля задаётся до configure(), чтобы
+///не было перехода от прежней
+void TestConvolver::dryAlignedWithWet()
+{
+    const int sampleRate = 48000;
+    for (int sourceRate : { 44100, 96000, 32000 }) {
+        QVector<float> impulse(200 * Convolver::Channels, 0.0f);
+        impulse[0] = impulse[1] = 1.0f;
+
+        for (double frequency : { 1000.0, 6000.0, 12000.0 }) {
+            Convolver convolver;
+            convolver.setMix(0.5f);
+            convolver.configure(sampleRate);
+            convolver.setImpulseResponse(impulse.constData(), 200, Convolver::Channels, sourceRate);
+
+            QVector<float> samples(sampleRate * Convolver::Channels);
+            for (int n = 0; n < sampleRate; ++n)
+                samples[n * 2] = samples[n * 2 + 1] = float(std::sin(2 * M_PI * frequency * n / sampleRate));
+            convolver.process(samples.data(), sampleRate);
+
+            double energy = 0;
+            for (int n = sampleRate / 2; n < sampleRate; ++n)
+                energy += double(samples.at(n * 2)) * samples.at(n * 2);
+            const double level = 10.0 * std::log10(2.0 * energy / (sampleRate / 2));
+            QVERIFY2(std::fabs(level) < 0.05, qPrintable(QString("%1 Hz response, %2 Hz: %3 dB")
+                                                         .arg(sourceRate).arg(frequency).arg(level)));
+        }
+
+        Convolver convolver;
+        convolver.setMix(0.0f);
+        convolver.configure(sampleRate);
+        convolver.setImpulseResponse(impulse.constData(), 200, Convolver::Channels, sourceRate);
+        const int frames = 4000;
+        const QVector<float> input = noise(frames * Convolver::Channels, 3, 1.0f);
+        QVector<float> output = input;
+        convolver.process(output.data(), frames);
+        const int latency = convolver.latencyFrames();
+        QVERIFY(latency > convolver.blockFrames());
+        for (int i = latency * Convolver::Channels; i < output.size(); ++i)
+            QVERIFY2(output.at(i) == input.at(i - latency * Convolver::Channels), qPrintable(QString("sample %1").arg(i)));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestConvolver)
+
+#include "tst_convolver.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_dynamics
+
+SOURCES += \
+        tst_dynamics.cpp \
+    ../../dynamics.cpp
+
+HEADERS += \
+    ../../dynamics.h
@@ -0,0 +1,136 @@
+#include <QtTest>
+
+#include "dynamics.h"
+
+class TestDynamics : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QVector<float> bursts(int frames, float quiet, float loud);
+    static void process(Dynamics &dynamics, QVector<float> &samples, int chunk);
+
+private slots:
+    void limiterHoldsCeiling();
+    void quietPassesBitExact();
+    void gainReductionReported();
+    void gainComputerCurve();
+};
+
+///Синус 440 Гц, который каждые 4000 кадров переключается между амплитудами
+///quiet и loud; правый канал тише и в противофазе
+QVector<float> TestDynamics::bursts(int frames, float quiet, float loud)
+{
+    QVector<float> samples(frames * Dynamics::Channels);
+    for (int n = 0; n < frames; ++n) {
+        const float amplitude = (n / 4000) % 2 ? loud : quiet;
+        const float value = amplitude * float(std::sin(2 * M_PI * 440 * n / 48000));
+        samples[n * 2] = value;
+        samples[n * 2 + 1] = -0.7f * value;
+    }
+    return samples;
+}
+
+void TestDynamics::process(Dynamics &dynamics, QVector<float> &samples, int chunk)
+{
+    const int frames = samples.size() / Dynamics::Channels;
+    for (int from = 0; from < frames; from += chunk)
+        dynamics.process(samples.data() + from * Dynamics::Channels, qMin(chunk, frames - from));
+}
+
+///Всплески на 12 дБ выше порога: выход нигде не выходит за ceiling
+///и на всплесках доходит до него — ослабление не больше нужного
+void TestDynamics::limiterHoldsCeiling()
+{
+    for (float ceilingDb : { -1.0f, -6.0f }) {
+        for (int chunk : { 1, 16, 480, 4096 }) {
+            Dynamics dynamics;
+            dynamics.configure(48000);
+            dynamics.setLimiter(ceilingDb, 60.0f);
+            const float ceiling = float(std::pow(10.0, ceilingDb / 20.0));
+
+            QVector<float> samples = bursts(48000, 0.3f * ceiling, 4.0f * ceiling);
+            process(dynamics, samples, chunk);
+
+            float peak = 0;
+            for (float sample : samples)
+                peak = qMax(peak, std::fabs(sample));
+            const QString context = QString("ceiling %1 dB, chunk %2: peak %3").arg(ceilingDb).arg(chunk).arg(peak);
+            QVERIFY2(peak <= ceiling * (1.0f + 1e-6f), qPrintable(context));
+            QVERIFY2(peak >= ceiling * 0.999f, qPrintable(context));
+        }
+    }
+}
+
+///Ниже порога лимитер ничего не меняет: выход — вход, задержанный
+///ровно на latencyFrames(), бит в бит
+void TestDynamics::quietPassesBitExact()
+{
+    Dynamics dynamics;
+    dynamics.configure(44100);
+    const int latency = dynamics.latencyFrames();
+    QCOMPARE(latency, qRound(44100 * Dynamics::LookaheadMs / 1000.0));
+
+    const int frames = 44100;
+    QVector<float> input(frames * Dynamics::Channels);
+    quint32 state = 1;
+    for (int i = 0; i < input.size(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        input[i] = 0.85f * float(int(state >> 8) - (1 << 23)) / (1 << 23);
+    }
+    QVector<float> output = input;
+    process(dynamics, output, 479);
+
+    for (int i = 0; i < latency * Dynamics::Channels; ++i)
+        QCOMPARE(output.at(i), 0.0f);
+    for (int i = latency * Dynamics::Channels; i < output.size(); ++i)
+        QVERIFY2(output.at(i) == input.at(i - latency * Dynamics::Channels), qPrintable(QString("sample %1").arg(i)));
+    QCOMPARE(dynamics.takeGainReduction(), 0.0f);
+}
+
+///Пиковое ослабление за период равно превышению всплеска над порогом
+///и сбрасывается при чтении
+void TestDynamics::gainReductionReported()
+{
+    Dynamics dynamics;
+    dynamics.configure(48000);
+    const float ceiling = float(std::pow(10.0, dynamics.ceiling() / 20.0));
+
+    QVector<float> samples = bursts(16000, 0.1f, 4.0f * ceiling);
+    process(dynamics, samples, 480);
+    const float reduction = dynamics.takeGainReduction();
+    QVERIFY2(std::fabs(reduction - 20.0f * std::log10(4.0f)) < 0.1f, qPrintable(QString("%1 dB").arg(reduction)));
+    QCOMPARE(dynamics.takeGainReduction(), 0.0f);
+}
+
+///Кривая компрессора: до колена ослабления нет, в колене оно растёт квадратично
+///и без изломов на краях, выше — прямая с наклоном 1/ratio
+void TestDynamics::gainComputerCurve()
+{
+    const float threshold = -18.0f;
+    const float ratio = 3.0f;
+    const float knee = 6.0f;
+    const float slope = 1.0f / ratio - 1.0f;
+
+    QCOMPARE(Dynamics::gainComputer(-40.0f, threshold, ratio, knee), 0.0f);
+    QCOMPARE(Dynamics::gainComputer(threshold - knee / 2, threshold, ratio, knee), 0.0f);
+    QVERIFY(std::fabs(Dynamics::gainComputer(threshold, threshold, ratio, knee) - slope * knee / 8) < 1e-5f);
+    QVERIFY(std::fabs(Dynamics::gainComputer(-6.0f, threshold, ratio, knee) - slope * 12.0f) < 1e-5f);
+
+    for (float edge : { threshold - knee / 2, threshold + knee / 2 }) {
+        const float below = Dynamics::gainComputer(edge - 1e-3f, threshold, ratio, knee);
+        const float above = Dynamics::gainComputer(edge + 1e-3f, threshold, ratio, knee);
+        QVERIFY2(std::fabs(above - below) < 1e-2f, qPrintable(QString("edge %1 dB").arg(edge)));
+    }
+
+    float previous = 0.0f;
+    for (float level = -40.0f; level <= 0.0f; level += 0.25f) {
+        const float gain = Dynamics::gainComputer(level, threshold, ratio, knee);
+        QVERIFY(gain <= previous + 1e-6f);
+        previous = gain;
+    }
+}
+
+QTEST_APPLESS_MAIN(TestDynamics)
+
+#include "tst_dynamics.moc"
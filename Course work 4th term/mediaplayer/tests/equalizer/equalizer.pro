@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_equalizer
+
+SOURCES += \
+        tst_equalizer.cpp \
+    ../../equalizer.cpp
+
+HEADERS += \
+    ../../equalizer.h
@@ -0,0 +1,187 @@
+#include <QtTest>
+
+#include "equalizer.h"
+
+class TestEqualizer : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QVector<float> sine(double frequency, int sampleRate, int frames, int channels);
+    static double levelDb(const QVector<float> &samples, int channels, int channel, int from);
+
+private slots:
+    void bandGainAtCentre();
+    void matchesReferenceCascade();
+    void flatLeavesBufferUntouched();
+    void gainSmoothing();
+};
+
+///Синус амплитуды 1 во всех каналах, в нечётных — с обратным знаком
+QVector<float> TestEqualizer::sine(double frequency, int sampleRate, int frames, int channels)
+{
+    QVector<float> samples(frames * channels);
+    for (int n = 0; n < frames; ++n) {
+        const float value = float(std::sin(2 * M_PI * frequency * n / sampleRate));
+        for (int c = 0; c < channels; ++c)
+            samples[n * channels + c] = c % 2 ? -value : value;
+    }
+    return samples;
+}
+
+///Уровень синуса в дБ относительно амплитуды 1 по кадрам с from до конца
+double TestEqualizer::levelDb(const QVector<float> &samples, int channels, int channel, int from)
+{
+    const int frames = samples.size() / channels;
+    double energy = 0;
+    for (int n = from; n < frames; ++n)
+        energy += double(samples.at(n * channels + channel)) * samples.at(n * channels + channel);
+    return 10.0 * std::log10(2.0 * energy / (frames - from));
+}
+
+///Полоса на ±12 дБ даёт на своей центральной частоте ровно ±12 дБ
+///в каждом канале, в том числе в неполном блоке Lanes каналов
+void TestEqualizer::bandGainAtCentre()
+{
+    for (int sampleRate : { 44100, 48000 }) {
+        for (int band = 0; band < Equalizer::Bands; ++band) {
+            for (float gain : { float(Equalizer::MaxGainDb), -float(Equalizer::MaxGainDb) }) {
+                const int channels = 6;
+                Equalizer equalizer;
+                equalizer.configure(sampleRate, channels);
+                equalizer.setGain(band, gain);
+                equalizer.reset();
+
+                const int frames = 2 * sampleRate;
+                QVector<float> samples = sine(Equalizer::defaultFrequency(band), sampleRate, frames, channels);
+                equalizer.process(samples.data(), frames);
+
+                for (int c = 0; c < channels; ++c) {
+                    const double measured = levelDb(samples, channels, c, frames / 2);
+                    QVERIFY2(std::fabs(measured - gain) < 0.05,
+                             qPrintable(QString("%1 Hz, band %2, channel %3: %4 dB, expected %5")
+                                        .arg(sampleRate).arg(band).arg(c).arg(measured).arg(gain)));
+                }
+            }
+        }
+    }
+}
+
+///Каскад с полками и пиками совпадает с тем же каскадом в double
+///на тех же коэффициентах. Расходится только округление float, которое
+///низкая полка поднимает сильнее всего, — SNR не ниже 80 дБ
+void TestEqualizer::matchesReferenceCascade()
+{
+    const int sampleRate = 48000;
+    const int channels = 5;
+    const int frames = 48000;
+    const float gains[Equalizer::Bands] = { 6, 0, -4, 9, 0, -12, 3, 0, 12, -7 };
+
+    Equalizer equalizer;
+    equalizer.configure(sampleRate, channels);
+    equalizer.setBand(0, Equalizer::LowShelf, 80.0f, gains[0], 0.707f);
+    equalizer.setBand(9, Equalizer::HighShelf, 12000.0f, gains[9], 0.707f);
+    for (int band = 1; band < Equalizer::Bands - 1; ++band)
+        equalizer.setGain(band, gains[band]);
+    equalizer.reset();
+
+    QVector<float> samples(frames * channels);
+    quint32 state = 1;
+    for (int i = 0; i < samples.size(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        samples[i] = 0.25f * float(int(state >> 8) - (1 << 23)) / (1 << 23);
+    }
+    QVector<double> reference(samples.size());
+    for (int i = 0; i < samples.size(); ++i)
+        reference[i] = samples.at(i);
+    equalizer.process(samples.data(), frames);
+
+    ///Транспонированная вторая прямая форма, как у эквалайзера
+    for (int band = 0; band < Equalizer::Bands; ++band) {
+        if (gains[band] == 0)
+            continue;
+        float c[5];
+        const Equalizer::FilterType type = band == 0 ? Equalizer::LowShelf
+                                         : band == Equalizer::Bands - 1 ? Equalizer::HighShelf : Equalizer::Peaking;
+        const float frequency = band == 0 ? 80.0f : band == Equalizer::Bands - 1 ? 12000.0f : Equalizer::defaultFrequency(band);
+        const float q = type == Equalizer::Peaking ? 1.41f : 0.707f;
+        Equalizer::coefficients(type, frequency, gains[band], q, sampleRate, c);
+        for (int channel = 0; channel < channels; ++channel) {
+            double s1 = 0, s2 = 0;
+            for (int n = 0; n < frames; ++n) {
+                double &x = reference[n * channels + channel];
+                const double y = c[0] * x + s1;
+                s1 = c[1] * x - c[3] * y + s2;
+                s2 = c[2] * x - c[4] * y;
+                x = y;
+            }
+        }
+    }
+
+    for (int channel = 0; channel < channels; ++channel) {
+        double signal = 0;
+        double error = 0;
+        for (int n = 0; n < frames; ++n) {
+            const double expected = reference.at(n * channels + channel);
+            const double difference = samples.at(n * channels + channel) - expected;
+            signal += expected * expected;
+            error += difference * difference;
+        }
+        const double snr = 10.0 * std::log10(signal / error);
+        QVERIFY2(snr >= 80.0, qPrintable(QString("channel %1: SNR %2 dB").arg(channel).arg(snr)));
+    }
+}
+
+///Ровный эквалайзер и выключенный, пусть и с поднятыми полосами,
+///оставляют буфер как был, бит в бит
+void TestEqualizer::flatLeavesBufferUntouched()
+{
+    const QVector<float> input = sine(1000, 48000, 4800, 2);
+
+    Equalizer flat;
+    QVERIFY(!flat.isActive());
+    QVector<float> samples = input;
+    flat.process(samples.data(), 4800);
+    QVERIFY(samples == input);
+
+    Equalizer disabled;
+    for (int band = 0; band < Equalizer::Bands; ++band)
+        disabled.setGain(band, 6.0f);
+    disabled.setEnabled(false);
+    disabled.reset();
+    QVERIFY(!disabled.isActive());
+    samples = input;
+    disabled.process(samples.data(), 4800);
+    QVERIFY(samples == input);
+}
+
+///Усиление, заданное на ходу, подходит к цели плавно: через десять постоянных
+///сглаживания полоса даёт свои +12 дБ, и по дороге уровень не выскакивает выше
+void TestEqualizer::gainSmoothing()
+{
+    const int sampleRate = 48000;
+    const int frames = sampleRate;
+    QVector<float> samples = sine(1000, sampleRate, frames, 2);
+    for (float &sample : samples)
+        sample *= 0.1f;
+
+    Equalizer equalizer;
+    const int before = 480;
+    equalizer.process(samples.data(), before);
+    equalizer.setGain(5, 12.0f);
+    equalizer.process(samples.data() + before * 2, frames - before);
+
+    float peak = 0;
+    for (float sample : samples)
+        peak = qMax(peak, std::fabs(sample));
+    const float target = 0.1f * float(std::pow(10.0, 12.0 / 20.0));
+    QVERIFY2(peak < target * 1.01f, qPrintable(QString("peak %1, target %2").arg(peak).arg(target)));
+
+    const int settled = before + 10 * Equalizer::SmoothingMs * sampleRate / 1000;
+    const double measured = levelDb(samples, 2, 0, settled) + 20.0;
+    QVERIFY2(std::fabs(measured - 12.0) < 0.05, qPrintable(QString("%1 dB").arg(measured)));
+}
+
+QTEST_APPLESS_MAIN(TestEqualizer)
+
+#include "tst_equalizer.moc"
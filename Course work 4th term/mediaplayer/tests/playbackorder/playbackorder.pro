@@ -0,0 +1,12 @@
+include(../tests.pri)
+
+TARGET = tst_playbackorder
+
+SOURCES += \
+        tst_playbackorder.cpp \
+    ../../playbackorder.cpp \
+    ../../playlistsequence.cpp
+
+HEADERS += \
+    ../../playbackorder.h \
+    ../../playlistsequence.h
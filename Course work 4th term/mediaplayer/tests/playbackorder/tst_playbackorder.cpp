@@ -0,0 +1,264 @@
+#include <QtTest>
+
+#include "playbackorder.h"
+#include "playlistsequence.h"
+
+class TestPlaybackOrder : public QObject
+{
+    Q_OBJECT
+
+private:
+    quint32 m_random = 1;
+
+    int random(int range);
+    static QVector<int> queue(const PlaybackOrder &order);
+    static QString inconsistency(const PlaybackOrder &order);
+
+private slots:
+    void randomSequences();
+    void appendMatchesInsert();
+    void appendOneAtATime();
+};
+
+///Линейный конгруэнтный генератор: последовательности операций воспроизводимы
+int TestPlaybackOrder::random(int range)
+{
+    m_random = m_random * 1664525u + 1013904223u;
+    return range > 0 ? int((quint64(m_random >> 8) * quint64(range)) >> 24) : 0;
+}
+
+QVector<int> TestPlaybackOrder::queue(const PlaybackOrder &order)
+{
+    QVector<int> tracks(order.count());
+    for (int i = 0; i < order.count(); ++i)
+        tracks[i] = order.trackAt(i);
+    return tracks;
+}
+
+///Пустая строка, если очередь — перестановка треков, курсор в её пределах,
+///а позиция каждого трека согласована с очередью: выбранный трек становится текущим
+QString TestPlaybackOrder::inconsistency(const PlaybackOrder &order)
+{
+    const int count = order.count();
+    QVector<bool> seen(count, false);
+    for (int i = 0; i < count; ++i) {
+        const int track = order.trackAt(i);
+        if (track < 0 || track >= count || seen.at(track))
+            return QString("position %1 holds track %2 of %3").arg(i).arg(track).arg(count);
+        seen[track] = true;
+    }
+
+    if (order.position() < -1 || order.position() >= count)
+        return QString("cursor %1 outside %2 tracks").arg(order.position()).arg(count);
+    const int expected = order.position() >= 0 ? order.trackAt(order.position()) : -1;
+    if (order.current() != expected)
+        return QString("current %1, queue has %2").arg(order.current()).arg(expected);
+
+    for (int track = 0; track < count; ++track) {
+        PlaybackOrder probe = order;
+        probe.setCurrent(track);
+        if (probe.current() != track)
+            return QString("setCurrent(%1) gives %2").arg(track).arg(probe.current());
+    }
+    return QString();
+}
+
+///Случайные последовательности вставок (чаще в конец), удалений (чаще с конца),
+///переходов, выбора трека, переноса строк и смены режима. После каждого шага
+///очередь согласована, а изменение совпадает с обещанным в playbackorder.h:
+///сыгранная история и текущий трек не трогаются, удаление сохраняет порядок
+///остальных треков, вставленные встают только после курсора
+void TestPlaybackOrder::randomSequences()
+{
+    for (int trial = 0; trial < 3000; ++trial) {
+        m_random = quint32(trial) + 1;
+        PlaybackOrder order(quint64(trial) + 1);
+        order.reset(random(20));
+        order.setMode(PlaybackOrder::Mode(random(4)));
+        order.setLoop(random(4) != 0);
+
+        for (int step = 0; step < 60; ++step) {
+            const QVector<int> before = queue(order);
+            const int count = order.count();
+            const int cursor = order.position();
+            const int current = order.current();
+            const bool sequential = order.mode() == PlaybackOrder::Sequential;
+            const int operation = random(9);
+            const QString context = QString("trial %1 step %2 operation %3").arg(trial).arg(step).arg(operation);
+
+            if (operation <= 1) {
+                const int index = operation == 0 ? count : random(count + 1);
+                const int added = 1 + random(3);
+                order.insert(index, added);
+                auto renumber = [index, added](int track) { return track >= index ? track + added : track; };
+
+                QCOMPARE(order.count(), count + added);
+                QVERIFY2(order.current() == (current >= 0 ? renumber(current) : -1), qPrintable(context));
+                if (!sequential) {
+                    for (int i = 0; i <= cursor; ++i)
+                        QVERIFY2(order.trackAt(i) == renumber(before.at(i)), qPrintable(context));
+                    const QVector<int> after = queue(order);
+                    for (int track = index; track < index + added; ++track)
+                        QVERIFY2(after.indexOf(track) > cursor, qPrintable(context));
+                }
+            } else if (operation <= 3 && count) {
+                const int removed = 1 + random(3);
+                const int index = operation == 2 ? qMax(0, count - removed) : random(count);
+                const int end = qMin(count, index + removed);
+                order.remove(index, removed);
+
+                QVector<int> expected;
+                int removedUpToCursor = 0;
+                for (int i = 0; i < count; ++i) {
+                    const int track = before.at(i);
+                    if (track >= index && track < end) {
+                        if (i <= cursor)
+                            ++removedUpToCursor;
+                        continue;
+                    }
+                    expected.append(track >= end ? track - (end - index) : track);
+                }
+                QVERIFY2(queue(order) == expected, qPrintable(context));
+                QVERIFY2(order.position() == cursor - removedUpToCursor, qPrintable(context));
+            } else if (operation == 4) {
+                const int track = order.next();
+                if (count && cursor + 1 < count) {
+                    QVERIFY2(order.position() == cursor + 1, qPrintable(context));
+                    QVERIFY2(queue(order) == before, qPrintable(context));
+                }
+                if (track >= 0)
+                    QVERIFY2(track == order.current(), qPrintable(context));
+            } else if (operation == 5) {
+                const int track = order.previous();
+                if (cursor > 0) {
+                    QVERIFY2(order.position() == cursor - 1, qPrintable(context));
+                    QVERIFY2(queue(order) == before, qPrintable(context));
+                }
+                if (track >= 0)
+                    QVERIFY2(track == order.current(), qPrintable(context));
+            } else if (operation == 6 && count) {
+                const int track = random(count);
+                const int was = before.indexOf(track);
+                order.setCurrent(track);
+                QVERIFY2(order.current() == track, qPrintable(context));
+                ///Трек впереди встаёт сразу за курсором, сыгранный переносится
+                ///на место курсора; остальная очередь не меняется
+                if (!sequential) {
+                    const QVector<int> after = queue(order);
+                    if (was > cursor) {
+                        QVERIFY2(order.position() == cursor + 1, qPrintable(context));
+                        QVERIFY2(after.mid(0, cursor + 1) == before.mid(0, cursor + 1), qPrintable(context));
+                    } else {
+                        QVERIFY2(order.position() == cursor, qPrintable(context));
+                        QVERIFY2(after.mid(cursor + 1) == before.mid(cursor + 1), qPrintable(context));
+                    }
+                }
+            } else if (operation == 7 && count) {
+                QVector<int> rows;
+                const int first = random(count);
+                const int length = 1 + random(qMin(3, count - first));
+                for (int row = first; row < first + length; ++row)
+                    rows.append(row);
+                const int destination = random(count + 1);
+                order.move(rows, destination);
+
+                QVERIFY2(order.current() == (current >= 0 ? PlaylistSequence::rowAfterMove(rows, destination, current) : -1),
+                         qPrintable(context));
+                if (!sequential) {
+                    for (int i = 0; i < count; ++i)
+                        QVERIFY2(order.trackAt(i) == PlaylistSequence::rowAfterMove(rows, destination, before.at(i)),
+                                 qPrintable(context));
+                }
+            } else if (operation == 8) {
+                order.setMode(PlaybackOrder::Mode(random(4)));
+                QVERIFY2(order.current() == current, qPrintable(context));
+            }
+
+            const QString problem = inconsistency(order);
+            QVERIFY2(problem.isEmpty(), qPrintable(context + ": " + problem));
+        }
+    }
+}
+
+///Вставка в середину и дописывание в конец идут разными ветками, но расходуют
+///случайные числа одинаково: при одном зерне очереди совпадают с точностью
+///до номеров треков. Дописывание по одному треку даёт ту же очередь, что и пачкой
+void TestPlaybackOrder::appendMatchesInsert()
+{
+    for (int trial = 0; trial < 3000; ++trial) {
+        m_random = quint32(trial) + 7;
+        const quint64 seed = quint64(trial) + 1;
+        const int size = 1 + random(20);
+        const PlaybackOrder::Mode mode = PlaybackOrder::Mode(1 + random(3));
+        const int steps = random(size + 1);
+        const int index = random(size + 1);
+        const int added = 1 + random(4);
+
+        PlaybackOrder appended(seed);
+        appended.reset(size);
+        appended.setMode(mode);
+        for (int i = 0; i < steps; ++i)
+            appended.next();
+        PlaybackOrder inserted = appended;
+        PlaybackOrder oneByOne = appended;
+
+        appended.insert(size, added);
+        inserted.insert(index, added);
+        for (int i = 0; i < added; ++i)
+            oneByOne.insert(oneByOne.count(), 1);
+
+        const QString context = QString("trial %1 mode %2 insert %3 at %4").arg(trial).arg(int(mode)).arg(added).arg(index);
+        QVERIFY2(queue(oneByOne) == queue(appended), qPrintable(context));
+        QVERIFY2(oneByOne.position() == appended.position(), qPrintable(context));
+
+        QCOMPARE(inserted.count(), appended.count());
+        QCOMPARE(inserted.position(), appended.position());
+        for (int i = 0; i < appended.count(); ++i) {
+            const int track = appended.trackAt(i);
+            const int relabelled = track >= size ? index + track - size
+                                                 : track >= index ? track + added : track;
+            QVERIFY2(inserted.trackAt(i) == relabelled, qPrintable(context));
+        }
+
+        QVERIFY2(inconsistency(appended).isEmpty(), qPrintable(context));
+        QVERIFY2(inconsistency(inserted).isEmpty(), qPrintable(context));
+    }
+}
+
+///Импорт папки дописывает треки по одному. Дописывание стоит O(count), поэтому
+///сто тысяч таких вставок занимают миллисекунды; с пересчётом всех позиций
+///на каждой вставке они шли бы десятки секунд
+void TestPlaybackOrder::appendOneAtATime()
+{
+    const int tracks = 100000;
+    PlaybackOrder order(1);
+    order.setMode(PlaybackOrder::Shuffle);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < tracks; ++i)
+        order.insert(order.count(), 1);
+    const qint64 elapsed = timer.elapsed();
+
+    QCOMPARE(order.count(), tracks);
+    QVector<bool> seen(tracks, false);
+    for (int i = 0; i < tracks; ++i) {
+        const int track = order.trackAt(i);
+        QVERIFY(track >= 0 && track < tracks && !seen.at(track));
+        seen[track] = true;
+    }
+
+    m_random = 3;
+    for (int i = 0; i < 100; ++i) {
+        const int track = random(tracks);
+        PlaybackOrder probe = order;
+        probe.setCurrent(track);
+        QCOMPARE(probe.current(), track);
+    }
+
+    QVERIFY2(elapsed < 2000, qPrintable(QString("%1 ms").arg(elapsed)));
+}
+
+QTEST_APPLESS_MAIN(TestPlaybackOrder)
+
+#include "tst_playbackorder.moc"
@@ -0,0 +1,138 @@
+#include <QtTest>
+
+#include "resampler.h"
+
+class TestResampler : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QVector<float> resample(Resampler &resampler, const QVector<float> &input, int chunk);
+
+private slots:
+    void sineSnr();
+    void chunkingMatchesOneShot();
+    void lengthDoesNotDrift();
+};
+
+///Вход порциями по chunk кадров, выход склеивается. Каждая порция
+///укладывается в maxOutputFrames()
+QVector<float> TestResampler::resample(Resampler &resampler, const QVector<float> &input, int chunk)
+{
+    const int frames = input.size() / Resampler::Channels;
+    QVector<float> output;
+    QVector<float> block(resampler.maxOutputFrames(chunk) * Resampler::Channels);
+    for (int from = 0; from < frames; from += chunk) {
+        const int count = qMin(chunk, frames - from);
+        const int produced = resampler.process(input.constData() + from * Resampler::Channels, count, block.data());
+        if (produced > resampler.maxOutputFrames(count))
+            return QVector<float>();
+        for (int i = 0; i < produced * Resampler::Channels; ++i)
+            output.append(block.at(i));
+    }
+    return output;
+}
+
+///Синус (в правом канале — косинус) после смены частоты сравнивается с тем же
+///синусом, посчитанным сразу на выходной частоте. Выходной кадр k стоит
+///на входе в момент k · in / out — фильтр ресемплера задержки не вносит.
+///Края в четверть секунды не считаются
+void TestResampler::sineSnr()
+{
+    struct Case { int input; int output; double frequency; double minimum; };
+    const Case cases[] = {
+        { 44100, 48000, 1000, 85 },
+        { 44100, 48000, 15000, 80 },
+        { 48000, 44100, 1000, 82 },
+        { 96000, 48000, 5000, 83 },
+        { 22050, 48000, 3000, 90 },
+        ///Больше MaxPhases фаз: берётся ближайшая из таблицы
+        { 44100, 47999, 1000, 72 },
+    };
+
+    for (const Case &test : cases) {
+        const int frames = 2 * test.input;
+        QVector<float> input(frames * Resampler::Channels);
+        for (int i = 0; i < frames; ++i) {
+            const double phase = 2 * M_PI * test.frequency * i / test.input;
+            input[i * Resampler::Channels] = float(0.5 * std::sin(phase));
+            input[i * Resampler::Channels + 1] = float(0.5 * std::cos(phase));
+        }
+
+        Resampler resampler;
+        resampler.configure(test.input, test.output, 4096);
+        const QVector<float> output = resample(resampler, input, 1000);
+        const int produced = output.size() / Resampler::Channels;
+        QVERIFY(produced > test.output);
+
+        double signal = 0;
+        double error = 0;
+        for (int k = test.output / 4; k < produced - test.output / 4; ++k) {
+            const double phase = 2 * M_PI * test.frequency * k / test.output;
+            const double left = 0.5 * std::sin(phase);
+            const double right = 0.5 * std::cos(phase);
+            signal += left * left + right * right;
+            error += (output.at(k * Resampler::Channels) - left) * (output.at(k * Resampler::Channels) - left)
+                   + (output.at(k * Resampler::Channels + 1) - right) * (output.at(k * Resampler::Channels + 1) - right);
+        }
+        const double snr = 10.0 * std::log10(signal / error);
+        QVERIFY2(snr >= test.minimum, qPrintable(QString("%1 -> %2 Hz, %3 Hz: SNR %4 dB")
+                                                 .arg(test.input).arg(test.output).arg(test.frequency).arg(snr)));
+    }
+}
+
+///Деление входа на порции любой длины не меняет выход ни в одном отсчёте
+void TestResampler::chunkingMatchesOneShot()
+{
+    const int frames = 20000;
+    QVector<float> input(frames * Resampler::Channels);
+    quint32 state = 1;
+    for (int i = 0; i < input.size(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        input[i] = float(int(state >> 8) - (1 << 23)) / (1 << 23);
+    }
+
+    for (int output : { 48000, 32000, 47999 }) {
+        Resampler whole;
+        whole.configure(44100, output, frames);
+        const QVector<float> expected = resample(whole, input, frames);
+
+        for (int chunk : { 1, 7, 480, 4096 }) {
+            Resampler split;
+            split.configure(44100, output, 4096);
+            const QVector<float> actual = resample(split, input, chunk);
+            QVERIFY2(!actual.isEmpty() && actual == expected,
+                     qPrintable(QString("44100 -> %1 Hz, chunk %2").arg(output).arg(chunk)));
+        }
+    }
+}
+
+///За десять секунд входа выход не уходит по длительности больше чем на кадр,
+///в том числе когда фаз больше MaxPhases. Последние taps() / 2 кадров входа
+///ещё ждут правой половины фильтра
+void TestResampler::lengthDoesNotDrift()
+{
+    const int rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 96000, 44100 }, { 44100, 47999 }, { 8000, 48000 } };
+    for (const auto &rate : rates) {
+        Resampler resampler;
+        resampler.configure(rate[0], rate[1], 4096);
+        const int chunk = 1237;
+        QVector<float> input(chunk * Resampler::Channels, 0.25f);
+        QVector<float> output(resampler.maxOutputFrames(chunk) * Resampler::Channels);
+
+        const qint64 frames = qint64(rate[0]) * 10 / chunk * chunk;
+        qint64 produced = 0;
+        for (qint64 from = 0; from < frames; from += chunk)
+            produced += resampler.process(input.constData(), chunk, output.data());
+
+        const double expected = double(frames - resampler.taps() / 2) * rate[1] / rate[0];
+        QVERIFY2(std::fabs(produced - expected) <= 1.0,
+                 qPrintable(QString("%1 -> %2 Hz: %3 frames, expected %4")
+                            .arg(rate[0]).arg(rate[1]).arg(produced).arg(expected)));
+        QVERIFY(std::fabs(output.at(0) - 0.25f) < 1e-4f);
+    }
+}
+
+QTEST_APPLESS_MAIN(TestResampler)
+
+#include "tst_resampler.moc"
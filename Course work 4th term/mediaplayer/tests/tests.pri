@@ -0,0 +1,14 @@
+# Общие настройки тестов: консольная программа QtTest без GUI,
+# исходники плеера подключаются из корня проекта
+
+QT       += core testlib
+QT       -= gui
+
+CONFIG   += console testcase c++11
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/..
@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Модульные тесты ядер обработки звука и очереди воспроизведения.
+# Каждый тест — отдельная программа QtTest в своём каталоге;
+# запуск всех: make check, код возврата ненулевой при провале
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    timestretcher \
+    playbackorder \
+    audiomixer \
+    resampler \
+    equalizer \
+    convolver \
+    dynamics
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_timestretcher
+
+SOURCES += \
+        tst_timestretcher.cpp \
+    ../../timestretcher.cpp
+
+HEADERS += \
+    ../../timestretcher.h
@@ -0,0 +1,71 @@
+#include <QtTest>
+
+#include "timestretcher.h"
+
+class TestTimeStretcher : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QVector<float> signal(int frames);
+    static QVector<float> stretch(TimeStretcher &stretcher, const QVector<float> &input, int chunk);
+
+private slots:
+    void resetAfterPendingSkip();
+};
+
+///Шум без периодичности, чтобы смещения отрезков не совпадали случайно
+QVector<float> TestTimeStretcher::signal(int frames)
+{
+    QVector<float> samples(frames * TimeStretcher::Channels);
+    quint32 state = 12345;
+    for (int i = 0; i < samples.size(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        samples[i] = float(int(state >> 8) - (1 << 23)) / (1 << 23);
+    }
+    return samples;
+}
+
+QVector<float> TestTimeStretcher::stretch(TimeStretcher &stretcher, const QVector<float> &input, int chunk)
+{
+    const int frames = input.size() / TimeStretcher::Channels;
+    QVector<float> output;
+    QVector<float> block(stretcher.maxOutputFrames(chunk) * TimeStretcher::Channels);
+    for (int from = 0; from < frames; from += chunk) {
+        const int count = qMin(chunk, frames - from);
+        const int produced = stretcher.process(input.constData() + from * TimeStretcher::Channels, count, block.data());
+        for (int i = 0; i < produced * TimeStretcher::Channels; ++i)
+            output.append(block.at(i));
+    }
+    return output;
+}
+
+///При темпе 2.0 шаг по входу длиннее накопленного после первого отрезка,
+///и часть пропуска откладывается на следующие порции. После reset()
+///отложенный пропуск не должен съедать начало нового входа
+void TestTimeStretcher::resetAfterPendingSkip()
+{
+    const QVector<float> input = signal(48000);
+
+    TimeStretcher fresh;
+    fresh.configure(48000, 4096);
+    fresh.setRate(2.0);
+    const QVector<float> expected = stretch(fresh, input, 1024);
+
+    TimeStretcher reused;
+    reused.configure(48000, 4096);
+    reused.setRate(2.0);
+    ///Ровно на один отрезок: его начало, поиск и переход
+    const int need = reused.latency() + 48000 * TimeStretcher::OverlapMs / 1000;
+    stretch(reused, signal(need), need);
+    reused.reset();
+    const QVector<float> actual = stretch(reused, input, 1024);
+
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(actual.size(), expected.size());
+    QVERIFY(actual == expected);
+}
+
+QTEST_APPLESS_MAIN(TestTimeStretcher)
+
+#include "tst_timestretcher.moc"
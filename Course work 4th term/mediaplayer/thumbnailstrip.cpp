@@ -0,0 +1,310 @@
+#include "thumbnailstrip.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+///Заголовок файла атласа, за ним идут пиксели RGB32 построчно
+struct ThumbnailStripHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 tileWidth;
+    quint32 tileHeight;
+    quint32 columns;
+    quint32 count;
+    qint64 interval;
+};
+
+static const quint32 ThumbnailStripMagic = 0x5354504d; // "MPTS"
+static const quint32 ThumbnailStripVersion = 1;
+
+ThumbnailStrip::ThumbnailStrip()
+{
+}
+
+ThumbnailStrip::~ThumbnailStrip()
+{
+    close();
+}
+
+bool ThumbnailStrip::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    if (m_file.size() < qint64(sizeof(ThumbnailStripHeader))) {
+        close();
+        return false;
+    }
+
+    uchar *data = m_file.map(0, m_file.size());
+    if (!data) {
+        close();
+        return false;
+    }
+
+    ThumbnailStripHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    int rows = header.columns ? int((header.count + header.columns - 1) / header.columns) : 0;
+    qint64 expected = qint64(sizeof(header))
+            + qint64(header.columns) * header.tileWidth * 4 * rows * header.tileHeight;
+
+    if (header.magic != ThumbnailStripMagic || header.version != ThumbnailStripVersion
+            || !header.count || !header.columns || header.interval <= 0
+            || m_file.size() < expected) {
+        close();
+        return false;
+    }
+
+    m_pixels = data + sizeof(header);
+    m_tileWidth = int(header.tileWidth);
+    m_tileHeight = int(header.tileHeight);
+    m_columns = int(header.columns);
+    m_count = int(header.count);
+    m_interval = header.interval;
+    m_bytesPerLine = m_columns * m_tileWidth * 4;
+    return true;
+}
+
+void ThumbnailStrip::close()
+{
+    if (m_file.isOpen())
+        m_file.close();     // Вместе с файлом снимается и отображение в память
+
+    m_pixels = nullptr;
+    m_count = 0;
+}
+
+///Плитка для позиции в миллисекундах. Изображение ссылается на память атласа,
+///поэтому действительно, пока атлас открыт
+QImage ThumbnailStrip::tile(qint64 position) const
+{
+    if (!m_pixels)
+        return QImage();
+
+    int index = int(qBound<qint64>(0, position / m_interval, m_count - 1));
+    int row = index / m_columns;
+    int column = index % m_columns;
+
+    const uchar *origin = m_pixels + qint64(row) * m_tileHeight * m_bytesPerLine
+            + column * m_tileWidth * 4;
+    return QImage(origin, m_tileWidth, m_tileHeight, m_bytesPerLine, QImage::Format_RGB32);
+}
+
+QString ThumbnailStrip::cacheFileName(const QUrl &source)
+{
+    QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheLocation.isEmpty() || !QDir().mkpath(cacheLocation + "/thumbnails"))
+        return QString();
+
+    QByteArray key = source.toString().toUtf8();
+    if (source.isLocalFile()) {
+        QFileInfo info(source.toLocalFile());
+        key += '|' + QByteArray::number(info.size())
+                + '|' + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    }
+
+    return cacheLocation + "/thumbnails/"
+            + QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex() + ".strip";
+}
+
+bool ThumbnailStrip::write(const QString &fileName, const QImage &atlas, const QSize &tileSize,
+                           int columns, int count, qint64 interval)
+{
+    QImage image = atlas.convertToFormat(QImage::Format_RGB32);
+
+    ThumbnailStripHeader header;
+    header.magic = ThumbnailStripMagic;
+    header.version = ThumbnailStripVersion;
+    header.tileWidth = quint32(tileSize.width());
+    header.tileHeight = quint32(tileSize.height());
+    header.columns = quint32(columns);
+    header.count = quint32(count);
+    header.interval = interval;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    int lineBytes = columns * tileSize.width() * 4;
+    for (int y = 0; y < image.height(); ++y)
+        file.write(reinterpret_cast<const char *>(image.constScanLine(y)), lineBytes);
+
+    return file.commit();
+}
+
+FrameGrabber::FrameGrabber(const QSize &tileSize, QObject *parent)
+    : QAbstractVideoSurface(parent),
+      m_tileSize(tileSize)
+{
+}
+
+QList<QVideoFrame::PixelFormat> FrameGrabber::supportedPixelFormats(QAbstractVideoBuffer::HandleType type) const
+{
+    if (type != QAbstractVideoBuffer::NoHandle)
+        return QList<QVideoFrame::PixelFormat>();
+
+    return QList<QVideoFrame::PixelFormat>()
+            << QVideoFrame::Format_RGB32
+            << QVideoFrame::Format_ARGB32
+            << QVideoFrame::Format_ARGB32_Premultiplied
+            << QVideoFrame::Format_RGB565
+            << QVideoFrame::Format_RGB24;
+}
+
+bool FrameGrabber::present(const QVideoFrame &frame)
+{
+    if (!m_wanted)
+        return true;
+
+    QVideoFrame copy(frame);
+    if (!copy.map(QAbstractVideoBuffer::ReadOnly))
+        return true;
+
+    QImage::Format format = QVideoFrame::imageFormatFromPixelFormat(copy.pixelFormat());
+    if (format != QImage::Format_Invalid) {
+        QImage image(copy.bits(), copy.width(), copy.height(), copy.bytesPerLine(), format);
+        m_wanted = false;
+        emit frameGrabbed(image.scaled(m_tileSize, Qt::KeepAspectRatio, Qt::FastTransformation)
+                          .convertToFormat(QImage::Format_RGB32));
+    }
+
+    copy.unmap();
+    return true;
+}
+
+ThumbnailStripBuilder::ThumbnailStripBuilder(QObject *parent)
+    : QObject(parent)
+{
+}
+
+///Постановка видео в очередь. Вызывается через очередь сигналов из потока интерфейса
+void ThumbnailStripBuilder::build(const QUrl &source)
+{
+    if (source.isEmpty() || source == m_source || m_queue.contains(source))
+        return;
+
+    QString fileName = ThumbnailStrip::cacheFileName(source);
+    if (!fileName.isEmpty() && QFileInfo::exists(fileName)) {
+        emit stripReady(source, fileName);
+        return;
+    }
+
+    m_queue.append(source);
+    if (m_source.isEmpty())
+        startNext();
+}
+
+void ThumbnailStripBuilder::startNext()
+{
+    if (!m_player) {
+        ///Плеер создаётся уже в рабочем потоке, звук ему не нужен
+        m_player = new QMediaPlayer(this, QMediaPlayer::VideoSurface);
+        m_player->setMuted(true);
+        m_grabber = new FrameGrabber(m_tileSize, this);
+        m_player->setVideoOutput(m_grabber);
+
+        m_timeout = new QTimer(this);
+        m_timeout->setSingleShot(true);
+        m_timeout->setInterval(2000);
+
+        connect(m_player, &QMediaPlayer::durationChanged, this, &ThumbnailStripBuilder::durationChanged);
+        connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &ThumbnailStripBuilder::mediaStatusChanged);
+        connect(m_grabber, &FrameGrabber::frameGrabbed, this, &ThumbnailStripBuilder::frameGrabbed);
+        connect(m_timeout, &QTimer::timeout, this, &ThumbnailStripBuilder::frameTimeout);
+    }
+
+    m_timeout->stop();
+    m_source = m_queue.isEmpty() ? QUrl() : m_queue.takeFirst();
+    m_index = -1;
+    m_count = 0;
+    m_atlas = QImage();
+
+    if (m_source.isEmpty()) {
+        m_player->setMedia(QMediaContent());
+        return;
+    }
+
+    m_player->setMedia(m_source);
+    m_player->pause();
+}
+
+void ThumbnailStripBuilder::durationChanged(qint64 duration)
+{
+    if (m_index >= 0 || duration <= 0 || m_source.isEmpty())
+        return;
+
+    ///Для длинных видео шаг увеличивается, чтобы атлас оставался ограниченным
+    m_stepInterval = qMax(m_interval, duration / m_maxCount + 1);
+    m_count = int(qMax<qint64>(1, duration / m_stepInterval));
+
+    int rows = (m_count + m_columns - 1) / m_columns;
+    m_atlas = QImage(m_columns * m_tileSize.width(), rows * m_tileSize.height(), QImage::Format_RGB32);
+    m_atlas.fill(QColor("#292929"));
+
+    m_index = 0;
+    seekNext();
+}
+
+void ThumbnailStripBuilder::mediaStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    if (status == QMediaPlayer::InvalidMedia && !m_source.isEmpty())
+        startNext();
+}
+
+///Переход выполняется без точного позиционирования: бэкенд останавливается
+///на ближайшем опорном кадре, и декодируется только он
+void ThumbnailStripBuilder::seekNext()
+{
+    m_grabber->grabNext();
+    m_player->setPosition(m_index * m_stepInterval);
+    m_timeout->start();
+}
+
+void ThumbnailStripBuilder::frameGrabbed(const QImage &tile)
+{
+    if (m_index < 0 || m_index >= m_count)
+        return;
+
+    int x = (m_index % m_columns) * m_tileSize.width();
+    int y = (m_index / m_columns) * m_tileSize.height();
+    QPainter painter(&m_atlas);
+    painter.drawImage(x + (m_tileSize.width() - tile.width()) / 2,
+                      y + (m_tileSize.height() - tile.height()) / 2, tile);
+    painter.end();
+
+    frameTimeout();
+}
+
+void ThumbnailStripBuilder::frameTimeout()
+{
+    m_timeout->stop();
+    if (m_index < 0)
+        return;
+
+    if (++m_index < m_count)
+        seekNext();
+    else
+        finish();
+}
+
+void ThumbnailStripBuilder::finish()
+{
+    QString fileName = ThumbnailStrip::cacheFileName(m_source);
+    if (!fileName.isEmpty()
+            && ThumbnailStrip::write(fileName, m_atlas, m_tileSize, m_columns, m_count, m_stepInterval))
+        emit stripReady(m_source, fileName);
+
+    startNext();
+}
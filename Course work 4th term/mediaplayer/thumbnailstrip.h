@@ -0,0 +1,112 @@
+#ifndef THUMBNAILSTRIP_H
+#define THUMBNAILSTRIP_H
+
+#include <QAbstractVideoSurface>
+#include <QFile>
+#include <QImage>
+#include <QMediaPlayer>
+#include <QUrl>
+
+QT_FORWARD_DECLARE_CLASS(QTimer)
+
+///Атлас миниатюр видео: один файл на диске, отображаемый в память.
+///Кадры лежат сеткой одинаковых плиток, поэтому плитка для любой позиции
+///находится за O(1) и отдаётся без копирования и декодирования
+class ThumbnailStrip
+{
+private:
+    QFile m_file;
+    uchar *m_pixels = nullptr;
+    int m_tileWidth = 0;
+    int m_tileHeight = 0;
+    int m_columns = 0;
+    int m_count = 0;
+    int m_bytesPerLine = 0;
+    qint64 m_interval = 0;
+
+public:
+    ThumbnailStrip();
+    ~ThumbnailStrip();
+
+    bool open(const QString &fileName);
+    void close();
+
+    bool isValid() const { return m_pixels != nullptr; }
+    int count() const { return m_count; }
+    qint64 interval() const { return m_interval; }
+    QSize tileSize() const { return QSize(m_tileWidth, m_tileHeight); }
+
+    QImage tile(qint64 position) const;
+
+    static QString cacheFileName(const QUrl &source);
+    static bool write(const QString &fileName, const QImage &atlas, const QSize &tileSize,
+                      int columns, int count, qint64 interval);
+};
+
+///Поверхность, которая забирает один кадр после каждого перехода и уменьшает его до плитки
+class FrameGrabber : public QAbstractVideoSurface
+{
+    Q_OBJECT
+
+private:
+    QSize m_tileSize;
+    bool m_wanted = false;
+
+public:
+    explicit FrameGrabber(const QSize &tileSize, QObject *parent = nullptr);
+
+    QList<QVideoFrame::PixelFormat> supportedPixelFormats(
+            QAbstractVideoBuffer::HandleType type = QAbstractVideoBuffer::NoHandle) const override;
+    bool present(const QVideoFrame &frame) override;
+
+    void grabNext() { m_wanted = true; }
+
+signals:
+    void frameGrabbed(const QImage &tile);
+};
+
+///Фоновое построение атласа: живёт в потоке с низким приоритетом,
+///переходит по видео с шагом interval и снимает по кадру на каждом шаге
+class ThumbnailStripBuilder : public QObject
+{
+    Q_OBJECT
+
+private:
+    QMediaPlayer *m_player = nullptr;
+    FrameGrabber *m_grabber = nullptr;
+    QTimer *m_timeout = nullptr;
+
+    QList<QUrl> m_queue;
+    QUrl m_source;
+    QImage m_atlas;
+    QSize m_tileSize = QSize(160, 90);
+    int m_columns = 10;
+    int m_maxCount = 600;
+    qint64 m_interval = 10000;
+    qint64 m_stepInterval = 0;
+    int m_count = 0;
+    int m_index = -1;
+
+    void startNext();
+    void seekNext();
+    void finish();
+
+private slots:
+    void durationChanged(qint64 duration);
+    void mediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void frameGrabbed(const QImage &tile);
+    void frameTimeout();
+
+public:
+    explicit ThumbnailStripBuilder(QObject *parent = nullptr);
+
+    void setInterval(qint64 interval) { m_interval = interval; }
+
+public slots:
+    void build(const QUrl &source);
+
+signals:
+    void stripReady(const QUrl &source, const QString &fileName);
+};
+
+#endif // THUMBNAILSTRIP_H
@@ -0,0 +1,34 @@
+#ifndef TIMEFORMAT_H
+#define TIMEFORMAT_H
+
+#include <QString>
+
+///Форматирование времени воспроизведения в строку вида "hh:mm:ss / hh:mm:ss".
+///Текст пишется в собственный буфер без выделения памяти, а если отображаемая
+///секунда не изменилась, то форматирование вовсе пропускается
+class TimeFormat
+{
+private:
+    char m_buffer[64];
+    int m_size = 0;
+    qint64 m_current = -1;
+    qint64 m_total = -1;
+
+    static int writeTime(char *out, qint64 seconds, bool withHours);
+
+public:
+    TimeFormat();
+
+    bool setTime(qint64 currentSeconds);
+    bool setTime(qint64 currentSeconds, qint64 totalSeconds);
+    bool clear();
+
+    ///Одиночное значение без кэша — для ячеек таблиц, где у каждой строки своё время
+    static QString toString(qint64 seconds);
+
+    const char *data() const { return m_buffer; }
+    int size() const { return m_size; }
+    QLatin1String text() const { return QLatin1String(m_buffer, m_size); }
+};
+
+#endif // TIMEFORMAT_H
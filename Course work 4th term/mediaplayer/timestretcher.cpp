@@ -0,0 +1,193 @@
+#include "timestretcher.h"
+
+#include <QtMath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TIMESTRETCHER_SSE2
+#endif
+
+constexpr double TimeStretcher::MinRate;
+constexpr double TimeStretcher::MaxRate;
+
+TimeStretcher::TimeStretcher()
+{
+    configure(48000, 8192);
+}
+
+///Длины кратны четырём, чтобы корреляция шла целыми векторами SSE
+void TimeStretcher::configure(int sampleRate, int maxInputFrames)
+{
+    m_sampleRate = qMax(1, sampleRate);
+    m_maxInputFrames = qMax(1, maxInputFrames);
+    m_sequence = qMax(8, (m_sampleRate * SequenceMs / 1000) & ~3);
+    m_seek = qMax(4, (m_sampleRate * SeekMs / 1000) & ~3);
+    m_overlap = qMax(4, (m_sampleRate * OverlapMs / 1000) & ~3);
+
+    const int capacity = m_seek + m_sequence + m_overlap + m_maxInputFrames;
+    m_input.fill(0.0f, capacity * Channels);
+    m_mono.fill(0.0f, capacity);
+    m_target.fill(0.0f, m_overlap * Channels);
+    m_targetMono.fill(0.0f, m_overlap);
+
+    ///Синусоидальный переход: сумма нарастания и спада — ровно единица
+    m_fade.fill(0.0f, m_overlap);
+    for (int i = 0; i < m_overlap; ++i) {
+        const double s = qSin(M_PI_2 * (i + 0.5) / m_overlap);
+        m_fade[i] = float(s * s);
+    }
+    reset();
+}
+
+///Первый отрезок нарастает из тишины
+void TimeStretcher::reset()
+{
+    m_inputFrames = 0;
+    m_skipFraction = 0;
+    m_pendingSkip = 0;
+    std::memset(m_target.data(), 0, size_t(m_target.size()) * sizeof(float));
+    std::memset(m_targetMono.data(), 0, size_t(m_targetMono.size()) * sizeof(float));
+}
+
+void TimeStretcher::setRate(double rate)
+{
+    m_rate = qBound(MinRate, rate, MaxRate);
+}
+
+int TimeStretcher::maxOutputFrames(int frames) const
+{
+    return int(frames / m_rate) + 2 * m_sequence;
+}
+
+///Отрезок требует Seek + Sequence + Overlap кадров от своего начала.
+///При темпе выше единицы шаг по входу бывает длиннее накопленного,
+///тогда недостающие кадры пропускаются прямо из следующих порций
+int TimeStretcher::process(const float *in, int frames, float *out)
+{
+    const int capacity = m_mono.size();
+    const int need = m_seek + m_sequence + m_overlap;
+    int produced = 0;
+    while (frames > 0) {
+        if (m_pendingSkip > 0) {
+            const int skipped = qMin(frames, m_pendingSkip);
+            m_pendingSkip -= skipped;
+            in += skipped * Channels;
+            frames -= skipped;
+            continue;
+        }
+
+        const int count = qMin(frames, capacity - m_inputFrames);
+        std::memcpy(m_input.data() + m_inputFrames * Channels, in, size_t(count) * Channels * sizeof(float));
+        float *mono = m_mono.data() + m_inputFrames;
+        for (int i = 0; i < count; ++i)
+            mono[i] = in[i * Channels] + in[i * Channels + 1];
+        m_inputFrames += count;
+        in += count * Channels;
+        frames -= count;
+
+        ///Пропущенные кадры сдвигаются один раз за порцию, а не после каждого отрезка
+        int consumed = 0;
+        while (m_pendingSkip == 0 && m_inputFrames - consumed >= need) {
+            produced += step(out + produced * Channels, consumed);
+
+            const double skip = m_sequence * m_rate + m_skipFraction;
+            const int whole = int(skip);
+            m_skipFraction = skip - whole;
+            if (whole <= m_inputFrames - consumed) {
+                consumed += whole;
+            } else {
+                m_pendingSkip = whole - (m_inputFrames - consumed);
+                consumed = m_inputFrames;
+            }
+        }
+
+        m_inputFrames -= consumed;
+        std::memmove(m_input.data(), m_input.constData() + consumed * Channels,
+                     size_t(m_inputFrames) * Channels * sizeof(float));
+        std::memmove(m_mono.data(), m_mono.constData() + consumed, size_t(m_inputFrames) * sizeof(float));
+    }
+    return produced;
+}
+
+///Смещение от base в [0, Seek] с наибольшей корреляцией с продолжением прошлого отрезка.
+///Энергия целевого куска одна на все смещения, поэтому делится только на энергию кандидата
+int TimeStretcher::bestOffset(int base) const
+{
+    const float *target = m_targetMono.constData();
+    const float *mono = m_mono.constData() + base;
+
+    int best = 0;
+    float bestScore = -1e30f;
+    auto score = [&](int offset) {
+        float product, energy;
+        correlate(target, mono + offset, m_overlap, &product, &energy);
+        const float value = product / qSqrt(energy + 1e-9f);
+        if (value > bestScore) {
+            bestScore = value;
+            best = offset;
+        }
+    };
+
+    for (int offset = 0; offset <= m_seek; offset += CoarseStep)
+        score(offset);
+
+    const int coarse = best;
+    const int from = qMax(0, coarse - CoarseStep + 1);
+    const int to = qMin(m_seek, coarse + CoarseStep - 1);
+    for (int offset = from; offset <= to; ++offset) {
+        if (offset != coarse)
+            score(offset);
+    }
+    return best;
+}
+
+///Переход от продолжения прошлого отрезка к новому, затем середина нового как есть
+int TimeStretcher::step(float *out, int base)
+{
+    const int offset = bestOffset(base);
+    const float *source = m_input.constData() + (base + offset) * Channels;
+    const float *target = m_target.constData();
+    const float *fade = m_fade.constData();
+
+    for (int i = 0; i < m_overlap; ++i) {
+        for (int c = 0; c < Channels; ++c) {
+            const int k = i * Channels + c;
+            out[k] = target[k] + (source[k] - target[k]) * fade[i];
+        }
+    }
+    std::memcpy(out + m_overlap * Channels, source + m_overlap * Channels,
+                size_t(m_sequence - m_overlap) * Channels * sizeof(float));
+
+    std::memcpy(m_target.data(), source + m_sequence * Channels, size_t(m_overlap) * Channels * sizeof(float));
+    std::memcpy(m_targetMono.data(), m_mono.constData() + base + offset + m_sequence, size_t(m_overlap) * sizeof(float));
+    return m_sequence;
+}
+
+void TimeStretcher::correlate(const float *a, const float *b, int samples, float *product, float *energy)
+{
+    int i = 0;
+    float p = 0.0f;
+    float e = 0.0f;
+
+#ifdef TIMESTRETCHER_SSE2
+    __m128 sumProduct = _mm_setzero_ps();
+    __m128 sumEnergy = _mm_setzero_ps();
+    for (; i + 4 <= samples; i += 4) {
+        const __m128 x = _mm_loadu_ps(b + i);
+        sumProduct = _mm_add_ps(sumProduct, _mm_mul_ps(_mm_loadu_ps(a + i), x));
+        sumEnergy = _mm_add_ps(sumEnergy, _mm_mul_ps(x, x));
+    }
+    sumProduct = _mm_add_ps(sumProduct, _mm_movehl_ps(sumProduct, sumProduct));
+    sumEnergy = _mm_add_ps(sumEnergy, _mm_movehl_ps(sumEnergy, sumEnergy));
+    p = _mm_cvtss_f32(_mm_add_ss(sumProduct, _mm_shuffle_ps(sumProduct, sumProduct, _MM_SHUFFLE(1, 1, 1, 1))));
+    e = _mm_cvtss_f32(_mm_add_ss(sumEnergy, _mm_shuffle_ps(sumEnergy, sumEnergy, _MM_SHUFFLE(1, 1, 1, 1))));
+#endif
+
+    for (; i < samples; ++i) {
+        p += a[i] * b[i];
+        e += b[i] * b[i];
+    }
+    *product = p;
+    *energy = e;
+}
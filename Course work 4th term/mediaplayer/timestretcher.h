@@ -0,0 +1,73 @@
+#ifndef TIMESTRETCHER_H
+#define TIMESTRETCHER_H
+
+#include <QVector>
+
+///Изменение темпа float-стерео без изменения высоты тона (WSOLA).
+///Выход собирается из отрезков входа длиной Sequence: каждый следующий
+///отрезок берётся примерно через Sequence * rate кадров входа, а точное
+///начало выбирается в окне Seek по максимуму нормированной корреляции
+///с естественным продолжением предыдущего отрезка. Отрезки сшиваются
+///плавным переходом длиной Overlap, поэтому период основного тона на стыке
+///не рвётся и звук не «булькает».
+///Корреляция считается по моно-сумме каналов: сначала грубо через CoarseStep
+///кадров, затем точно вокруг лучшего смещения; оба цикла векторизованы.
+///Буферы выделяются в configure(), process() памяти не выделяет
+class TimeStretcher
+{
+public:
+    static const int Channels = 2;
+    static const int SequenceMs = 40;
+    static const int SeekMs = 15;
+    static const int OverlapMs = 8;
+    static const int CoarseStep = 4;
+
+    static constexpr double MinRate = 0.5;
+    static constexpr double MaxRate = 2.0;
+
+private:
+    int m_sampleRate = 0;
+    double m_rate = 1.0;
+    int m_sequence = 0;
+    int m_seek = 0;
+    int m_overlap = 0;
+    int m_maxInputFrames = 0;
+
+    QVector<float> m_input;         // стерео, с начала — ещё не пропущенные кадры
+    QVector<float> m_mono;          // моно-сумма тех же кадров
+    int m_inputFrames = 0;
+    QVector<float> m_target;        // продолжение прошлого отрезка, Overlap кадров стерео
+    QVector<float> m_targetMono;
+    QVector<float> m_fade;          // нарастание 0..1 на Overlap кадров
+    double m_skipFraction = 0;
+    int m_pendingSkip = 0;          // кадры, которые надо пропустить, но их ещё не было на входе
+
+    int bestOffset(int base) const;
+    int step(float *out, int base);
+
+public:
+    TimeStretcher();
+
+    void configure(int sampleRate, int maxInputFrames = 8192);
+    ///Сбрасывает накопленное, например после перемотки источника
+    void reset();
+
+    int sampleRate() const { return m_sampleRate; }
+    double rate() const { return m_rate; }
+    ///rate > 1 — быстрее. Вступает в силу со следующего отрезка
+    void setRate(double rate);
+
+    ///Задержка от входа до выхода в кадрах
+    int latency() const { return m_sequence + m_seek; }
+
+    ///Сколько кадров самое большее даст process() на frames входных при текущем темпе
+    int maxOutputFrames(int frames) const;
+
+    ///Возвращает число записанных в out кадров
+    int process(const float *in, int frames, float *out);
+
+    ///Скалярное произведение a·b и энергия b·b для поиска смещения
+    static void correlate(const float *a, const float *b, int samples, float *product, float *energy);
+};
+
+#endif // TIMESTRETCHER_H
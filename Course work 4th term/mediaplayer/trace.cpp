@@ -0,0 +1,171 @@
+#include "trace.h"
+
+#include <QAtomicInteger>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+QAtomicInt Trace::s_enabled;
+
+struct TraceEvent
+{
+    const char *category;
+    const char *name;
+    qint64 start;
+    qint64 end;
+};
+
+///Кольцо одного потока. Пишет только владелец, читает только сброс под s_ringsMutex.
+///Индексы растут монотонно, слот — младшие биты индекса
+struct TraceRing
+{
+    TraceEvent events[Trace::Capacity];
+    QAtomicInteger<quint32> head;
+    quint32 base = 0;   // начало после clear(), меняется только под s_ringsMutex
+    int id = 0;
+    QString name;
+};
+
+static QElapsedTimer startedClock()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+}
+
+static const QElapsedTimer s_clock = startedClock();
+static const qint64 s_originTicks = Trace::ticks();
+static QMutex s_ringsMutex;
+static QVector<TraceRing *> s_rings;
+static thread_local TraceRing *t_ring = nullptr;
+
+///Кольца не освобождаются: поток может завершиться раньше, чем трассу сбросят
+static TraceRing *currentRing()
+{
+    if (Q_LIKELY(t_ring))
+        return t_ring;
+
+    TraceRing *ring = new TraceRing;
+    QThread *thread = QThread::currentThread();
+    ring->name = thread->objectName();
+
+    QMutexLocker locker(&s_ringsMutex);
+    ring->id = s_rings.size() + 1;
+    if (ring->name.isEmpty()) {
+        QCoreApplication *application = QCoreApplication::instance();
+        ring->name = application && application->thread() == thread
+                ? QString("GUI")
+                : QString("thread %1").arg(ring->id);
+    }
+    s_rings.append(ring);
+    t_ring = ring;
+    return ring;
+}
+
+void Trace::setEnabled(bool enabled)
+{
+    s_enabled.storeRelease(enabled ? 1 : 0);
+}
+
+qint64 Trace::now()
+{
+    return s_clock.nsecsElapsed();
+}
+
+void Trace::record(const char *category, const char *name, qint64 start, qint64 end)
+{
+    TraceRing *ring = currentRing();
+    const quint32 head = ring->head.loadAcquire();
+    TraceEvent &event = ring->events[head & (Capacity - 1)];
+    event.category = category;
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    ring->head.storeRelease(head + 1);
+}
+
+int Trace::threadId()
+{
+    return currentRing()->id;
+}
+
+static void appendEscaped(QByteArray &out, const char *text)
+{
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\')
+            out += '\\';
+        out += *text;
+    }
+}
+
+static void appendSeparator(QByteArray &out)
+{
+    if (!out.isEmpty())
+        out += ",\n";
+}
+
+///Пока события копируются, владелец может продолжать писать и затереть самые старые.
+///Поэтому голова читается до и после копии, и всё, что могло быть затёрто, отбрасывается
+QByteArray Trace::chromeEvents()
+{
+    QByteArray out;
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+    ///Частота счётчика тактов берётся по часам за всё время работы процесса
+    const qint64 elapsedTicks = Trace::ticks() - s_originTicks;
+    const double nsPerTick = elapsedTicks > 0 ? double(now()) / elapsedTicks : 1.0;
+
+    QMutexLocker locker(&s_ringsMutex);
+    QVector<TraceEvent> copy;
+    for (TraceRing *ring : s_rings) {
+        const QByteArray tid = QByteArray::number(ring->id);
+
+        appendSeparator(out);
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+                + ",\"args\":{\"name\":\"" + ring->name.toUtf8() + "\"}}";
+
+        const quint32 end = ring->head.loadAcquire();
+        quint32 first = end - ring->base > quint32(Capacity) ? end - Capacity : ring->base;
+        copy.resize(int(end - first));
+        for (quint32 i = first; i != end; ++i)
+            copy[int(i - first)] = ring->events[i & (Capacity - 1)];
+
+        const quint32 after = ring->head.loadAcquire();
+        const quint32 overwritten = after - first >= quint32(Capacity) ? after - Capacity + 1 - first : 0;
+
+        for (int i = int(qMin<quint32>(overwritten, end - first)); i < copy.size(); ++i) {
+            const TraceEvent &event = copy.at(i);
+            appendSeparator(out);
+            out += "{\"name\":\"";
+            appendEscaped(out, event.name);
+            out += "\",\"cat\":\"";
+            appendEscaped(out, event.category);
+            out += "\",\"ph\":\"X\",\"ts\":" + QByteArray::number((event.start - s_originTicks) * nsPerTick / 1000.0, 'f', 3)
+                    + ",\"dur\":" + QByteArray::number((event.end - event.start) * nsPerTick / 1000.0, 'f', 3)
+                    + ",\"pid\":" + pid + ",\"tid\":" + tid + "}";
+        }
+    }
+    return out;
+}
+
+bool Trace::writeChromeJson(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    file.write("[\n");
+    file.write(chromeEvents());
+    file.write("\n]\n");
+    return true;
+}
+
+void Trace::clear()
+{
+    QMutexLocker locker(&s_ringsMutex);
+    for (TraceRing *ring : s_rings)
+        ring->base = ring->head.loadAcquire();
+}
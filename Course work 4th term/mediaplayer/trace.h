@@ -0,0 +1,91 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRACE_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define TRACE_TSC
+#endif
+
+///Трассировка горячих участков. TRACE_SCOPE ставит замер на время блока:
+///при выключенной записи это одно чтение флага, при включённой — два чтения
+///счётчика тактов и запись события в кольцо своего потока без блокировок.
+///Кольцо каждого потока хранит последние Trace::Capacity событий, старые затираются.
+///По запросу кольца сбрасываются в JSON-формат chrome://tracing (он же читается Perfetto).
+///Имя и категория должны быть строковыми литералами: указатели хранятся без копирования.
+///С MEDIAPLAYER_NO_TRACE макросы не порождают кода
+class Trace
+{
+private:
+    static QAtomicInt s_enabled;
+
+public:
+    static const int Capacity = 8192;
+
+    static bool isEnabled() { return s_enabled.loadAcquire() != 0; }
+    static void setEnabled(bool enabled);
+
+    ///Монотонное время от запуска процесса в наносекундах
+    static qint64 now();
+
+    ///Отметка для замеров. На x86 это счётчик тактов: он в несколько раз дешевле
+    ///системных часов, а в наносекунды переводится только при сбросе
+    static qint64 ticks()
+    {
+#ifdef TRACE_TSC
+        return qint64(__rdtsc());
+#else
+        return now();
+#endif
+    }
+
+    static void record(const char *category, const char *name, qint64 start, qint64 end);
+
+    ///Номер потока в трассе, кольцо потока заводится при первом обращении
+    static int threadId();
+
+    ///События всех колец через запятую, без обрамляющих скобок массива,
+    ///чтобы их можно было дописать к уже открытой трассе
+    static QByteArray chromeEvents();
+    static bool writeChromeJson(const QString &path);
+    static void clear();
+};
+
+class TraceScope
+{
+private:
+    const char *m_category;
+    const char *m_name;
+    qint64 m_start;
+
+public:
+    TraceScope(const char *category, const char *name)
+        : m_category(category),
+          m_name(name),
+          m_start(Trace::isEnabled() ? Trace::ticks() : -1)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_start >= 0)
+            Trace::record(m_category, m_name, m_start, Trace::ticks());
+    }
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef MEDIAPLAYER_NO_TRACE
+#define TRACE_SCOPE(category, name)
+#else
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,287 @@
+#include "trackimporter.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+
+#include <algorithm>
+
+#include "audiosniffer.h"
+#include "trace.h"
+
+static bool isPlaylistFile(const QFileInfo &info)
+{
+    return !info.suffix().compare(QLatin1String("m3u"), Qt::CaseInsensitive)
+            || !info.suffix().compare(QLatin1String("m3u8"), Qt::CaseInsensitive);
+}
+
+///Строки m3u — пути относительно самого файла или адреса, строки с # — комментарии
+static QStringList readPlaylist(const QString &fileName)
+{
+    QStringList urls;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return urls;
+
+    const QDir dir = QFileInfo(fileName).absoluteDir();
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+
+        ///Однобуквенная схема — это диск Windows, а не адрес
+        const QUrl url(line);
+        if (url.scheme().size() > 1)
+            urls.append(url.toString(QUrl::FullyEncoded));
+        else
+            urls.append(QUrl::fromLocalFile(dir.absoluteFilePath(line)).toString(QUrl::FullyEncoded));
+    }
+    return urls;
+}
+
+///Раскрывает папку (со всеми вложенными) или плейлист m3u в список адресов
+class ScanTask : public QRunnable
+{
+private:
+    TrackImporter *m_importer;
+    int m_unit;
+    QString m_path;
+    bool m_folder;
+
+public:
+    ScanTask(TrackImporter *importer, int unit, const QString &path, bool folder)
+        : m_importer(importer), m_unit(unit), m_path(path), m_folder(folder)
+    {
+    }
+
+    void run() override
+    {
+        TRACE_SCOPE("import", "ScanTask::run");
+
+        QStringList urls;
+        if (m_folder) {
+            QStringList files;
+            QDirIterator it(m_path, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+            while (it.hasNext())
+                files.append(it.next());
+            std::sort(files.begin(), files.end(), [](const QString &a, const QString &b) {
+                return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+            });
+            for (const QString &file : files)
+                urls.append(QUrl::fromLocalFile(file).toString(QUrl::FullyEncoded));
+        } else {
+            urls = readPlaylist(m_path);
+        }
+
+        ///Содержимое папки — не выбор пользователя: о непохожих на звук файлах молчим
+        QMetaObject::invokeMethod(m_importer, "listScanned", Qt::QueuedConnection,
+                                  Q_ARG(int, m_unit), Q_ARG(QStringList, urls), Q_ARG(bool, !m_folder));
+    }
+};
+
+static bool hasAudioSuffix(const QString &suffix)
+{
+    for (int format = AudioSniffer::Wave; format <= AudioSniffer::Aiff; ++format) {
+        if (AudioSniffer::matchesSuffix(AudioSniffer::Format(format), suffix))
+            return true;
+    }
+    return false;
+}
+
+///Проверяет пачку файлов: одно чтение заголовка на файл
+class SniffTask : public QRunnable
+{
+private:
+    TrackImporter *m_importer;
+    int m_unit;
+    int m_chunk;
+    QStringList m_urls;
+    bool m_reportUnknown;
+
+public:
+    SniffTask(TrackImporter *importer, int unit, int chunk, const QStringList &urls, bool reportUnknown)
+        : m_importer(importer), m_unit(unit), m_chunk(chunk), m_urls(urls), m_reportUnknown(reportUnknown)
+    {
+    }
+
+    void run() override
+    {
+        TRACE_SCOPE("import", "SniffTask::run");
+
+        QStringList accepted, mimeTypes, rejected, reasons;
+        int relabelled = 0;
+        QByteArray header(AudioSniffer::HeaderSize, Qt::Uninitialized);
+
+        for (const QString &entry : m_urls) {
+            const QUrl url(entry);
+            if (!url.isLocalFile()) {
+                accepted.append(entry);
+                mimeTypes.append(QString());
+                continue;
+            }
+
+            const QString path = url.toLocalFile();
+            const QString suffix = QFileInfo(path).suffix();
+            AudioSniffer::Format format = AudioSniffer::Unknown;
+            QString reason;
+
+            QFile file(path);
+            if (file.open(QIODevice::ReadOnly)) {
+                const qint64 size = file.read(header.data(), header.size());
+                format = AudioSniffer::sniff(header.constData(), int(qMax<qint64>(0, size)), &reason);
+            } else {
+                reason = file.errorString();
+            }
+
+            if (AudioSniffer::isSupported(format)) {
+                accepted.append(entry);
+                mimeTypes.append(AudioSniffer::mimeType(format));
+                if (!AudioSniffer::matchesSuffix(format, suffix))
+                    ++relabelled;
+                continue;
+            }
+
+            if (format != AudioSniffer::Unknown)
+                reason = TrackImporter::tr("%1 files are not supported").arg(AudioSniffer::name(format));
+            else if (!m_reportUnknown && !hasAudioSuffix(suffix))
+                continue;
+
+            rejected.append(QDir::toNativeSeparators(path));
+            reasons.append(reason);
+        }
+
+        QMetaObject::invokeMethod(m_importer, "chunkSniffed", Qt::QueuedConnection,
+                                  Q_ARG(int, m_unit), Q_ARG(int, m_chunk),
+                                  Q_ARG(QStringList, accepted), Q_ARG(QStringList, mimeTypes),
+                                  Q_ARG(QStringList, rejected), Q_ARG(QStringList, reasons),
+                                  Q_ARG(int, relabelled));
+    }
+};
+
+TrackImporter::TrackImporter(QObject *parent)
+    : QObject(parent)
+{
+}
+
+TrackImporter::~TrackImporter()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+int TrackImporter::addUnit()
+{
+    m_units.append(Unit());
+    return m_firstUnit + m_units.size() - 1;
+}
+
+///Подряд идущие файлы объединяются в один элемент и проверяются пачками,
+///папки и плейлисты сначала раскрываются в рабочем потоке
+void TrackImporter::import(const QList<QUrl> &urls)
+{
+    TRACE_SCOPE("import", "TrackImporter::import");
+
+    if (urls.isEmpty())
+        return;
+    m_running = true;
+
+    QStringList files;
+    for (const QUrl &url : urls) {
+        const QFileInfo info(url.isLocalFile() ? url.toLocalFile() : QString());
+        const bool folder = info.isDir();
+        if (!url.isLocalFile() || (!folder && !isPlaylistFile(info))) {
+            files.append(url.toString(QUrl::FullyEncoded));
+            continue;
+        }
+
+        if (!files.isEmpty()) {
+            startChunks(addUnit(), files, true);
+            files.clear();
+        }
+        m_pool.start(new ScanTask(this, addUnit(), info.absoluteFilePath(), folder));
+    }
+    if (!files.isEmpty())
+        startChunks(addUnit(), files, true);
+
+    flush();
+}
+
+void TrackImporter::startChunks(int unit, const QStringList &urls, bool reportUnknown)
+{
+    Unit &target = m_units[unit - m_firstUnit];
+    target.scanned = true;
+    for (int start = 0; start < urls.size(); start += ChunkSize) {
+        target.chunks.append(Chunk());
+        m_pool.start(new SniffTask(this, unit, target.chunks.size() - 1, urls.mid(start, ChunkSize), reportUnknown));
+    }
+}
+
+void TrackImporter::listScanned(int unit, const QStringList &urls, bool reportUnknown)
+{
+    startChunks(unit, urls, reportUnknown);
+    flush();
+}
+
+void TrackImporter::chunkSniffed(int unit, int chunk, const QStringList &accepted, const QStringList &mimeTypes,
+                                 const QStringList &rejected, const QStringList &reasons, int relabelled)
+{
+    Chunk &target = m_units[unit - m_firstUnit].chunks[chunk];
+    target.done = true;
+    target.accepted = accepted;
+    target.mimeTypes = mimeTypes;
+    target.rejected = rejected;
+    target.reasons = reasons;
+    target.relabelled = relabelled;
+    flush();
+}
+
+///Готовые пачки отдаются по порядку, пока не встретится незаконченная.
+///Номера пачек внутри элемента не сдвигаются: выданные только очищаются
+void TrackImporter::flush()
+{
+    while (!m_units.isEmpty()) {
+        Unit &unit = m_units.first();
+        if (!unit.scanned)
+            break;
+
+        bool complete = true;
+        for (Chunk &chunk : unit.chunks) {
+            if (!chunk.done) {
+                complete = false;
+                break;
+            }
+            if (chunk.accepted.isEmpty() && chunk.rejected.isEmpty())
+                continue;
+
+            QList<QUrl> urls;
+            urls.reserve(chunk.accepted.size());
+            for (const QString &url : chunk.accepted)
+                urls.append(QUrl(url));
+            if (!urls.isEmpty())
+                emit tracksAccepted(urls, chunk.mimeTypes);
+
+            m_accepted += chunk.accepted.size();
+            m_relabelled += chunk.relabelled;
+            m_rejectedFiles += chunk.rejected;
+            m_reasons += chunk.reasons;
+            chunk = Chunk();
+            chunk.done = true;
+        }
+        if (!complete)
+            break;
+
+        m_units.removeFirst();
+        ++m_firstUnit;
+    }
+
+    if (m_units.isEmpty() && m_running) {
+        m_running = false;
+        emit finished(m_accepted, m_relabelled, m_rejectedFiles, m_reasons);
+        m_accepted = 0;
+        m_relabelled = 0;
+        m_rejectedFiles.clear();
+        m_reasons.clear();
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef TRACKIMPORTER_H
+#define TRACKIMPORTER_H
+
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QUrl>
+
+///Приём файлов в плейлист. Папки (рекурсивно) и плейлисты m3u раскрываются
+///в рабочем потоке, затем каждый файл пачками проверяется одним коротким чтением
+///в пуле потоков (AudioSniffer). Испорченные и неподдерживаемые файлы отсекаются,
+///файлы с чужим расширением принимаются с MIME-типом по содержимому.
+///Результаты выдаются в том порядке, в каком файлы были переданы
+class TrackImporter : public QObject
+{
+    Q_OBJECT
+
+private:
+    ///Одна пачка файлов и её результат
+    struct Chunk
+    {
+        bool done = false;
+        QStringList accepted;       // адреса в QUrl::FullyEncoded
+        QStringList mimeTypes;
+        QStringList rejected;
+        QStringList reasons;
+        int relabelled = 0;
+    };
+
+    ///Исходный элемент import(): файл, папка или плейлист
+    struct Unit
+    {
+        bool scanned = false;
+        QList<Chunk> chunks;
+    };
+
+    QThreadPool m_pool;
+    QList<Unit> m_units;
+    int m_firstUnit = 0;     // номер m_units.first() с начала работы
+
+    int m_accepted = 0;
+    int m_relabelled = 0;
+    QStringList m_rejectedFiles;
+    QStringList m_reasons;
+
+    bool m_running = false;
+
+    int addUnit();
+    void startChunks(int unit, const QStringList &urls, bool reportUnknown);
+    void flush();
+
+private slots:
+    void listScanned(int unit, const QStringList &urls, bool reportUnknown);
+    void chunkSniffed(int unit, int chunk, const QStringList &accepted, const QStringList &mimeTypes,
+                      const QStringList &rejected, const QStringList &reasons, int relabelled);
+
+public:
+    static const int ChunkSize = 64;
+
+    explicit TrackImporter(QObject *parent = nullptr);
+    ~TrackImporter();
+
+    void import(const QList<QUrl> &urls);
+    bool isBusy() const { return !m_units.isEmpty(); }
+
+signals:
+    void tracksAccepted(const QList<QUrl> &urls, const QStringList &mimeTypes);
+
+    ///Когда обработано всё переданное: итог и причины отказов
+    void finished(int accepted, int relabelled, const QStringList &rejected, const QStringList &reasons);
+};
+
+#endif // TRACKIMPORTER_H
@@ -0,0 +1,77 @@
+#include "trackinfoloader.h"
+
+#include <QRunnable>
+
+#include "durationestimator.h"
+#include "trace.h"
+
+///Пачка файлов одного запроса. Файлы без тегов тоже попадают в ответ
+///с пустой записью, чтобы модель знала, что ждать больше нечего.
+///Длительность читается сразу за тегами, пока начало файла ещё в кэше страниц
+class TagTask : public QRunnable
+{
+private:
+    TrackInfoLoader *m_loader;
+    int m_generation;
+    QVector<int> m_keys;
+    QStringList m_fileNames;
+
+public:
+    TagTask(TrackInfoLoader *loader, int generation, const QVector<int> &keys, const QStringList &fileNames)
+        : m_loader(loader), m_generation(generation), m_keys(keys), m_fileNames(fileNames)
+    {
+    }
+
+    void run() override
+    {
+        TRACE_SCOPE("io", "TagTask::run");
+
+        QVector<TagReader::Tags> tags(m_fileNames.size());
+        QVector<qint64> durations(m_fileNames.size());
+        for (int i = 0; i < m_fileNames.size(); ++i) {
+            TagReader::read(m_fileNames.at(i), &tags[i]);
+            durations[i] = DurationEstimator::estimate(m_fileNames.at(i));
+        }
+
+        QMetaObject::invokeMethod(m_loader, "batchRead", Qt::QueuedConnection,
+                                  Q_ARG(int, m_generation), Q_ARG(QVector<int>, m_keys),
+                                  Q_ARG(QStringList, m_fileNames), Q_ARG(QVector<TagReader::Tags>, tags),
+                                  Q_ARG(QVector<qint64>, durations));
+    }
+};
+
+TrackInfoLoader::TrackInfoLoader(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QVector<int>>("QVector<int>");
+    qRegisterMetaType<QVector<TagReader::Tags>>("QVector<TagReader::Tags>");
+    qRegisterMetaType<QVector<qint64>>("QVector<qint64>");
+    m_pool.setMaxThreadCount(2);
+}
+
+TrackInfoLoader::~TrackInfoLoader()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void TrackInfoLoader::request(const QVector<int> &keys, const QStringList &fileNames)
+{
+    for (int first = 0; first < keys.size(); first += BatchSize) {
+        const int count = qMin(BatchSize, keys.size() - first);
+        m_pool.start(new TagTask(this, m_generation, keys.mid(first, count), fileNames.mid(first, count)));
+    }
+}
+
+void TrackInfoLoader::cancel()
+{
+    m_pool.clear();
+    ++m_generation;
+}
+
+void TrackInfoLoader::batchRead(int generation, const QVector<int> &keys, const QStringList &fileNames,
+                                const QVector<TagReader::Tags> &tags, const QVector<qint64> &durations)
+{
+    if (generation == m_generation)
+        emit infoRead(keys, fileNames, tags, durations);
+}
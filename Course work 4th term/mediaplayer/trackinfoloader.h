@@ -0,0 +1,45 @@
+#ifndef TRACKINFOLOADER_H
+#define TRACKINFOLOADER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include "tagreader.h"
+
+///Теги и длительность треков (DurationEstimator) читаются пачками в пуле потоков,
+///ответ — одним сигналом на пачку,
+///чтобы модель обновляла строки одним dataChanged, а не по строке.
+///Ключ запроса выбирает модель (номер трека или строки) и получает его обратно
+///вместе с именем файла — по нему модель проверяет, что строка всё ещё та же
+class TrackInfoLoader : public QObject
+{
+    Q_OBJECT
+
+private:
+    QThreadPool m_pool;
+    int m_generation = 0;
+
+private slots:
+    void batchRead(int generation, const QVector<int> &keys, const QStringList &fileNames,
+                   const QVector<TagReader::Tags> &tags, const QVector<qint64> &durations);
+
+public:
+    static const int BatchSize = 64;
+
+    explicit TrackInfoLoader(QObject *parent = nullptr);
+    ~TrackInfoLoader();
+
+    void request(const QVector<int> &keys, const QStringList &fileNames);
+
+    ///Ещё не начатые пачки отменяются, ответы уже начатых отбрасываются
+    void cancel();
+
+signals:
+    ///durations — в миллисекундах, -1 для файла, длительность которого не определить
+    void infoRead(const QVector<int> &keys, const QStringList &fileNames, const QVector<TagReader::Tags> &tags,
+                  const QVector<qint64> &durations);
+};
+
+#endif // TRACKINFOLOADER_H
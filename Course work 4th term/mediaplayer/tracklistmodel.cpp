@@ -0,0 +1,281 @@
+#include "tracklistmodel.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QMimeData>
+
+#include <algorithm>
+
+#include "timeformat.h"
+#include "trace.h"
+
+static const char rowsMimeType[] = "application/x-mediaplayer-rows";
+
+TrackListModel::TrackListModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+    connect(&m_infoLoader, &TrackInfoLoader::infoRead, this, &TrackListModel::infoRead);
+}
+
+int TrackListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_sequence.count();
+}
+
+int TrackListModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TrackListModel::data(const QModelIndex &index, int role) const
+{
+    TRACE_SCOPE("model", "TrackListModel::data");
+
+    if (!index.isValid())
+        return QVariant();
+    if (role == Qt::TextAlignmentRole && index.column() == Duration)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    const Track &track = m_tracks.at(m_sequence.at(index.row()));
+    if (index.column() == Title)
+        return track.title;
+    if (index.column() == Duration)
+        return track.duration >= 0 ? TimeFormat::toString(track.duration / 1000) : QString();
+    return track.url.isLocalFile() ? QDir::toNativeSeparators(track.url.toLocalFile()) : track.url.toString();
+}
+
+QVariant TrackListModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal)
+        return QVariant();
+    if (role == Qt::TextAlignmentRole && section == Duration)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (section) {
+    case Title:
+        return tr("AUDIO TRACK");
+    case Duration:
+        return m_knownDurations > 0 ? TimeFormat::toString(m_totalDuration / 1000) : tr("TIME");
+    default:
+        return tr("FILE PATH");
+    }
+}
+
+///Бросать можно только между строками, на саму строку — нельзя
+Qt::ItemFlags TrackListModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::ItemIsDropEnabled;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+}
+
+Qt::DropActions TrackListModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
+
+QStringList TrackListModel::mimeTypes() const
+{
+    return QStringList() << QString::fromLatin1(rowsMimeType);
+}
+
+///При перетаскивании передаются только номера строк, а не данные всех ячеек
+QMimeData *TrackListModel::mimeData(const QModelIndexList &indexes) const
+{
+    QByteArray encoded;
+    QDataStream stream(&encoded, QIODevice::WriteOnly);
+    for (const QModelIndex &index : indexes) {
+        if (index.column() == Title)
+            stream << index.row();
+    }
+
+    QMimeData *mimeData = new QMimeData;
+    mimeData->setData(QString::fromLatin1(rowsMimeType), encoded);
+    return mimeData;
+}
+
+bool TrackListModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > rowCount())
+        return false;
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    m_ids.resize(0);
+    m_sequence.remove(row, count, &m_ids);
+    const int knownDurations = m_knownDurations;
+    for (int id : m_ids) {
+        if (m_tracks.at(id).duration >= 0) {
+            m_totalDuration -= m_tracks.at(id).duration;
+            --m_knownDurations;
+        }
+        m_tracks[id] = Track();
+        if (id == m_currentId)
+            m_currentId = -1;
+    }
+    endRemoveRows();
+
+    if (m_knownDurations != knownDurations)
+        emit headerDataChanged(Qt::Horizontal, Duration, Duration);
+    return true;
+}
+
+QUrl TrackListModel::url(int row) const
+{
+    return row >= 0 && row < rowCount() ? m_tracks.at(m_sequence.at(row)).url : QUrl();
+}
+
+QString TrackListModel::title(int row) const
+{
+    return row >= 0 && row < rowCount() ? m_tracks.at(m_sequence.at(row)).title : QString();
+}
+
+QString TrackListModel::mimeType(int row) const
+{
+    return row >= 0 && row < rowCount() ? m_tracks.at(m_sequence.at(row)).mimeType : QString();
+}
+
+qint64 TrackListModel::duration(int row) const
+{
+    return row >= 0 && row < rowCount() ? m_tracks.at(m_sequence.at(row)).duration : -1;
+}
+
+int TrackListModel::currentRow() const
+{
+    return m_sequence.indexOf(m_currentId);
+}
+
+void TrackListModel::setCurrentRow(int row)
+{
+    m_currentId = row >= 0 && row < rowCount() ? m_sequence.at(row) : -1;
+}
+
+void TrackListModel::insertTracks(int row, const QList<QUrl> &urls, const QStringList &mimeTypes)
+{
+    TRACE_SCOPE("model", "TrackListModel::insertTracks");
+
+    if (urls.isEmpty())
+        return;
+    row = qBound(0, row, rowCount());
+
+    beginInsertRows(QModelIndex(), row, row + urls.size() - 1);
+    m_ids.resize(0);
+    m_sequence.insert(row, urls.size(), &m_ids);
+    if (m_tracks.size() < m_sequence.capacity())
+        m_tracks.resize(m_sequence.capacity());
+    QVector<int> localIds;
+    QStringList fileNames;
+    for (int i = 0; i < urls.size(); ++i) {
+        Track &track = m_tracks[m_ids.at(i)];
+        track.url = urls.at(i);
+        track.title = urls.at(i).fileName();
+        track.mimeType = mimeTypes.value(i);
+        if (track.url.isLocalFile()) {
+            localIds.append(m_ids.at(i));
+            fileNames.append(track.url.toLocalFile());
+        }
+    }
+    endInsertRows();
+
+    m_infoLoader.request(localIds, fileNames);
+}
+
+///Номер трека мог освободиться и достаться другому файлу, поэтому сверяется и имя.
+///Все строки пачки обновляются одним dataChanged, общее время — одним headerDataChanged
+void TrackListModel::infoRead(const QVector<int> &ids, const QStringList &fileNames, const QVector<TagReader::Tags> &tags,
+                              const QVector<qint64> &durations)
+{
+    TRACE_SCOPE("model", "TrackListModel::infoRead");
+
+    int first = rowCount();
+    int last = -1;
+    bool durationsChanged = false;
+    for (int i = 0; i < ids.size(); ++i) {
+        const int id = ids.at(i);
+        if (id >= m_tracks.size() || (tags.at(i).isEmpty() && durations.at(i) < 0))
+            continue;
+        Track &track = m_tracks[id];
+        if (!track.url.isLocalFile() || track.url.toLocalFile() != fileNames.at(i))
+            continue;
+
+        if (!tags.at(i).isEmpty())
+            track.title = TagReader::displayTitle(tags.at(i), track.title);
+        if (durations.at(i) >= 0 && track.duration < 0) {
+            track.duration = durations.at(i);
+            m_totalDuration += track.duration;
+            ++m_knownDurations;
+            durationsChanged = true;
+        }
+        const int row = m_sequence.indexOf(id);
+        first = qMin(first, row);
+        last = qMax(last, row);
+    }
+
+    if (last >= 0)
+        emit dataChanged(index(first, Title), index(last, Duration));
+    if (durationsChanged)
+        emit headerDataChanged(Qt::Horizontal, Duration, Duration);
+}
+
+void TrackListModel::appendTracks(const QList<QUrl> &urls, const QStringList &mimeTypes)
+{
+    insertTracks(rowCount(), urls, mimeTypes);
+}
+
+QVector<int> TrackListModel::sortedRows(QList<int> rows, int count)
+{
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    QVector<int> sorted;
+    sorted.reserve(rows.size());
+    for (int row : rows) {
+        if (row >= 0 && row < count)
+            sorted.append(row);
+    }
+    return sorted;
+}
+
+///Разрозненные строки сначала переносятся в конец, чтобы удалить их одним отрезком
+void TrackListModel::removeTracks(const QList<int> &rows)
+{
+    TRACE_SCOPE("model", "TrackListModel::removeTracks");
+
+    const QVector<int> sorted = sortedRows(rows, rowCount());
+    if (sorted.isEmpty())
+        return;
+
+    const int count = sorted.size();
+    if (sorted.last() - sorted.first() + 1 != count)
+        moveTracks(rows, rowCount());
+    removeRows(sorted.last() - sorted.first() + 1 == count ? sorted.first() : rowCount() - count, count);
+}
+
+///Постоянные индексы (выделение, текущая строка вида) пересчитываются
+///по формуле переноса, без прохода по всем строкам
+int TrackListModel::moveTracks(const QList<int> &rows, int destination)
+{
+    TRACE_SCOPE("model", "TrackListModel::moveTracks");
+
+    const QVector<int> sorted = sortedRows(rows, rowCount());
+    destination = qBound(0, destination, rowCount());
+    if (sorted.isEmpty())
+        return destination;
+
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::NoLayoutChangeHint);
+    const int first = m_sequence.move(sorted, destination);
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &index : from)
+        to.append(this->index(PlaylistSequence::rowAfterMove(sorted, destination, index.row()), index.column()));
+    changePersistentIndexList(from, to);
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::NoLayoutChangeHint);
+
+    emit tracksMoved(sorted, destination);
+    return first;
+}
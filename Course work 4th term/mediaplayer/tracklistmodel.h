@@ -0,0 +1,96 @@
+#ifndef TRACKLISTMODEL_H
+#define TRACKLISTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QUrl>
+#include <QVector>
+
+#include "playlistsequence.h"
+#include "trackinfoloader.h"
+
+///Плейлист аудиоплеера: порядок строк хранит PlaylistSequence, данные треков
+///лежат по их номерам и при перестановках не двигаются.
+///Удаление и перенос выделения из любого числа строк — одна операция над моделью:
+///перенос идёт одним layoutChanged, удаление разрозненных строк сначала собирает
+///их в конец тем же переносом, а затем удаляет одним отрезком.
+///Текущий трек запоминается по номеру и переживает любые перестановки.
+///Теги и длительность локальных файлов читаются в фоне сразу при добавлении,
+///до их прихода название — имя файла, а время пустое.
+///Заголовок столбца длительности показывает общее время плейлиста
+class TrackListModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+private:
+    struct Track
+    {
+        QUrl url;
+        QString title;
+        QString mimeType;
+        qint64 duration = -1;
+    };
+
+    PlaylistSequence m_sequence;
+    QVector<Track> m_tracks;
+    QVector<int> m_ids;
+    int m_currentId = -1;
+    TrackInfoLoader m_infoLoader;
+    ///Сумма известных длительностей и число треков, у которых она известна
+    qint64 m_totalDuration = 0;
+    int m_knownDurations = 0;
+
+    static QVector<int> sortedRows(QList<int> rows, int count);
+
+private slots:
+    void infoRead(const QVector<int> &ids, const QStringList &fileNames, const QVector<TagReader::Tags> &tags,
+                  const QVector<qint64> &durations);
+
+public:
+    enum Column
+    {
+        Title = 0,
+        Duration,
+        Path,
+        ColumnCount
+    };
+
+    explicit TrackListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    Qt::DropActions supportedDropActions() const override;
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+
+    QUrl url(int row) const;
+    QString title(int row) const;
+    ///Тип по содержимому файла, если его определили при добавлении
+    QString mimeType(int row) const;
+    ///Миллисекунды, -1 — ещё не прочитана или не определяется
+    qint64 duration(int row) const;
+    qint64 totalDuration() const { return m_totalDuration; }
+
+    ///Строка текущего трека, -1 если его нет или он удалён
+    int currentRow() const;
+    void setCurrentRow(int row);
+
+    void insertTracks(int row, const QList<QUrl> &urls, const QStringList &mimeTypes = QStringList());
+    void appendTracks(const QList<QUrl> &urls, const QStringList &mimeTypes = QStringList());
+
+    ///Строки могут идти в любом порядке и повторяться
+    void removeTracks(const QList<int> &rows);
+    ///Переносит строки одним блоком перед строкой destination, возвращает первую строку блока
+    int moveTracks(const QList<int> &rows, int destination);
+
+signals:
+    ///rows — исходные строки по возрастанию, как их принимает PlaylistSequence::rowAfterMove
+    void tracksMoved(const QVector<int> &rows, int destination);
+};
+
+#endif // TRACKLISTMODEL_H
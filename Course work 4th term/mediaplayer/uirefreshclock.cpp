@@ -0,0 +1,155 @@
+#include "uirefreshclock.h"
+
+#include <QCoreApplication>
+
+UiRefreshClock::UiRefreshClock(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setInterval(1000 / m_rate);
+    connect(&m_timer, &QTimer::timeout, this, &UiRefreshClock::sample);
+}
+
+UiRefreshClock *UiRefreshClock::instance()
+{
+    static UiRefreshClock *clock = new UiRefreshClock(QCoreApplication::instance());
+    return clock;
+}
+
+int UiRefreshClock::indexOf(QMediaPlayer *player) const
+{
+    for (int i = 0; i < m_watches.size(); ++i) {
+        if (m_watches.at(i).player == player)
+            return i;
+    }
+    return -1;
+}
+
+bool UiRefreshClock::isWatching(QMediaPlayer *player) const
+{
+    return player && indexOf(player) >= 0;
+}
+
+///Плеер отслеживается, пока его не снимут unwatch() или он не будет удалён
+void UiRefreshClock::watch(QMediaPlayer *player)
+{
+    if (!player || indexOf(player) >= 0)
+        return;
+
+    Watch watch;
+    watch.player = player;
+    m_watches.append(watch);
+
+    connect(player, &QMediaPlayer::stateChanged, this, [this, player](QMediaPlayer::State state) {
+        playerStateChanged(player, state);
+    });
+    connect(player, &QMediaPlayer::positionChanged, this, [this, player](qint64 position) {
+        playerPositionChanged(player, position);
+    });
+    connect(player, &QObject::destroyed, this, [this]() { updateTimer(); });
+
+    updateTimer();
+    resync(player);
+}
+
+void UiRefreshClock::unwatch(QMediaPlayer *player)
+{
+    const int index = indexOf(player);
+    if (index < 0)
+        return;
+
+    disconnect(player, nullptr, this, nullptr);
+    m_watches.remove(index);
+    updateTimer();
+}
+
+int UiRefreshClock::rate() const
+{
+    return m_rate;
+}
+
+///Частота опроса плееров в тактах в секунду
+void UiRefreshClock::setRate(int rate)
+{
+    m_rate = qBound(1, rate, 1000);
+    m_timer.setInterval(1000 / m_rate);
+}
+
+qint64 UiRefreshClock::resolution() const
+{
+    return m_resolution;
+}
+
+///Шаг отображаемого значения в миллисекундах: изменения позиции
+///внутри одного шага не приводят к обновлению интерфейса
+void UiRefreshClock::setResolution(qint64 resolution)
+{
+    m_resolution = qMax<qint64>(1, resolution);
+    for (Watch &watch : m_watches)
+        watch.lastTick = -1;
+}
+
+void UiRefreshClock::resync(QMediaPlayer *player)
+{
+    const int index = indexOf(player);
+    if (index < 0)
+        return;
+
+    m_watches[index].lastTick = -1;
+    publish(m_watches[index], player->position());
+}
+
+void UiRefreshClock::publish(Watch &watch, qint64 position)
+{
+    qint64 tick = position / m_resolution;
+    if (tick == watch.lastTick)
+        return;
+
+    watch.lastTick = tick;
+    emit positionChanged(watch.player.data(), position);
+}
+
+///Таймер работает, только пока хоть один плеер играет; удалённые плееры
+///выбрасываются здесь же
+void UiRefreshClock::updateTimer()
+{
+    bool playing = false;
+    for (int i = m_watches.size() - 1; i >= 0; --i) {
+        QMediaPlayer *player = m_watches.at(i).player;
+        if (!player)
+            m_watches.remove(i);
+        else if (player->state() == QMediaPlayer::PlayingState)
+            playing = true;
+    }
+
+    if (!playing)
+        m_timer.stop();
+    else if (!m_timer.isActive())
+        m_timer.start();
+}
+
+void UiRefreshClock::sample()
+{
+    for (Watch &watch : m_watches) {
+        if (watch.player && watch.player->state() == QMediaPlayer::PlayingState)
+            publish(watch, watch.player->position());
+    }
+}
+
+void UiRefreshClock::playerStateChanged(QMediaPlayer *player, QMediaPlayer::State state)
+{
+    ///В паузе и остановке интерфейс плеера обновляется лишь по редким
+    ///уведомлениям, поэтому его позиция публикуется сразу
+    updateTimer();
+    if (state != QMediaPlayer::PlayingState)
+        playerPositionChanged(player, player->position());
+}
+
+void UiRefreshClock::playerPositionChanged(QMediaPlayer *player, qint64 position)
+{
+    if (player->state() == QMediaPlayer::PlayingState)
+        return;
+
+    const int index = indexOf(player);
+    if (index >= 0)
+        publish(m_watches[index], position);
+}
@@ -0,0 +1,61 @@
+#ifndef UIREFRESHCLOCK_H
+#define UIREFRESHCLOCK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QPointer>
+#include <QMediaPlayer>
+#include <QVector>
+
+///Единые часы обновления интерфейса, одни на приложение.
+///Один таймер обслуживает все отслеживаемые плееры обоих окон: пока хоть один
+///играет, раз за такт опрашивается позиция каждого играющего плеера,
+///и о ней сообщается только тогда, когда меняется отображаемое значение
+class UiRefreshClock : public QObject
+{
+    Q_OBJECT
+
+private:
+    struct Watch
+    {
+        QPointer<QMediaPlayer> player;
+        qint64 lastTick = -1;
+    };
+
+    QVector<Watch> m_watches;
+    QTimer m_timer;
+    int m_rate = 10;
+    qint64 m_resolution = 1000;
+
+    explicit UiRefreshClock(QObject *parent = nullptr);
+
+    int indexOf(QMediaPlayer *player) const;
+    void publish(Watch &watch, qint64 position);
+    void updateTimer();
+
+private slots:
+    void sample();
+    void playerStateChanged(QMediaPlayer *player, QMediaPlayer::State state);
+    void playerPositionChanged(QMediaPlayer *player, qint64 position);
+
+public:
+    static UiRefreshClock *instance();
+
+    bool isWatching(QMediaPlayer *player) const;
+
+    int rate() const;
+    void setRate(int rate);
+
+    qint64 resolution() const;
+    void setResolution(qint64 resolution);
+
+public slots:
+    void watch(QMediaPlayer *player);
+    void unwatch(QMediaPlayer *player);
+    void resync(QMediaPlayer *player);
+
+signals:
+    void positionChanged(QMediaPlayer *player, qint64 position);
+};
+
+#endif // UIREFRESHCLOCK_H
@@ -6,16 +6,13 @@ VolumeButton::VolumeButton(QWidget *parent):
     setPopupMode(QToolButton::InstantPopup);
 
     setIcon(QIcon(":/buttons/volume_w.png"));
-    setStyleSheet("padding-left: 0px;"
-                  "padding-right: 0px;"
-                  "padding-top: 0px;"
-                  "padding-bottom: 0px;");
+    setObjectName("btn_volume");
     setIconSize(QSize(20,20));
     QWidget *popup = new QWidget(this);
 
     m_slider = new QSlider(Qt::Horizontal, popup);
     m_slider->setRange(0,100);
-    m_slider->setStyleSheet(Style::getSliderStyleSheet2());
+    m_slider->setObjectName("volumeSlider");
 
     connect(m_slider, &QAbstractSlider::valueChanged, this, &VolumeButton::volumeChanged);
 
@@ -0,0 +1,244 @@
+#include "wavfile.h"
+
+#include <QCoreApplication>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static inline quint32 readLe16(const uchar *p)
+{
+    return quint32(p[0]) | quint32(p[1]) << 8;
+}
+
+static inline quint32 readLe32(const uchar *p)
+{
+    return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+}
+
+static inline quint64 readLe64(const uchar *p)
+{
+    return quint64(readLe32(p)) | quint64(readLe32(p + 4)) << 32;
+}
+
+static inline bool hasTag(const uchar *p, const char *tag)
+{
+    return std::memcmp(p, tag, 4) == 0;
+}
+
+WavFile::WavFile()
+{
+}
+
+WavFile::~WavFile()
+{
+    close();
+}
+
+bool WavFile::fail(const QString &error)
+{
+    close();
+    m_errorString = error;
+    return false;
+}
+
+bool WavFile::parseFmt(const uchar *data, int size, Format *format)
+{
+    if (size < 16)
+        return false;
+
+    quint32 tag = readLe16(data);
+    const int channels = int(readLe16(data + 2));
+    const int sampleRate = int(readLe32(data + 4));
+    const int blockAlign = int(readLe16(data + 12));
+    const int containerBits = int(readLe16(data + 14));
+    int sampleBits = containerBits;
+
+    ///WAVE_FORMAT_EXTENSIBLE: настоящий формат — в первых байтах GUID подформата
+    if (tag == 0xFFFE) {
+        if (size < 40)
+            return false;
+        if (readLe16(data + 18))
+            sampleBits = int(readLe16(data + 18));
+        tag = readLe16(data + 24);
+    }
+
+    Format result;
+    if (tag == 1)
+        result.sampleType = containerBits == 8 ? UnsignedInt : SignedInt;
+    else if (tag == 3)
+        result.sampleType = Float;
+    else
+        return false;
+
+    const bool integer = result.sampleType != Float;
+    const bool validContainer = integer ? (containerBits == 8 || containerBits == 16 || containerBits == 24 || containerBits == 32)
+                                        : (containerBits == 32 || containerBits == 64);
+    if (!validContainer || channels <= 0 || sampleRate <= 0 || sampleBits <= 0 || sampleBits > containerBits
+            || blockAlign != channels * containerBits / 8)
+        return false;
+
+    result.channels = channels;
+    result.sampleRate = sampleRate;
+    result.sampleBits = sampleBits;
+    result.containerBits = containerBits;
+    result.blockAlign = blockAlign;
+    *format = result;
+    return true;
+}
+
+///Заголовки чанков читаются по одному: у BWF перед data бывают bext
+///и LIST на десятки килобайт, читать их целиком незачем
+bool WavFile::open(const QString &fileName)
+{
+    close();
+    m_errorString.clear();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return fail(m_file.errorString());
+
+    const qint64 fileSize = m_file.size();
+    uchar header[12];
+    if (m_file.read(reinterpret_cast<char *>(header), 12) != 12)
+        return fail(QCoreApplication::translate("WavFile", "File is too short"));
+
+    const bool rf64 = hasTag(header, "RF64") || hasTag(header, "BW64");
+    if ((!rf64 && !hasTag(header, "RIFF")) || !hasTag(header + 8, "WAVE"))
+        return fail(QCoreApplication::translate("WavFile", "Not a WAV file"));
+
+    quint64 ds64DataSize = 0;
+    bool hasFormat = false;
+    qint64 offset = 12;
+    while (offset + 8 <= fileSize) {
+        uchar chunk[8];
+        if (!m_file.seek(offset) || m_file.read(reinterpret_cast<char *>(chunk), 8) != 8)
+            break;
+        quint64 size = readLe32(chunk + 4);
+        const qint64 body = offset + 8;
+
+        if (hasTag(chunk, "ds64")) {
+            uchar ds64[24];
+            if (size < 24 || m_file.read(reinterpret_cast<char *>(ds64), 24) != 24)
+                return fail(QCoreApplication::translate("WavFile", "RF64 ds64 chunk is invalid"));
+            ds64DataSize = readLe64(ds64 + 8);
+        } else if (hasTag(chunk, "fmt ")) {
+            uchar fmt[40];
+            const int length = int(qMin<quint64>(size, sizeof(fmt)));
+            if (m_file.read(reinterpret_cast<char *>(fmt), length) != length || !parseFmt(fmt, length, &m_format))
+                return fail(QCoreApplication::translate("WavFile", "Unsupported WAV sample format"));
+            hasFormat = true;
+        } else if (hasTag(chunk, "data")) {
+            if (!hasFormat)
+                return fail(QCoreApplication::translate("WavFile", "WAV data chunk comes before the fmt chunk"));
+
+            ///Размер больше 4 ГБ: в RF64 он лежит в ds64, а в RIFF поле
+            ///переполнено или забито 0xFFFFFFFF — тогда данные идут до конца файла
+            if (rf64 && size == 0xFFFFFFFFu)
+                size = ds64DataSize;
+            else if (!rf64 && (size == 0xFFFFFFFFu || fileSize - body > qint64(0xFFFFFFFFu)))
+                size = quint64(fileSize - body);
+            size = qMin<quint64>(size, quint64(fileSize - body));
+
+            m_dataOffset = body;
+            m_frameCount = qint64(size) / m_format.blockAlign;
+            if (m_frameCount <= 0)
+                return fail(QCoreApplication::translate("WavFile", "WAV file has no audio data"));
+            return true;
+        }
+
+        offset = body + qint64(size) + qint64(size & 1);
+    }
+
+    return fail(QCoreApplication::translate("WavFile", "WAV file has no data chunk"));
+}
+
+void WavFile::close()
+{
+    unmapWindow();
+    if (m_file.isOpen())
+        m_file.close();
+    m_format = Format();
+    m_dataOffset = 0;
+    m_frameCount = 0;
+}
+
+void WavFile::unmapWindow()
+{
+    if (m_window)
+        m_file.unmap(m_window);
+    m_window = nullptr;
+    m_windowFirst = 0;
+    m_windowFrames = 0;
+}
+
+const uchar *WavFile::map(qint64 frame, qint64 maxFrames, qint64 *frames)
+{
+    *frames = 0;
+    if (!isOpen() || frame < 0 || frame >= m_frameCount || maxFrames <= 0)
+        return nullptr;
+
+    if (!m_window || frame < m_windowFirst || frame >= m_windowFirst + m_windowFrames) {
+        unmapWindow();
+        const qint64 count = qMin(qMax<qint64>(1, WindowSize / m_format.blockAlign), m_frameCount - frame);
+        m_window = m_file.map(m_dataOffset + frame * m_format.blockAlign, count * m_format.blockAlign);
+        if (!m_window)
+            return nullptr;
+        m_windowFirst = frame;
+        m_windowFrames = count;
+
+#ifdef Q_OS_UNIX
+        ///Окно читается подряд: ядро может подкачивать страницы заранее
+        const quintptr page = quintptr(sysconf(_SC_PAGESIZE));
+        const quintptr start = quintptr(m_window) & ~(page - 1);
+        posix_madvise(reinterpret_cast<void *>(start), size_t(quintptr(m_window) - start + quintptr(count * m_format.blockAlign)),
+                      POSIX_MADV_SEQUENTIAL);
+#endif
+    }
+
+    *frames = qMin(maxFrames, m_windowFirst + m_windowFrames - frame);
+    return m_window + (frame - m_windowFirst) * m_format.blockAlign;
+}
+
+bool WavFile::convertToFloat(const uchar *data, const Format &format, qint64 frames, float *out)
+{
+    const qint64 samples = frames * format.channels;
+
+    switch (format.sampleType) {
+    case UnsignedInt:
+        for (qint64 i = 0; i < samples; ++i)
+            out[i] = float(int(data[i]) - 128) * (1.0f / 128);
+        return true;
+
+    case SignedInt:
+        if (format.containerBits == 16) {
+            for (qint64 i = 0; i < samples; ++i, data += 2)
+                out[i] = float(qint16(quint16(readLe16(data)))) * (1.0f / 32768);
+        } else if (format.containerBits == 24) {
+            for (qint64 i = 0; i < samples; ++i, data += 3)
+                out[i] = float(qint32(quint32(data[0]) << 8 | quint32(data[1]) << 16 | quint32(data[2]) << 24)) * (1.0f / 2147483648.0f);
+        } else if (format.containerBits == 32) {
+            for (qint64 i = 0; i < samples; ++i, data += 4)
+                out[i] = float(qint32(readLe32(data))) * (1.0f / 2147483648.0f);
+        } else {
+            return false;
+        }
+        return true;
+
+    case Float:
+        for (qint64 i = 0; i < samples; ++i) {
+            if (format.containerBits == 32) {
+                std::memcpy(&out[i], data + i * 4, 4);
+            } else {
+                double value;
+                std::memcpy(&value, data + i * 8, 8);
+                out[i] = float(value);
+            }
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
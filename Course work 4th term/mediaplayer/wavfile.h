@@ -0,0 +1,76 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <QFile>
+#include <QString>
+
+///Файл WAV, BWF или RF64/BW64, открытый для чтения отображением в память.
+///Заголовок разбирается по чанкам: размеры больше 4 ГБ берутся из ds64,
+///у RIFF с переполненным размером data данные считаются до конца файла.
+///Отсчёты не копируются: map() отдаёт указатель на кадры прямо в окне
+///отображения, окно сдвигается по файлу, поэтому и в 32-битной сборке
+///не нужно отображать весь файл целиком
+class WavFile
+{
+public:
+    enum SampleType {
+        Unknown = 0,
+        UnsignedInt,
+        SignedInt,
+        Float
+    };
+
+    struct Format
+    {
+        SampleType sampleType = Unknown;
+        int channels = 0;
+        int sampleRate = 0;
+        int sampleBits = 0;     // значащие биты
+        int containerBits = 0;  // биты в контейнере отсчёта
+        int blockAlign = 0;     // байт на кадр
+    };
+
+    ///Окно отображения; кадры в окне не разрезаются границей
+    static const qint64 WindowSize = 32 * 1024 * 1024;
+
+private:
+    QFile m_file;
+    Format m_format;
+    qint64 m_dataOffset = 0;
+    qint64 m_frameCount = 0;
+
+    uchar *m_window = nullptr;
+    qint64 m_windowFirst = 0;   // первый кадр окна
+    qint64 m_windowFrames = 0;
+    QString m_errorString;
+
+    bool fail(const QString &error);
+    void unmapWindow();
+
+public:
+    WavFile();
+    ~WavFile();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    QString fileName() const { return m_file.fileName(); }
+    QString errorString() const { return m_errorString; }
+
+    const Format &format() const { return m_format; }
+    qint64 frameCount() const { return m_frameCount; }
+    qint64 dataOffset() const { return m_dataOffset; }
+
+    ///Указатель на кадр frame и число кадров подряд за ним (не больше maxFrames);
+    ///nullptr, если кадр за концом данных или отобразить не удалось
+    const uchar *map(qint64 frame, qint64 maxFrames, qint64 *frames);
+
+    ///Разбор тела чанка fmt (в том числе WAVE_FORMAT_EXTENSIBLE)
+    static bool parseFmt(const uchar *data, int size, Format *format);
+
+    ///Приводит кадры к float в диапазоне [-1, 1) с тем же числом каналов
+    static bool convertToFloat(const uchar *data, const Format &format, qint64 frames, float *out);
+};
+
+#endif // WAVFILE_H
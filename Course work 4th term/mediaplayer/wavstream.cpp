@@ -0,0 +1,374 @@
+#include "wavstream.h"
+
+#include <QAudioDeviceInfo>
+#include <QAudioOutput>
+#include <QMetaMethod>
+#include <QtMath>
+#include <cstring>
+
+#include "trace.h"
+
+WavStream::WavStream(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(PeriodMs);
+    connect(&m_timer, &QTimer::timeout, this, &WavStream::feed);
+}
+
+WavStream::~WavStream()
+{
+    close();
+}
+
+bool WavStream::convertToInt16(const uchar *data, const WavFile::Format &format, qint64 frames, qint16 *out)
+{
+    const qint64 samples = frames * format.channels;
+
+    switch (format.sampleType) {
+    case WavFile::UnsignedInt:
+        for (qint64 i = 0; i < samples; ++i)
+            out[i] = qint16((int(data[i]) - 128) * 256);
+        return true;
+
+    case WavFile::SignedInt:
+        if (format.containerBits == 16) {
+            for (qint64 i = 0; i < samples; ++i, data += 2)
+                out[i] = qint16(quint16(data[0] | data[1] << 8));
+        } else if (format.containerBits == 24) {
+            for (qint64 i = 0; i < samples; ++i, data += 3)
+                out[i] = qint16(quint16(data[1] | data[2] << 8));
+        } else if (format.containerBits == 32) {
+            for (qint64 i = 0; i < samples; ++i, data += 4)
+                out[i] = qint16(quint16(data[2] | data[3] << 8));
+        } else {
+            return false;
+        }
+        return true;
+
+    case WavFile::Float:
+        for (qint64 i = 0; i < samples; ++i) {
+            double value;
+            if (format.containerBits == 32) {
+                float sample;
+                std::memcpy(&sample, data + i * 4, 4);
+                value = sample;
+            } else {
+                std::memcpy(&value, data + i * 8, 8);
+            }
+            out[i] = qint16(qRound(qBound(-1.0, value, 1.0) * 32767.0));
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+///Сначала пробуется формат файла как есть, затем Int16 с той же частотой и каналами.
+///Частоту не меняем: такой файл пусть играет QMediaPlayer
+bool WavStream::open(const QString &fileName)
+{
+    TRACE_SCOPE("audio", "WavStream::open");
+    close();
+    if (!m_file.open(fileName))
+        return false;
+
+    const WavFile::Format &source = m_file.format();
+    QAudioFormat format;
+    format.setSampleRate(source.sampleRate);
+    format.setChannelCount(source.channels);
+    format.setSampleSize(source.containerBits);
+    format.setCodec("audio/pcm");
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setSampleType(source.sampleType == WavFile::Float ? QAudioFormat::Float
+                         : source.sampleType == WavFile::UnsignedInt ? QAudioFormat::UnSignedInt
+                         : QAudioFormat::SignedInt);
+
+    const QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+    m_convert = !device.isFormatSupported(format);
+    if (m_convert) {
+        format.setSampleSize(16);
+        format.setSampleType(QAudioFormat::SignedInt);
+        if (!device.isFormatSupported(format)) {
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_limiting = source.sampleType == WavFile::Float && source.channels <= Dynamics::Channels;
+    m_format = format;
+    m_outputFrameBytes = format.bytesPerFrame();
+    m_scratch.resize(m_convert || m_limiting ? format.bytesForDuration(BufferMs * 1000) : 0);
+    if (m_limiting) {
+        m_dynamics.configure(source.sampleRate);
+        m_samples.resize(format.framesForDuration(BufferMs * 1000) * Dynamics::Channels);
+    }
+
+    m_output = new QAudioOutput(device, format, this);
+    m_output->setBufferSize(format.bytesForDuration(BufferMs * 1000));
+    m_output->setVolume(m_volume / 100.0);
+    connect(m_output, &QAudioOutput::stateChanged, this, &WavStream::outputStateChanged);
+
+    m_frame = 0;
+    m_reportedTick = -1;
+    emit durationChanged(duration());
+    emit mediaStatusChanged(QMediaPlayer::LoadedMedia);
+    reportPosition();
+    return true;
+}
+
+void WavStream::close()
+{
+    if (!m_output)
+        return;
+
+    stop();
+    delete m_output;
+    m_output = nullptr;
+    m_file.close();
+    m_scratch.clear();
+    m_samples.clear();
+    m_limiting = false;
+    m_frame = 0;
+    emit mediaStatusChanged(QMediaPlayer::NoMedia);
+}
+
+void WavStream::setState(QMediaPlayer::State state)
+{
+    if (m_state == state)
+        return;
+    m_state = state;
+    emit stateChanged(state);
+}
+
+void WavStream::startOutput()
+{
+    if (m_limiting)
+        m_dynamics.reset();
+    m_device = m_output->start();
+    feed();
+}
+
+qint64 WavStream::bufferedFrames() const
+{
+    if (!m_device)
+        return 0;
+    return qMax(0, m_output->bufferSize() - m_output->bytesFree()) / m_outputFrameBytes;
+}
+
+///Лимитер задерживает звук на latencyFrames() кадров, поэтому после конца файла
+///в вывод дописывается ещё столько же кадров
+qint64 WavStream::endFrame() const
+{
+    return m_file.frameCount() + (m_limiting ? m_dynamics.latencyFrames() : 0);
+}
+
+qint64 WavStream::framePosition() const
+{
+    const qint64 delay = m_limiting ? m_dynamics.latencyFrames() : 0;
+    return qMax<qint64>(0, m_frame - bufferedFrames() - delay);
+}
+
+qint64 WavStream::duration() const
+{
+    return m_file.isOpen() ? m_file.frameCount() * 1000 / m_file.format().sampleRate : 0;
+}
+
+qint64 WavStream::position() const
+{
+    return m_file.isOpen() ? framePosition() * 1000 / m_file.format().sampleRate : 0;
+}
+
+///Как и UiRefreshClock, сообщает о позиции только при смене отображаемого значения
+void WavStream::reportPosition()
+{
+    const qint64 current = position();
+    if (current / 100 == m_reportedTick)
+        return;
+    m_reportedTick = current / 100;
+    emit positionChanged(current);
+}
+
+void WavStream::play()
+{
+    if (!m_output || m_state == QMediaPlayer::PlayingState)
+        return;
+
+    if (m_state == QMediaPlayer::PausedState)
+        m_output->resume();
+    else
+        startOutput();
+    m_timer.start();
+    setState(QMediaPlayer::PlayingState);
+}
+
+void WavStream::pause()
+{
+    if (m_state != QMediaPlayer::PlayingState)
+        return;
+
+    m_timer.stop();
+    m_output->suspend();
+    setState(QMediaPlayer::PausedState);
+}
+
+void WavStream::stop()
+{
+    if (m_state == QMediaPlayer::StoppedState)
+        return;
+
+    m_timer.stop();
+    m_state = QMediaPlayer::StoppedState;
+    m_output->stop();
+    m_device = nullptr;
+    m_frame = 0;
+    emit stateChanged(m_state);
+    reportPosition();
+}
+
+void WavStream::setPosition(qint64 position)
+{
+    if (m_file.isOpen())
+        setFramePosition(position * m_file.format().sampleRate / 1000);
+}
+
+///Буфер вывода сбрасывается, следующая запись начинается ровно с кадра frame
+void WavStream::setFramePosition(qint64 frame)
+{
+    if (!m_output)
+        return;
+
+    m_frame = qBound<qint64>(0, frame, m_file.frameCount());
+    if (m_state != QMediaPlayer::StoppedState) {
+        m_output->stop();
+        startOutput();
+        if (m_state == QMediaPlayer::PausedState)
+            m_output->suspend();
+    }
+    m_reportedTick = -1;
+    reportPosition();
+}
+
+void WavStream::setVolume(int volume)
+{
+    m_volume = qBound(0, volume, 100);
+    if (m_output)
+        m_output->setVolume(m_volume / 100.0);
+}
+
+///Кадры файла, а после его конца тишина (data == nullptr), проходят через лимитер
+///и пишутся в out в формате вывода: float или double, как в файле, либо Int16
+void WavStream::limit(const uchar *data, qint64 frames, char *out)
+{
+    const WavFile::Format &source = m_file.format();
+    const int bytes = source.containerBits / 8;
+    float *samples = m_samples.data();
+
+    for (qint64 i = 0; i < frames; ++i) {
+        for (int c = 0; c < Dynamics::Channels; ++c) {
+            float value = 0.0f;
+            if (data) {
+                ///Моно дублируется в оба канала лимитера
+                const uchar *sample = data + i * source.blockAlign + qMin(c, source.channels - 1) * bytes;
+                if (bytes == 4) {
+                    std::memcpy(&value, sample, 4);
+                } else {
+                    double wide;
+                    std::memcpy(&wide, sample, 8);
+                    value = float(wide);
+                }
+            }
+            samples[i * Dynamics::Channels + c] = value;
+        }
+    }
+
+    m_dynamics.process(samples, int(frames));
+
+    for (qint64 i = 0; i < frames; ++i) {
+        for (int c = 0; c < source.channels; ++c) {
+            const float value = samples[i * Dynamics::Channels + c];
+            const qint64 index = i * source.channels + c;
+            if (m_convert) {
+                reinterpret_cast<qint16 *>(out)[index] = qint16(qRound(qBound(-1.0f, value, 1.0f) * 32767.0f));
+            } else if (bytes == 4) {
+                std::memcpy(out + index * 4, &value, 4);
+            } else {
+                const double wide = value;
+                std::memcpy(out + index * 8, &wide, 8);
+            }
+        }
+    }
+}
+
+///Дописывает в вывод столько целых кадров, сколько в нём свободно.
+///Без преобразования в устройство уходит указатель прямо в отображение файла
+void WavStream::feed()
+{
+    if (!m_device)
+        return;
+
+    TRACE_SCOPE("audio", "WavStream::feed");
+    const WavFile::Format &source = m_file.format();
+    qint64 freeFrames = m_output->bytesFree() / m_outputFrameBytes;
+
+    static const QMetaMethod probedSignal = QMetaMethod::fromSignal(&WavStream::audioBufferProbed);
+    const bool probed = isSignalConnected(probedSignal);
+    QByteArray probe;
+
+    while (freeFrames > 0 && m_frame < endFrame()) {
+        qint64 frames = 0;
+        const uchar *data = nullptr;
+        if (m_frame < m_file.frameCount()) {
+            data = m_file.map(m_frame, freeFrames, &frames);
+            if (!data)
+                break;
+        } else {
+            frames = qMin(freeFrames, endFrame() - m_frame);
+        }
+
+        const char *out = reinterpret_cast<const char *>(data);
+        if (m_limiting) {
+            frames = qMin<qint64>(frames, m_samples.size() / Dynamics::Channels);
+            limit(data, frames, m_scratch.data());
+            out = m_scratch.constData();
+        } else if (m_convert) {
+            frames = qMin<qint64>(frames, m_scratch.size() / m_outputFrameBytes);
+            convertToInt16(data, source, frames, reinterpret_cast<qint16 *>(m_scratch.data()));
+            out = m_scratch.constData();
+        }
+
+        const qint64 written = m_device->write(out, frames * m_outputFrameBytes) / m_outputFrameBytes;
+        if (written <= 0)
+            break;
+        m_frame += written;
+        freeFrames -= written;
+
+        ///Окно отображения может смениться на следующем шаге, поэтому копия снимается сразу
+        if (probed) {
+            const qint64 bytes = written * m_outputFrameBytes;
+            const int tail = int(qMin<qint64>(bytes, m_format.bytesForDuration(PeriodMs * 1000)));
+            probe = QByteArray(out + bytes - tail, tail);
+        }
+    }
+
+    if (!probe.isEmpty())
+        emit audioBufferProbed(QAudioBuffer(probe, m_format));
+
+    reportPosition();
+}
+
+///Вывод опустел: при дописанном до конца файле это конец трека, иначе недогрузка
+void WavStream::outputStateChanged()
+{
+    if (!m_output || m_state != QMediaPlayer::PlayingState || m_output->state() != QAudio::IdleState)
+        return;
+
+    if (m_frame < endFrame()) {
+        feed();
+        return;
+    }
+
+    stop();
+    emit mediaStatusChanged(QMediaPlayer::EndOfMedia);
+}
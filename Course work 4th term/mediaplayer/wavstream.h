@@ -0,0 +1,109 @@
+#ifndef WAVSTREAM_H
+#define WAVSTREAM_H
+
+#include <QAudioBuffer>
+#include <QAudioFormat>
+#include <QMediaPlayer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "dynamics.h"
+#include "wavfile.h"
+
+QT_FORWARD_DECLARE_CLASS(QAudioOutput)
+QT_FORWARD_DECLARE_CLASS(QIODevice)
+
+///Собственное воспроизведение WAV/BWF/RF64 мимо бэкенда QMediaPlayer.
+///Файл отображён в память (WavFile), таймер дописывает в QAudioOutput
+///ровно столько кадров, сколько в его буфере свободно. Если устройство
+///принимает формат файла как есть, в вывод пишется указатель прямо
+///в отображение, без промежуточных буферов и преобразований; иначе
+///отсчёты приводятся к Int16 в заранее выделенный буфер.
+///Отсчёты с плавающей точкой могут выходить за полную шкалу, поэтому
+///моно и стерео такого файла идут через лимитер (Dynamics) и пишутся
+///в формате вывода; целые отсчёты шкалу не превышают и ограничения не требуют.
+///Позиция считается в кадрах, поэтому перемотка точна до отсчёта.
+///Состояния и сигналы повторяют QMediaPlayer, чтобы окно переключалось
+///между ними без отдельной логики
+class WavStream : public QObject
+{
+    Q_OBJECT
+
+private:
+    WavFile m_file;
+    QAudioFormat m_format;
+    bool m_convert = false;
+    int m_outputFrameBytes = 0;
+    QByteArray m_scratch;
+    bool m_limiting = false;        // отсчёты идут через m_dynamics
+    Dynamics m_dynamics;
+    QVector<float> m_samples;       // float-стерео для лимитера
+
+    QAudioOutput *m_output = nullptr;
+    QIODevice *m_device = nullptr;
+    QTimer m_timer;
+
+    QMediaPlayer::State m_state = QMediaPlayer::StoppedState;
+    qint64 m_frame = 0;             // следующий кадр для записи в вывод
+    qint64 m_reportedTick = -1;     // позиция в десятых секунды, о которой уже сообщено
+    int m_volume = 100;
+
+    void setState(QMediaPlayer::State state);
+    void startOutput();
+    qint64 bufferedFrames() const;
+    qint64 endFrame() const;
+    void limit(const uchar *data, qint64 frames, char *out);
+    void reportPosition();
+
+private slots:
+    void feed();
+    void outputStateChanged();
+
+public:
+    ///Период подкачки и объём буфера вывода
+    static const int PeriodMs = 10;
+    static const int BufferMs = 100;
+
+    explicit WavStream(QObject *parent = nullptr);
+    ~WavStream();
+
+    ///false, если файл не WAV или устройство не примет ни его формат, ни Int16
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return m_output != nullptr; }
+
+    QMediaPlayer::State state() const { return m_state; }
+    QAudioFormat format() const { return m_format; }
+    bool isZeroCopy() const { return isOpen() && !m_convert && !m_limiting; }
+    bool isLimiting() const { return isOpen() && m_limiting; }
+    Dynamics *dynamics() { return &m_dynamics; }
+
+    qint64 frameCount() const { return m_file.frameCount(); }
+    qint64 framePosition() const;
+    qint64 duration() const;
+    qint64 position() const;
+
+    ///Приводит кадры к Int16 с тем же числом каналов; false для формата, который не поддержан
+    static bool convertToInt16(const uchar *data, const WavFile::Format &format, qint64 frames, qint16 *out);
+
+public slots:
+    void play();
+    void pause();
+    void stop();
+    void setPosition(qint64 position);
+    void setFramePosition(qint64 frame);
+    void setVolume(int volume);
+
+signals:
+    void stateChanged(QMediaPlayer::State state);
+    void mediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void durationChanged(qint64 duration);
+    void positionChanged(qint64 position);
+
+    ///Копия только что записанного периода для индикаторов уровня;
+    ///копируется, только если к сигналу кто-то подключён
+    void audioBufferProbed(const QAudioBuffer &buffer);
+};
+
+#endif // WAVSTREAM_H
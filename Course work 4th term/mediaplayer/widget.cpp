@@ -1,9 +1,18 @@
 #include <QAudioProbe>
+#include <QFileInfo>
+#include <QMimeData>
+#include <QNetworkRequest>
+#include <QPainter>
+#include <QScreen>
+#include <QShortcut>
+#include <QWindow>
 
 #include "widget.h"
 #include "ui_widget.h"
 #include "player.h"
 #include "histogramwidget.h"
+#include "startuptimeline.h"
+#include "trace.h"
 
 Widget::Widget(QWidget *parent) :
     QWidget(parent),
@@ -11,44 +20,22 @@ Widget::Widget(QWidget *parent) :
     m_leftMouseButtonPressed(None)
 {
     ui->setupUi(this);
+    StartupTimeline::mark("Widget::setupUi");
 
     /// Настройка UI
     this->setWindowFlags(Qt::FramelessWindowHint);      // Отключаем оформление окна
     this->setAttribute(Qt::WA_TranslucentBackground);   // Делаем фон главного виджета прозрачным
-    this->setStyleSheet(Style::getWindowStyleSheet());    // Устанавливаем стиль виджета
     this->setMouseTracking(true);   // Включаем отслеживание курсора без нажатых кнопок
 
-    /// Создаём эффект тени
-    QGraphicsDropShadowEffect *shadowEffect = new QGraphicsDropShadowEffect(this);
-    shadowEffect->setBlurRadius(9); // Устанавливаем радиус размытия
-    shadowEffect->setOffset(0);     // Устанавливаем смещение тени
-    ui->widgetInterface->setGraphicsEffect(shadowEffect);   // Устанавливаем эффект тени на окно
+    /// Тень рисуется в paintEvent из заранее размытой картинки
+    m_shadow.setRadius(9);                                  // Устанавливаем радиус размытия
     ui->widgetInterface->layout()->setMargin(0);            // Устанавливаем размер полей
     ui->widgetInterface->layout()->setSpacing(0);
     ui->label->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
 
 
-    /// Установка стилей для всех элементов
-    ui->currentTrack->setStyleSheet("color:#c1c1c1;");
-    ui->btn_close->setStyleSheet(Style::getCloseStyleSheet());
-    ui->btn_maximize->setStyleSheet(Style::getMaximizeStyleSheet());
-    ui->btn_minimize->setStyleSheet(Style::getMinimizeStyleSheet());
-    ui->btn_next->setStyleSheet(Style::getNextStyleSheet());
-    ui->btn_previous->setStyleSheet(Style::getPreviousStyleSheet());
-    ui->btn_stop->setStyleSheet(Style::getStopStyleSheet());
-    ui->btn_play->setStyleSheet(Style::getPlayStyleSheet());
-    ui->btn_pause->setStyleSheet(Style::getPauseStyleSheet());
-    ui->btn_add->setStyleSheet(Style::getMenuStyleSheet());
-    ui->btn_del->setStyleSheet(Style::getRemoveStyleSheet());
-    ui->btn_add->setStyleSheet(Style::getAddStyleSheet());
-    ui->btn_random->setStyleSheet(Style::getRandomStyleSheet());
-    ui->btn_music->setStyleSheet(Style::getBtnToolStyleSheet());
-    ui->btn_video->setStyleSheet(Style::getBtnToolStyleSheet());
-
-    ui->playlistView->setStyleSheet(Style::getTableViewStyleSheet());
-    ui->positionSlider->setStyleSheet(Style::getSliderStyleSheet());
-    ui->playlistView->verticalScrollBar()->setStyleSheet(Style::getVerticalScrollBarStyleSheet());
-    ui->playlistView->horizontalScrollBar()->setStyleSheet(Style::getHorizontalScrollBarStyleSheet());
+    /// Стили всех элементов заданы общей таблицей приложения (Style::applicationStyleSheet)
+    /// и выбираются по objectName из формы
 
     ui->btn_add->setToolTip("Add track");
     ui->btn_del->setToolTip("Remove track");
@@ -67,45 +54,70 @@ Widget::Widget(QWidget *parent) :
     ui->btn_pause->setCursor(Qt::PointingHandCursor);
 
 
-    m_playListModel = new QStandardItemModel(this);
+    m_playListModel = new TrackListModel(this);
     ui->playlistView->setModel(m_playListModel);
+    ui->playlistView->setDurationColumn(TrackListModel::Duration);
 
     ui->horizontalLayout->setSpacing(0);
     ui->horizontalLayout_2->setSpacing(0);
-    ui->playlistView->verticalHeader()->setVisible(false);
-
-    ui->playlistView->setSelectionBehavior(QAbstractItemView::SelectRows);
-    ui->playlistView->setSelectionMode(QAbstractItemView::SingleSelection);
-    ui->playlistView->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    ui->playlistView->horizontalHeader()->setStretchLastSection(true);
-
-
+    /// Высота строк, выделение строками и растяжение последнего столбца задаёт PlaylistView.
+    /// Выделять можно несколько строк и перетаскивать их внутри списка
+    ui->playlistView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    ui->playlistView->setDragDropMode(QAbstractItemView::InternalMove);
+    ui->playlistView->setDragDropOverwriteMode(false);
+    ui->playlistView->setDropIndicatorShown(true);
+    connect(ui->playlistView, &PlaylistView::rowsDropped, m_playListModel, &TrackListModel::moveTracks);
+
+    /// Добавляемые файлы, папки и плейлисты проверяются в пуле потоков.
+    /// Их же можно бросить на окно из файлового менеджера
+    m_importer = new TrackImporter(this);
+    connect(m_importer, &TrackImporter::tracksAccepted, m_playListModel, &TrackListModel::appendTracks);
+    connect(m_importer, &TrackImporter::finished, this, &Widget::importFinished);
+    setAcceptDrops(true);
+
+
+    /// Плейлист ведёт TrackListModel, порядок — PlaybackOrder, плеер получает только текущий трек
     m_player = new QMediaPlayer(this);
-    m_playlist = new QMediaPlaylist(m_player);
-    m_player->setPlaylist(m_playlist);
+    m_order.setLoop(true);
 
-    m_playlist->setPlaybackMode(QMediaPlaylist::Loop);
+    /// WAV, BWF и RF64 играются из отображённого в память файла мимо бэкенда плеера
+    m_wavStream = new WavStream(this);
+    StartupTimeline::mark("Widget media player");
 
-    connect(ui->btn_previous, &QToolButton::clicked, m_playlist, &QMediaPlaylist::previous);
-    connect(ui->btn_next, &QToolButton::clicked, m_playlist, &QMediaPlaylist::next);
-    connect(ui->btn_play, &QToolButton::clicked, m_player, &QMediaPlayer::play);
-    connect(ui->btn_pause, &QToolButton::clicked, m_player, &QMediaPlayer::pause);
-    connect(ui->btn_stop, &QToolButton::clicked, m_player, &QMediaPlayer::stop);
-    connect(ui->btn_del, &QToolButton::clicked, m_player, &QMediaPlayer::stop);
+    connect(m_playListModel, &QAbstractItemModel::rowsInserted, [this](const QModelIndex &, int start, int end){
+        m_order.insert(start, end - start + 1);});
+    connect(m_playListModel, &QAbstractItemModel::rowsRemoved, [this](const QModelIndex &, int start, int end){
+        m_order.remove(start, end - start + 1);});
+    connect(m_playListModel, &TrackListModel::tracksMoved, [this](const QVector<int> &rows, int destination){
+        m_order.move(rows, destination);});
+    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &Widget::advancePlayback, Qt::QueuedConnection);
+    connect(m_wavStream, &WavStream::mediaStatusChanged, this, &Widget::advancePlayback, Qt::QueuedConnection);
+
+    connect(ui->btn_previous, &QToolButton::clicked, this, &Widget::playPrevious);
+    connect(ui->btn_next, &QToolButton::clicked, this, &Widget::playNext);
+    connect(ui->btn_play, &QToolButton::clicked, this, &Widget::play);
+    connect(ui->btn_pause, &QToolButton::clicked, this, &Widget::pause);
+    connect(ui->btn_stop, &QToolButton::clicked, this, &Widget::stop);
+    connect(ui->btn_del, &QToolButton::clicked, this, &Widget::stop);
 
 
     /// Устанавливаем громкость воспроизведения треков
     m_volumeButton = new VolumeButton(this);
     m_volumeButton->setToolTip(tr("Volume"));
     m_volumeButton->setVolume(m_player->volume());
-    m_volumeButton->setStyleSheet("QToolButton::menu-indicator{image:none;}");
     connect(m_volumeButton, &VolumeButton::volumeChanged, m_player, &QMediaPlayer::setVolume);
+    m_wavStream->setVolume(m_player->volume());
+    connect(m_volumeButton, &VolumeButton::volumeChanged, m_wavStream, &WavStream::setVolume);
     ui->gridLayout_3->addWidget(m_volumeButton,0,0);
 
 
     ///Устанавливаем перемотку треков и время вопроизыведения
-    connect(m_player, &QMediaPlayer::positionChanged, this, &Widget::updatePosition);
+    m_refreshClock = UiRefreshClock::instance();
+    m_refreshClock->watch(m_player);
+    connect(m_refreshClock, &UiRefreshClock::positionChanged, this, &Widget::clockPositionChanged);
     connect(m_player, &QMediaPlayer::durationChanged, this, &Widget::updateDuration);
+    connect(m_wavStream, &WavStream::positionChanged, this, &Widget::updatePosition);
+    connect(m_wavStream, &WavStream::durationChanged, this, &Widget::updateDuration);
     connect(ui->positionSlider, &QAbstractSlider::valueChanged, this, &Widget::setPosition);
 
 
@@ -113,11 +125,11 @@ Widget::Widget(QWidget *parent) :
     connect(ui->btn_minimize, &QToolButton::clicked, this, &QWidget::showMinimized);
     connect(ui->btn_maximize, &QToolButton::clicked, [this](){
         if (this->isMaximized()) {
-            ui->btn_maximize->setStyleSheet(Style::getMaximizeStyleSheet());
+            Style::setState(ui->btn_maximize, "maximized", false);
             this->layout()->setMargin(9);
             this->showNormal();
         } else {
-            ui->btn_maximize->setStyleSheet(Style::getRestoreStyleSheet());
+            Style::setState(ui->btn_maximize, "maximized", true);
             this->layout()->setMargin(0);
             this->showMaximized();
         }
@@ -126,15 +138,9 @@ Widget::Widget(QWidget *parent) :
     connect(ui->btn_close, &QToolButton::clicked, this, &QWidget::close);
 
     connect(ui->playlistView, &QTableView::doubleClicked, [this](const QModelIndex &index){
-        m_playlist->setCurrentIndex(index.row());});
-
-    connect(m_playlist, &QMediaPlaylist::currentIndexChanged, [this](int index){
-        ui->currentTrack->setText(m_playListModel->data(m_playListModel->index(index, 0)).toString());});
-
-    connect(m_playlist, &QMediaPlaylist::currentIndexChanged, [this](int index){
-        ui->playlistView->selectRow(index);});
+        setCurrentRow(index.row());});
 
-    m_audioProbe = new QAudioProbe(this);
+    ///Пробник создаётся при первом воспроизведении, поток гистограммы — при первом кадре
     m_audioHistogram = new HistogramWidget(this);
 
     QHBoxLayout *histogramLayout = new QHBoxLayout;
@@ -143,8 +149,8 @@ Widget::Widget(QWidget *parent) :
     ui->horizontalLayout_6->addLayout(histogramLayout);
     ui->horizontalLayout_6->setSpacing(0);
 
-    connect(m_audioProbe, &QAudioProbe::audioBufferProbed, m_audioHistogram, &HistogramWidget::processBuffer);
-    m_audioProbe->setSource(m_player);
+    connect(m_player, &QMediaPlayer::stateChanged, this, &Widget::attachProbe);
+    connect(m_wavStream, &WavStream::audioBufferProbed, m_audioHistogram, &HistogramWidget::processBuffer);
 
     ui->positionSlider->setVisible(false);
     ui->positionLabel->setVisible(false);
@@ -162,13 +168,33 @@ Widget::Widget(QWidget *parent) :
     ui->currentTrack->setText("");
 
     setWindowTitle("Audio Player");
+
+    /// Перемещение и изменение размеров окна применяются не чаще частоты обновления экрана
+    m_geometryTimer.setSingleShot(true);
+    m_geometryTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_geometryTimer, &QTimer::timeout, this, &Widget::applyPendingGeometry);
+
+    QShortcut *timelineShortcut = new QShortcut(QKeySequence("Ctrl+Shift+T"), this);
+    connect(timelineShortcut, &QShortcut::activated, [](){ StartupTimeline::dump(); });
+
+    ///Панель замеров производительности и запись трассы для chrome://tracing
+    PerformanceMonitor *monitor = PerformanceMonitor::instance();
+    monitor->watchPaint(m_audioHistogram, "histogram");
+    monitor->watchPaint(ui->playlistView->viewport(), "playlist");
+    connect(m_player, &QMediaPlayer::bufferStatusChanged, monitor, [monitor](int percent){
+        monitor->recordBufferFill("audio", percent);});
+
+    m_hud = new PerformanceHud(this);
+    QShortcut *hudShortcut = new QShortcut(QKeySequence("Ctrl+Shift+H"), this);
+    connect(hudShortcut, &QShortcut::activated, m_hud, &PerformanceHud::toggle);
+    QShortcut *traceShortcut = new QShortcut(QKeySequence("Ctrl+Shift+R"), this);
+    connect(traceShortcut, &QShortcut::activated, monitor, &PerformanceMonitor::toggleRecording);
 }
 
 Widget::~Widget()
 {
     delete ui;
     delete m_playListModel;
-    delete m_playlist;
     delete m_player;
 }
 
@@ -178,18 +204,13 @@ void Widget::on_btn_add_clicked()
     QStringList files = QFileDialog::getOpenFileNames(this,
                                                       tr("Open files"),
                                                       QString(),
-                                                      tr("Audio Files(*.wav *.mp3)"));
-
-    foreach (QString filePath, files) {
-        QList<QStandardItem *> items;
-        items.append(new QStandardItem(QDir(filePath).dirName()));
-        items.append(new QStandardItem(filePath));
-        m_playListModel->appendRow(items);
-        m_playlist->addMedia(QUrl(filePath));
-    };
+                                                      tr("Audio Files(*.wav *.mp3);;All Files(*)"));
 
-    m_playListModel->setHorizontalHeaderLabels(QStringList()  << tr("AUDIO TRACK")
-                                               << tr("FILE PATH"));
+    TRACE_SCOPE("playlist", "Widget::on_btn_add_clicked");
+    QList<QUrl> urls;
+    for (const QString &filePath : files)
+        urls.append(QUrl::fromLocalFile(filePath));
+    addToPlaylist(urls);
 }
 #endif
 
@@ -202,7 +223,8 @@ void Widget::on_btn_add_clicked()
 
     QStringList supportedMimeTypes;
     supportedMimeTypes << "audio/mp3"
-                << "audio/wav";
+                << "audio/wav"
+                << "application/octet-stream";
 
     if (!supportedMimeTypes.isEmpty()) {
         fileDialog.setMimeTypeFilters(supportedMimeTypes);
@@ -211,61 +233,181 @@ void Widget::on_btn_add_clicked()
 
 
     if (fileDialog.exec() == QDialog::Accepted) {
+        TRACE_SCOPE("playlist", "Widget::on_btn_add_clicked");
         addToPlaylist(fileDialog.selectedUrls());
-        QList<QStandardItem *> items;
-        for(auto &url: fileDialog.selectedUrls()){
-        items.append(new QStandardItem(QDir(url.toString()).dirName()));
-        items.append(new QStandardItem(url.toString()));
-        m_playListModel->appendRow(items);
-        }
     }
-    m_playListModel->setHorizontalHeaderLabels(QStringList()  << tr("AUDIO TRACK")
-                                               << tr("FILE PATH"));
 }
 #endif
 
 
-static bool isPlaylist(const QUrl &url)
+///Файлы, папки и плейлисты проверяет TrackImporter, в плейлист они попадают по его сигналу
+void Widget::addToPlaylist(const QList<QUrl> &urls)
 {
-    if (!url.isLocalFile())
-        return false;
-    const QFileInfo fileInfo(url.toLocalFile());
-    return fileInfo.exists() && !fileInfo.suffix().compare(QLatin1String("m3u"), Qt::CaseInsensitive);
+    TRACE_SCOPE("playlist", "Widget::addToPlaylist");
+    m_importer->import(urls);
 }
 
-void Widget::addToPlaylist(const QList<QUrl> &urls)
+///Неподдерживаемые и испорченные файлы перечисляются в подсказке строки текущего трека
+void Widget::importFinished(int accepted, int relabelled, const QStringList &rejected, const QStringList &reasons)
 {
-    for (auto &url: urls) {
-        if (isPlaylist(url))
-            m_playlist->load(url);
-        else
-            m_playlist->addMedia(url);
-    }
+    Q_UNUSED(relabelled);
+    if (rejected.isEmpty())
+        return;
+
+    QStringList lines;
+    for (int i = 0; i < rejected.size() && i < 20; ++i)
+        lines << QString("%1: %2").arg(QFileInfo(rejected.at(i)).fileName(), reasons.at(i));
+    if (rejected.size() > 20)
+        lines << tr("and %1 more").arg(rejected.size() - 20);
+
+    ui->currentTrack->setText(tr("Skipped %1 of %2 files").arg(rejected.size()).arg(accepted + rejected.size()));
+    ui->currentTrack->setToolTip(lines.join('\n'));
+}
+
+void Widget::dragEnterEvent(QDragEnterEvent *event)
+{
+    if (event->mimeData()->hasUrls())
+        event->acceptProposedAction();
+}
+
+void Widget::dropEvent(QDropEvent *event)
+{
+    addToPlaylist(event->mimeData()->urls());
+    event->acceptProposedAction();
 }
 
 
+///Все выделенные строки удаляются одной операцией над моделью
 void Widget::on_btn_del_clicked()
 {
-    m_playlist->removeMedia(ui->playlistView->currentIndex().row());
-    m_playListModel->removeRow(ui->playlistView->currentIndex().row());
+    QList<int> rows;
+    for (const QModelIndex &index : ui->playlistView->selectionModel()->selectedRows())
+        rows.append(index.row());
+    m_playListModel->removeTracks(rows);
     ui->currentTrack->setText("");
     clearHistogram();
 }
 
+///В режиме перемешивания следующий трек берётся из перемешанной очереди PlaybackOrder,
+///без него — по порядку, как раньше: по кругу до первого переключения, затем до конца списка
 void Widget::on_btn_random_clicked()
 {
-    static int check=4;
-    if(check%2==0)
-    {
-    ui->btn_random->setStyleSheet(Style::getSequentialStyleSheet());
-    m_playlist->setPlaybackMode(QMediaPlaylist::Random);
+    m_shuffle = !m_shuffle;
+    Style::setState(ui->btn_random, "random", m_shuffle);
+    m_order.setMode(m_shuffle ? PlaybackOrder::Shuffle : PlaybackOrder::Sequential);
+    m_order.setLoop(m_shuffle);
+}
+
+QMediaPlayer::State Widget::playbackState() const
+{
+    return m_native ? m_wavStream->state() : m_player->state();
+}
+
+///Плеер получает адрес текущего трека; если он играл, то продолжает уже с нового.
+///Локальный WAV забирает WavStream, всё остальное и WAV, который устройство
+///не примет без смены частоты, играет QMediaPlayer
+void Widget::setCurrentRow(int row)
+{
+    const bool playing = playbackState() == QMediaPlayer::PlayingState;
+    m_playListModel->setCurrentRow(row);
+    m_order.setCurrent(row);
+
+    const QUrl url = m_playListModel->url(row);
+    const QString mimeType = m_playListModel->mimeType(row);
+    const bool wave = mimeType == QLatin1String("audio/wav")
+            || (mimeType.isEmpty() && !QFileInfo(url.path()).suffix().compare(QLatin1String("wav"), Qt::CaseInsensitive));
+    m_native = url.isLocalFile() && wave && m_wavStream->open(url.toLocalFile());
+
+    if (m_native) {
+        m_player->setMedia(QMediaContent());
+    } else {
+        m_wavStream->close();
+        ///Тип по содержимому подсказывает бэкенду формат файла с чужим расширением
+        QNetworkRequest request(url);
+        if (!mimeType.isEmpty())
+            request.setHeader(QNetworkRequest::ContentTypeHeader, mimeType);
+        m_player->setMedia(row >= 0 ? QMediaContent(request) : QMediaContent());
+
+        ///Длительность из заголовков файла: ползунок готов до того, как бэкенд её сообщит
+        const qint64 duration = m_playListModel->duration(row);
+        if (duration > 0)
+            updateDuration(duration);
     }
-    else
-    {
-    ui->btn_random->setStyleSheet(Style::getRandomStyleSheet());
-    m_playlist->setPlaybackMode(QMediaPlaylist::Sequential);
+    if (playing)
+        play();
+
+    ui->currentTrack->setText(m_playListModel->title(row));
+    ui->currentTrack->setToolTip(QString());
+    ui->playlistView->selectRow(row);
+}
+
+void Widget::play()
+{
+    if (m_playListModel->currentRow() < 0) {
+        const int row = m_order.next();
+        if (row < 0)
+            return;
+        setCurrentRow(row);
     }
-    check++;
+    if (m_native)
+        m_wavStream->play();
+    else
+        m_player->play();
+}
+
+void Widget::pause()
+{
+    if (m_native)
+        m_wavStream->pause();
+    else
+        m_player->pause();
+}
+
+void Widget::stop()
+{
+    if (m_native)
+        m_wavStream->stop();
+    else
+        m_player->stop();
+}
+
+void Widget::playNext()
+{
+    const int row = m_order.next();
+    if (row >= 0)
+        setCurrentRow(row);
+}
+
+void Widget::playPrevious()
+{
+    const int row = m_order.previous();
+    if (row >= 0)
+        setCurrentRow(row);
+}
+
+///Подключён с очередью: к этому моменту плеер уже остановился на конце трека
+void Widget::advancePlayback(QMediaPlayer::MediaStatus status)
+{
+    if (status != QMediaPlayer::EndOfMedia)
+        return;
+
+    const int row = m_order.next();
+    if (row < 0)
+        return;
+    setCurrentRow(row);
+    play();
+}
+
+void Widget::attachProbe(QMediaPlayer::State state)
+{
+    if (state != QMediaPlayer::PlayingState || m_audioProbe)
+        return;
+
+    m_audioProbe = new QAudioProbe(this);
+    connect(m_audioProbe, &QAudioProbe::audioBufferProbed, m_audioHistogram, &HistogramWidget::processBuffer);
+    PerformanceMonitor::instance()->watchProbe(m_audioProbe, "audio");
+    m_audioProbe->setSource(m_player);
+    disconnect(m_player, &QMediaPlayer::stateChanged, this, &Widget::attachProbe);
 }
 
 void Widget::clearHistogram()
@@ -293,6 +435,13 @@ void Widget::mousePressEvent(QMouseEvent *event)
     if (event->button() == Qt::LeftButton ) {
         m_leftMouseButtonPressed = checkResizableField(event);
         setPreviousPosition(event->pos());
+        m_pressGlobalPosition = event->globalPos();
+        m_pressGeometry = geometry();
+        m_pendingGeometry = geometry();
+
+        QScreen *screen = windowHandle() ? windowHandle()->screen() : QGuiApplication::primaryScreen();
+        qreal refreshRate = screen ? screen->refreshRate() : 60;
+        m_geometryTimer.setInterval(qMax(1, qRound(1000 / qMax(refreshRate, qreal(1)))));
     }
     return QWidget::mousePressEvent(event);
 }
@@ -301,12 +450,23 @@ void Widget::mouseReleaseEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton) {
         m_leftMouseButtonPressed = None;
+        // Последнее положение применяем сразу, не дожидаясь таймера
+        if (m_geometryTimer.isActive()) {
+            m_geometryTimer.stop();
+            applyPendingGeometry();
+        }
     }
     return QWidget::mouseReleaseEvent(event);
 }
 
 void Widget::mouseMoveEvent(QMouseEvent *event)
 {
+    // Новая геометрия считается от положения окна в момент нажатия
+    // и глобального смещения курсора, поэтому не зависит от того,
+    // успело ли окно сдвинуться после предыдущего события мыши
+    QPoint delta = event->globalPos() - m_pressGlobalPosition;
+    QRect target = m_pressGeometry;
+
     // При перемещении мыши, проверяем статус нажатия левой кнопки мыши
     switch (m_leftMouseButtonPressed) {
     case Move: {
@@ -316,19 +476,21 @@ void Widget::mouseMoveEvent(QMouseEvent *event)
             // Необходимо вернуть окно в нормальное состояние и установить стили кнопки
             // А также путём нехитрых вычислений пересчитать позицию окна,
             // чтобы оно оказалось под курсором
-            ui->btn_maximize->setStyleSheet(Style::getMaximizeStyleSheet());
+            Style::setState(ui->btn_maximize, "maximized", false);
             this->layout()->setMargin(9);
             auto part = event->screenPos().x() / width();
             this->showNormal();
             auto offsetX = width() * part;
             setGeometry(event->screenPos().x() - offsetX, 0, width(), height());
             setPreviousPosition(QPoint(offsetX, event->y()));
+            m_pressGlobalPosition = event->globalPos();
+            m_pressGeometry = geometry();
+            m_pendingGeometry = geometry();
         } else {
             // Если окно не максимизировано, то просто перемещаем его относительно
-            // последней запомненной позиции, пока не отпустим кнопку мыши
-            auto dx = event->x() - m_previousPosition.x();
-            auto dy = event->y() - m_previousPosition.y();
-            setGeometry(x() + dx, y() + dy, width(), height());
+            // запомненной при нажатии позиции, пока не отпустим кнопку мыши
+            target.translate(delta);
+            scheduleGeometry(target);
         }
         break;
     }
@@ -336,31 +498,29 @@ void Widget::mouseMoveEvent(QMouseEvent *event)
         // Для изменения размеров также проверяем на максимизацию
         // поскольку мы же не можем изменить размеры у максимизированного окна
         if (!isMaximized()) {
-        auto dy = event->y() - m_previousPosition.y();
-        setGeometry(x(), y() + dy, width(), height() - dy);
+            target.setTop(qMin(target.top() + delta.y(), target.bottom() - minimumHeight()));
+            scheduleGeometry(target);
         }
         break;
     }
     case Bottom: {
         if (!isMaximized()) {
-            auto dy = event->y() - m_previousPosition.y();
-            setGeometry(x(), y(), width(), height() + dy);
-            setPreviousPosition(event->pos());
+            target.setBottom(target.bottom() + delta.y());
+            scheduleGeometry(target);
         }
         break;
     }
     case Left: {
         if (!isMaximized()) {
-            auto dx = event->x() - m_previousPosition.x();
-            setGeometry(x() + dx, y(), width() - dx, height());
+            target.setLeft(qMin(target.left() + delta.x(), target.right() - minimumWidth()));
+            scheduleGeometry(target);
         }
         break;
     }
     case Right: {
         if (!isMaximized()) {
-            auto dx = event->x() - m_previousPosition.x();
-            setGeometry(x(), y(), width() + dx, height());
-            setPreviousPosition(event->pos());
+            target.setRight(target.right() + delta.x());
+            scheduleGeometry(target);
         }
         break;
     }
@@ -374,6 +534,32 @@ void Widget::mouseMoveEvent(QMouseEvent *event)
     return QWidget::mouseMoveEvent(event);
 }
 
+///События мыши приходят чаще, чем обновляется экран. Запоминаем только
+///последнюю геометрию и применяем её один раз за кадр
+void Widget::scheduleGeometry(const QRect &geometry)
+{
+    m_pendingGeometry = geometry;
+    if (!m_geometryTimer.isActive())
+        m_geometryTimer.start();
+}
+
+void Widget::applyPendingGeometry()
+{
+    if (m_pendingGeometry.isValid() && m_pendingGeometry != geometry())
+        setGeometry(m_pendingGeometry);
+}
+
+void Widget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    if (isMaximized() || isFullScreen())
+        return;
+
+    QPainter painter(this);
+    m_shadow.paint(&painter, ui->widgetInterface->geometry(), devicePixelRatioF());
+}
+
 Widget::MouseType Widget::checkResizableField(QMouseEvent *event)
 {
     QPointF position = event->screenPos();  // Определяем позицию курсора на экране
@@ -425,11 +611,12 @@ void Widget::createTaskbar()
     connect(ui->positionSlider, &QAbstractSlider::rangeChanged, m_taskbarProgress, &QWinTaskbarProgress::setRange);
 
     connect(m_player, &QMediaPlayer::stateChanged, this, &Widget::updateTaskbar);
+    connect(m_wavStream, &WavStream::stateChanged, this, &Widget::updateTaskbar);
 }
 
 void Widget::updateTaskbar()
 {
-    switch (m_player->state()) {
+    switch (playbackState()) {
     case QMediaPlayer::PlayingState:
         m_taskbarButton->setOverlayIcon(style()->standardIcon(QStyle::SP_MediaPlay));
         m_taskbarProgress->show();
@@ -474,19 +661,20 @@ void Widget::createThumbnailToolBar()
     thumbnailToolBar->addButton(playToolButton);
     thumbnailToolBar->addButton(forwardToolButton);
 
-    connect(m_player, &QMediaPlayer::positionChanged, this, &Widget::updateThumbnailToolBar);
     connect(m_player, &QMediaPlayer::durationChanged, this, &Widget::updateThumbnailToolBar);
     connect(m_player, &QMediaPlayer::stateChanged, this, &Widget::updateThumbnailToolBar);
+    connect(m_wavStream, &WavStream::stateChanged, this, &Widget::updateThumbnailToolBar);
+    connect(m_wavStream, &WavStream::positionChanged, this, &Widget::updateThumbnailToolBar);
 
 }
 
 void Widget::updateThumbnailToolBar()
 {
-    playToolButton->setEnabled(m_player->duration() > 0);
-    backwardToolButton->setEnabled(m_player->position() > 0);
-    forwardToolButton->setEnabled(m_player->position() < m_player->duration());
+    playToolButton->setEnabled(ui->positionSlider->maximum() > 0);
+    backwardToolButton->setEnabled(ui->positionSlider->value() > 0);
+    forwardToolButton->setEnabled(ui->positionSlider->value() < ui->positionSlider->maximum());
 
-    if (m_player->state() == QMediaPlayer::PlayingState) {
+    if (playbackState() == QMediaPlayer::PlayingState) {
         playToolButton->setToolTip(tr("Pause"));
         playToolButton->setIcon(style()->standardIcon(QStyle::SP_MediaPause));
     } else {
@@ -498,10 +686,10 @@ void Widget::updateThumbnailToolBar()
 
 void Widget::togglePlayback()
 {
-    if (m_player->state() == QMediaPlayer::PlayingState)
-        m_player->pause();
+    if (playbackState() == QMediaPlayer::PlayingState)
+        pause();
     else
-        m_player->play();
+        play();
 }
 
 void Widget::seekForward()
@@ -514,18 +702,23 @@ void Widget::seekBackward()
     ui->positionSlider->triggerAction(QSlider::SliderPageStepSub);
 }
 
-static QString formatTime(qint64 timeMilliSeconds)
+///Часы общие с окном Player: позиции его плееров сюда тоже приходят и пропускаются
+void Widget::clockPositionChanged(QMediaPlayer *player, qint64 position)
 {
-    qint64 seconds = timeMilliSeconds / 1000;
-    const qint64 minutes = seconds / 60;
-    seconds -= minutes * 60;
-    return QStringLiteral("%1:%2").arg(minutes, 2, 10, QLatin1Char('0')).arg(seconds, 2, 10, QLatin1Char('0'));
+    if (player != m_player)
+        return;
+
+    updatePosition(position);
+#ifdef WIN32
+    updateThumbnailToolBar();
+#endif
 }
 
 void Widget::updatePosition(qint64 position)
 {
     ui->positionSlider->setValue(position);
-    ui->positionLabel->setText(formatTime(position));
+    if (m_positionFormat.setTime(position / 1000))
+        ui->positionLabel->setText(m_positionFormat.text());
 }
 
 void Widget::updateDuration(qint64 duration)
@@ -537,16 +730,20 @@ void Widget::updateDuration(qint64 duration)
 
 void Widget::setPosition(int position)
 {
-    if (qAbs(m_player->position() - position) > 99)
+    if (m_native) {
+        if (qAbs(m_wavStream->position() - position) > 99)
+            m_wavStream->setPosition(position);
+    } else if (qAbs(m_player->position() - position) > 99) {
         m_player->setPosition(position);
+    }
 }
 
 void Widget::on_btn_music_clicked()
 {
     if(player!=nullptr)
     {
-        player->m_player_music->stop();
-        player->m_player->stop();
+        player->m_session_music->stop();
+        player->m_session->stop();
         player->close();
     }
 
@@ -576,7 +773,7 @@ void Widget::on_btn_music_clicked()
 
 void Widget::on_btn_video_clicked()
 {
-    m_player->stop();
+    stop();
     ui->positionSlider->setVisible(false);
     ui->positionLabel->setVisible(false);
     ui->btn_stop->setVisible(false);
@@ -592,7 +789,11 @@ void Widget::on_btn_video_clicked()
     m_audioHistogram->setVisible(false);
     ui->playlistView->setVisible(false);
 
-    if(player == nullptr) player = new Player();
+    if(player == nullptr) {
+        StartupTimeline::mark("Player requested");
+        player = new Player();
+        StartupTimeline::mark("Player constructed");
+    }
     player->show();
 }
 
@@ -2,13 +2,11 @@
 #define WIDGET_H
 
 #include <QWidget>
-#include <QStandardItemModel>
 #include <QMediaPlayer>
-#include <QMediaPlaylist>
 #include <QMouseEvent>
 #include <QFileDialog>
 #include <QDir>
-#include <QGraphicsDropShadowEffect>
+#include <QTimer>
 #include <QMediaMetaData>
 
 #ifdef WIN32
@@ -19,6 +17,14 @@
 #include "histogramwidget.h"
 #include "player.h"
 #include "style.h"
+#include "timeformat.h"
+#include "uirefreshclock.h"
+#include "windowshadow.h"
+#include "performancehud.h"
+#include "playbackorder.h"
+#include "tracklistmodel.h"
+#include "trackimporter.h"
+#include "wavstream.h"
 
 QT_FORWARD_DECLARE_CLASS(QSlider)
 QT_FORWARD_DECLARE_CLASS(QWinTaskbarButton)
@@ -59,11 +65,18 @@ private:
     HistogramWidget *m_audioHistogram = nullptr;
     QAudioProbe *m_audioProbe = nullptr;
 
-    QStandardItemModel *m_playListModel = nullptr;
+    TrackListModel *m_playListModel = nullptr;
+    TrackImporter *m_importer = nullptr;
     QMediaPlayer *m_player = nullptr;
-    QMediaPlaylist *m_playlist = nullptr;
+    WavStream *m_wavStream = nullptr;
+    bool m_native = false;          // текущий трек играет WavStream, а не m_player
+    PlaybackOrder m_order;
+    bool m_shuffle = false;
+    UiRefreshClock *m_refreshClock = nullptr;
 
     VolumeButton *m_volumeButton = nullptr;
+    TimeFormat m_positionFormat;
+    PerformanceHud *m_hud = nullptr;
 
 #ifdef WIN32
     QWinTaskbarProgress *m_taskbarProgress = nullptr;
@@ -79,20 +92,37 @@ private:
     MouseType m_leftMouseButtonPressed;
     QPoint m_previousPosition;
 
+    // Положение курсора и окна в момент нажатия, от них считается новая геометрия
+    QPoint m_pressGlobalPosition;
+    QRect m_pressGeometry;
+    QRect m_pendingGeometry;
+    QTimer m_geometryTimer;
+    WindowShadow m_shadow;
+
     MouseType checkResizableField(QMouseEvent*);
+    void scheduleGeometry(const QRect &geometry);
 
 #ifdef WIN32
     void createTaskbar();
     void createThumbnailToolBar();
 #endif
     void clearHistogram();
+    void setCurrentRow(int row);
+    QMediaPlayer::State playbackState() const;
 
 private slots:
     void on_btn_add_clicked();
     void on_btn_del_clicked();
     void on_btn_random_clicked();
+    void playNext();
+    void playPrevious();
+    void advancePlayback(QMediaPlayer::MediaStatus status);
+    void attachProbe(QMediaPlayer::State state);
+    void applyPendingGeometry();
+    void importFinished(int accepted, int relabelled, const QStringList &rejected, const QStringList &reasons);
 
     void updatePosition(qint64);
+    void clockPositionChanged(QMediaPlayer *player, qint64 position);
     void updateDuration(qint64);
     void setPosition(int);
 
@@ -110,6 +140,9 @@ protected:
     void mousePressEvent(QMouseEvent*);
     void mouseReleaseEvent(QMouseEvent*);
     void mouseMoveEvent(QMouseEvent*);
+    void paintEvent(QPaintEvent*);
+    void dragEnterEvent(QDragEnterEvent *event);
+    void dropEvent(QDropEvent *event);
 
 public:
     explicit Widget(QWidget *parent = nullptr);
@@ -121,6 +154,9 @@ public:
 public slots:
     void setPreviousPosition(QPoint);
 
+    void play();
+    void pause();
+    void stop();
     void togglePlayback();
     void seekForward();
     void seekBackward();
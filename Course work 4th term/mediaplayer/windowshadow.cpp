@@ -0,0 +1,108 @@
+#include "windowshadow.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+
+///Один проход скользящего среднего по строкам (step = 1) или столбцам (step = size)
+static void boxBlur(QVector<int> &alpha, int size, int radius, bool horizontal)
+{
+    QVector<int> line(size);
+    const int window = 2 * radius + 1;
+    for (int l = 0; l < size; ++l) {
+        int *p = alpha.data() + (horizontal ? l * size : l);
+        const int step = horizontal ? 1 : size;
+        for (int i = 0; i < size; ++i)
+            line[i] = p[i * step];
+
+        int sum = 0;
+        for (int i = -radius; i <= radius; ++i)
+            sum += (i >= 0 && i < size) ? line[i] : 0;
+        for (int i = 0; i < size; ++i) {
+            p[i * step] = sum / window;
+            int out = i - radius;
+            int in = i + radius + 1;
+            sum += (in < size ? line[in] : 0) - (out >= 0 ? line[out] : 0);
+        }
+    }
+}
+
+void WindowShadow::setRadius(int radius)
+{
+    if (radius == m_radius)
+        return;
+    m_radius = qMax(0, radius);
+    m_pixmap = QPixmap();
+}
+
+void WindowShadow::setColor(const QColor &color)
+{
+    if (color == m_color)
+        return;
+    m_color = color;
+    m_pixmap = QPixmap();
+}
+
+///Картинка размером 4r+1: непрозрачный квадрат от r до 3r, размытый
+///тремя проходами box blur (приближение гаусса). Столбец и строка 2r
+///не задеты углами и служат растягиваемыми сторонами
+void WindowShadow::render(qreal devicePixelRatio)
+{
+    m_devicePixelRatio = devicePixelRatio;
+    const int r = qRound(m_radius * devicePixelRatio);
+    const int size = 4 * r + 1;
+
+    QVector<int> alpha(size * size, 0);
+    for (int y = r; y < 3 * r + 1; ++y)
+        for (int x = r; x < 3 * r + 1; ++x)
+            alpha[y * size + x] = 255;
+
+    const int pass = qMax(1, r / 3);
+    for (int i = 0; i < 3; ++i) {
+        boxBlur(alpha, size, pass, true);
+        boxBlur(alpha, size, pass, false);
+    }
+
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < size; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size; ++x) {
+            int a = alpha[y * size + x] * m_color.alpha() / 255;
+            line[x] = qPremultiply(qRgba(m_color.red(), m_color.green(), m_color.blue(), a));
+        }
+    }
+
+    m_pixmap = QPixmap::fromImage(image);
+}
+
+///contentRect — прямоугольник содержимого окна, тень рисуется вокруг него
+///полосой шириной radius. Внутренняя часть не закрашивается
+void WindowShadow::paint(QPainter *painter, const QRect &contentRect, qreal devicePixelRatio)
+{
+    if (m_radius <= 0)
+        return;
+    if (m_pixmap.isNull() || !qFuzzyCompare(m_devicePixelRatio, devicePixelRatio))
+        render(devicePixelRatio);
+
+    const int r = m_radius;
+    const int s = qRound(r * devicePixelRatio);     // r в пикселях картинки
+    const QRect outer = contentRect.adjusted(-r, -r, r, r);
+    const int left = outer.left();
+    const int top = outer.top();
+    const int right = outer.right() + 1;
+    const int bottom = outer.bottom() + 1;
+    const int w = qMax(0, outer.width() - 2 * r);
+    const int h = qMax(0, outer.height() - 2 * r);
+
+    ///Углы: внешняя четверть угла картинки, внутренняя часть закрыта содержимым
+    painter->drawPixmap(QRect(left, top, r, r), m_pixmap, QRect(0, 0, s, s));
+    painter->drawPixmap(QRect(right - r, top, r, r), m_pixmap, QRect(3 * s + 1, 0, s, s));
+    painter->drawPixmap(QRect(left, bottom - r, r, r), m_pixmap, QRect(0, 3 * s + 1, s, s));
+    painter->drawPixmap(QRect(right - r, bottom - r, r, r), m_pixmap, QRect(3 * s + 1, 3 * s + 1, s, s));
+
+    ///Стороны: однопиксельная полоса из середины, растянутая по длине окна
+    painter->drawPixmap(QRect(left + r, top, w, r), m_pixmap, QRect(2 * s, 0, 1, s));
+    painter->drawPixmap(QRect(left + r, bottom - r, w, r), m_pixmap, QRect(2 * s, 3 * s + 1, 1, s));
+    painter->drawPixmap(QRect(left, top + r, r, h), m_pixmap, QRect(0, 2 * s, s, 1));
+    painter->drawPixmap(QRect(right - r, top + r, r, h), m_pixmap, QRect(3 * s + 1, 2 * s, s, 1));
+}
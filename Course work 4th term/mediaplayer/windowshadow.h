@@ -0,0 +1,34 @@
+#ifndef WINDOWSHADOW_H
+#define WINDOWSHADOW_H
+
+#include <QColor>
+#include <QPixmap>
+
+class QPainter;
+
+///Тень окна из заранее отрисованной девятичастной картинки.
+///Размытие считается один раз при смене радиуса или цвета, а при отрисовке
+///только копируются углы и растягиваются однопиксельные полосы сторон.
+///Заменяет QGraphicsDropShadowEffect, который перерисовывал и размывал
+///всё содержимое окна на каждом кадре
+class WindowShadow
+{
+private:
+    QPixmap m_pixmap;
+    int m_radius = 9;
+    QColor m_color = QColor(63, 63, 63, 180);
+    qreal m_devicePixelRatio = 0;
+
+    void render(qreal devicePixelRatio);
+
+public:
+    int radius() const { return m_radius; }
+    void setRadius(int radius);
+
+    QColor color() const { return m_color; }
+    void setColor(const QColor &color);
+
+    void paint(QPainter *painter, const QRect &contentRect, qreal devicePixelRatio);
+};
+
+#endif // WINDOWSHADOW_H